@@ -0,0 +1,198 @@
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "asset_cache.hpp"
+#include "batch_renderer.hpp"
+#include "render_job.hpp"
+#include "thread_pool.hpp"
+
+// Long-running batch renderer: reads job lines (see goob::parse_job()) from stdin, or from the *.job files of a
+// spool directory, and renders them through one BatchRenderer so assets stay cached between jobs. Exits with 1
+// when any job or job line failed, in both modes.
+
+namespace {
+    volatile std::sig_atomic_t stop_requested = 0;
+
+    void request_stop(int) {
+        stop_requested = 1;
+    }
+
+    void usage() {
+        std::cerr << "usage: batch [options]\n"
+                     "Renders job lines read from stdin, or from the *.job files of a spool directory.\n"
+                     "  --spool DIR        take jobs from DIR, renaming each file to .done or .failed when finished\n"
+                     "  --once             with --spool, exit once the spool is empty instead of waiting for jobs\n"
+                     "  --poll-ms N        spool polling interval (250)\n"
+                     "  --threads N        render threads (all cores)\n"
+                     "  --cache-mb N       asset cache budget in MiB (1024)\n"
+                     "  --mesh-cache DIR   keep binary caches of the loaded meshes in DIR\n"
+                     "  --queue N          jobs buffered between pipeline stages (2)\n";
+    }
+
+    double ms(std::int64_t ns) {
+        return static_cast<double>(ns) / 1e6;
+    }
+
+    // Progress of a claimed spool file; it is finished once all of its lines were submitted and reported
+    struct SpoolFile {
+        std::filesystem::path path;
+        std::size_t outstanding = 0;
+        bool submitted = false;
+        bool failed = false;
+    };
+}
+
+int main(int argc, char ** argv) {
+    std::filesystem::path spool_dir, mesh_cache;
+    bool once = false;
+    int poll_ms = 250;
+    unsigned threads = std::thread::hardware_concurrency();
+    std::size_t cache_mb = 1024;
+    goob::BatchOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const auto value = [&]() -> const char * {
+            if (i + 1 >= argc) {
+                usage();
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (arg == "--spool") {
+            spool_dir = value();
+        } else if (arg == "--once") {
+            once = true;
+        } else if (arg == "--poll-ms") {
+            poll_ms = std::atoi(value());
+        } else if (arg == "--threads") {
+            threads = static_cast<unsigned>(std::atoi(value()));
+        } else if (arg == "--cache-mb") {
+            cache_mb = static_cast<std::size_t>(std::atoll(value()));
+        } else if (arg == "--mesh-cache") {
+            mesh_cache = value();
+        } else if (arg == "--queue") {
+            options.queue_depth = static_cast<std::size_t>(std::atoi(value()));
+        } else {
+            usage();
+            return arg == "--help" || arg == "-h" ? 0 : 2;
+        }
+    }
+
+    try {
+        goob::ThreadPool pool(threads ? threads : 1);
+        // Assets load on the pipeline's load thread, overlapping the renders on the pool
+        goob::AssetCache assets(cache_mb << 20, nullptr, mesh_cache);
+
+        std::mutex mutex;
+        std::map<std::uint64_t, std::shared_ptr<SpoolFile>> job_files;
+        std::uint64_t next_sequence = 0;
+        std::optional<goob::JobSpool> spool;
+        std::size_t failures = 0;
+
+        const auto finish_file = [&](SpoolFile & file) {
+            try {
+                spool->finish(file.path, !file.failed);
+            } catch (const std::exception & error) {
+                ++failures;
+                std::cerr << "error " << file.path.string() << ": " << error.what() << '\n';
+            }
+        };
+
+        goob::BatchRenderer renderer(pool, assets, [&](const goob::JobResult & result) {
+            std::lock_guard lock(mutex);
+            if (result.succeeded()) {
+                std::cout << "ok " << result.job.output.string() << " load=" << ms(result.load_ns) << "ms render=" << ms(result.render_ns)
+                          << "ms encode=" << ms(result.encode_ns) << "ms write=" << ms(result.write_ns) << "ms" << std::endl;
+            } else {
+                ++failures;
+                std::cerr << "error " << result.job.output.string() << ": " << result.error << std::endl;
+            }
+            const auto it = job_files.find(result.sequence);
+            if (it != job_files.end()) {
+                const std::shared_ptr<SpoolFile> file = std::move(it->second);
+                job_files.erase(it);
+                file->failed |= !result.succeeded();
+                if (--file->outstanding == 0 && file->submitted) {
+                    finish_file(*file);
+                }
+            }
+        }, options);
+
+        if (spool_dir.empty()) {
+            std::string line;
+            for (std::size_t number = 1; std::getline(std::cin, line); ++number) {
+                try {
+                    if (std::optional<goob::RenderJob> job = goob::parse_job(line)) {
+                        renderer.submit(std::move(*job));
+                        ++next_sequence;
+                    }
+                } catch (const std::exception & error) {
+                    std::lock_guard lock(mutex);
+                    ++failures;
+                    std::cerr << "error stdin:" << number << ": " << error.what() << std::endl;
+                }
+            }
+            renderer.wait();
+            return failures ? 1 : 0;
+        }
+
+        spool.emplace(spool_dir);
+        std::signal(SIGINT, request_stop);
+        std::signal(SIGTERM, request_stop);
+        while (!stop_requested) {
+            const std::optional<std::filesystem::path> claimed = spool->claim();
+            if (!claimed) {
+                if (once) {
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(poll_ms));
+                continue;
+            }
+
+            const auto file = std::make_shared<SpoolFile>(*claimed);
+            std::ifstream in(*claimed);
+            std::string line;
+            for (std::size_t number = 1; std::getline(in, line); ++number) {
+                try {
+                    if (std::optional<goob::RenderJob> job = goob::parse_job(line, claimed->parent_path())) {
+                        // Registered under the sequence number submit() will assign, before submitting: the job may
+                        // be reported before submit() returns, and submit() may block on the reporting thread
+                        {
+                            std::lock_guard lock(mutex);
+                            ++file->outstanding;
+                            job_files[next_sequence++] = file;
+                        }
+                        renderer.submit(std::move(*job));
+                    }
+                } catch (const std::exception & error) {
+                    std::lock_guard lock(mutex);
+                    ++failures;
+                    file->failed = true;
+                    std::cerr << "error " << claimed->string() << ":" << number << ": " << error.what() << std::endl;
+                }
+            }
+            std::lock_guard lock(mutex);
+            file->submitted = true;
+            if (file->outstanding == 0) {
+                finish_file(*file);
+            }
+        }
+        renderer.wait();
+        return failures ? 1 : 0;
+    } catch (const std::exception & error) {
+        std::cerr << "batch: " << error.what() << '\n';
+        return 1;
+    }
+}
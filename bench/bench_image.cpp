@@ -0,0 +1,84 @@
+#include "thread_pool.hpp"
+#include "tga_image.hpp"
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// TGA encode, decode and file round-trip throughput on a synthetic 1024x1024 BGRA image: horizontal runs of flat
+// color (which RLE compresses) alternating with a noisy gradient (which it cannot). Items are pixels.
+
+namespace {
+    constexpr int size = 1024;
+
+    goob::TGAImage synthetic_image() {
+        goob::TGAImage image(size, size, goob::PixelFormat::bgra);
+        std::uint8_t * p = image.pixels().data();
+        std::uint32_t noise = 1;
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x, p += 4) {
+                noise = noise * 1664525u + 1013904223u;
+                const bool flat = (x / 64 + y / 64) % 2 == 0;
+                p[0] = flat ? 40 : static_cast<std::uint8_t>(x + (noise >> 29));
+                p[1] = flat ? 90 : static_cast<std::uint8_t>(y);
+                p[2] = flat ? 200 : static_cast<std::uint8_t>(noise >> 24);
+                p[3] = 255;
+            }
+        }
+        return image;
+    }
+
+    const goob::TGAImage & image() {
+        static const goob::TGAImage instance = synthetic_image();
+        return instance;
+    }
+
+    goob::ThreadPool * pool_for(benchmark::State & state) {
+        static goob::ThreadPool instance;
+        return state.range(1) != 0 ? &instance : nullptr;
+    }
+
+    goob::TGACompression compression(benchmark::State & state) {
+        return state.range(0) != 0 ? goob::TGACompression::rle : goob::TGACompression::none;
+    }
+
+    void set_processed(benchmark::State & state) {
+        state.SetItemsProcessed(state.iterations() * size * size);
+        state.SetBytesProcessed(state.iterations() * size * size * 4);
+    }
+
+    void BM_tga_encode(benchmark::State & state) {
+        goob::ThreadPool * pool = pool_for(state);
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(goob::encode_tga(image().view(), compression(state), pool));
+        }
+        set_processed(state);
+    }
+    BENCHMARK(BM_tga_encode)->ArgNames({"rle", "pool"})->ArgsProduct({{0, 1}, {0, 1}})->UseRealTime();
+
+    void BM_tga_decode(benchmark::State & state) {
+        const std::vector<std::uint8_t> file = goob::encode_tga(image().view(), compression(state));
+        // Uncompressed pixels are referenced in place, so that case measures header parsing and validation only
+        for (auto _ : state) {
+            goob::TGAImage decoded = goob::TGAImage::decode(file);
+            benchmark::DoNotOptimize(decoded.view().row(size - 1)[0]);
+        }
+        set_processed(state);
+    }
+    BENCHMARK(BM_tga_decode)->ArgNames({"rle", "pool"})->ArgsProduct({{0, 1}, {0}});
+
+    // Write to and load from the temporary directory, so the numbers include the page cache but rarely the disk
+    void BM_tga_save_load(benchmark::State & state) {
+        goob::ThreadPool * pool = pool_for(state);
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / "goob_bench_image.tga";
+        for (auto _ : state) {
+            image().write(path, compression(state), pool);
+            goob::TGAImage loaded = goob::TGAImage::load(path);
+            benchmark::DoNotOptimize(loaded.view().row(size - 1)[0]);
+        }
+        std::filesystem::remove(path);
+        set_processed(state);
+    }
+    BENCHMARK(BM_tga_save_load)->ArgNames({"rle", "pool"})->ArgsProduct({{0, 1}, {0, 1}})->UseRealTime();
+}
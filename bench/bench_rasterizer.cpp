@@ -0,0 +1,82 @@
+#include "rasterizer.hpp"
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+// Rasterizer throughput on a 1024x768 target. Triangle counts are sized so every iteration shades a similar
+// number of pixels; items are pixels written (fill rate) or pixels tested (depth test).
+
+namespace {
+    constexpr int width = 1024;
+    constexpr int height = 768;
+
+    goob::ThreadPool & pool() {
+        static goob::ThreadPool instance;
+        return instance;
+    }
+
+    // Two triangles covering the whole target at depth z
+    std::vector<goob::ScreenTriangle> full_screen(float z) {
+        const float w = static_cast<float>(width), h = static_cast<float>(height);
+        return {{{{0, 0, z, 1}, {w, 0, z, 1}, {0, h, z, 1}}}, {{{w, 0, z, 1}, {w, h, z, 1}, {0, h, z, 1}}}};
+    }
+
+    // Right triangles with legs of `size` pixels tiling the screen in a grid, at depth z
+    std::vector<goob::ScreenTriangle> grid(float size, float z) {
+        std::vector<goob::ScreenTriangle> triangles;
+        for (float y = 0; y + size <= height; y += size) {
+            for (float x = 0; x + size <= width; x += size) {
+                triangles.push_back({{{x, y, z, 1}, {x + size, y, z, 1}, {x, y + size, z, 1}}});
+                triangles.push_back({{{x + size, y, z, 1}, {x + size, y + size, z, 1}, {x, y + size, z, 1}}});
+            }
+        }
+        return triangles;
+    }
+
+    void fill(benchmark::State & state, goob::SurfaceLayout layout) {
+        const std::vector<goob::ScreenTriangle> triangles = grid(static_cast<float>(state.range(0)), 0.5f);
+        goob::Rasterizer rasterizer(pool());
+        goob::Framebuffer fb(width, height, layout);
+        for (auto _ : state) {
+            // Clearing is part of a frame, and keeps the depth test from rejecting later iterations
+            fb.clear();
+            rasterizer.draw(triangles, fb, [](std::uint32_t triangle, const linalg::vec<float,3> &) { return triangle * 0x9e3779b1u; });
+        }
+        const goob::RasterStats stats = rasterizer.stats();
+        state.SetItemsProcessed(static_cast<std::int64_t>(stats.pixels_shaded));
+        state.counters["triangles"] = static_cast<double>(triangles.size());
+    }
+
+    void BM_fill_linear(benchmark::State & state) { fill(state, goob::SurfaceLayout::linear); }
+    void BM_fill_tiled(benchmark::State & state) { fill(state, goob::SurfaceLayout::tiled); }
+    // Triangle leg in pixels
+    BENCHMARK(BM_fill_linear)->Arg(2)->Arg(8)->Arg(32)->Arg(128)->UseRealTime();
+    BENCHMARK(BM_fill_tiled)->Arg(2)->Arg(8)->Arg(32)->Arg(128)->UseRealTime();
+
+    // Layers of full-screen quads drawn back to front (every pixel passes) or front to back (every later layer
+    // fails), with hierarchical Z on or off
+    void BM_depth_test(benchmark::State & state) {
+        const bool front_to_back = state.range(0) != 0;
+        const bool hiz = state.range(1) != 0;
+        constexpr int layers = 8;
+        std::vector<goob::ScreenTriangle> triangles;
+        for (int layer = 0; layer < layers; ++layer) {
+            const float z = front_to_back ? 0.1f + 0.1f * layer : 0.9f - 0.1f * layer;
+            const std::vector<goob::ScreenTriangle> quad = full_screen(z);
+            triangles.insert(triangles.end(), quad.begin(), quad.end());
+        }
+
+        goob::Rasterizer rasterizer(pool());
+        rasterizer.set_hierarchical_z(hiz);
+        goob::Framebuffer fb(width, height, goob::SurfaceLayout::tiled);
+        for (auto _ : state) {
+            fb.clear();
+            rasterizer.draw(triangles, fb, [](std::uint32_t, const linalg::vec<float,3> &) { return 0xffffffffu; });
+        }
+        const goob::RasterStats stats = rasterizer.stats();
+        state.SetItemsProcessed(static_cast<std::int64_t>(stats.pixels_shaded + stats.pixels_depth_failed + stats.pixels_culled));
+        state.counters["shaded"] = benchmark::Counter(static_cast<double>(stats.pixels_shaded), benchmark::Counter::kAvgIterations);
+    }
+    BENCHMARK(BM_depth_test)->ArgNames({"front_to_back", "hiz"})->ArgsProduct({{0, 1}, {0, 1}})->UseRealTime();
+}
@@ -0,0 +1,118 @@
+#include "vector.hpp"
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Hot linalg operations over fixed pseudo-random inputs. Inputs are arrays larger than a few registers so the
+// compiler cannot fold the work, and small enough to stay in L1 so the numbers reflect arithmetic, not memory.
+
+namespace {
+    constexpr std::size_t input_count = 1024;
+
+    // Deterministic values in [-1,1)
+    struct Lcg {
+        std::uint32_t state = 12345;
+        float next() {
+            state = state * 1664525u + 1013904223u;
+            return static_cast<float>(state >> 8) / float(1 << 23) - 1.0f;
+        }
+    };
+
+    std::vector<linalg::vec<float,4>> vec4s() {
+        Lcg lcg;
+        std::vector<linalg::vec<float,4>> out(input_count);
+        for (auto & v : out) {
+            v = {lcg.next(), lcg.next(), lcg.next(), lcg.next()};
+        }
+        return out;
+    }
+
+    std::vector<linalg::mat<float,4,4>> mat4s() {
+        Lcg lcg;
+        std::vector<linalg::mat<float,4,4>> out(input_count);
+        for (auto & m : out) {
+            // Diagonally dominant, so every matrix is comfortably invertible
+            for (int c = 0; c < 4; ++c) {
+                m[c] = {lcg.next(), lcg.next(), lcg.next(), lcg.next()};
+                m[c][c] += 4.0f;
+            }
+        }
+        return out;
+    }
+
+    void BM_mat4_mul_vec4(benchmark::State & state) {
+        const auto matrices = mat4s();
+        const auto vectors = vec4s();
+        for (auto _ : state) {
+            for (std::size_t i = 0; i < input_count; ++i) {
+                benchmark::DoNotOptimize(linalg::mul(matrices[i], vectors[i]));
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * input_count);
+    }
+    BENCHMARK(BM_mat4_mul_vec4);
+
+    void BM_mat4_mul_mat4(benchmark::State & state) {
+        const auto matrices = mat4s();
+        for (auto _ : state) {
+            for (std::size_t i = 0; i + 1 < input_count; ++i) {
+                benchmark::DoNotOptimize(linalg::mul(matrices[i], matrices[i + 1]));
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * (input_count - 1));
+    }
+    BENCHMARK(BM_mat4_mul_mat4);
+
+    void BM_mat4_inverse(benchmark::State & state) {
+        const auto matrices = mat4s();
+        for (auto _ : state) {
+            for (const auto & m : matrices) {
+                benchmark::DoNotOptimize(linalg::inverse(m));
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * input_count);
+    }
+    BENCHMARK(BM_mat4_inverse);
+
+    void BM_vec3_normalize(benchmark::State & state) {
+        const auto vectors = vec4s();
+        for (auto _ : state) {
+            for (const auto & v : vectors) {
+                benchmark::DoNotOptimize(linalg::normalize(v.xyz()));
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * input_count);
+    }
+    BENCHMARK(BM_vec3_normalize);
+
+    void BM_qmul(benchmark::State & state) {
+        auto quaternions = vec4s();
+        for (auto & q : quaternions) {
+            q = linalg::normalize(q);
+        }
+        for (auto _ : state) {
+            for (std::size_t i = 0; i + 1 < input_count; ++i) {
+                benchmark::DoNotOptimize(linalg::qmul(quaternions[i], quaternions[i + 1]));
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * (input_count - 1));
+    }
+    BENCHMARK(BM_qmul);
+
+    void BM_qrot(benchmark::State & state) {
+        auto quaternions = vec4s();
+        for (auto & q : quaternions) {
+            q = linalg::normalize(q);
+        }
+        const auto points = vec4s();
+        for (auto _ : state) {
+            for (std::size_t i = 0; i < input_count; ++i) {
+                benchmark::DoNotOptimize(linalg::qrot(quaternions[i], points[i].xyz()));
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * input_count);
+    }
+    BENCHMARK(BM_qrot);
+}
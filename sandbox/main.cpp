@@ -5,5 +5,5 @@ int main() {
     Goob goob = Goob();
     goob.hello();
 
-    Vector2<uint32_t> vec;
+    linalg::vec<uint32_t,2> vec;
 }
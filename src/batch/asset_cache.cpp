@@ -0,0 +1,160 @@
+#include "asset_cache.hpp"
+
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+#include "mesh_cache.hpp"
+#include "obj_loader.hpp"
+#include "tga_image.hpp"
+
+namespace goob {
+
+namespace {
+    std::size_t mesh_bytes(const Mesh & mesh) {
+        return mesh.positions.size() * sizeof(mesh.positions[0]) + mesh.normals.size() * sizeof(mesh.normals[0])
+             + mesh.texcoords.size() * sizeof(mesh.texcoords[0]) + mesh.indices.size() * sizeof(mesh.indices[0]);
+    }
+
+    std::size_t texture_bytes(const Texture & texture) {
+        std::size_t texels = 0;
+        for (int i = 0; i < texture.level_count(); ++i) {
+            texels += static_cast<std::size_t>(texture.level(i).width) * texture.level(i).height;
+        }
+        return texels * sizeof(std::uint32_t);
+    }
+}
+
+AssetCache::AssetCache(std::size_t budget, ThreadPool * pool, std::filesystem::path mesh_cache_dir)
+    : budget_(budget), pool_(pool), mesh_cache_dir_(std::move(mesh_cache_dir)) {
+    if (!mesh_cache_dir_.empty()) {
+        std::filesystem::create_directories(mesh_cache_dir_);
+    }
+}
+
+std::shared_ptr<const Mesh> AssetCache::mesh(const std::filesystem::path & path) {
+    return std::static_pointer_cast<const Mesh>(get('m', path, [&](const std::filesystem::path & source) {
+        Mesh mesh;
+        if (mesh_cache_dir_.empty()) {
+            mesh = load_obj(source, pool_);
+        } else {
+            // One cache file per source path; the stem keeps the directory readable
+            const std::size_t hash = std::hash<std::string>{}(source.string());
+            const std::filesystem::path cache = mesh_cache_dir_ / (source.stem().string() + "-" + std::to_string(hash) + ".gmesh");
+            mesh = load_mesh_cached(source, cache, pool_).to_mesh();
+        }
+        const std::size_t bytes = mesh_bytes(mesh);
+        return std::pair{std::shared_ptr<const void>(std::make_shared<const Mesh>(std::move(mesh))), bytes};
+    }));
+}
+
+std::shared_ptr<const Texture> AssetCache::texture(const std::filesystem::path & path) {
+    return std::static_pointer_cast<const Texture>(get('t', path, [&](const std::filesystem::path & source) {
+        auto texture = std::make_shared<const Texture>(TGAImage::load(source), pool_);
+        const std::size_t bytes = texture_bytes(*texture);
+        return std::pair{std::shared_ptr<const void>(std::move(texture)), bytes};
+    }));
+}
+
+template<class Load>
+std::shared_ptr<const void> AssetCache::get(char kind, const std::filesystem::path & path, Load && load) {
+    std::error_code error;
+    const std::filesystem::path source = std::filesystem::weakly_canonical(path, error);
+    FileStamp stamp;
+    if (!error) {
+        stamp.size = std::filesystem::file_size(source, error);
+    }
+    if (!error) {
+        stamp.mtime = std::filesystem::last_write_time(source, error);
+    }
+    if (error) {
+        throw std::runtime_error("Cannot open asset " + path.string());
+    }
+
+    const std::string key = kind + source.string();
+    std::promise<std::shared_ptr<const void>> promise;
+    std::shared_future<std::shared_ptr<const void>> value;
+    std::uint64_t load_id = 0;
+    {
+        std::lock_guard lock(mutex_);
+        Entry & entry = entries_[key];
+        entry.last_use = ++clock_;
+        if (entry.value.valid() && entry.stamp == stamp) {
+            ++stats_.hits;
+            value = entry.value;
+        } else {
+            // New or changed on disk: jobs still holding the old version keep it
+            ++stats_.loads;
+            bytes_ -= entry.bytes;
+            value = promise.get_future().share();
+            load_id = entry.last_use;
+            entry = {value, stamp, 0, load_id, load_id};
+        }
+    }
+    if (load_id == 0) {
+        return value.get();
+    }
+
+    try {
+        auto [asset, bytes] = load(source);
+        promise.set_value(asset);
+        std::lock_guard lock(mutex_);
+        const auto it = entries_.find(key);
+        if (it != entries_.end() && it->second.load_id == load_id) {
+            it->second.bytes = bytes;
+            bytes_ += bytes;
+            evict();
+        }
+        return asset;
+    } catch (...) {
+        promise.set_exception(std::current_exception());
+        std::lock_guard lock(mutex_);
+        const auto it = entries_.find(key);
+        if (it != entries_.end() && it->second.load_id == load_id) {
+            entries_.erase(it);
+        }
+        throw;
+    }
+}
+
+void AssetCache::evict() {
+    while (bytes_ > budget_) {
+        auto victim = entries_.end();
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            const Entry & entry = it->second;
+            // Loaded and held by nobody but the cache
+            if (entry.bytes != 0 && entry.value.get().use_count() == 1 && (victim == entries_.end() || entry.last_use < victim->second.last_use)) {
+                victim = it;
+            }
+        }
+        if (victim == entries_.end()) {
+            return;
+        }
+        bytes_ -= victim->second.bytes;
+        entries_.erase(victim);
+        ++stats_.evictions;
+    }
+}
+
+void AssetCache::clear() {
+    std::lock_guard lock(mutex_);
+    entries_.clear();
+    bytes_ = 0;
+}
+
+std::size_t AssetCache::size() const {
+    std::lock_guard lock(mutex_);
+    return entries_.size();
+}
+
+std::size_t AssetCache::bytes() const {
+    std::lock_guard lock(mutex_);
+    return bytes_;
+}
+
+AssetCache::Stats AssetCache::stats() const {
+    std::lock_guard lock(mutex_);
+    return stats_;
+}
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "mesh.hpp"
+#include "texture.hpp"
+
+namespace goob {
+
+class ThreadPool;
+
+// Meshes and textures shared by the jobs of a long-running process.
+//
+// Assets are loaded on first use and handed out as shared pointers, so a job keeps what it uses alive however
+// the cache changes afterwards. Concurrent requests for a file that is still loading wait for that one load.
+// Every lookup compares the file's size and modification time with those of the loaded version and reloads
+// changed files. Once the loaded assets exceed `budget` bytes, the least recently used ones that no job holds
+// are dropped.
+//
+// OBJ meshes go through a binary mesh cache (see load_mesh_cached()) when a cache directory is given, so a
+// restarted process skips parsing as well. Loads run on the calling thread, in parallel on `pool` when given.
+class AssetCache {
+public:
+    struct Stats {
+        std::uint64_t hits = 0;
+        std::uint64_t loads = 0;
+        std::uint64_t evictions = 0;
+    };
+
+    explicit AssetCache(std::size_t budget = std::size_t(1) << 30, ThreadPool * pool = nullptr, std::filesystem::path mesh_cache_dir = {});
+
+    AssetCache(const AssetCache &) = delete;
+    AssetCache & operator=(const AssetCache &) = delete;
+
+    // Throw std::runtime_error when the file cannot be loaded; a failed load is retried by the next request
+    std::shared_ptr<const Mesh> mesh(const std::filesystem::path & path);
+    std::shared_ptr<const Texture> texture(const std::filesystem::path & path);
+
+    // Drops every entry; assets held by jobs stay valid
+    void clear();
+
+    std::size_t size() const;
+    // Approximate memory of the loaded entries
+    std::size_t bytes() const;
+    Stats stats() const;
+
+private:
+    struct FileStamp {
+        std::uintmax_t size = 0;
+        std::filesystem::file_time_type mtime;
+
+        bool operator==(const FileStamp &) const = default;
+    };
+
+    struct Entry {
+        std::shared_future<std::shared_ptr<const void>> value;
+        FileStamp stamp;
+        std::size_t bytes = 0;      // 0 while loading
+        std::uint64_t last_use = 0;
+        std::uint64_t load_id = 0;  // tells a finishing load whether its entry was replaced meanwhile
+    };
+
+    template<class Load>
+    std::shared_ptr<const void> get(char kind, const std::filesystem::path & path, Load && load);
+    void evict();
+
+    const std::size_t budget_;
+    ThreadPool * pool_;
+    const std::filesystem::path mesh_cache_dir_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::size_t bytes_ = 0;
+    std::uint64_t clock_ = 0;
+    Stats stats_;
+};
+
+}
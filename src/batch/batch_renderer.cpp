@@ -0,0 +1,279 @@
+#include "batch_renderer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <numbers>
+#include <optional>
+#include <utility>
+
+#include "atomic_file.hpp"
+#include "framebuffer.hpp"
+#include "multisample.hpp"
+#include "pipeline.hpp"
+#include "profiler.hpp"
+
+namespace goob {
+
+namespace {
+    struct MeshVertex {
+        linalg::vec<float,3> position;
+        linalg::vec<float,3> normal;
+        linalg::vec<float,2> texcoord;
+        float lod = 0.0f;
+    };
+
+    struct MeshShader {
+        using Vertex = MeshVertex;
+        using Varyings = linalg::mat<float,3,2>;   // normal and (u, v, lod)
+
+        linalg::mat<float,4,4> view_projection;
+        linalg::vec<float,3> light;     // unit direction towards the camera
+        const Texture * texture = nullptr;
+        bool lit = true;
+
+        linalg::vec<float,4> vertex(const Vertex & v, Varyings & out) const {
+            out = Varyings(v.normal, linalg::vec<float,3>(v.texcoord, v.lod));
+            return linalg::mul(view_projection, linalg::vec<float,4>(v.position, 1.0f));
+        }
+
+        linalg::vec<float,4> fragment(const Varyings & in) const {
+            const linalg::vec<float,4> albedo = texture ? texture->sample(Sampler{TextureFilter::trilinear}, in[1].xy(), in[1].z) : linalg::vec<float,4>(0.8f, 0.8f, 0.8f, 1.0f);
+            float intensity = 1.0f;
+            if (lit) {
+                const float length = linalg::length(in[0]);
+                const float lambert = length > 0.0f ? std::max(linalg::dot(in[0], light) / length, 0.0f) : 0.0f;
+                intensity = 0.15f + 0.85f * lambert;
+            }
+            return {albedo.xyz() * intensity, 1.0f};
+        }
+    };
+
+    // Through a unique temporary (see write_file_atomic()), so readers never see a partial image and services
+    // sharing a spool never clobber each other's writes
+    void write_file(const std::filesystem::path & path, const std::vector<std::uint8_t> & file) {
+        if (path.has_parent_path()) {
+            std::filesystem::create_directories(path.parent_path());
+        }
+        write_file_atomic(path, file);
+    }
+}
+
+struct BatchRenderer::Work {
+    JobResult result;
+    std::shared_ptr<const Mesh> mesh;
+    std::shared_ptr<const Texture> texture;
+    std::vector<std::uint32_t> pixels;      // row-major, once rendered
+    std::vector<std::uint8_t> file;         // once encoded
+};
+
+// The render stage's state, reused from job to job
+class BatchRenderer::Renderer {
+public:
+    explicit Renderer(ThreadPool & pool) : pool_(pool), pipeline_(pool) {}
+
+    void render(Work & work) {
+        const RenderJob & job = work.result.job;
+        const Mesh & mesh = *work.mesh;
+
+        // OBJ texcoords have v = 0 at the bottom, textures at the top
+        vertices_.resize(mesh.vertex_count());
+        for (std::size_t i = 0; i < vertices_.size(); ++i) {
+            const linalg::vec<float,2> uv = mesh.texcoords.empty() ? linalg::vec<float,2>(0.0f) : mesh.texcoords[i];
+            vertices_[i] = {mesh.positions[i], mesh.normals.empty() ? linalg::vec<float,3>(0.0f) : mesh.normals[i], {uv.x, 1.0f - uv.y}};
+        }
+
+        const float aspect = static_cast<float>(job.width) / job.height;
+        const linalg::mat<float,4,4> projection = linalg::perspective_matrix(job.fov * std::numbers::pi_v<float> / 180.0f, aspect, job.near, job.far);
+        const MeshShader shader{
+            linalg::mul(projection, linalg::lookat_matrix(job.eye, job.target, job.up)),
+            linalg::normalize(job.eye - job.target),
+            work.texture.get(),
+            !mesh.normals.empty(),
+        };
+        if (work.texture && !mesh.texcoords.empty()) {
+            assign_lods(mesh, *work.texture, shader.view_projection, job.width, job.height);
+        }
+        const std::uint32_t background = pack_color(linalg::vec<float,4>(job.background, 1.0f));
+
+        work.pixels.resize(static_cast<std::size_t>(job.width) * job.height);
+        if (job.samples == 1) {
+            if (!framebuffer_ || framebuffer_->width() != job.width || framebuffer_->height() != job.height) {
+                framebuffer_.emplace(job.width, job.height, SurfaceLayout::tiled);
+            }
+            framebuffer_->clear(background);
+            pipeline_.draw(shader, vertices_, mesh.indices, *framebuffer_);
+            framebuffer_->resolve_color(work.pixels, &pool_);
+        } else {
+            if (!multisample_ || multisample_->width() != job.width || multisample_->height() != job.height || multisample_->samples() != job.samples) {
+                multisample_.emplace(job.width, job.height, job.samples, SurfaceLayout::tiled);
+            }
+            multisample_->clear(background);
+            pipeline_.draw(shader, vertices_, mesh.indices, *multisample_);
+            multisample_->resolve_color(work.pixels, &pool_);
+        }
+    }
+
+private:
+    // The shader has no screen-space derivatives, so every vertex gets the mean mip level of its triangles, from
+    // the ratio of texels to pixels covered (see Texture::lod()). Triangles crossing the eye plane are skipped.
+    void assign_lods(const Mesh & mesh, const Texture & texture, const linalg::mat<float,4,4> & view_projection, int width, int height) {
+        screen_.resize(vertices_.size());
+        for (std::size_t i = 0; i < vertices_.size(); ++i) {
+            const linalg::vec<float,4> clip = linalg::mul(view_projection, linalg::vec<float,4>(vertices_[i].position, 1.0f));
+            screen_[i] = {0.5f * width * (1.0f + clip.x / clip.w), 0.5f * height * (1.0f - clip.y / clip.w), clip.w};
+        }
+        lod_sums_.assign(vertices_.size(), 0.0f);
+        lod_counts_.assign(vertices_.size(), 0);
+
+        const float texels = static_cast<float>(texture.level(0).width) * texture.level(0).height;
+        for (std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+            const std::uint32_t a = mesh.indices[i], b = mesh.indices[i + 1], c = mesh.indices[i + 2];
+            if (std::max({a, b, c}) >= vertices_.size() || screen_[a].z <= 0.0f || screen_[b].z <= 0.0f || screen_[c].z <= 0.0f) {
+                continue;
+            }
+            const float pixel_area = std::abs(linalg::cross(screen_[b].xy() - screen_[a].xy(), screen_[c].xy() - screen_[a].xy()));
+            const float uv_area = std::abs(linalg::cross(vertices_[b].texcoord - vertices_[a].texcoord, vertices_[c].texcoord - vertices_[a].texcoord));
+            if (pixel_area <= 0.0f || uv_area <= 0.0f) {
+                continue;
+            }
+            // Half the log of the area ratio is the log of the edge length ratio
+            const float lod = 0.5f * std::log2(uv_area * texels / pixel_area);
+            for (std::uint32_t v : {a, b, c}) {
+                lod_sums_[v] += lod;
+                ++lod_counts_[v];
+            }
+        }
+        for (std::size_t i = 0; i < vertices_.size(); ++i) {
+            vertices_[i].lod = lod_counts_[i] ? lod_sums_[i] / static_cast<float>(lod_counts_[i]) : 0.0f;
+        }
+    }
+
+    ThreadPool & pool_;
+    Pipeline<MeshShader> pipeline_;
+    std::vector<MeshVertex> vertices_;
+    std::vector<linalg::vec<float,3>> screen_;     // pixel x, y and clip w of vertices_
+    std::vector<float> lod_sums_;
+    std::vector<std::uint32_t> lod_counts_;
+    std::optional<Framebuffer> framebuffer_;
+    std::optional<MultisampleFramebuffer> multisample_;
+};
+
+BatchRenderer::BatchRenderer(ThreadPool & pool, AssetCache & assets, Callback done, BatchOptions options)
+    : assets_(assets), done_(std::move(done)), renderer_(std::make_unique<Renderer>(pool)),
+      to_load_(options.queue_depth), to_render_(options.queue_depth), to_encode_(options.queue_depth), to_write_(options.queue_depth) {
+    threads_.emplace_back(&BatchRenderer::load_stage, this);
+    threads_.emplace_back(&BatchRenderer::render_stage, this);
+    threads_.emplace_back(&BatchRenderer::encode_stage, this);
+    threads_.emplace_back(&BatchRenderer::write_stage, this);
+}
+
+BatchRenderer::~BatchRenderer() {
+    // Each stage closes the next one's queue once its own is drained
+    to_load_.close();
+    for (std::thread & thread : threads_) {
+        thread.join();
+    }
+}
+
+std::uint64_t BatchRenderer::submit(RenderJob job) {
+    auto work = std::make_unique<Work>();
+    work->result.job = std::move(job);
+    // Held until the job is queued, so concurrent submitters queue jobs in sequence order. Not mutex_, which the
+    // write stage needs to report jobs while push() blocks on a full queue.
+    std::lock_guard submitting(submit_mutex_);
+    {
+        std::lock_guard lock(mutex_);
+        work->result.sequence = submitted_++;
+    }
+    const std::uint64_t sequence = work->result.sequence;
+    to_load_.push(std::move(work));
+    return sequence;
+}
+
+void BatchRenderer::wait() {
+    std::unique_lock lock(mutex_);
+    reported_.wait(lock, [&] { return completed_ == submitted_; });
+}
+
+void BatchRenderer::load_stage() {
+    while (std::optional<std::unique_ptr<Work>> work = to_load_.pop()) {
+        JobResult & result = (*work)->result;
+        const std::int64_t begin = Profiler::now();
+        try {
+            (*work)->mesh = assets_.mesh(result.job.mesh);
+            if (!result.job.texture.empty()) {
+                (*work)->texture = assets_.texture(result.job.texture);
+            }
+        } catch (const std::exception & error) {
+            result.error = error.what();
+        }
+        result.load_ns = Profiler::now() - begin;
+        to_render_.push(std::move(*work));
+    }
+    to_render_.close();
+}
+
+void BatchRenderer::render_stage() {
+    while (std::optional<std::unique_ptr<Work>> work = to_render_.pop()) {
+        JobResult & result = (*work)->result;
+        if (result.succeeded()) {
+            const std::int64_t begin = Profiler::now();
+            try {
+                renderer_->render(**work);
+            } catch (const std::exception & error) {
+                result.error = error.what();
+            }
+            result.render_ns = Profiler::now() - begin;
+        }
+        // Let the cache evict assets no later job uses
+        (*work)->mesh.reset();
+        (*work)->texture.reset();
+        to_encode_.push(std::move(*work));
+    }
+    to_encode_.close();
+}
+
+void BatchRenderer::encode_stage() {
+    while (std::optional<std::unique_ptr<Work>> work = to_encode_.pop()) {
+        Work & w = **work;
+        if (w.result.succeeded()) {
+            const std::int64_t begin = Profiler::now();
+            const RenderJob & job = w.result.job;
+            const ImageView image(reinterpret_cast<const std::uint8_t *>(w.pixels.data()), job.width, job.height, PixelFormat::bgra,
+                                  static_cast<std::ptrdiff_t>(job.width) * 4, 4);
+            try {
+                w.file = encode_tga(image, job.compression);
+            } catch (const std::exception & error) {
+                w.result.error = error.what();
+            }
+            w.pixels = {};
+            w.result.encode_ns = Profiler::now() - begin;
+        }
+        to_write_.push(std::move(*work));
+    }
+    to_write_.close();
+}
+
+void BatchRenderer::write_stage() {
+    while (std::optional<std::unique_ptr<Work>> work = to_write_.pop()) {
+        JobResult & result = (*work)->result;
+        if (result.succeeded()) {
+            const std::int64_t begin = Profiler::now();
+            try {
+                write_file(result.job.output, (*work)->file);
+            } catch (const std::exception & error) {
+                result.error = error.what();
+            }
+            result.write_ns = Profiler::now() - begin;
+        }
+        if (done_) {
+            done_(result);
+        }
+        std::lock_guard lock(mutex_);
+        ++completed_;
+        reported_.notify_all();
+    }
+}
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "asset_cache.hpp"
+#include "channel.hpp"
+#include "render_job.hpp"
+#include "thread_pool.hpp"
+
+namespace goob {
+
+// Outcome of a job, with the time it spent in each stage
+struct JobResult {
+    std::uint64_t sequence = 0;     // returned by BatchRenderer::submit()
+    RenderJob job;
+    std::string error;              // empty on success
+    std::int64_t load_ns = 0;
+    std::int64_t render_ns = 0;
+    std::int64_t encode_ns = 0;
+    std::int64_t write_ns = 0;
+
+    bool succeeded() const { return error.empty(); }
+};
+
+struct BatchOptions {
+    std::size_t queue_depth = 2;    // jobs waiting between two stages
+};
+
+// Renders jobs back to back in a four-stage pipeline: load (assets through the AssetCache), render (on the
+// thread pool), encode (TGA) and write. Each stage runs on its own thread and hands jobs to the next through a
+// bounded Channel, so while frame n is rendered frame n + 1 is loading and frame n - 1 is being encoded, and a
+// stall in one stage fills the queues in front of it rather than memory.
+//
+// Meshes are drawn with a headlight: Lambertian shading of the vertex normals (unlit when the mesh has none)
+// times the texture sampled trilinearly at the vertex texcoords, or light grey without a texture. The mip level
+// is estimated per vertex from the texel-to-pixel ratio of its triangles. Render targets are kept
+// between jobs of the same size.
+//
+// A failing job is reported with its error and the pipeline goes on. Results are reported by the write stage's
+// thread, one at a time and in submission order; the callback must not throw.
+class BatchRenderer {
+public:
+    using Callback = std::function<void(const JobResult &)>;
+
+    BatchRenderer(ThreadPool & pool, AssetCache & assets, Callback done, BatchOptions options = {});
+    // Finishes every submitted job
+    ~BatchRenderer();
+
+    BatchRenderer(const BatchRenderer &) = delete;
+    BatchRenderer & operator=(const BatchRenderer &) = delete;
+
+    // Queues a job, blocking while the load stage's queue is full. Returns the job's sequence number; jobs are
+    // processed in sequence order, also when several threads submit.
+    std::uint64_t submit(RenderJob job);
+
+    // Blocks until every submitted job was reported
+    void wait();
+
+private:
+    struct Work;
+    class Renderer;
+
+    void load_stage();
+    void render_stage();
+    void encode_stage();
+    void write_stage();
+
+    AssetCache & assets_;
+    Callback done_;
+    std::unique_ptr<Renderer> renderer_;
+
+    Channel<std::unique_ptr<Work>> to_load_;
+    Channel<std::unique_ptr<Work>> to_render_;
+    Channel<std::unique_ptr<Work>> to_encode_;
+    Channel<std::unique_ptr<Work>> to_write_;
+
+    std::mutex submit_mutex_;
+    std::mutex mutex_;
+    std::condition_variable reported_;
+    std::uint64_t submitted_ = 0;
+    std::uint64_t completed_ = 0;
+
+    std::vector<std::thread> threads_;
+};
+
+}
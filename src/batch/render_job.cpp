@@ -0,0 +1,173 @@
+#include "render_job.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace goob {
+
+namespace {
+    bool is_space(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    [[noreturn]] void fail(std::string_view key, std::string_view message) {
+        throw std::invalid_argument("Job key '" + std::string(key) + "': " + std::string(message));
+    }
+
+    template<class T>
+    T parse_number(std::string_view key, std::string_view text) {
+        T value{};
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error != std::errc() || end != text.data() + text.size()) {
+            fail(key, "expected a number, got '" + std::string(text) + "'");
+        }
+        return value;
+    }
+
+    linalg::vec<float,3> parse_vec3(std::string_view key, std::string_view text) {
+        linalg::vec<float,3> v;
+        for (int i = 0; i < 3; ++i) {
+            const std::size_t comma = text.find(',');
+            if ((comma == std::string_view::npos) != (i == 2)) {
+                fail(key, "expected three comma-separated numbers");
+            }
+            v[i] = parse_number<float>(key, text.substr(0, comma));
+            text.remove_prefix(comma == std::string_view::npos ? text.size() : comma + 1);
+        }
+        return v;
+    }
+
+    int parse_size(std::string_view key, std::string_view text) {
+        const int value = parse_number<int>(key, text);
+        if (value <= 0 || value > 16384) {
+            fail(key, "must be within [1, 16384]");
+        }
+        return value;
+    }
+}
+
+std::optional<RenderJob> parse_job(std::string_view line, const std::filesystem::path & base) {
+    RenderJob job;
+    bool any = false;
+    while (true) {
+        while (!line.empty() && is_space(line.front())) {
+            line.remove_prefix(1);
+        }
+        if (line.empty() || line.front() == '#') {
+            break;
+        }
+        const std::size_t end = static_cast<std::size_t>(std::find_if(line.begin(), line.end(), is_space) - line.begin());
+        const std::string_view pair = line.substr(0, end);
+        line.remove_prefix(end);
+
+        const std::size_t equals = pair.find('=');
+        if (equals == std::string_view::npos) {
+            fail(pair, "expected key=value");
+        }
+        const std::string_view key = pair.substr(0, equals), value = pair.substr(equals + 1);
+        const auto path = [&] {
+            if (value.empty()) {
+                fail(key, "expected a path");
+            }
+            return base / std::filesystem::path(value);
+        };
+
+        if (key == "mesh") {
+            job.mesh = path();
+        } else if (key == "texture") {
+            job.texture = path();
+        } else if (key == "output") {
+            job.output = path();
+        } else if (key == "width") {
+            job.width = parse_size(key, value);
+        } else if (key == "height") {
+            job.height = parse_size(key, value);
+        } else if (key == "samples") {
+            job.samples = parse_number<int>(key, value);
+            if (job.samples != 1 && job.samples != 2 && job.samples != 4 && job.samples != 8) {
+                fail(key, "must be 1, 2, 4 or 8");
+            }
+        } else if (key == "eye") {
+            job.eye = parse_vec3(key, value);
+        } else if (key == "target") {
+            job.target = parse_vec3(key, value);
+        } else if (key == "up") {
+            job.up = parse_vec3(key, value);
+        } else if (key == "fov") {
+            job.fov = parse_number<float>(key, value);
+            if (!(job.fov > 0.0f && job.fov < 180.0f)) {
+                fail(key, "must be within (0, 180) degrees");
+            }
+        } else if (key == "near") {
+            job.near = parse_number<float>(key, value);
+        } else if (key == "far") {
+            job.far = parse_number<float>(key, value);
+        } else if (key == "background") {
+            job.background = parse_vec3(key, value);
+        } else if (key == "compression") {
+            if (value == "rle") {
+                job.compression = TGACompression::rle;
+            } else if (value == "none") {
+                job.compression = TGACompression::none;
+            } else {
+                fail(key, "expected rle or none");
+            }
+        } else {
+            fail(key, "unknown key");
+        }
+        any = true;
+    }
+
+    if (!any) {
+        return std::nullopt;
+    }
+    if (job.mesh.empty()) {
+        fail("mesh", "missing");
+    }
+    if (job.output.empty()) {
+        fail("output", "missing");
+    }
+    if (!(job.near > 0.0f && job.near < job.far)) {
+        fail("near", "must be positive and below far");
+    }
+    return job;
+}
+
+JobSpool::JobSpool(std::filesystem::path directory) : directory_(std::move(directory)) {
+    if (!std::filesystem::is_directory(directory_)) {
+        throw std::runtime_error("Spool " + directory_.string() + " is not a directory");
+    }
+}
+
+std::optional<std::filesystem::path> JobSpool::claim() {
+    std::vector<std::filesystem::path> pending;
+    for (const std::filesystem::directory_entry & entry : std::filesystem::directory_iterator(directory_)) {
+        if (entry.path().extension() == ".job" && entry.is_regular_file()) {
+            pending.push_back(entry.path());
+        }
+    }
+    std::sort(pending.begin(), pending.end());
+    for (const std::filesystem::path & file : pending) {
+        std::filesystem::path claimed = file;
+        claimed += ".work";
+        // Fails when another service renamed the file first
+        std::error_code error;
+        std::filesystem::rename(file, claimed, error);
+        if (!error) {
+            return claimed;
+        }
+    }
+    return std::nullopt;
+}
+
+void JobSpool::finish(const std::filesystem::path & claimed, bool succeeded) {
+    std::filesystem::path done = claimed;
+    done.replace_extension(succeeded ? ".done" : ".failed");
+    std::filesystem::rename(claimed, done);
+}
+
+}
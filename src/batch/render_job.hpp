@@ -0,0 +1,59 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+#include "tga_image.hpp"
+#include "vector.hpp"
+
+namespace goob {
+
+// One frame of a batch: a mesh seen from a camera, written to a TGA file
+struct RenderJob {
+    std::filesystem::path mesh;         // OBJ file
+    std::filesystem::path texture;      // TGA file, none when empty
+    std::filesystem::path output;
+    int width = 512;
+    int height = 512;
+    int samples = 1;                    // 1, or 2, 4 or 8 for multisampling
+    linalg::vec<float,3> eye{0, 0, 3};
+    linalg::vec<float,3> target{0, 0, 0};
+    linalg::vec<float,3> up{0, 1, 0};
+    float fov = 60.0f;                  // vertical field of view in degrees
+    float near = 0.1f;
+    float far = 100.0f;
+    linalg::vec<float,3> background{0, 0, 0};
+    TGACompression compression = TGACompression::rle;
+};
+
+// Parses a job line of whitespace-separated key=value pairs, e.g.
+//
+//     mesh=head.obj texture=head.tga output=out/0001.tga width=800 height=600 eye=0,0.5,3 samples=4
+//
+// Keys are the RenderJob fields; vectors are comma-separated, compression is `rle` or `none`, and mesh and output
+// are required. Relative paths are taken relative to `base`. Returns nullopt for blank lines and comments (`#`).
+// Throws std::invalid_argument naming the offending key.
+std::optional<RenderJob> parse_job(std::string_view line, const std::filesystem::path & base = {});
+
+// A spool directory other processes drop jobs into as `*.job` files of job lines.
+//
+// claim() takes the pending file first by name and renames it to `<name>.work`, so several services can share a
+// spool without taking a file twice, and finish() renames the claimed file to `.done` or `.failed`. A file is only
+// claimed once its writer renamed it into place under the .job extension.
+class JobSpool {
+public:
+    // Throws std::runtime_error when `directory` is not a directory
+    explicit JobSpool(std::filesystem::path directory);
+
+    const std::filesystem::path & directory() const { return directory_; }
+
+    // Path of the claimed file, nullopt when none is pending
+    std::optional<std::filesystem::path> claim();
+    void finish(const std::filesystem::path & claimed, bool succeeded);
+
+private:
+    std::filesystem::path directory_;
+};
+
+}
@@ -0,0 +1,97 @@
+#include "arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace goob {
+
+namespace {
+    std::byte * align_up(std::byte * p, std::size_t alignment) {
+        const auto address = reinterpret_cast<std::uintptr_t>(p);
+        return p + ((alignment - address % alignment) % alignment);
+    }
+
+    // Keeps block payloads aligned for any fundamental type and cache-line friendly
+    constexpr std::size_t header_size = 64;
+}
+
+Arena::Arena(std::size_t block_size) : block_size_(std::max<std::size_t>(block_size, 256)) {
+}
+
+Arena::~Arena() {
+    for (Block * block = first_; block;) {
+        Block * next = block->next;
+        ::operator delete(block, std::align_val_t(header_size));
+        block = next;
+    }
+}
+
+void Arena::reset() {
+    current_ = first_;
+    cursor_ = first_ ? reinterpret_cast<std::byte *>(first_) + header_size : nullptr;
+    end_ = first_ ? cursor_ + first_->size : nullptr;
+    used_ = 0;
+}
+
+void * Arena::do_allocate(std::size_t bytes, std::size_t alignment) {
+    if (cursor_) {
+        std::byte * p = align_up(cursor_, alignment);
+        if (p <= end_ && bytes <= static_cast<std::size_t>(end_ - p)) {
+            cursor_ = p + bytes;
+            used_ += bytes;
+            return p;
+        }
+    }
+    return allocate_slow(bytes, alignment);
+}
+
+void * Arena::allocate_slow(std::size_t bytes, std::size_t alignment) {
+    // Later blocks of the chain are reused in order; the rest of a block too small for the request is skipped
+    const std::size_t needed = bytes + std::max<std::size_t>(alignment, header_size);
+    Block * previous = current_;
+    Block * block = current_ ? current_->next : first_;
+    while (block && block->size + header_size < needed) {
+        previous = block;
+        block = block->next;
+    }
+
+    if (!block) {
+        // Geometric growth keeps the chain short for workloads far above the initial block size
+        const std::size_t size = std::max({needed, block_size_, capacity_});
+        block = static_cast<Block *>(::operator new(size + header_size, std::align_val_t(header_size)));
+        block->next = nullptr;
+        block->size = size;
+        capacity_ += size;
+        ++block_allocations_;
+        if (previous) {
+            previous->next = block;
+        } else {
+            first_ = block;
+        }
+    }
+
+    current_ = block;
+    cursor_ = reinterpret_cast<std::byte *>(block) + header_size;
+    end_ = cursor_ + block->size;
+    std::byte * p = align_up(cursor_, alignment);
+    cursor_ = p + bytes;
+    used_ += bytes;
+    return p;
+}
+
+FrameArena::FrameArena(unsigned workers, std::size_t block_size) : frame_(block_size) {
+    workers_.reserve(workers);
+    for (unsigned i = 0; i < workers; ++i) {
+        workers_.push_back(std::make_unique<Arena>(block_size));
+    }
+}
+
+void FrameArena::reset() {
+    frame_.reset();
+    for (const std::unique_ptr<Arena> & worker : workers_) {
+        worker->reset();
+    }
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace goob {
+
+// Bump allocator for transient data.
+//
+// Allocations are carved out of a chain of blocks and never freed individually; reset() rewinds to the first
+// block in O(1) and keeps every block, so once a workload has run its peak footprint repeating it allocates
+// nothing from the heap. Usable directly or as a std::pmr::memory_resource for pmr containers, which must not
+// outlive the next reset(). Not thread-safe: use one arena per thread (see FrameArena).
+class Arena final : public std::pmr::memory_resource {
+public:
+    explicit Arena(std::size_t block_size = 64 * 1024);
+    ~Arena() override;
+
+    Arena(const Arena &) = delete;
+    Arena & operator=(const Arena &) = delete;
+
+    // Uninitialized storage for n objects of an implicit-lifetime type
+    template<class T>
+    std::span<T> allocate_array(std::size_t n) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena memory is released without running destructors");
+        return {static_cast<T *>(allocate(n * sizeof(T), alignof(T))), n};
+    }
+
+    void reset();
+
+    // Bytes handed out since the last reset and bytes held in blocks
+    std::size_t used() const { return used_; }
+    std::size_t capacity() const { return capacity_; }
+    // Number of blocks taken from the heap over the arena's lifetime
+    std::size_t block_allocations() const { return block_allocations_; }
+
+private:
+    struct Block {
+        Block * next;
+        std::size_t size;   // usable bytes after the header
+    };
+
+    void * do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void *, std::size_t, std::size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource & other) const noexcept override { return this == &other; }
+
+    void * allocate_slow(std::size_t bytes, std::size_t alignment);
+
+    std::size_t block_size_;
+    Block * first_ = nullptr;
+    Block * current_ = nullptr;
+    std::byte * cursor_ = nullptr;
+    std::byte * end_ = nullptr;
+    std::size_t used_ = 0;
+    std::size_t capacity_ = 0;
+    std::size_t block_allocations_ = 0;
+};
+
+// Arenas of one frame: a shared one for the thread recording the frame and one per thread pool worker
+// (indexed by the `worker` argument of ThreadPool::parallel_for). Everything is released at once by reset()
+// at the end of the frame.
+class FrameArena {
+public:
+    explicit FrameArena(unsigned workers, std::size_t block_size = 64 * 1024);
+
+    Arena & frame() { return frame_; }
+    Arena & worker(unsigned index) { return *workers_[index]; }
+    unsigned worker_count() const { return static_cast<unsigned>(workers_.size()); }
+
+    // O(number of workers)
+    void reset();
+
+private:
+    Arena frame_;
+    std::vector<std::unique_ptr<Arena>> workers_;   // separate allocations keep workers off each other's cache lines
+};
+
+}
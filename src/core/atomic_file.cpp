@@ -0,0 +1,42 @@
+#include "atomic_file.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+namespace goob {
+
+namespace {
+    // Temporary name next to `path`, distinct for every writer
+    std::filesystem::path temporary_path(const std::filesystem::path & path) {
+        static thread_local std::mt19937_64 rng{std::random_device{}()};
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), ".%016llx.tmp", static_cast<unsigned long long>(rng()));
+        std::filesystem::path temporary = path;
+        temporary += suffix;
+        return temporary;
+    }
+}
+
+void write_file_atomic(const std::filesystem::path & path, std::span<const std::uint8_t> bytes) {
+    const std::filesystem::path temporary = temporary_path(path);
+    try {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        // Closing flushes the buffered tail, whose write errors (a full disk) only show up here
+        out.close();
+        if (!out) {
+            throw std::runtime_error("Cannot write " + path.string());
+        }
+        std::filesystem::rename(temporary, path);
+    } catch (...) {
+        std::error_code ignored;
+        std::filesystem::remove(temporary, ignored);
+        throw;
+    }
+}
+
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+namespace goob {
+
+// Writes `bytes` to a temporary next to `path` and renames it into place, so readers see the old file or the
+// whole new one, never a partial write. Every call uses its own temporary name, so processes writing the same
+// path concurrently do not clobber each other's data; the last rename wins. On failure the temporary is removed
+// and std::runtime_error, or std::filesystem::filesystem_error from the rename, is thrown.
+void write_file_atomic(const std::filesystem::path & path, std::span<const std::uint8_t> bytes);
+
+}
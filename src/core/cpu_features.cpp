@@ -0,0 +1,84 @@
+#include "cpu_features.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+#if defined(_MSC_VER) && defined(GOOB_X86)
+#include <intrin.h>
+#endif
+
+namespace goob {
+
+namespace {
+    SimdLevel detect() {
+#if defined(GOOB_X86) && (defined(__GNUC__) || defined(__clang__))
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+            return SimdLevel::avx512;
+        }
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c")) {
+            return SimdLevel::avx2;
+        }
+        return SimdLevel::sse2;
+#elif defined(GOOB_X86) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        const bool f16c = (info[2] & (1 << 29)) != 0;
+        __cpuidex(info, 7, 0);
+        const bool avx2 = f16c && (info[1] & (1 << 5)) != 0;
+        const bool avx512 = (info[1] & (1 << 16)) != 0 && (info[1] & (1 << 30)) != 0;
+        // The OS has to preserve the wide registers across context switches
+        const unsigned long long xcr0 = _xgetbv(0);
+        if (avx512 && (xcr0 & 0xe6) == 0xe6) {
+            return SimdLevel::avx512;
+        }
+        if (avx2 && (xcr0 & 0x6) == 0x6) {
+            return SimdLevel::avx2;
+        }
+        return SimdLevel::sse2;
+#else
+        return SimdLevel::scalar;
+#endif
+    }
+
+    SimdLevel hardware_level() {
+        static const SimdLevel level = detect();
+        return level;
+    }
+
+    SimdLevel requested_level() {
+        const SimdLevel hardware = hardware_level();
+        const char * env = std::getenv("GOOB_SIMD");
+        if (!env) {
+            return hardware;
+        }
+        for (SimdLevel level : {SimdLevel::scalar, SimdLevel::sse2, SimdLevel::avx2, SimdLevel::avx512}) {
+            if (std::strcmp(env, to_string(level)) == 0) {
+                return level < hardware ? level : hardware;
+            }
+        }
+        return hardware;
+    }
+}
+
+SimdLevel simd_level() {
+    static const SimdLevel level = requested_level();
+    return level;
+}
+
+bool simd_supported(SimdLevel level) {
+    return level <= hardware_level();
+}
+
+const char * to_string(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::scalar: return "scalar";
+        case SimdLevel::sse2:   return "sse2";
+        case SimdLevel::avx2:   return "avx2";
+        case SimdLevel::avx512: return "avx512";
+    }
+    return "unknown";
+}
+
+}
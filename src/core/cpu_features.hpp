@@ -0,0 +1,40 @@
+#pragma once
+
+// Helpers for selecting SIMD code paths at runtime. Kernels for wider instruction sets are compiled with
+// per-function target attributes so the rest of the build keeps the baseline ISA.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define GOOB_X86 1
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define GOOB_TARGET(isa) __attribute__((target(isa)))
+#else
+#define GOOB_TARGET(isa)
+#endif
+
+// GCC 12's AVX-512 headers build pass-through operands from self-initialized variables, which optimized builds
+// report as maybe-uninitialized once the intrinsics are inlined. AVX-512 kernels sit between these two.
+#if defined(__GNUC__) && !defined(__clang__)
+#define GOOB_AVX512_WARNINGS_PUSH _Pragma("GCC diagnostic push") _Pragma("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+#define GOOB_AVX512_WARNINGS_POP _Pragma("GCC diagnostic pop")
+#else
+#define GOOB_AVX512_WARNINGS_PUSH
+#define GOOB_AVX512_WARNINGS_POP
+#endif
+
+namespace goob {
+
+// Instruction set levels with dedicated kernels, ordered from least to most capable
+enum class SimdLevel { scalar, sse2, avx2, avx512 };
+
+// Highest level supported by the CPU, optionally capped by the GOOB_SIMD environment variable
+// (scalar, sse2, avx2 or avx512). Detected once and cached.
+SimdLevel simd_level();
+
+// Whether code for `level` can run on this CPU; ignores GOOB_SIMD
+bool simd_supported(SimdLevel level);
+
+const char * to_string(SimdLevel level);
+
+}
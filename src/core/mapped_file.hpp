@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+namespace goob {
+
+// Read-only memory mapping of a whole file. Move-only; the mapping is released on destruction.
+class MappedFile {
+public:
+    MappedFile() = default;
+    // Throws std::runtime_error when the file cannot be opened or mapped
+    explicit MappedFile(const std::filesystem::path & path);
+    ~MappedFile();
+
+    MappedFile(MappedFile && other) noexcept;
+    MappedFile & operator=(MappedFile && other) noexcept;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile & operator=(const MappedFile &) = delete;
+
+    const std::uint8_t * data() const { return data_; }
+    std::size_t size() const { return size_; }
+    std::span<const std::uint8_t> bytes() const { return {data_, size_}; }
+    bool empty() const { return size_ == 0; }
+
+private:
+    void close();
+
+    const std::uint8_t * data_ = nullptr;
+    std::size_t size_ = 0;
+#ifdef _WIN32
+    void * mapping_ = nullptr;
+#endif
+};
+
+}
@@ -0,0 +1,117 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+namespace goob {
+
+namespace {
+    constexpr const char * stage_names[stage_count] = {"vertex", "clip", "cull", "bin", "raster", "shade", "resolve"};
+    constexpr const char * counter_names[counter_count] = {
+        "vertices_shaded", "triangles_in", "triangles_culled", "fragments_shaded", "fragments_killed", "pixels_resolved",
+    };
+
+    // Trace timestamps are microseconds relative to the first kept frame. They are negative for intervals that
+    // began before it, e.g. a stage scope opened before begin_frame().
+    void write_time(std::ostream & out, std::int64_t ns) {
+        const std::uint64_t magnitude = ns < 0 ? 0 - static_cast<std::uint64_t>(ns) : static_cast<std::uint64_t>(ns);
+        if (ns < 0) {
+            out << '-';
+        }
+        out << magnitude / 1000 << '.' << static_cast<char>('0' + magnitude / 100 % 10) << static_cast<char>('0' + magnitude / 10 % 10)
+            << static_cast<char>('0' + magnitude % 10);
+    }
+
+    void write_slice(std::ostream & out, const char * name, std::int64_t begin_ns, std::int64_t duration_ns, std::uint64_t frame) {
+        out << "{\"name\":\"" << name << "\",\"cat\":\"goob\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":";
+        write_time(out, begin_ns);
+        out << ",\"dur\":";
+        write_time(out, duration_ns);
+        out << ",\"args\":{\"frame\":" << frame << "}}";
+    }
+}
+
+const char * to_string(Stage stage) {
+    return stage_names[static_cast<std::size_t>(stage)];
+}
+
+const char * to_string(Counter counter) {
+    return counter_names[static_cast<std::size_t>(counter)];
+}
+
+Profiler::Profiler(unsigned threads, std::size_t max_events)
+    : slots_(std::max(1u, threads)) {
+    events_.reserve(std::max<std::size_t>(1, max_events));
+    last_.thread_counters.resize(slots_.size());
+}
+
+void Profiler::begin_frame() {
+    for (Slot & slot : slots_) {
+        slot.counters = {};
+    }
+    events_.clear();
+    frame_begin_ = now();
+}
+
+const FrameStats & Profiler::end_frame() {
+    const std::int64_t end = now();
+    last_.frame = frame_++;
+    last_.begin_ns = frame_begin_;
+    last_.duration_ns = end - frame_begin_;
+    last_.stage_ns = {};
+    for (const Event & event : events_) {
+        last_.stage_ns[static_cast<std::size_t>(event.stage)] += event.end_ns - event.begin_ns;
+    }
+    last_.counters = {};
+    for (std::size_t thread = 0; thread < slots_.size(); ++thread) {
+        last_.thread_counters[thread] = slots_[thread].counters;
+        for (std::size_t c = 0; c < counter_count; ++c) {
+            last_.counters[c] += slots_[thread].counters[c];
+        }
+    }
+    if (tracing_) {
+        trace_.push_back({last_, events_});
+    }
+    return last_;
+}
+
+void Profiler::clear_trace() {
+    trace_.clear();
+}
+
+void Profiler::write_chrome_trace(std::ostream & out) const {
+    const std::int64_t origin = trace_.empty() ? 0 : trace_.front().stats.begin_ns;
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"frame\"}}";
+    for (const TracedFrame & traced : trace_) {
+        const FrameStats & stats = traced.stats;
+        out << ",\n";
+        write_slice(out, "frame", stats.begin_ns - origin, stats.duration_ns, stats.frame);
+        for (const Event & event : traced.events) {
+            out << ",\n";
+            write_slice(out, to_string(event.stage), event.begin_ns - origin, event.end_ns - event.begin_ns, stats.frame);
+        }
+        out << ",\n{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"ts\":";
+        write_time(out, stats.begin_ns - origin);
+        out << ",\"args\":{";
+        for (std::size_t c = 0; c < counter_count; ++c) {
+            out << (c ? "," : "") << '"' << counter_names[c] << "\":" << stats.counters[c];
+        }
+        out << "}}";
+    }
+    out << "\n]}\n";
+}
+
+void Profiler::write_chrome_trace(const std::filesystem::path & path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open trace file " + path.string());
+    }
+    write_chrome_trace(file);
+    if (!file.flush()) {
+        throw std::runtime_error("Cannot write trace file " + path.string());
+    }
+}
+
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <vector>
+
+// Instrumentation is compiled in unless the build sets GOOB_ENABLE_STATS=0 (CMake option GOOB_ENABLE_STATS), in
+// which case the GOOB_PROFILE_* macros expand to nothing and a Profiler only ever reports empty frames
+#ifndef GOOB_ENABLE_STATS
+#define GOOB_ENABLE_STATS 1
+#endif
+
+namespace goob {
+
+// Stages of a frame, timed on the thread driving them
+enum class Stage : std::uint8_t {
+    vertex,     // vertex shading
+    clip,       // primitive assembly and clipping
+    cull,       // triangle culling and setup
+    bin,        // sorting triangles into screen tiles
+    raster,     // coverage, depth test and forward shading
+    shade,      // deferred lighting
+    resolve,    // visibility-buffer shading and sample resolves
+};
+constexpr std::size_t stage_count = 7;
+
+// Work counters, kept per thread
+enum class Counter : std::uint8_t {
+    vertices_shaded,
+    triangles_in,       // submitted to the rasterizer
+    triangles_culled,   // rejected by the cull kernel
+    fragments_shaded,   // passed the depth test and written
+    fragments_killed,   // rejected by the depth test or hierarchical Z
+    pixels_resolved,    // shaded by a deferred lighting or visibility resolve pass
+};
+constexpr std::size_t counter_count = 6;
+
+const char * to_string(Stage stage);
+const char * to_string(Counter counter);
+
+// Statistics of one frame, from begin_frame() to end_frame()
+struct FrameStats {
+    std::uint64_t frame = 0;
+    std::int64_t begin_ns = 0;
+    std::int64_t duration_ns = 0;
+    std::array<std::int64_t, stage_count> stage_ns{};       // wall time spent in each stage
+    std::array<std::uint64_t, counter_count> counters{};    // summed over threads
+    std::vector<std::array<std::uint64_t, counter_count>> thread_counters;
+
+    std::int64_t time(Stage stage) const { return stage_ns[static_cast<std::size_t>(stage)]; }
+    std::uint64_t count(Counter counter) const { return counters[static_cast<std::size_t>(counter)]; }
+};
+
+// Frame statistics and tracing for the renderer.
+//
+// Counters live in one cache-line-aligned slot per thread and are written without synchronization: thread i of
+// a pool only touches slot i (the `worker` of ThreadPool::parallel_for). Stage intervals are appended to a
+// preallocated buffer by the thread recording the frame; intervals beyond its capacity are dropped and counted.
+// end_frame() merges everything into a FrameStats, so the hot paths never lock, and allocate nothing unless
+// tracing keeps the frames for write_chrome_trace().
+class Profiler {
+public:
+    // `threads` counter slots, at least the size of the pools reporting into it
+    explicit Profiler(unsigned threads, std::size_t max_events = 1024);
+
+    unsigned threads() const { return static_cast<unsigned>(slots_.size()); }
+
+    void begin_frame();
+    // Merges the per-thread data of the frame; the result stays valid until the next end_frame()
+    const FrameStats & end_frame();
+    const FrameStats & last_frame() const { return last_; }
+
+    void count(unsigned thread, Counter counter, std::uint64_t n) {
+        slots_[thread].counters[static_cast<std::size_t>(counter)] += n;
+    }
+
+    // Records a stage interval from the thread recording the frame
+    void record(Stage stage, std::int64_t begin_ns, std::int64_t end_ns) {
+        if (events_.size() == events_.capacity()) {
+            ++dropped_events_;
+            return;
+        }
+        events_.push_back({stage, begin_ns, end_ns});
+    }
+    std::uint64_t dropped_events() const { return dropped_events_; }
+
+    // While enabled, ended frames and their stage intervals are kept for write_chrome_trace()
+    void set_tracing(bool enabled) { tracing_ = enabled; }
+    bool tracing() const { return tracing_; }
+    void clear_trace();
+
+    // Writes the kept frames in the Chrome trace event format (chrome://tracing, Perfetto): one track of frame and
+    // stage slices and one counter track per frame. Throws std::runtime_error when the file cannot be written.
+    void write_chrome_trace(std::ostream & out) const;
+    void write_chrome_trace(const std::filesystem::path & path) const;
+
+    // Nanoseconds on the steady clock
+    static std::int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::array<std::uint64_t, counter_count> counters{};
+    };
+
+    struct Event {
+        Stage stage;
+        std::int64_t begin_ns;
+        std::int64_t end_ns;
+    };
+
+    struct TracedFrame {
+        FrameStats stats;
+        std::vector<Event> events;
+    };
+
+    std::vector<Slot> slots_;
+    std::vector<Event> events_;
+    std::uint64_t dropped_events_ = 0;
+    std::uint64_t frame_ = 0;
+    std::int64_t frame_begin_ = 0;
+    FrameStats last_;
+    bool tracing_ = false;
+    std::vector<TracedFrame> trace_;
+};
+
+// Records the lifetime of the scope as a stage of the profiler's frame; does nothing without a profiler
+class StageScope {
+public:
+    StageScope(Profiler * profiler, Stage stage) : profiler_(profiler), stage_(stage), begin_(profiler ? Profiler::now() : 0) {}
+    ~StageScope() {
+        if (profiler_) {
+            profiler_->record(stage_, begin_, Profiler::now());
+        }
+    }
+
+    StageScope(const StageScope &) = delete;
+    StageScope & operator=(const StageScope &) = delete;
+
+private:
+    Profiler * profiler_;
+    Stage stage_;
+    std::int64_t begin_;
+};
+
+}
+
+#define GOOB_PROFILE_CONCAT_(a, b) a##b
+#define GOOB_PROFILE_CONCAT(a, b) GOOB_PROFILE_CONCAT_(a, b)
+
+#if GOOB_ENABLE_STATS
+// Times the rest of the enclosing scope as `stage` of a Profiler * (which may be null)
+#define GOOB_PROFILE_STAGE(profiler, stage) \
+    const ::goob::StageScope GOOB_PROFILE_CONCAT(goob_stage_scope_, __LINE__)((profiler), ::goob::Stage::stage)
+// Adds n to `counter` of a Profiler * (which may be null) in the slot of `thread`
+#define GOOB_PROFILE_COUNT(profiler, thread, counter, n) \
+    do { if (::goob::Profiler * goob_profiler_ = (profiler)) goob_profiler_->count((thread), ::goob::Counter::counter, (n)); } while (false)
+#else
+#define GOOB_PROFILE_STAGE(profiler, stage) static_cast<void>(0)
+#define GOOB_PROFILE_COUNT(profiler, thread, counter, n) static_cast<void>(0)
+#endif
@@ -0,0 +1,149 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+namespace goob {
+
+namespace {
+    // Pool and participant index of the job this thread is executing; null outside of jobs. Jobs of another pool
+    // started from inside a job nest, so the previous values are restored when the inner job ends.
+    thread_local const ThreadPool * tls_pool = nullptr;
+    thread_local unsigned tls_worker = 0;
+
+    class JobScope {
+    public:
+        JobScope(const ThreadPool * pool, unsigned worker) : pool_(tls_pool), worker_(tls_worker) {
+            tls_pool = pool;
+            tls_worker = worker;
+        }
+        ~JobScope() {
+            tls_pool = pool_;
+            tls_worker = worker_;
+        }
+
+        JobScope(const JobScope &) = delete;
+        JobScope & operator=(const JobScope &) = delete;
+
+    private:
+        const ThreadPool * pool_;
+        unsigned worker_;
+    };
+}
+
+ThreadPool::ThreadPool(unsigned thread_count)
+    : slots_(std::max(1u, thread_count)) {
+    threads_.reserve(slots_.size() - 1);
+    for (unsigned i = 1; i < slots_.size(); ++i) {
+        threads_.emplace_back([this, i] { worker_main(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto & thread : threads_) {
+        thread.join();
+    }
+}
+
+unsigned ThreadPool::current_worker() {
+    return tls_pool ? tls_worker : 0;
+}
+
+void ThreadPool::run(std::size_t count, void * ctx, Invoke invoke) {
+    if (count == 0) {
+        return;
+    }
+
+    // Nested job of this pool or single participant: there is nobody to hand work to. A job running on another
+    // pool's worker submits normally, since that worker's index means nothing here.
+    if (tls_pool == this || slots_.size() == 1) {
+        const unsigned worker = tls_pool == this ? tls_worker : 0;
+        const JobScope scope(this, worker);
+        for (std::size_t i = 0; i < count; ++i) {
+            invoke(ctx, i, worker);
+        }
+        return;
+    }
+
+    std::lock_guard submit(submit_mutex_);
+
+    const std::size_t participants = slots_.size();
+    for (std::size_t s = 0; s < participants; ++s) {
+        slots_[s].next.store(count * s / participants, std::memory_order_relaxed);
+        slots_[s].end = count * (s + 1) / participants;
+    }
+    ctx_ = ctx;
+    invoke_ = invoke;
+    error_ = nullptr;
+    busy_.store(static_cast<unsigned>(threads_.size()), std::memory_order_relaxed);
+
+    {
+        std::lock_guard lock(wake_mutex_);
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    {
+        const JobScope scope(this, 0);
+        work(0);
+    }
+
+    // Workers still touch the slots until they run out of indices to steal
+    for (unsigned busy = busy_.load(std::memory_order_acquire); busy != 0; busy = busy_.load(std::memory_order_acquire)) {
+        busy_.wait(busy, std::memory_order_acquire);
+    }
+
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
+
+void ThreadPool::work(unsigned worker) {
+    const std::size_t participants = slots_.size();
+    for (std::size_t k = 0; k < participants; ++k) {
+        Slot & slot = slots_[(worker + k) % participants];
+        for (;;) {
+            const std::size_t index = slot.next.fetch_add(1, std::memory_order_relaxed);
+            if (index >= slot.end) {
+                break;
+            }
+            try {
+                invoke_(ctx_, index, worker);
+            } catch (...) {
+                std::lock_guard lock(error_mutex_);
+                if (!error_) {
+                    error_ = std::current_exception();
+                }
+            }
+        }
+    }
+}
+
+void ThreadPool::worker_main(unsigned worker) {
+    std::uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock lock(wake_mutex_);
+            wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+            if (stopping_) {
+                return;
+            }
+            seen = generation_;
+        }
+
+        {
+            const JobScope scope(this, worker);
+            work(worker);
+        }
+
+        if (busy_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            busy_.notify_all();
+        }
+    }
+}
+
+}
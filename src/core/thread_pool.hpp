@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace goob {
+
+// Fixed-size pool of worker threads executing index-space jobs.
+//
+// A job is split into one contiguous index range per participant (the workers plus the calling
+// thread). Every participant drains its own range first and then steals indices from the ranges
+// of the others, so uneven work (e.g. screen tiles with very different triangle counts) balances
+// itself without a central queue. Submitting a job does not allocate.
+class ThreadPool {
+public:
+    // `thread_count` is the total number of participants including the caller of parallel_for()
+    explicit ThreadPool(unsigned thread_count = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool & operator=(const ThreadPool &) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(slots_.size()); }
+
+    // Calls body(index, worker) for every index in [0, count) and blocks until all calls returned.
+    // `worker` is in [0, size()) and identifies the participant, so callers can keep per-worker
+    // scratch data without locking. Nested calls from inside a job of this pool run serially on the calling
+    // worker; calls from a job of another pool are submitted like any other.
+    // The first exception thrown by `body` is rethrown here once the job has drained.
+    template<class F>
+    void parallel_for(std::size_t count, F && body) {
+        using Body = std::remove_reference_t<F>;
+        run(count, const_cast<void *>(static_cast<const void *>(std::addressof(body))),
+            [](void * ctx, std::size_t index, unsigned worker) { (*static_cast<Body *>(ctx))(index, worker); });
+    }
+
+    // Index of the participant executing the innermost job on this thread, within that job's pool; 0 outside of jobs
+    static unsigned current_worker();
+
+private:
+    using Invoke = void (*)(void *, std::size_t, unsigned);
+
+    struct alignas(64) Slot {
+        std::atomic<std::size_t> next{0};
+        std::size_t end = 0;
+    };
+
+    void run(std::size_t count, void * ctx, Invoke invoke);
+    void work(unsigned worker);
+    void worker_main(unsigned worker);
+
+    std::vector<Slot> slots_;
+    std::vector<std::thread> threads_;
+
+    std::mutex submit_mutex_;   // serializes jobs submitted from different external threads
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::uint64_t generation_ = 0;
+    bool stopping_ = false;
+
+    void * ctx_ = nullptr;
+    Invoke invoke_ = nullptr;
+    std::atomic<unsigned> busy_{0};
+
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+};
+
+}
@@ -0,0 +1,326 @@
+#include "texture.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "cpu_features.hpp"
+#include "thread_pool.hpp"
+
+#ifdef GOOB_X86
+#include <immintrin.h>
+#endif
+
+namespace goob {
+
+namespace {
+    constexpr float inv255 = 1.0f / 255.0f;
+
+    template<class F>
+    void for_each_row(int height, ThreadPool * pool, F && body) {
+        if (pool) {
+            pool->parallel_for(static_cast<std::size_t>(height), [&](std::size_t y, unsigned) { body(static_cast<int>(y)); });
+        } else {
+            for (int y = 0; y < height; ++y) {
+                body(y);
+            }
+        }
+    }
+
+    // Channels of a packed texel as RGBA in [0,255]
+    linalg::vec<float,4> unpack(std::uint32_t c) {
+        return {float((c >> 16) & 0xff), float((c >> 8) & 0xff), float(c & 0xff), float(c >> 24)};
+    }
+
+    std::uint32_t average(std::uint32_t a, std::uint32_t b, std::uint32_t c, std::uint32_t d) {
+        std::uint32_t result = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            const std::uint32_t sum = ((a >> shift) & 0xff) + ((b >> shift) & 0xff) + ((c >> shift) & 0xff) + ((d >> shift) & 0xff);
+            result |= ((sum + 2) >> 2) << shift;
+        }
+        return result;
+    }
+
+    linalg::vec<float,4> lerp(const linalg::vec<float,4> & a, const linalg::vec<float,4> & b, float t) {
+        return a + (b - a) * t;
+    }
+
+    // The two texels around texture coordinate t along an axis of `size` texels and the weight of the second
+    struct Axis {
+        int i0, i1;
+        float f;
+    };
+
+    // Texel coordinate `x` wrapped or clamped into [0,size]; NaN, also from wrapping infinity, becomes 0 as in wrap8()
+    float wrap_coordinate(float x, float size, TextureWrap wrap) {
+        if (wrap == TextureWrap::repeat) {
+            // Rounding can leave the wrapped value a hair below zero
+            x -= size * std::floor(x / size);
+            return x > 0.0f ? x : 0.0f;
+        }
+        return std::min(x > 0.0f ? x : 0.0f, size - 1.0f);
+    }
+
+    Axis bilinear_axis(float t, int size, TextureWrap wrap) {
+        const float s = static_cast<float>(size);
+        const float x = wrap_coordinate(t * s - 0.5f, s, wrap);
+        const float base = std::floor(x);
+        Axis axis{std::min(static_cast<int>(base), size - 1), 0, x - base};
+        axis.i1 = axis.i0 + 1;
+        axis.i1 = wrap == TextureWrap::repeat ? (axis.i1 == size ? 0 : axis.i1) : std::min(axis.i1, size - 1);
+        return axis;
+    }
+
+    int nearest_axis(float t, int size, TextureWrap wrap) {
+        const float s = static_cast<float>(size);
+        const float x = wrap_coordinate(t * s, s, wrap);
+        return std::min(static_cast<int>(x), size - 1);
+    }
+
+    // Unscaled [0,255] results, so the batch kernels can round the same way
+    linalg::vec<float,4> nearest(const Texture & texture, TextureWrap wrap, int level, const linalg::vec<float,2> & uv) {
+        const Texture::Level & l = texture.level(level);
+        return unpack(texture.texel(level, nearest_axis(uv.x, l.width, wrap), nearest_axis(uv.y, l.height, wrap)));
+    }
+
+    linalg::vec<float,4> bilinear(const Texture & texture, TextureWrap wrap, int level, const linalg::vec<float,2> & uv) {
+        const Texture::Level & l = texture.level(level);
+        const Axis x = bilinear_axis(uv.x, l.width, wrap), y = bilinear_axis(uv.y, l.height, wrap);
+        const linalg::vec<float,4> top = lerp(unpack(texture.texel(level, x.i0, y.i0)), unpack(texture.texel(level, x.i1, y.i0)), x.f);
+        const linalg::vec<float,4> bottom = lerp(unpack(texture.texel(level, x.i0, y.i1)), unpack(texture.texel(level, x.i1, y.i1)), x.f);
+        return lerp(top, bottom, y.f);
+    }
+
+    float clamp_lod(float lod, int levels) {
+        // NaN selects the base level
+        return std::min(lod > 0.0f ? lod : 0.0f, static_cast<float>(levels - 1));
+    }
+
+    linalg::vec<float,4> sample_scalar(const Texture & texture, const Sampler & sampler, const linalg::vec<float,2> & uv, float lod) {
+        lod = clamp_lod(lod, texture.level_count());
+        switch (sampler.filter) {
+            case TextureFilter::nearest:
+                return nearest(texture, sampler.wrap, static_cast<int>(lod + 0.5f), uv) * inv255;
+            case TextureFilter::bilinear:
+                return bilinear(texture, sampler.wrap, static_cast<int>(lod + 0.5f), uv) * inv255;
+            case TextureFilter::trilinear: {
+                const int l0 = static_cast<int>(lod);
+                const int l1 = std::min(l0 + 1, texture.level_count() - 1);
+                const float t = lod - static_cast<float>(l0);
+                return lerp(bilinear(texture, sampler.wrap, l0, uv), bilinear(texture, sampler.wrap, l1, uv), t) * inv255;
+            }
+        }
+        return {};
+    }
+
+    using BatchSampler = void (*)(const Texture &, const Sampler &, SoaConstSpan<2>, std::span<const float>, SoaSpan<4>, std::size_t);
+
+    void sample_batch_scalar(const Texture & texture, const Sampler & sampler, SoaConstSpan<2> uv, std::span<const float> lod, SoaSpan<4> out, std::size_t begin) {
+        for (std::size_t i = begin; i < uv.size; ++i) {
+            out.set(i, sample_scalar(texture, sampler, uv.get(i), lod[i]));
+        }
+    }
+
+#ifdef GOOB_X86
+    struct Color8 {
+        __m256 c[4];
+    };
+
+    // Per-lane level parameters, gathered from small tables
+    struct Levels8 {
+        __m256i width, height, blocks_x, offset;
+    };
+
+    struct LevelTables {
+        alignas(32) std::int32_t width[32], height[32], blocks_x[32], offset[32];
+    };
+
+    GOOB_TARGET("avx2")
+    Levels8 gather_levels(const LevelTables & t, __m256i level) {
+        return {_mm256_i32gather_epi32(t.width, level, 4), _mm256_i32gather_epi32(t.height, level, 4),
+                _mm256_i32gather_epi32(t.blocks_x, level, 4), _mm256_i32gather_epi32(t.offset, level, 4)};
+    }
+
+    GOOB_TARGET("avx2")
+    __m256 wrap8(__m256 x, __m256 size, TextureWrap wrap) {
+        if (wrap == TextureWrap::repeat) {
+            // Rounding can leave the wrapped value a hair below zero
+            return _mm256_max_ps(_mm256_sub_ps(x, _mm256_mul_ps(size, _mm256_floor_ps(_mm256_div_ps(x, size)))), _mm256_setzero_ps());
+        }
+        return _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()), _mm256_sub_ps(size, _mm256_set1_ps(1.0f)));
+    }
+
+    GOOB_TARGET("avx2")
+    void bilinear_axis8(__m256 t, __m256i size, TextureWrap wrap, __m256i & i0, __m256i & i1, __m256 & f) {
+        const __m256 s = _mm256_cvtepi32_ps(size);
+        const __m256 x = wrap8(_mm256_sub_ps(_mm256_mul_ps(t, s), _mm256_set1_ps(0.5f)), s, wrap);
+        const __m256 base = _mm256_floor_ps(x);
+        const __m256i last = _mm256_sub_epi32(size, _mm256_set1_epi32(1));
+        f = _mm256_sub_ps(x, base);
+        i0 = _mm256_min_epi32(_mm256_cvttps_epi32(base), last);
+        i1 = _mm256_add_epi32(i0, _mm256_set1_epi32(1));
+        i1 = wrap == TextureWrap::repeat ? _mm256_andnot_si256(_mm256_cmpeq_epi32(i1, size), i1) : _mm256_min_epi32(i1, last);
+    }
+
+    GOOB_TARGET("avx2")
+    __m256i nearest_axis8(__m256 t, __m256i size, TextureWrap wrap) {
+        const __m256 s = _mm256_cvtepi32_ps(size);
+        const __m256 x = wrap8(_mm256_mul_ps(t, s), s, wrap);
+        return _mm256_min_epi32(_mm256_cvttps_epi32(x), _mm256_sub_epi32(size, _mm256_set1_epi32(1)));
+    }
+
+    GOOB_TARGET("avx2")
+    __m256i fetch8(const std::uint32_t * texels, const Levels8 & l, __m256i x, __m256i y) {
+        const __m256i three = _mm256_set1_epi32(3);
+        const __m256i block = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_srli_epi32(y, 2), l.blocks_x), _mm256_srli_epi32(x, 2));
+        __m256i index = _mm256_add_epi32(l.offset, _mm256_slli_epi32(block, 4));
+        index = _mm256_add_epi32(index, _mm256_add_epi32(_mm256_slli_epi32(_mm256_and_si256(y, three), 2), _mm256_and_si256(x, three)));
+        return _mm256_i32gather_epi32(reinterpret_cast<const int *>(texels), index, 4);
+    }
+
+    GOOB_TARGET("avx2")
+    Color8 unpack8(__m256i t) {
+        const __m256i byte = _mm256_set1_epi32(0xff);
+        return {{_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(t, 16), byte)),
+                 _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(t, 8), byte)),
+                 _mm256_cvtepi32_ps(_mm256_and_si256(t, byte)),
+                 _mm256_cvtepi32_ps(_mm256_srli_epi32(t, 24))}};
+    }
+
+    GOOB_TARGET("avx2")
+    __m256 lerp8(__m256 a, __m256 b, __m256 t) {
+        return _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), t));
+    }
+
+    GOOB_TARGET("avx2")
+    Color8 nearest8(const Texture & texture, TextureWrap wrap, const Levels8 & l, __m256 u, __m256 v) {
+        return unpack8(fetch8(texture.texels(), l, nearest_axis8(u, l.width, wrap), nearest_axis8(v, l.height, wrap)));
+    }
+
+    GOOB_TARGET("avx2")
+    Color8 bilinear8(const Texture & texture, TextureWrap wrap, const Levels8 & l, __m256 u, __m256 v) {
+        __m256i x0, x1, y0, y1;
+        __m256 fx, fy;
+        bilinear_axis8(u, l.width, wrap, x0, x1, fx);
+        bilinear_axis8(v, l.height, wrap, y0, y1, fy);
+        const Color8 t00 = unpack8(fetch8(texture.texels(), l, x0, y0)), t10 = unpack8(fetch8(texture.texels(), l, x1, y0));
+        const Color8 t01 = unpack8(fetch8(texture.texels(), l, x0, y1)), t11 = unpack8(fetch8(texture.texels(), l, x1, y1));
+        Color8 result;
+        for (int c = 0; c < 4; ++c) {
+            result.c[c] = lerp8(lerp8(t00.c[c], t10.c[c], fx), lerp8(t01.c[c], t11.c[c], fx), fy);
+        }
+        return result;
+    }
+
+    GOOB_TARGET("avx2")
+    void sample_batch_avx2(const Texture & texture, const Sampler & sampler, SoaConstSpan<2> uv, std::span<const float> lod, SoaSpan<4> out, std::size_t) {
+        LevelTables tables;
+        for (int i = 0; i < texture.level_count(); ++i) {
+            const Texture::Level & l = texture.level(i);
+            tables.width[i] = l.width;
+            tables.height[i] = l.height;
+            tables.blocks_x[i] = l.blocks_x;
+            tables.offset[i] = static_cast<std::int32_t>(l.offset);
+        }
+        const __m256 max_lod = _mm256_set1_ps(static_cast<float>(texture.level_count() - 1));
+        const __m256i last_level = _mm256_set1_epi32(texture.level_count() - 1);
+
+        std::size_t i = 0;
+        for (; i + 8 <= uv.size; i += 8) {
+            const __m256 u = _mm256_loadu_ps(uv.components[0] + i), v = _mm256_loadu_ps(uv.components[1] + i);
+            // max returns the second operand for NaN, which selects the base level like clamp_lod()
+            const __m256 level = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(lod.data() + i), _mm256_setzero_ps()), max_lod);
+
+            Color8 color;
+            if (sampler.filter == TextureFilter::trilinear) {
+                const __m256i l0 = _mm256_cvttps_epi32(level);
+                const __m256i l1 = _mm256_min_epi32(_mm256_add_epi32(l0, _mm256_set1_epi32(1)), last_level);
+                const __m256 t = _mm256_sub_ps(level, _mm256_cvtepi32_ps(l0));
+                const Color8 c0 = bilinear8(texture, sampler.wrap, gather_levels(tables, l0), u, v);
+                const Color8 c1 = bilinear8(texture, sampler.wrap, gather_levels(tables, l1), u, v);
+                for (int c = 0; c < 4; ++c) {
+                    color.c[c] = lerp8(c0.c[c], c1.c[c], t);
+                }
+            } else {
+                const Levels8 l = gather_levels(tables, _mm256_cvttps_epi32(_mm256_add_ps(level, _mm256_set1_ps(0.5f))));
+                color = sampler.filter == TextureFilter::nearest ? nearest8(texture, sampler.wrap, l, u, v) : bilinear8(texture, sampler.wrap, l, u, v);
+            }
+            for (int c = 0; c < 4; ++c) {
+                _mm256_storeu_ps(out.components[c] + i, _mm256_mul_ps(color.c[c], _mm256_set1_ps(inv255)));
+            }
+        }
+        sample_batch_scalar(texture, sampler, uv, lod, out, i);
+    }
+#endif
+
+    BatchSampler batch_sampler() {
+#ifdef GOOB_X86
+        if (simd_level() >= SimdLevel::avx2) {
+            return sample_batch_avx2;
+        }
+#endif
+        return sample_batch_scalar;
+    }
+}
+
+Texture::Texture(const ImageView & image, ThreadPool * pool) {
+    if (image.width() <= 0 || image.height() <= 0 || image.width() > max_size || image.height() > max_size) {
+        throw std::invalid_argument("Texture dimensions must be within 1.." + std::to_string(max_size));
+    }
+
+    // Levels are whole blocks, so every level starts on a cache line
+    std::size_t texel_count = 0;
+    for (int w = image.width(), h = image.height();; w = std::max(1, w / 2), h = std::max(1, h / 2)) {
+        const int blocks_x = (w + block_size - 1) / block_size, blocks_y = (h + block_size - 1) / block_size;
+        levels_.push_back({w, h, blocks_x, texel_count});
+        texel_count += static_cast<std::size_t>(blocks_x) * blocks_y * block_size * block_size;
+        if (w == 1 && h == 1) {
+            break;
+        }
+    }
+    texels_.reset(static_cast<std::uint32_t *>(::operator new(texel_count * sizeof(std::uint32_t), std::align_val_t(64))));
+    std::memset(texels_.get(), 0, texel_count * sizeof(std::uint32_t));
+
+    std::uint32_t * texels = texels_.get();
+    for_each_row(image.height(), pool, [&](int y) {
+        for (int x = 0; x < image.width(); ++x) {
+            const linalg::vec<std::uint8_t,4> p = image.bgra(x, y);
+            texels[texel_index(0, x, y)] = p.x | (p.y << 8) | (p.z << 16) | (static_cast<std::uint32_t>(p.w) << 24);
+        }
+    });
+
+    // Each level depends on the previous one; the rows of a level are independent
+    for (int level = 1; level < level_count(); ++level) {
+        const Level & src = levels_[level - 1];
+        for_each_row(levels_[level].height, pool, [&](int y) {
+            const int y0 = 2 * y, y1 = std::min(2 * y + 1, src.height - 1);
+            for (int x = 0; x < levels_[level].width; ++x) {
+                const int x0 = 2 * x, x1 = std::min(2 * x + 1, src.width - 1);
+                texels[texel_index(level, x, y)] = average(texel(level - 1, x0, y0), texel(level - 1, x1, y0),
+                                                           texel(level - 1, x0, y1), texel(level - 1, x1, y1));
+            }
+        });
+    }
+}
+
+float Texture::lod(const linalg::vec<float,2> & duv_dx, const linalg::vec<float,2> & duv_dy) const {
+    const linalg::vec<float,2> size(static_cast<float>(width()), static_cast<float>(height()));
+    const float footprint = std::max({linalg::length2(duv_dx * size), linalg::length2(duv_dy * size), 1e-20f});
+    return 0.5f * std::log2(footprint);
+}
+
+linalg::vec<float,4> Texture::sample(const Sampler & sampler, const linalg::vec<float,2> & uv, float lod) const {
+    return sample_scalar(*this, sampler, uv, lod);
+}
+
+void Texture::sample(const Sampler & sampler, SoaConstSpan<2> uv, std::span<const float> lod, SoaSpan<4> out) const {
+    if (lod.size() < uv.size || out.size < uv.size) {
+        throw std::invalid_argument("Texture sample batch sizes differ");
+    }
+    static const BatchSampler kernel = batch_sampler();
+    kernel(*this, sampler, uv, lod, out, 0);
+}
+
+}
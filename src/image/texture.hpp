@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+#include <vector>
+
+#include "batch.hpp"
+#include "tga_image.hpp"
+#include "vector.hpp"
+
+namespace goob {
+
+class ThreadPool;
+
+enum class TextureFilter {
+    nearest,    // nearest texel of the nearest mip level
+    bilinear,   // 2x2 texels of the nearest mip level
+    trilinear,  // bilinear on the two mip levels around the lod, blended
+};
+
+enum class TextureWrap { repeat, clamp };
+
+struct Sampler {
+    TextureFilter filter = TextureFilter::bilinear;
+    TextureWrap wrap = TextureWrap::repeat;
+};
+
+// Mipmapped RGBA8 texture.
+//
+// Texels are packed like framebuffer colors (B,G,R,A bytes) and every level is stored in 4x4 texel blocks of one
+// 64-byte cache line each, so the 2x2 footprint of a bilinear sample rarely touches more than one line and
+// minified lookups walk far fewer lines than row-major storage would. Each level is a 2x2 box filter of the
+// previous one, generated row-parallel on a pool when given.
+//
+// Texture coordinates span the image over [0,1] with v = 0 at the top row; texel centers are at (i + 0.5) / size.
+// Colors are returned as RGBA in [0,1].
+class Texture {
+public:
+    static constexpr int block_size = 4;
+    static constexpr int max_size = 32768;
+
+    struct Level {
+        int width;
+        int height;
+        int blocks_x;
+        std::size_t offset;     // of the level's first texel
+    };
+
+    // Throws std::invalid_argument for empty images or sides above max_size
+    explicit Texture(const ImageView & image, ThreadPool * pool = nullptr);
+    explicit Texture(const TGAImage & image, ThreadPool * pool = nullptr) : Texture(image.view(), pool) {}
+
+    int width() const { return levels_[0].width; }
+    int height() const { return levels_[0].height; }
+    int level_count() const { return static_cast<int>(levels_.size()); }
+    const Level & level(int i) const { return levels_[i]; }
+    const std::uint32_t * texels() const { return texels_.get(); }
+
+    std::size_t texel_index(int level, int x, int y) const {
+        const Level & l = levels_[level];
+        return l.offset + (static_cast<std::size_t>(y >> 2) * l.blocks_x + (x >> 2)) * 16 + (y & 3) * 4 + (x & 3);
+    }
+    std::uint32_t texel(int level, int x, int y) const { return texels_.get()[texel_index(level, x, y)]; }
+
+    // Level of detail for the screen-space derivatives of the texture coordinates
+    float lod(const linalg::vec<float,2> & duv_dx, const linalg::vec<float,2> & duv_dy) const;
+
+    linalg::vec<float,4> sample(const Sampler & sampler, const linalg::vec<float,2> & uv, float lod = 0.0f) const;
+
+    // out[i] = sample(sampler, uv[i], lod[i]); eight samples at a time with AVX2
+    void sample(const Sampler & sampler, SoaConstSpan<2> uv, std::span<const float> lod, SoaSpan<4> out) const;
+
+private:
+    struct AlignedDelete {
+        void operator()(std::uint32_t * p) const { ::operator delete(p, std::align_val_t(64)); }
+    };
+
+    std::vector<Level> levels_;
+    std::unique_ptr<std::uint32_t, AlignedDelete> texels_;
+};
+
+}
@@ -0,0 +1,343 @@
+#include "tga_image.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "thread_pool.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define GOOB_TGA_SSE2 1
+#endif
+
+namespace goob {
+
+namespace {
+    constexpr std::size_t header_size = 18;
+
+    enum ImageType : std::uint8_t {
+        uncompressed_truecolor = 2,
+        uncompressed_grayscale = 3,
+        rle_truecolor = 10,
+        rle_grayscale = 11,
+    };
+
+    [[noreturn]] void fail(const std::string & what) {
+        throw std::runtime_error("TGA: " + what);
+    }
+
+    std::uint16_t read_u16(const std::uint8_t * p) {
+        return static_cast<std::uint16_t>(p[0] | (p[1] << 8));
+    }
+
+    // TGA 2.0 footer without extension or developer areas
+    constexpr std::uint8_t footer[26] = {0, 0, 0, 0, 0, 0, 0, 0, 'T', 'R', 'U', 'E', 'V', 'I', 'S', 'I', 'O', 'N', '-', 'X', 'F', 'I', 'L', 'E', '.', 0};
+
+    // Worst case of an RLE scanline: only raw packets, one header byte per 128 pixels
+    std::size_t max_rle_row_bytes(int width, int bpp) {
+        return static_cast<std::size_t>(width) * bpp + (width + 127) / 128;
+    }
+
+    template<int BPP>
+    bool same_pixel(const std::uint8_t * a, const std::uint8_t * b) {
+        return std::memcmp(a, b, BPP) == 0;
+    }
+
+    // RLE-encodes one scanline into `out` and returns the number of bytes written
+    template<int BPP>
+    std::size_t encode_rle_row(const std::uint8_t * row, std::ptrdiff_t stride, int width, std::uint8_t * out) {
+        std::uint8_t * const begin = out;
+        const auto at = [&](int x) { return row + x * stride; };
+        int x = 0;
+        while (x < width) {
+            int run = 1;
+            while (x + run < width && run < 128 && same_pixel<BPP>(at(x + run), at(x))) {
+                ++run;
+            }
+            if (run >= 2) {
+                *out++ = static_cast<std::uint8_t>(0x80 | (run - 1));
+                std::memcpy(out, at(x), BPP);
+                out += BPP;
+                x += run;
+                continue;
+            }
+
+            // Raw packet up to the start of the next run
+            std::uint8_t * header = out++;
+            int count = 0;
+            do {
+                std::memcpy(out, at(x), BPP);
+                out += BPP;
+                ++x;
+                ++count;
+            } while (x < width && count < 128 && !(x + 1 < width && same_pixel<BPP>(at(x), at(x + 1))));
+            *header = static_cast<std::uint8_t>(count - 1);
+        }
+        return static_cast<std::size_t>(out - begin);
+    }
+
+    std::size_t encode_rle_row(const ImageView & image, int y, std::uint8_t * out) {
+        switch (image.format()) {
+            case PixelFormat::grayscale: return encode_rle_row<1>(image.row(y), image.pixel_stride(), image.width(), out);
+            case PixelFormat::bgr:       return encode_rle_row<3>(image.row(y), image.pixel_stride(), image.width(), out);
+            case PixelFormat::bgra:      return encode_rle_row<4>(image.row(y), image.pixel_stride(), image.width(), out);
+        }
+        return 0;
+    }
+
+    template<class F>
+    void for_each_row(int height, ThreadPool * pool, F && body) {
+        if (pool) {
+            pool->parallel_for(static_cast<std::size_t>(height), [&](std::size_t y, unsigned) { body(static_cast<int>(y)); });
+        } else {
+            for (int y = 0; y < height; ++y) {
+                body(y);
+            }
+        }
+    }
+
+    // Writes `count` copies of one pixel. Long runs are expanded with 16-byte stores of a repeating pattern.
+    void expand_run(std::uint8_t * dst, const std::uint8_t * pixel, int bpp, std::size_t count) {
+        if (bpp == 1) {
+            std::memset(dst, pixel[0], count);
+            return;
+        }
+#ifdef GOOB_TGA_SSE2
+        if (count >= 16) {
+            // lcm(bpp, 16) bytes of pattern: 16 bytes for BGRA, 48 bytes for BGR
+            alignas(16) std::uint8_t pattern[48];
+            for (int i = 0; i < 48; ++i) {
+                pattern[i] = pixel[i % bpp];
+            }
+            const std::size_t period = bpp == 4 ? 16 : 48;
+            const __m128i p0 = _mm_load_si128(reinterpret_cast<const __m128i *>(pattern));
+            const __m128i p1 = _mm_load_si128(reinterpret_cast<const __m128i *>(pattern + 16));
+            const __m128i p2 = _mm_load_si128(reinterpret_cast<const __m128i *>(pattern + 32));
+            const std::size_t bytes = count * bpp;
+            std::size_t offset = 0;
+            for (; offset + period <= bytes; offset += period) {
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + offset), p0);
+                if (period == 48) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + offset + 16), p1);
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + offset + 32), p2);
+                }
+            }
+            std::memcpy(dst + offset, pattern, bytes - offset);
+            return;
+        }
+#endif
+        for (std::size_t i = 0; i < count; ++i, dst += bpp) {
+            std::memcpy(dst, pixel, bpp);
+        }
+    }
+
+    // Decodes RLE packets in a single pass. Packets are allowed to cross scanlines.
+    void decode_rle(const std::uint8_t * src, const std::uint8_t * src_end, std::uint8_t * dst, std::size_t pixel_count, int bpp) {
+        std::size_t decoded = 0;
+        while (decoded < pixel_count) {
+            if (src == src_end) {
+                fail("truncated RLE data");
+            }
+            const std::uint8_t packet = *src++;
+            const std::size_t count = std::min<std::size_t>((packet & 0x7f) + 1, pixel_count - decoded);
+            if (packet & 0x80) {
+                if (src_end - src < bpp) {
+                    fail("truncated RLE data");
+                }
+                expand_run(dst, src, bpp, count);
+                src += bpp;
+            } else {
+                const std::size_t bytes = count * bpp;
+                if (static_cast<std::size_t>(src_end - src) < bytes) {
+                    fail("truncated RLE data");
+                }
+                std::memcpy(dst, src, bytes);
+                src += bytes;
+            }
+            dst += count * bpp;
+            decoded += count;
+        }
+    }
+}
+
+TGAImage::TGAImage(int width, int height, PixelFormat format)
+    : width_(width), height_(height), format_(format) {
+    // Before sizing the pixels, which would turn a negative dimension into a huge allocation
+    if (width <= 0 || height <= 0) {
+        throw std::invalid_argument("TGAImage dimensions must be positive");
+    }
+    owned_.resize(static_cast<std::size_t>(width) * height * bytes_per_pixel(format));
+    data_ = owned_.data();
+}
+
+TGAImage TGAImage::load(const std::filesystem::path & path) {
+    MappedFile file(path);
+    TGAImage image = decode(file.bytes());
+    if (image.owned_.empty()) {
+        image.file_ = std::move(file);
+    }
+    return image;
+}
+
+TGAImage TGAImage::decode(std::span<const std::uint8_t> file) {
+    if (file.size() < header_size) {
+        fail("file too small for a header");
+    }
+    const std::uint8_t * header = file.data();
+    const std::uint8_t id_length = header[0];
+    const std::uint8_t colormap_type = header[1];
+    const std::uint8_t type = header[2];
+    const std::size_t colormap_bytes = colormap_type ? read_u16(header + 5) * ((header[7] + 7) / 8) : 0;
+    const int width = read_u16(header + 12);
+    const int height = read_u16(header + 14);
+    const int bits = header[16];
+    const std::uint8_t descriptor = header[17];
+
+    const bool grayscale = type == uncompressed_grayscale || type == rle_grayscale;
+    const bool rle = type == rle_truecolor || type == rle_grayscale;
+    if (type != uncompressed_truecolor && type != uncompressed_grayscale && !rle) {
+        fail("unsupported image type " + std::to_string(type));
+    }
+    if (width == 0 || height == 0) {
+        fail("empty image");
+    }
+
+    TGAImage image;
+    if (grayscale && bits == 8) {
+        image.format_ = PixelFormat::grayscale;
+    } else if (!grayscale && bits == 24) {
+        image.format_ = PixelFormat::bgr;
+    } else if (!grayscale && bits == 32) {
+        image.format_ = PixelFormat::bgra;
+    } else {
+        fail("unsupported pixel depth " + std::to_string(bits));
+    }
+    image.width_ = width;
+    image.height_ = height;
+    image.bottom_up_ = (descriptor & 0x20) == 0;
+    image.right_to_left_ = (descriptor & 0x10) != 0;
+
+    const std::size_t offset = header_size + id_length + colormap_bytes;
+    const std::size_t pixel_count = static_cast<std::size_t>(width) * height;
+    const int bpp = bytes_per_pixel(image.format_);
+    if (offset > file.size()) {
+        fail("truncated header");
+    }
+
+    if (rle) {
+        image.owned_.resize(pixel_count * bpp);
+        decode_rle(file.data() + offset, file.data() + file.size(), image.owned_.data(), pixel_count, bpp);
+        image.data_ = image.owned_.data();
+    } else {
+        if (file.size() - offset < pixel_count * bpp) {
+            fail("truncated pixel data");
+        }
+        image.data_ = file.data() + offset;
+    }
+    return image;
+}
+
+std::vector<std::uint8_t> encode_tga(const ImageView & image, TGACompression compression, ThreadPool * pool) {
+    const int width = image.width(), height = image.height();
+    if (width <= 0 || height <= 0 || width > 0xffff || height > 0xffff) {
+        throw std::invalid_argument("TGA: image dimensions out of range");
+    }
+    const int bpp = bytes_per_pixel(image.format());
+    const bool grayscale = image.format() == PixelFormat::grayscale;
+    const bool rle = compression == TGACompression::rle;
+
+    std::vector<std::uint8_t> file(header_size, 0);
+    file[2] = rle ? (grayscale ? rle_grayscale : rle_truecolor) : (grayscale ? uncompressed_grayscale : uncompressed_truecolor);
+    file[12] = static_cast<std::uint8_t>(width & 0xff);
+    file[13] = static_cast<std::uint8_t>(width >> 8);
+    file[14] = static_cast<std::uint8_t>(height & 0xff);
+    file[15] = static_cast<std::uint8_t>(height >> 8);
+    file[16] = static_cast<std::uint8_t>(bpp * 8);
+    file[17] = static_cast<std::uint8_t>(0x20 | (image.format() == PixelFormat::bgra ? 8 : 0));  // top-left origin, alpha bits
+
+    const std::size_t row_bytes = static_cast<std::size_t>(width) * bpp;
+    if (!rle) {
+        file.resize(header_size + row_bytes * height);
+        for_each_row(height, pool, [&](int y) {
+            std::uint8_t * dst = file.data() + header_size + row_bytes * y;
+            if (image.rows_contiguous()) {
+                std::memcpy(dst, image.row(y), row_bytes);
+            } else {
+                for (int x = 0; x < width; ++x) {
+                    std::memcpy(dst + x * bpp, image.pixel(x, y), bpp);
+                }
+            }
+        });
+    } else {
+        // Rows are encoded into fixed-size slots, then packed behind each other
+        const std::size_t slot = max_rle_row_bytes(width, bpp);
+        std::vector<std::uint8_t> scratch(slot * height);
+        std::vector<std::size_t> offsets(static_cast<std::size_t>(height) + 1, 0);
+        for_each_row(height, pool, [&](int y) {
+            offsets[y + 1] = encode_rle_row(image, y, scratch.data() + slot * y);
+        });
+        for (int y = 0; y < height; ++y) {
+            offsets[y + 1] += offsets[y];
+        }
+        file.resize(header_size + offsets[height]);
+        for_each_row(height, pool, [&](int y) {
+            std::memcpy(file.data() + header_size + offsets[y], scratch.data() + slot * y, offsets[y + 1] - offsets[y]);
+        });
+    }
+
+    file.insert(file.end(), std::begin(footer), std::end(footer));
+    return file;
+}
+
+void TGAImage::write(const std::filesystem::path & path, TGACompression compression, ThreadPool * pool) const {
+    const std::vector<std::uint8_t> file = encode_tga(view(), compression, pool);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(file.data()), static_cast<std::streamsize>(file.size()));
+    if (!out) {
+        fail("cannot write " + path.string());
+    }
+}
+
+ImageView TGAImage::view() const {
+    const int bpp = bytes_per_pixel(format_);
+    ImageView stored(data_, width_, height_, format_, static_cast<std::ptrdiff_t>(width_) * bpp, bpp);
+    if (bottom_up_) {
+        stored = stored.flipped_vertically();
+    }
+    if (right_to_left_) {
+        stored = stored.flipped_horizontally();
+    }
+    return stored;
+}
+
+std::span<std::uint8_t> TGAImage::pixels() {
+    if (!owned_.empty() && !bottom_up_ && !right_to_left_) {
+        return owned_;
+    }
+
+    const ImageView source = view();
+    const int bpp = bytes_per_pixel(format_);
+    std::vector<std::uint8_t> top_down(static_cast<std::size_t>(width_) * height_ * bpp);
+    for (int y = 0; y < height_; ++y) {
+        std::uint8_t * dst = top_down.data() + static_cast<std::size_t>(y) * width_ * bpp;
+        if (source.rows_contiguous()) {
+            std::memcpy(dst, source.row(y), static_cast<std::size_t>(width_) * bpp);
+        } else {
+            for (int x = 0; x < width_; ++x) {
+                std::memcpy(dst + x * bpp, source.pixel(x, y), bpp);
+            }
+        }
+    }
+
+    owned_ = std::move(top_down);
+    file_ = MappedFile();
+    data_ = owned_.data();
+    bottom_up_ = false;
+    right_to_left_ = false;
+    return owned_;
+}
+
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "vector.hpp"
+
+namespace goob {
+
+class ThreadPool;
+
+// Pixel layouts stored by TGA files; the value is the number of bytes per pixel
+enum class PixelFormat { grayscale = 1, bgr = 3, bgra = 4 };
+
+inline int bytes_per_pixel(PixelFormat format) { return static_cast<int>(format); }
+
+// Non-owning view of an image with (0,0) at the top-left corner. Row and pixel strides may be negative,
+// which is how images stored bottom-up or right-to-left are presented without copying them.
+class ImageView {
+public:
+    ImageView() = default;
+    ImageView(const std::uint8_t * origin, int width, int height, PixelFormat format, std::ptrdiff_t row_stride, std::ptrdiff_t pixel_stride)
+        : origin_(origin), width_(width), height_(height), format_(format), row_stride_(row_stride), pixel_stride_(pixel_stride) {}
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    PixelFormat format() const { return format_; }
+    std::ptrdiff_t row_stride() const { return row_stride_; }
+    std::ptrdiff_t pixel_stride() const { return pixel_stride_; }
+
+    // Rows are contiguous left-to-right runs of pixels (rows may still be in any order)
+    bool rows_contiguous() const { return pixel_stride_ == bytes_per_pixel(format_); }
+
+    const std::uint8_t * row(int y) const { return origin_ + y * row_stride_; }
+    const std::uint8_t * pixel(int x, int y) const { return row(y) + x * pixel_stride_; }
+
+    // Pixel expanded to BGRA; grayscale is replicated into the color channels, missing alpha is opaque
+    linalg::vec<std::uint8_t,4> bgra(int x, int y) const {
+        const std::uint8_t * p = pixel(x, y);
+        switch (format_) {
+            case PixelFormat::grayscale: return {p[0], p[0], p[0], 255};
+            case PixelFormat::bgr:       return {p[0], p[1], p[2], 255};
+            case PixelFormat::bgra:      return {p[0], p[1], p[2], p[3]};
+        }
+        return {};
+    }
+
+    ImageView flipped_vertically() const {
+        return {row(height_ - 1), width_, height_, format_, -row_stride_, pixel_stride_};
+    }
+    ImageView flipped_horizontally() const {
+        return {origin_ + (width_ - 1) * pixel_stride_, width_, height_, format_, row_stride_, -pixel_stride_};
+    }
+
+private:
+    const std::uint8_t * origin_ = nullptr;
+    int width_ = 0;
+    int height_ = 0;
+    PixelFormat format_ = PixelFormat::bgra;
+    std::ptrdiff_t row_stride_ = 0;
+    std::ptrdiff_t pixel_stride_ = 0;
+};
+
+enum class TGACompression { none, rle };
+
+// Encodes a complete TGA file (top-left origin). With RLE every scanline is encoded independently, in
+// parallel when a pool is given, and packets never cross scanlines.
+std::vector<std::uint8_t> encode_tga(const ImageView & image, TGACompression compression = TGACompression::rle, ThreadPool * pool = nullptr);
+
+// Truevision TGA image (uncompressed or RLE, 8-bit grayscale, 24-bit BGR or 32-bit BGRA).
+//
+// Uncompressed files are memory-mapped and their pixels are used in place; RLE files are decoded
+// in one streaming pass into an owned buffer. Either way pixels keep the row order of the file,
+// and view() presents them top-left first.
+class TGAImage {
+public:
+    TGAImage() = default;
+    // Owned image with zeroed pixels stored top-down
+    TGAImage(int width, int height, PixelFormat format);
+
+    // Throws std::runtime_error for missing, truncated, malformed or unsupported files
+    static TGAImage load(const std::filesystem::path & path);
+    // Decodes a TGA file already in memory; uncompressed pixels are referenced, not copied
+    static TGAImage decode(std::span<const std::uint8_t> file);
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    PixelFormat format() const { return format_; }
+
+    // True when pixels are read directly from the mapped file
+    bool is_mapped() const { return !file_.empty(); }
+
+    ImageView view() const;
+
+    // Encodes and writes the image; throws std::runtime_error when the file cannot be written
+    void write(const std::filesystem::path & path, TGACompression compression = TGACompression::rle, ThreadPool * pool = nullptr) const;
+
+    // Mutable access to owned pixels, top-down rows, tightly packed. Mapped images are copied into memory first.
+    std::span<std::uint8_t> pixels();
+
+private:
+    MappedFile file_;
+    std::vector<std::uint8_t> owned_;
+    const std::uint8_t * data_ = nullptr;  // first stored pixel
+    int width_ = 0;
+    int height_ = 0;
+    PixelFormat format_ = PixelFormat::bgra;
+    bool bottom_up_ = false;
+    bool right_to_left_ = false;
+};
+
+}
@@ -0,0 +1,83 @@
+#include "tga_writer.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+namespace goob {
+
+TGAWriter::TGAWriter(std::size_t max_pending)
+    : max_pending_(max_pending == 0 ? 1 : max_pending), thread_([this] { run(); }) {
+}
+
+TGAWriter::~TGAWriter() {
+    {
+        std::unique_lock lock(mutex_);
+        stopping_ = true;
+    }
+    queued_.notify_all();
+    thread_.join();
+}
+
+void TGAWriter::submit(const std::filesystem::path & path, const ImageView & image, TGACompression compression, ThreadPool * pool) {
+    submit(path, encode_tga(image, compression, pool));
+}
+
+void TGAWriter::submit(std::filesystem::path path, std::vector<std::uint8_t> file) {
+    {
+        std::unique_lock lock(mutex_);
+        drained_.wait(lock, [&] { return jobs_.size() + in_flight_ < max_pending_; });
+        rethrow_error();
+        jobs_.push_back({std::move(path), std::move(file)});
+    }
+    queued_.notify_one();
+}
+
+void TGAWriter::flush() {
+    std::unique_lock lock(mutex_);
+    drained_.wait(lock, [&] { return jobs_.empty() && in_flight_ == 0; });
+    rethrow_error();
+}
+
+std::size_t TGAWriter::pending() const {
+    std::lock_guard lock(mutex_);
+    return jobs_.size() + in_flight_;
+}
+
+void TGAWriter::rethrow_error() {
+    if (error_) {
+        std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+}
+
+void TGAWriter::run() {
+    std::unique_lock lock(mutex_);
+    for (;;) {
+        queued_.wait(lock, [&] { return stopping_ || !jobs_.empty(); });
+        if (jobs_.empty()) {
+            return;
+        }
+        Job job = std::move(jobs_.front());
+        jobs_.pop_front();
+        ++in_flight_;
+        lock.unlock();
+
+        std::exception_ptr failure;
+        std::ofstream out(job.path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(job.file.data()), static_cast<std::streamsize>(job.file.size()));
+        out.close();
+        if (!out) {
+            failure = std::make_exception_ptr(std::runtime_error("TGA: cannot write " + job.path.string()));
+        }
+        job = {};
+
+        lock.lock();
+        --in_flight_;
+        if (failure && !error_) {
+            error_ = failure;
+        }
+        drained_.notify_all();
+    }
+}
+
+}
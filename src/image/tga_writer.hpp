@@ -0,0 +1,59 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "tga_image.hpp"
+
+namespace goob {
+
+// Writes encoded TGA files on a background thread so the next frame can render while the previous one
+// goes to disk. At most `max_pending` encoded files are held in memory; submit() blocks while the queue is full.
+class TGAWriter {
+public:
+    explicit TGAWriter(std::size_t max_pending = 2);
+    // Finishes all pending writes; errors not yet reported by flush() are dropped
+    ~TGAWriter();
+
+    TGAWriter(const TGAWriter &) = delete;
+    TGAWriter & operator=(const TGAWriter &) = delete;
+
+    // Encodes `image` on the calling thread (scanlines in parallel on `pool`) and queues the file
+    void submit(const std::filesystem::path & path, const ImageView & image, TGACompression compression = TGACompression::rle, ThreadPool * pool = nullptr);
+    // Queues an already encoded file
+    void submit(std::filesystem::path path, std::vector<std::uint8_t> file);
+
+    // Blocks until every queued file is written. Rethrows the first error of a write since the last flush().
+    void flush();
+
+    // Files queued or being written
+    std::size_t pending() const;
+
+private:
+    struct Job {
+        std::filesystem::path path;
+        std::vector<std::uint8_t> file;
+    };
+
+    void run();
+    void rethrow_error();
+
+    const std::size_t max_pending_;
+    mutable std::mutex mutex_;
+    std::condition_variable queued_;    // a job was queued or the writer is stopping
+    std::condition_variable drained_;   // a job was completed
+    std::deque<Job> jobs_;
+    std::size_t in_flight_ = 0;
+    bool stopping_ = false;
+    std::exception_ptr error_;
+    std::thread thread_;
+};
+
+}
@@ -0,0 +1,51 @@
+#include "bounds.hpp"
+
+#include <cmath>
+
+namespace goob {
+
+Frustum Frustum::from_matrix(const linalg::mat<float,4,4> & m, linalg::z_range depth_range) {
+    // clip = m * p, so each clip-space inequality (e.g. x >= -w) is a plane built from rows of m
+    const linalg::vec<float,4> x = m.row(0), y = m.row(1), z = m.row(2), w = m.row(3);
+    Frustum frustum = {{w + x, w - x, w + y, w - y, depth_range == linalg::zero_to_one ? z : w + z, w - z}};
+    for (linalg::vec<float,4> & plane : frustum.planes) {
+        const float length = linalg::length(plane.xyz());
+        if (length > 0.0f) {
+            plane /= length;
+        }
+    }
+    return frustum;
+}
+
+Visibility Frustum::classify(const Aabb & box) const {
+    const linalg::vec<float,3> center = box.center(), half = box.extent() * 0.5f;
+    Visibility result = Visibility::inside;
+    for (const linalg::vec<float,4> & plane : planes) {
+        // Distance of the center and the box's projected radius onto the plane normal
+        const float distance = linalg::dot(plane.xyz(), center) + plane.w;
+        const float radius = linalg::dot(linalg::abs(plane.xyz()), half);
+        if (distance < -radius) {
+            return Visibility::outside;
+        }
+        if (distance < radius) {
+            result = Visibility::intersecting;
+        }
+    }
+    return result;
+}
+
+Visibility Frustum::classify(const linalg::vec<float,3> & center, float radius) const {
+    Visibility result = Visibility::inside;
+    for (const linalg::vec<float,4> & plane : planes) {
+        const float distance = linalg::dot(plane.xyz(), center) + plane.w;
+        if (distance < -radius) {
+            return Visibility::outside;
+        }
+        if (distance < radius) {
+            result = Visibility::intersecting;
+        }
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+#include "vector.hpp"
+
+namespace goob {
+
+// Axis-aligned box; default-constructed boxes are empty and grow with extend()
+struct Aabb {
+    linalg::vec<float,3> min = linalg::vec<float,3>(std::numeric_limits<float>::infinity());
+    linalg::vec<float,3> max = linalg::vec<float,3>(-std::numeric_limits<float>::infinity());
+
+    bool empty() const { return !(min.x <= max.x && min.y <= max.y && min.z <= max.z); }
+    linalg::vec<float,3> center() const { return (min + max) * 0.5f; }
+    linalg::vec<float,3> extent() const { return max - min; }
+
+    // Half the surface area, the only part the surface area heuristic needs; 0 for empty boxes
+    float half_area() const {
+        if (empty()) {
+            return 0.0f;
+        }
+        const linalg::vec<float,3> e = extent();
+        return e.x * e.y + e.y * e.z + e.z * e.x;
+    }
+
+    void extend(const linalg::vec<float,3> & p) {
+        min = linalg::min(min, p);
+        max = linalg::max(max, p);
+    }
+    void extend(const Aabb & other) {
+        min = linalg::min(min, other.min);
+        max = linalg::max(max, other.max);
+    }
+
+    bool contains(const Aabb & other) const {
+        return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z
+            && max.x >= other.max.x && max.y >= other.max.y && max.z >= other.max.z;
+    }
+};
+
+// Result of testing a volume against a frustum
+enum class Visibility { outside, intersecting, inside };
+
+// The six planes of a view frustum in world space, taken from a view-projection matrix with the conventions of
+// linalg's projection matrices (see ClipSpace in the renderer). Planes are normalized and point inwards:
+// dot(plane.xyz(), p) + plane.w >= 0 inside.
+struct Frustum {
+    std::array<linalg::vec<float,4>,6> planes;      // left, right, bottom, top, near, far
+
+    static Frustum from_matrix(const linalg::mat<float,4,4> & view_projection, linalg::z_range depth_range = linalg::neg_one_to_one);
+
+    // Conservative: boxes and spheres near the frustum's edges may be reported visible while outside
+    Visibility classify(const Aabb & box) const;
+    Visibility classify(const linalg::vec<float,3> & center, float radius) const;
+    bool intersects(const Aabb & box) const { return classify(box) != Visibility::outside; }
+};
+
+}
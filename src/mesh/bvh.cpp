@@ -0,0 +1,613 @@
+#include "bvh.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+
+#include "cpu_features.hpp"
+#include "thread_pool.hpp"
+
+#ifdef GOOB_X86
+#include <immintrin.h>
+#endif
+
+namespace goob {
+
+namespace {
+    // Beyond this depth ranges are split at the median, which bounds the depth of the tree
+    constexpr int sah_depth = 64;
+    // Smallest subtree built as one parallel task
+    constexpr std::size_t min_task_size = 4096;
+    // Cost of visiting a node relative to testing one primitive
+    constexpr float traversal_cost = 1.0f;
+
+    template<class Body>
+    void for_each_index(std::size_t count, ThreadPool * pool, Body && body) {
+        constexpr std::size_t grain = 1024;
+        const std::size_t chunks = (count + grain - 1) / grain;
+        const auto chunk = [&](std::size_t c) {
+            const std::size_t end = std::min(count, (c + 1) * grain);
+            for (std::size_t i = c * grain; i < end; ++i) {
+                body(i);
+            }
+        };
+        if (pool) {
+            pool->parallel_for(chunks, [&](std::size_t c, unsigned) { chunk(c); });
+        } else {
+            for (std::size_t c = 0; c < chunks; ++c) {
+                chunk(c);
+            }
+        }
+    }
+
+    Bvh::Node leaf_node(const Aabb & bounds, std::uint32_t first, std::uint32_t count) {
+        return {bounds.min, first, bounds.max, static_cast<std::uint16_t>(count), 0};
+    }
+
+    Bvh::Node interior_node(const Aabb & bounds, int axis) {
+        return {bounds.min, 0, bounds.max, 0, static_cast<std::uint16_t>(axis)};
+    }
+
+    struct Split {
+        int axis;
+        std::uint32_t mid;
+    };
+
+    // Top-down builder over a range of `order`. Ranges are disjoint, so subtrees can be built concurrently.
+    struct Builder {
+        std::span<const Aabb> boxes;
+        std::span<const linalg::vec<float,3>> centroids;
+        std::span<std::uint32_t> order;
+        std::uint32_t max_leaf_size;
+
+        Aabb bounds(std::uint32_t begin, std::uint32_t end) const {
+            Aabb box;
+            for (std::uint32_t i = begin; i < end; ++i) {
+                box.extend(boxes[order[i]]);
+            }
+            return box;
+        }
+
+        // Partitions order[begin, end) and returns the split, or nullopt when the range should be a leaf
+        std::optional<Split> split(std::uint32_t begin, std::uint32_t end, const Aabb & box, int depth) const {
+            const std::uint32_t count = end - begin;
+            if (count <= 1) {
+                return std::nullopt;
+            }
+            Aabb centroid_box;
+            for (std::uint32_t i = begin; i < end; ++i) {
+                centroid_box.extend(centroids[order[i]]);
+            }
+
+            struct Bin {
+                Aabb box;
+                std::uint32_t count = 0;
+            };
+            float best_cost = std::numeric_limits<float>::infinity();
+            int best_axis = -1, best_bin = 0;
+            for (int axis = 0; axis < 3 && depth < sah_depth; ++axis) {
+                const float extent = centroid_box.max[axis] - centroid_box.min[axis];
+                if (!(extent > 0.0f)) {
+                    continue;
+                }
+                const float scale = Bvh::bins / extent;
+                std::array<Bin, Bvh::bins> bin_array;
+                for (std::uint32_t i = begin; i < end; ++i) {
+                    const int b = std::min(Bvh::bins - 1, static_cast<int>((centroids[order[i]][axis] - centroid_box.min[axis]) * scale));
+                    bin_array[b].box.extend(boxes[order[i]]);
+                    ++bin_array[b].count;
+                }
+                // Cost of the right side of every split plane, then sweep from the left
+                std::array<float, Bvh::bins> right_cost{};
+                Bin right;
+                for (int b = Bvh::bins - 1; b > 0; --b) {
+                    right.box.extend(bin_array[b].box);
+                    right.count += bin_array[b].count;
+                    right_cost[b - 1] = right.box.half_area() * right.count;
+                }
+                Bin left;
+                for (int b = 0; b < Bvh::bins - 1; ++b) {
+                    left.box.extend(bin_array[b].box);
+                    left.count += bin_array[b].count;
+                    const float cost = left.box.half_area() * left.count + right_cost[b];
+                    if (left.count != 0 && left.count != count && cost < best_cost) {
+                        best_cost = cost;
+                        best_axis = axis;
+                        best_bin = b;
+                    }
+                }
+            }
+
+            const float leaf_cost = box.half_area() * count;
+            if (best_axis >= 0 && (count > max_leaf_size || traversal_cost * box.half_area() + best_cost < leaf_cost)) {
+                const float scale = Bvh::bins / (centroid_box.max[best_axis] - centroid_box.min[best_axis]);
+                const auto mid = std::partition(order.begin() + begin, order.begin() + end, [&](std::uint32_t p) {
+                    return std::min(Bvh::bins - 1, static_cast<int>((centroids[p][best_axis] - centroid_box.min[best_axis]) * scale)) <= best_bin;
+                });
+                return Split{best_axis, static_cast<std::uint32_t>(mid - order.begin())};
+            }
+            if (count <= max_leaf_size) {
+                return std::nullopt;
+            }
+
+            // No usable plane (coincident centroids or too deep): halve the range along the widest axis
+            const linalg::vec<float,3> extent = centroid_box.extent();
+            const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+            const std::uint32_t mid = begin + count / 2;
+            std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end, [&](std::uint32_t a, std::uint32_t b) {
+                return centroids[a][axis] < centroids[b][axis];
+            });
+            return Split{axis, mid};
+        }
+
+        // Appends the subtree of order[begin, end) depth-first
+        void build(std::uint32_t begin, std::uint32_t end, int depth, std::vector<Bvh::Node> & nodes) const {
+            const std::size_t index = nodes.size();
+            const Aabb box = bounds(begin, end);
+            const std::optional<Split> s = split(begin, end, box, depth);
+            if (!s) {
+                nodes.push_back(leaf_node(box, begin, end - begin));
+                return;
+            }
+            nodes.push_back(interior_node(box, s->axis));
+            build(begin, s->mid, depth + 1, nodes);
+            nodes[index].offset = static_cast<std::uint32_t>(nodes.size());
+            build(s->mid, end, depth + 1, nodes);
+        }
+    };
+
+    // Upper levels of a parallel build: split serially down to subtrees of about `task_size` primitives
+    struct TopLevel {
+        struct Node {
+            Aabb box;
+            int axis = 0;
+            int left = -1, right = -1;
+            int task = -1;      // subtree built in parallel, or -1 for an interior node
+        };
+        struct Task {
+            std::uint32_t begin, end;
+            int depth;
+            std::vector<Bvh::Node> nodes;
+        };
+
+        const Builder & builder;
+        std::size_t task_size;
+        std::vector<Node> nodes;
+        std::vector<Task> tasks;
+
+        int split(std::uint32_t begin, std::uint32_t end, int depth) {
+            const int index = static_cast<int>(nodes.size());
+            nodes.push_back({builder.bounds(begin, end)});
+            std::optional<Split> s;
+            if (end - begin > task_size) {
+                s = builder.split(begin, end, nodes[index].box, depth);
+            }
+            if (!s) {
+                nodes[index].task = static_cast<int>(tasks.size());
+                tasks.push_back({begin, end, depth, {}});
+                return index;
+            }
+            nodes[index].axis = s->axis;
+            const int left = split(begin, s->mid, depth + 1);
+            const int right = split(s->mid, end, depth + 1);
+            nodes[index].left = left;
+            nodes[index].right = right;
+            return index;
+        }
+
+        void emit(int index, std::vector<Bvh::Node> & out) const {
+            const Node & node = nodes[index];
+            if (node.task >= 0) {
+                const std::uint32_t base = static_cast<std::uint32_t>(out.size());
+                for (Bvh::Node n : tasks[node.task].nodes) {
+                    if (!n.leaf()) {
+                        n.offset += base;
+                    }
+                    out.push_back(n);
+                }
+                return;
+            }
+            const std::size_t at = out.size();
+            out.push_back(interior_node(node.box, node.axis));
+            emit(node.left, out);
+            out[at].offset = static_cast<std::uint32_t>(out.size());
+            emit(node.right, out);
+        }
+    };
+}
+
+Bvh::Bvh(std::span<const Aabb> boxes, ThreadPool * pool, int max_leaf_size) {
+    if (max_leaf_size < 1 || max_leaf_size > 255) {
+        throw std::invalid_argument("BVH leaf size must be within [1, 255]");
+    }
+    if (boxes.empty()) {
+        return;
+    }
+    primitives_.resize(boxes.size());
+    std::iota(primitives_.begin(), primitives_.end(), 0u);
+    std::vector<linalg::vec<float,3>> centroids(boxes.size());
+    for_each_index(boxes.size(), pool, [&](std::size_t i) { centroids[i] = boxes[i].center(); });
+
+    const Builder builder{boxes, centroids, primitives_, static_cast<std::uint32_t>(max_leaf_size)};
+    const std::uint32_t count = static_cast<std::uint32_t>(boxes.size());
+    if (!pool || boxes.size() < 2 * min_task_size) {
+        builder.build(0, count, 0, nodes_);
+        return;
+    }
+
+    TopLevel top{builder, std::max(min_task_size, boxes.size() / (4 * pool->size())), {}, {}};
+    top.split(0, count, 0);
+    pool->parallel_for(top.tasks.size(), [&](std::size_t t, unsigned) {
+        TopLevel::Task & task = top.tasks[t];
+        builder.build(task.begin, task.end, task.depth, task.nodes);
+    });
+    top.emit(0, nodes_);
+}
+
+namespace {
+    constexpr float inf = std::numeric_limits<float>::infinity();
+
+    linalg::vec<float,3> reciprocal(const linalg::vec<float,3> & d) {
+        return {1.0f / d.x, 1.0f / d.y, 1.0f / d.z};
+    }
+
+    // Slab test; t_far is the current closest hit
+    bool hits_box(const Bvh::Node & node, const linalg::vec<float,3> & origin, const linalg::vec<float,3> & inv_direction, float t_far) {
+        float t_near = 0.0f;
+        for (int a = 0; a < 3; ++a) {
+            const float t0 = (node.min[a] - origin[a]) * inv_direction[a];
+            const float t1 = (node.max[a] - origin[a]) * inv_direction[a];
+            t_near = std::max(t_near, std::min(t0, t1));
+            t_far = std::min(t_far, std::max(t0, t1));
+        }
+        return t_near <= t_far;
+    }
+
+    // Moller-Trumbore; writes t and the barycentrics of a hit nearer than t_far
+    bool hits_triangle(const MeshBvh::Triangle & tri, const Ray & ray, float t_far, float & t, linalg::vec<float,2> & barycentric) {
+        const linalg::vec<float,3> p = linalg::cross(ray.direction, tri.e2);
+        const float det = linalg::dot(tri.e1, p);
+        if (det == 0.0f) {
+            return false;
+        }
+        const float inv_det = 1.0f / det;
+        const linalg::vec<float,3> s = ray.origin - tri.v0;
+        const float u = linalg::dot(s, p) * inv_det;
+        const linalg::vec<float,3> q = linalg::cross(s, tri.e1);
+        const float v = linalg::dot(ray.direction, q) * inv_det;
+        const float distance = linalg::dot(tri.e2, q) * inv_det;
+        if (!(u >= 0.0f && v >= 0.0f && u + v <= 1.0f && distance > 0.0f && distance < t_far)) {
+            return false;
+        }
+        t = distance;
+        barycentric = {u, v};
+        return true;
+    }
+
+    // Rays in lanes, with the nearest hit so far
+    template<int N>
+    struct alignas(32) RayPacket {
+        float origin[3][N];
+        float direction[3][N];
+        float inv_direction[3][N];
+        float t[N];
+        std::uint32_t triangle[N];
+        float u[N], v[N];
+
+        RayPacket(std::span<const Ray> rays) {
+            for (int i = 0; i < N; ++i) {
+                const linalg::vec<float,3> inv = reciprocal(rays[i].direction);
+                for (int a = 0; a < 3; ++a) {
+                    origin[a][i] = rays[i].origin[a];
+                    direction[a][i] = rays[i].direction[a];
+                    inv_direction[a][i] = inv[a];
+                }
+                t[i] = rays[i].t_max;
+                triangle[i] = RayHit::none;
+                u[i] = v[i] = 0.0f;
+            }
+        }
+    };
+
+    // Depth-first traversal of a packet. `box` returns the lanes hitting a node, `triangle` tests the lanes of a
+    // mask against one triangle.
+    template<int N, class Box, class Triangle>
+    void traverse(std::span<const Bvh::Node> nodes, std::span<const MeshBvh::Triangle> triangles, RayPacket<N> & packet, Box box, Triangle triangle) {
+        if (nodes.empty()) {
+            return;
+        }
+        std::uint32_t stack[Bvh::max_depth];
+        int top = 0;
+        std::uint32_t index = 0;
+        while (true) {
+            const Bvh::Node & node = nodes[index];
+            const unsigned mask = box(node, packet);
+            if (mask != 0) {
+                if (!node.leaf()) {
+                    // Near child first, as seen by the first active ray
+                    const bool left_first = packet.direction[node.axis][std::countr_zero(mask)] >= 0.0f;
+                    stack[top++] = left_first ? node.offset : index + 1;
+                    index = left_first ? index + 1 : node.offset;
+                    continue;
+                }
+                for (std::uint32_t i = node.offset; i < node.offset + node.count; ++i) {
+                    triangle(triangles[i], i, packet, mask);
+                }
+            }
+            if (top == 0) {
+                break;
+            }
+            index = stack[--top];
+        }
+    }
+
+#ifdef GOOB_X86
+    GOOB_TARGET("avx2")
+    unsigned box_avx2(const Bvh::Node & node, const RayPacket<8> & p) {
+        __m256 t_near = _mm256_setzero_ps(), t_far = _mm256_load_ps(p.t);
+        for (int a = 0; a < 3; ++a) {
+            const __m256 origin = _mm256_load_ps(p.origin[a]), inv = _mm256_load_ps(p.inv_direction[a]);
+            const __m256 t0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.min[a]), origin), inv);
+            const __m256 t1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.max[a]), origin), inv);
+            t_near = _mm256_max_ps(t_near, _mm256_min_ps(t0, t1));
+            t_far = _mm256_min_ps(t_far, _mm256_max_ps(t0, t1));
+        }
+        return unsigned(_mm256_movemask_ps(_mm256_cmp_ps(t_near, t_far, _CMP_LE_OQ)));
+    }
+
+    GOOB_TARGET("avx2")
+    void triangle_avx2(const MeshBvh::Triangle & tri, std::uint32_t id, RayPacket<8> & p, unsigned mask) {
+        const __m256 active = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+            _mm256_and_si256(_mm256_set1_epi32(static_cast<int>(mask)), _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128)),
+            _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128)));
+        const __m256 dx = _mm256_load_ps(p.direction[0]), dy = _mm256_load_ps(p.direction[1]), dz = _mm256_load_ps(p.direction[2]);
+        const __m256 e1x = _mm256_set1_ps(tri.e1.x), e1y = _mm256_set1_ps(tri.e1.y), e1z = _mm256_set1_ps(tri.e1.z);
+        const __m256 e2x = _mm256_set1_ps(tri.e2.x), e2y = _mm256_set1_ps(tri.e2.y), e2z = _mm256_set1_ps(tri.e2.z);
+
+        // p = d x e2, det = e1 . p
+        const __m256 px = _mm256_sub_ps(_mm256_mul_ps(dy, e2z), _mm256_mul_ps(dz, e2y));
+        const __m256 py = _mm256_sub_ps(_mm256_mul_ps(dz, e2x), _mm256_mul_ps(dx, e2z));
+        const __m256 pz = _mm256_sub_ps(_mm256_mul_ps(dx, e2y), _mm256_mul_ps(dy, e2x));
+        const __m256 det = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, px), _mm256_mul_ps(e1y, py)), _mm256_mul_ps(e1z, pz));
+        const __m256 inv_det = _mm256_div_ps(_mm256_set1_ps(1.0f), det);
+
+        // s = o - v0, u = s . p, q = s x e1, v = d . q, t = e2 . q
+        const __m256 sx = _mm256_sub_ps(_mm256_load_ps(p.origin[0]), _mm256_set1_ps(tri.v0.x));
+        const __m256 sy = _mm256_sub_ps(_mm256_load_ps(p.origin[1]), _mm256_set1_ps(tri.v0.y));
+        const __m256 sz = _mm256_sub_ps(_mm256_load_ps(p.origin[2]), _mm256_set1_ps(tri.v0.z));
+        const __m256 u = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, px), _mm256_mul_ps(sy, py)), _mm256_mul_ps(sz, pz)), inv_det);
+        const __m256 qx = _mm256_sub_ps(_mm256_mul_ps(sy, e1z), _mm256_mul_ps(sz, e1y));
+        const __m256 qy = _mm256_sub_ps(_mm256_mul_ps(sz, e1x), _mm256_mul_ps(sx, e1z));
+        const __m256 qz = _mm256_sub_ps(_mm256_mul_ps(sx, e1y), _mm256_mul_ps(sy, e1x));
+        const __m256 v = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, qx), _mm256_mul_ps(dy, qy)), _mm256_mul_ps(dz, qz)), inv_det);
+        const __m256 t = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, qx), _mm256_mul_ps(e2y, qy)), _mm256_mul_ps(e2z, qz)), inv_det);
+
+        const __m256 zero = _mm256_setzero_ps();
+        __m256 hit = _mm256_and_ps(active, _mm256_cmp_ps(det, zero, _CMP_NEQ_OQ));
+        hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(u, zero, _CMP_GE_OQ), _mm256_cmp_ps(v, zero, _CMP_GE_OQ)));
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_add_ps(u, v), _mm256_set1_ps(1.0f), _CMP_LE_OQ));
+        hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GT_OQ), _mm256_cmp_ps(t, _mm256_load_ps(p.t), _CMP_LT_OQ)));
+        if (_mm256_movemask_ps(hit) == 0) {
+            return;
+        }
+        _mm256_store_ps(p.t, _mm256_blendv_ps(_mm256_load_ps(p.t), t, hit));
+        _mm256_store_ps(p.u, _mm256_blendv_ps(_mm256_load_ps(p.u), u, hit));
+        _mm256_store_ps(p.v, _mm256_blendv_ps(_mm256_load_ps(p.v), v, hit));
+        const __m256 ids = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(id)));
+        _mm256_store_ps(reinterpret_cast<float *>(p.triangle), _mm256_blendv_ps(_mm256_load_ps(reinterpret_cast<const float *>(p.triangle)), ids, hit));
+    }
+
+    GOOB_TARGET("sse2")
+    __m128 select_sse2(__m128 mask, __m128 a, __m128 b) {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    GOOB_TARGET("sse2")
+    unsigned box_sse2(const Bvh::Node & node, const RayPacket<4> & p) {
+        __m128 t_near = _mm_setzero_ps(), t_far = _mm_load_ps(p.t);
+        for (int a = 0; a < 3; ++a) {
+            const __m128 origin = _mm_load_ps(p.origin[a]), inv = _mm_load_ps(p.inv_direction[a]);
+            const __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.min[a]), origin), inv);
+            const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.max[a]), origin), inv);
+            t_near = _mm_max_ps(t_near, _mm_min_ps(t0, t1));
+            t_far = _mm_min_ps(t_far, _mm_max_ps(t0, t1));
+        }
+        return unsigned(_mm_movemask_ps(_mm_cmple_ps(t_near, t_far)));
+    }
+
+    GOOB_TARGET("sse2")
+    void triangle_sse2(const MeshBvh::Triangle & tri, std::uint32_t id, RayPacket<4> & p, unsigned mask) {
+        const __m128i bits = _mm_setr_epi32(1, 2, 4, 8);
+        const __m128 active = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(static_cast<int>(mask)), bits), bits));
+        const __m128 dx = _mm_load_ps(p.direction[0]), dy = _mm_load_ps(p.direction[1]), dz = _mm_load_ps(p.direction[2]);
+        const __m128 e1x = _mm_set1_ps(tri.e1.x), e1y = _mm_set1_ps(tri.e1.y), e1z = _mm_set1_ps(tri.e1.z);
+        const __m128 e2x = _mm_set1_ps(tri.e2.x), e2y = _mm_set1_ps(tri.e2.y), e2z = _mm_set1_ps(tri.e2.z);
+
+        const __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+        const __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+        const __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+        const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+        const __m128 inv_det = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+        const __m128 sx = _mm_sub_ps(_mm_load_ps(p.origin[0]), _mm_set1_ps(tri.v0.x));
+        const __m128 sy = _mm_sub_ps(_mm_load_ps(p.origin[1]), _mm_set1_ps(tri.v0.y));
+        const __m128 sz = _mm_sub_ps(_mm_load_ps(p.origin[2]), _mm_set1_ps(tri.v0.z));
+        const __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inv_det);
+        const __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+        const __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+        const __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+        const __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inv_det);
+        const __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inv_det);
+
+        const __m128 zero = _mm_setzero_ps();
+        __m128 hit = _mm_and_ps(active, _mm_cmpneq_ps(det, zero));
+        hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmpge_ps(v, zero)));
+        hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+        hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpgt_ps(t, zero), _mm_cmplt_ps(t, _mm_load_ps(p.t))));
+        if (_mm_movemask_ps(hit) == 0) {
+            return;
+        }
+        _mm_store_ps(p.t, select_sse2(hit, t, _mm_load_ps(p.t)));
+        _mm_store_ps(p.u, select_sse2(hit, u, _mm_load_ps(p.u)));
+        _mm_store_ps(p.v, select_sse2(hit, v, _mm_load_ps(p.v)));
+        const __m128 ids = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(id)));
+        _mm_store_ps(reinterpret_cast<float *>(p.triangle), select_sse2(hit, ids, _mm_load_ps(reinterpret_cast<const float *>(p.triangle))));
+    }
+#endif
+}
+
+template<class Position>
+void MeshBvh::build(Position position, std::size_t vertex_count, std::span<const std::uint32_t> indices, ThreadPool * pool) {
+    if (indices.size() % 3 != 0) {
+        throw std::invalid_argument("Index count is not a multiple of three");
+    }
+    for (std::uint32_t index : indices) {
+        if (index >= vertex_count) {
+            throw std::invalid_argument("Vertex index out of range");
+        }
+    }
+
+    const std::size_t count = indices.size() / 3;
+    std::vector<Aabb> boxes(count);
+    for_each_index(count, pool, [&](std::size_t t) {
+        for (int c = 0; c < 3; ++c) {
+            boxes[t].extend(position(indices[3 * t + c]));
+        }
+    });
+    bvh_ = Bvh(boxes, pool);
+
+    triangles_.resize(count);
+    indices_.resize(indices.size());
+    const std::span<const std::uint32_t> order = bvh_.primitives();
+    for_each_index(count, pool, [&](std::size_t i) {
+        const std::uint32_t t = order[i];
+        const linalg::vec<float,3> v0 = position(indices[3 * t]);
+        triangles_[i] = {v0, position(indices[3 * t + 1]) - v0, position(indices[3 * t + 2]) - v0};
+        std::copy_n(indices.begin() + 3 * t, 3, indices_.begin() + 3 * i);
+    });
+}
+
+MeshBvh::MeshBvh(std::span<const linalg::vec<float,3>> positions, std::span<const std::uint32_t> indices, ThreadPool * pool) {
+    build([&](std::uint32_t i) { return positions[i]; }, positions.size(), indices, pool);
+}
+
+MeshBvh::MeshBvh(SoaConstSpan<3> positions, std::span<const std::uint32_t> indices, ThreadPool * pool) {
+    build([&](std::uint32_t i) { return positions.get(i); }, positions.size, indices, pool);
+}
+
+RayHit MeshBvh::intersect(const Ray & ray) const {
+    RayHit hit;
+    hit.t = ray.t_max;
+    const std::span<const Bvh::Node> nodes = bvh_.nodes();
+    if (nodes.empty()) {
+        hit.t = inf;
+        return hit;
+    }
+    const linalg::vec<float,3> inv_direction = reciprocal(ray.direction);
+    std::uint32_t stack[Bvh::max_depth];
+    int top = 0;
+    std::uint32_t index = 0;
+    while (true) {
+        const Bvh::Node & node = nodes[index];
+        if (hits_box(node, ray.origin, inv_direction, hit.t)) {
+            if (!node.leaf()) {
+                const bool left_first = ray.direction[node.axis] >= 0.0f;
+                stack[top++] = left_first ? node.offset : index + 1;
+                index = left_first ? index + 1 : node.offset;
+                continue;
+            }
+            for (std::uint32_t i = node.offset; i < node.offset + node.count; ++i) {
+                if (hits_triangle(triangles_[i], ray, hit.t, hit.t, hit.barycentric)) {
+                    hit.triangle = i;
+                }
+            }
+        }
+        if (top == 0) {
+            break;
+        }
+        index = stack[--top];
+    }
+    if (hit.hit()) {
+        hit.triangle = bvh_.primitives()[hit.triangle];
+    } else {
+        hit.t = inf;
+    }
+    return hit;
+}
+
+bool MeshBvh::occluded(const Ray & ray) const {
+    const std::span<const Bvh::Node> nodes = bvh_.nodes();
+    if (nodes.empty()) {
+        return false;
+    }
+    const linalg::vec<float,3> inv_direction = reciprocal(ray.direction);
+    std::uint32_t stack[Bvh::max_depth];
+    int top = 0;
+    std::uint32_t index = 0;
+    while (true) {
+        const Bvh::Node & node = nodes[index];
+        if (hits_box(node, ray.origin, inv_direction, ray.t_max)) {
+            if (!node.leaf()) {
+                stack[top++] = node.offset;
+                ++index;
+                continue;
+            }
+            float t;
+            linalg::vec<float,2> barycentric;
+            for (std::uint32_t i = node.offset; i < node.offset + node.count; ++i) {
+                if (hits_triangle(triangles_[i], ray, ray.t_max, t, barycentric)) {
+                    return true;
+                }
+            }
+        }
+        if (top == 0) {
+            return false;
+        }
+        index = stack[--top];
+    }
+}
+
+void MeshBvh::intersect(std::span<const Ray,4> rays, std::span<RayHit,4> hits) const {
+#ifdef GOOB_X86
+    if (simd_level() >= SimdLevel::sse2) {
+        RayPacket<4> packet(rays);
+        traverse<4>(bvh_.nodes(), triangles_, packet, box_sse2, triangle_sse2);
+        for (int i = 0; i < 4; ++i) {
+            const bool hit = packet.triangle[i] != RayHit::none;
+            hits[i] = {hit ? packet.t[i] : inf, hit ? bvh_.primitives()[packet.triangle[i]] : RayHit::none, {packet.u[i], packet.v[i]}};
+        }
+        return;
+    }
+#endif
+    for (int i = 0; i < 4; ++i) {
+        hits[i] = intersect(rays[i]);
+    }
+}
+
+void MeshBvh::intersect(std::span<const Ray,8> rays, std::span<RayHit,8> hits) const {
+#ifdef GOOB_X86
+    if (simd_level() >= SimdLevel::avx2) {
+        RayPacket<8> packet(rays);
+        traverse<8>(bvh_.nodes(), triangles_, packet, box_avx2, triangle_avx2);
+        for (int i = 0; i < 8; ++i) {
+            const bool hit = packet.triangle[i] != RayHit::none;
+            hits[i] = {hit ? packet.t[i] : inf, hit ? bvh_.primitives()[packet.triangle[i]] : RayHit::none, {packet.u[i], packet.v[i]}};
+        }
+        return;
+    }
+#endif
+    intersect(rays.first<4>(), hits.first<4>());
+    intersect(rays.last<4>(), hits.last<4>());
+}
+
+void MeshBvh::visible_indices(const Frustum & frustum, std::vector<std::uint32_t> & out) const {
+    bvh_.cull(frustum, [&](std::uint32_t first, std::uint32_t count) {
+        out.insert(out.end(), indices_.begin() + 3 * first, indices_.begin() + 3 * (first + count));
+    });
+}
+
+}
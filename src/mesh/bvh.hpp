@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "batch.hpp"
+#include "bounds.hpp"
+#include "mesh.hpp"
+
+namespace goob {
+
+class ThreadPool;
+
+// Bounding volume hierarchy over primitives given by their boxes.
+//
+// Built top-down with the binned surface area heuristic; a range falls back to a median split when no split
+// beats a leaf but it holds more than `max_leaf_size` primitives, or when the tree gets too deep. Nodes are
+// stored depth-first in one array of 32-byte nodes: an interior node's first child follows it directly and
+// `offset` is the index of the second one, a leaf covers primitives()[offset .. offset + count). Every subtree
+// therefore covers a contiguous range of primitives().
+//
+// With a pool the upper levels are split on the calling thread until there are enough subtrees to keep the
+// workers busy; those are built in parallel and spliced into the array.
+class Bvh {
+public:
+    static constexpr int bins = 16;
+    static constexpr int max_depth = 128;    // bound on the depth of any leaf, sizes traversal stacks
+
+    struct alignas(32) Node {
+        linalg::vec<float,3> min;
+        std::uint32_t offset;
+        linalg::vec<float,3> max;
+        std::uint16_t count;    // primitives of a leaf, 0 for interior nodes
+        std::uint16_t axis;     // split axis of interior nodes
+
+        bool leaf() const { return count != 0; }
+        Aabb bounds() const { return {min, max}; }
+    };
+
+    Bvh() = default;
+    // Throws std::invalid_argument when max_leaf_size is not within [1, 255]
+    explicit Bvh(std::span<const Aabb> boxes, ThreadPool * pool = nullptr, int max_leaf_size = 4);
+
+    std::span<const Node> nodes() const { return nodes_; }
+    std::span<const std::uint32_t> primitives() const { return primitives_; }     // primitive ids in leaf order
+    Aabb bounds() const { return nodes_.empty() ? Aabb{} : nodes_[0].bounds(); }
+
+    // Calls visible(first, count) for ranges of primitives() whose boxes may intersect the frustum, in order and
+    // with adjacent ranges merged. Subtrees entirely inside the frustum are reported without visiting them.
+    template<class Visible>
+    void cull(const Frustum & frustum, Visible && visible) const;
+
+private:
+    std::vector<Node> nodes_;
+    std::vector<std::uint32_t> primitives_;
+};
+
+template<class Visible>
+void Bvh::cull(const Frustum & frustum, Visible && visible) const {
+    if (nodes_.empty()) {
+        return;
+    }
+    std::uint32_t first = 0, count = 0;
+    const auto report = [&](std::uint32_t begin, std::uint32_t end) {
+        if (count != 0 && first + count == begin) {
+            count = end - first;
+            return;
+        }
+        if (count != 0) {
+            visible(first, count);
+        }
+        first = begin;
+        count = end - begin;
+    };
+
+    std::uint32_t stack[max_depth];
+    int top = 0;
+    std::uint32_t index = 0;
+    while (true) {
+        const Node & node = nodes_[index];
+        const Visibility visibility = frustum.classify(node.bounds());
+        if (visibility == Visibility::inside || (visibility == Visibility::intersecting && node.leaf())) {
+            // The subtree's range runs from its leftmost to its rightmost leaf
+            std::uint32_t left = index, right = index;
+            while (!nodes_[left].leaf()) {
+                ++left;
+            }
+            while (!nodes_[right].leaf()) {
+                right = nodes_[right].offset;
+            }
+            report(nodes_[left].offset, nodes_[right].offset + nodes_[right].count);
+        } else if (visibility == Visibility::intersecting) {
+            stack[top++] = node.offset;
+            index = index + 1;
+            continue;
+        }
+        if (top == 0) {
+            break;
+        }
+        index = stack[--top];
+    }
+    if (count != 0) {
+        visible(first, count);
+    }
+}
+
+struct Ray {
+    linalg::vec<float,3> origin;
+    linalg::vec<float,3> direction;     // need not be normalized; t is in units of its length
+    float t_max = std::numeric_limits<float>::infinity();
+};
+
+struct RayHit {
+    static constexpr std::uint32_t none = ~0u;
+
+    float t = std::numeric_limits<float>::infinity();
+    std::uint32_t triangle = none;      // index of the triangle in the mesh
+    linalg::vec<float,2> barycentric;   // weights of the triangle's second and third vertex
+
+    bool hit() const { return triangle != none; }
+};
+
+// BVH over the triangles of an indexed mesh, for frustum culling and ray queries.
+//
+// The triangles are copied in leaf order as a vertex and two edges (the form Moller-Trumbore intersection
+// needs), so a leaf's triangles are adjacent in memory. Throws std::invalid_argument for an index count that is
+// not a multiple of three or an index out of range.
+class MeshBvh {
+public:
+    MeshBvh(std::span<const linalg::vec<float,3>> positions, std::span<const std::uint32_t> indices, ThreadPool * pool = nullptr);
+    MeshBvh(SoaConstSpan<3> positions, std::span<const std::uint32_t> indices, ThreadPool * pool = nullptr);
+    explicit MeshBvh(const Mesh & mesh, ThreadPool * pool = nullptr) : MeshBvh(mesh.positions, mesh.indices, pool) {}
+
+    const Bvh & bvh() const { return bvh_; }
+    std::size_t triangle_count() const { return triangles_.size(); }
+
+    // Nearest hit with 0 < t < ray.t_max
+    RayHit intersect(const Ray & ray) const;
+    // Whether anything is hit with 0 < t < ray.t_max, stopping at the first hit found (shadow rays)
+    bool occluded(const Ray & ray) const;
+
+    // Nearest hits of a packet of rays. The rays traverse the tree together and every node and triangle is tested
+    // against all of them at once with SSE2 or AVX2, which pays off for coherent rays: picking around a cursor or
+    // shadow rays towards one light.
+    void intersect(std::span<const Ray,4> rays, std::span<RayHit,4> hits) const;
+    void intersect(std::span<const Ray,8> rays, std::span<RayHit,8> hits) const;
+
+    // Appends the vertex indices of the triangles that may be inside the frustum to `out`, in leaf order, which
+    // keeps neighbouring triangles together for the renderer's vertex cache
+    void visible_indices(const Frustum & frustum, std::vector<std::uint32_t> & out) const;
+
+    // A triangle in leaf order
+    struct Triangle {
+        linalg::vec<float,3> v0, e1, e2;
+    };
+
+private:
+    template<class Position>
+    void build(Position position, std::size_t vertex_count, std::span<const std::uint32_t> indices, ThreadPool * pool);
+
+    Bvh bvh_;
+    std::vector<Triangle> triangles_;
+    std::vector<std::uint32_t> indices_;    // three per triangle, in leaf order
+};
+
+}
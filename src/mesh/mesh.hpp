@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "vector.hpp"
+
+namespace goob {
+
+// Indexed triangle mesh. Attribute arrays are either empty or have one entry per vertex.
+struct Mesh {
+    std::vector<linalg::vec<float,3>> positions;
+    std::vector<linalg::vec<float,3>> normals;
+    std::vector<linalg::vec<float,2>> texcoords;
+    std::vector<std::uint32_t> indices;     // three per triangle
+
+    std::size_t vertex_count() const { return positions.size(); }
+    std::size_t triangle_count() const { return indices.size() / 3; }
+};
+
+}
@@ -0,0 +1,264 @@
+#include "mesh_cache.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include "atomic_file.hpp"
+#include "obj_loader.hpp"
+#include "thread_pool.hpp"
+
+namespace goob {
+
+namespace {
+    constexpr char magic[8] = {'G', 'O', 'O', 'B', 'M', 'E', 'S', 'H'};
+    constexpr std::size_t stream_alignment = 64;
+    constexpr std::size_t hash_block = 1 << 20;
+    constexpr int float_streams = 8;
+
+    constexpr std::uint32_t normals_present = 1;
+    constexpr std::uint32_t texcoords_present = 2;
+
+    // On-disk header, little-endian. Stream offsets are from the start of the file; index stream last.
+    struct CacheHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t flags;
+        std::uint64_t source_size;
+        std::int64_t source_mtime;
+        std::uint64_t source_hash;
+        std::uint64_t vertex_count;
+        std::uint64_t index_count;
+        std::uint64_t offsets[float_streams + 1];
+    };
+    static_assert(sizeof(CacheHeader) == 128);
+
+    void require_little_endian() {
+        if constexpr (std::endian::native != std::endian::little) {
+            throw std::runtime_error("Mesh caches are only supported on little-endian hosts");
+        }
+    }
+
+    std::size_t align_up(std::size_t offset) {
+        return (offset + stream_alignment - 1) & ~(stream_alignment - 1);
+    }
+
+    std::uint64_t mix(std::uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        return h ^ (h >> 33);
+    }
+
+    // Four independent multiply-rotate lanes over 8-byte words, so the multiplies of a block overlap
+    std::uint64_t hash_block_bytes(const std::uint8_t * data, std::size_t size) {
+        std::uint64_t lanes[4] = {0x9e3779b97f4a7c15ull, 0xbf58476d1ce4e5b9ull, 0x94d049bb133111ebull, 0x2545f4914f6cdd1dull};
+        std::size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            for (int l = 0; l < 4; ++l) {
+                std::uint64_t word;
+                std::memcpy(&word, data + i + 8 * l, 8);
+                lanes[l] = std::rotl(lanes[l] ^ word, 29) * 0x9fb21c651e98df25ull;
+            }
+        }
+        std::uint64_t h = size;
+        for (; i < size; ++i) {
+            h = (h ^ data[i]) * 0x100000001b3ull;
+        }
+        for (std::uint64_t lane : lanes) {
+            h = mix(h ^ lane);
+        }
+        return h;
+    }
+
+    // Blocks have a fixed size so the hash does not depend on the number of workers
+    std::uint64_t hash_bytes(std::span<const std::uint8_t> bytes, ThreadPool * pool) {
+        const std::size_t blocks = (bytes.size() + hash_block - 1) / hash_block;
+        std::vector<std::uint64_t> hashes(blocks);
+        const auto body = [&](std::size_t b) {
+            const std::size_t begin = b * hash_block;
+            hashes[b] = hash_block_bytes(bytes.data() + begin, std::min(hash_block, bytes.size() - begin));
+        };
+        if (pool) {
+            pool->parallel_for(blocks, [&](std::size_t b, unsigned) { body(b); });
+        } else {
+            for (std::size_t b = 0; b < blocks; ++b) {
+                body(b);
+            }
+        }
+        std::uint64_t h = mix(bytes.size());
+        for (std::uint64_t block : hashes) {
+            h = mix(h ^ block) + 0x9e3779b97f4a7c15ull;
+        }
+        return h;
+    }
+
+    std::int64_t modification_time(const std::filesystem::path & path) {
+        return static_cast<std::int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count());
+    }
+
+    // Records a new source mtime in place, so later opens trust the stamp again instead of rehashing. Best
+    // effort: a read-only cache just keeps being verified through the hash.
+    void refresh_mtime(const std::filesystem::path & cache, std::int64_t mtime) {
+        std::fstream file(cache, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(offsetof(CacheHeader, source_mtime));
+        file.write(reinterpret_cast<const char *>(&mtime), sizeof(mtime));
+    }
+}
+
+SourceStamp SourceStamp::of(const std::filesystem::path & source, ThreadPool * pool) {
+    const MappedFile file(source);
+    return {file.size(), modification_time(source), hash_bytes(file.bytes(), pool)};
+}
+
+CachedMesh::CachedMesh(const std::filesystem::path & cache) : file_(cache) {
+    require_little_endian();
+
+    CacheHeader header;
+    if (file_.size() < sizeof(header)) {
+        throw std::runtime_error("Mesh cache truncated: " + cache.string());
+    }
+    std::memcpy(&header, file_.data(), sizeof(header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0) {
+        throw std::runtime_error("Not a mesh cache: " + cache.string());
+    }
+    if (header.version != version) {
+        throw std::runtime_error("Mesh cache version " + std::to_string(header.version) + " unsupported: " + cache.string());
+    }
+
+    const auto check_stream = [&](std::uint64_t offset, std::uint64_t bytes) {
+        if (offset % stream_alignment != 0 || offset > file_.size() || bytes > file_.size() - offset) {
+            throw std::runtime_error("Mesh cache streams out of bounds: " + cache.string());
+        }
+    };
+    if (header.vertex_count > file_.size() || header.index_count > file_.size() || header.index_count % 3 != 0) {
+        throw std::runtime_error("Mesh cache counts invalid: " + cache.string());
+    }
+
+    has_normals_ = header.flags & normals_present;
+    has_texcoords_ = header.flags & texcoords_present;
+    vertex_count_ = header.vertex_count;
+    for (int s = 0; s < float_streams; ++s) {
+        const bool present = s < 3 || (s < 6 ? has_normals_ : has_texcoords_);
+        if (present) {
+            check_stream(header.offsets[s], header.vertex_count * sizeof(float));
+            streams_[s] = reinterpret_cast<const float *>(file_.data() + header.offsets[s]);
+        }
+    }
+    check_stream(header.offsets[float_streams], header.index_count * sizeof(std::uint32_t));
+    indices_ = {reinterpret_cast<const std::uint32_t *>(file_.data() + header.offsets[float_streams]), header.index_count};
+    for (std::uint32_t index : indices_) {
+        if (index >= vertex_count_) {
+            throw std::runtime_error("Mesh cache index out of range: " + cache.string());
+        }
+    }
+    stamp_ = {header.source_size, header.source_mtime, header.source_hash};
+}
+
+std::optional<CachedMesh> CachedMesh::open(const std::filesystem::path & cache, const std::filesystem::path & source, ThreadPool * pool) {
+    std::error_code error;
+    if (!std::filesystem::exists(cache, error)) {
+        return std::nullopt;
+    }
+    try {
+        CachedMesh mesh(cache);
+        const std::uint64_t size = std::filesystem::file_size(source);
+        if (size != mesh.stamp_.size) {
+            return std::nullopt;
+        }
+        const std::int64_t mtime = modification_time(source);
+        if (mtime != mesh.stamp_.mtime) {
+            if (SourceStamp::of(source, pool).hash != mesh.stamp_.hash) {
+                return std::nullopt;
+            }
+            refresh_mtime(cache, mtime);
+            mesh.stamp_.mtime = mtime;
+        }
+        return mesh;
+    } catch (const std::exception &) {
+        return std::nullopt;
+    }
+}
+
+Mesh CachedMesh::to_mesh() const {
+    Mesh mesh;
+    mesh.positions.resize(vertex_count_);
+    mesh.normals.resize(has_normals_ ? vertex_count_ : 0);
+    mesh.texcoords.resize(has_texcoords_ ? vertex_count_ : 0);
+    for (std::size_t i = 0; i < vertex_count_; ++i) {
+        mesh.positions[i] = positions().get(i);
+        if (has_normals_) {
+            mesh.normals[i] = normals().get(i);
+        }
+        if (has_texcoords_) {
+            mesh.texcoords[i] = texcoords().get(i);
+        }
+    }
+    mesh.indices.assign(indices_.begin(), indices_.end());
+    return mesh;
+}
+
+void write_mesh_cache(const std::filesystem::path & cache, const Mesh & mesh, const SourceStamp & stamp) {
+    require_little_endian();
+
+    const std::size_t n = mesh.vertex_count();
+    if ((!mesh.normals.empty() && mesh.normals.size() != n) || (!mesh.texcoords.empty() && mesh.texcoords.size() != n)) {
+        throw std::invalid_argument("Mesh attribute arrays differ in length");
+    }
+
+    CacheHeader header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = CachedMesh::version;
+    header.flags = (mesh.normals.empty() ? 0u : normals_present) | (mesh.texcoords.empty() ? 0u : texcoords_present);
+    header.source_size = stamp.size;
+    header.source_mtime = stamp.mtime;
+    header.source_hash = stamp.hash;
+    header.vertex_count = n;
+    header.index_count = mesh.indices.size();
+
+    // Absent streams keep offset 0 and take no space
+    std::size_t offset = align_up(sizeof(header));
+    for (int s = 0; s < float_streams; ++s) {
+        const bool present = s < 3 || (s < 6 ? !mesh.normals.empty() : !mesh.texcoords.empty());
+        if (present) {
+            header.offsets[s] = offset;
+            offset = align_up(offset + n * sizeof(float));
+        }
+    }
+    header.offsets[float_streams] = offset;
+    const std::size_t file_size = offset + mesh.indices.size() * sizeof(std::uint32_t);
+
+    std::vector<std::uint8_t> bytes(file_size, 0);
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    for (std::size_t i = 0; i < n; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            std::memcpy(bytes.data() + header.offsets[c] + i * sizeof(float), &mesh.positions[i][c], sizeof(float));
+            if (!mesh.normals.empty()) {
+                std::memcpy(bytes.data() + header.offsets[3 + c] + i * sizeof(float), &mesh.normals[i][c], sizeof(float));
+            }
+        }
+        for (int c = 0; c < 2 && !mesh.texcoords.empty(); ++c) {
+            std::memcpy(bytes.data() + header.offsets[6 + c] + i * sizeof(float), &mesh.texcoords[i][c], sizeof(float));
+        }
+    }
+    std::memcpy(bytes.data() + header.offsets[float_streams], mesh.indices.data(), mesh.indices.size() * sizeof(std::uint32_t));
+
+    write_file_atomic(cache, bytes);
+}
+
+CachedMesh load_mesh_cached(const std::filesystem::path & source, const std::filesystem::path & cache, ThreadPool * pool) {
+    if (std::optional<CachedMesh> cached = CachedMesh::open(cache, source, pool)) {
+        return std::move(*cached);
+    }
+    // Stamp before parsing so a source modified meanwhile leaves the cache stale rather than wrong
+    const SourceStamp stamp = SourceStamp::of(source, pool);
+    write_mesh_cache(cache, load_obj(source, pool), stamp);
+    return CachedMesh(cache);
+}
+
+}
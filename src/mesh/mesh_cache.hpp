@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+#include "batch.hpp"
+#include "mapped_file.hpp"
+#include "mesh.hpp"
+
+namespace goob {
+
+class ThreadPool;
+
+// Identity of the source file a cache was built from
+struct SourceStamp {
+    std::uint64_t size = 0;
+    std::int64_t mtime = 0;     // std::filesystem::file_time_type ticks
+    std::uint64_t hash = 0;     // of the file contents
+
+    // Hashes the file contents, in parallel on `pool` when given
+    static SourceStamp of(const std::filesystem::path & source, ThreadPool * pool = nullptr);
+};
+
+// Binary mesh cache.
+//
+// A little-endian file holding a header with the source stamp followed by one stream per attribute component
+// (position x/y/z, normal x/y/z, texcoord u/v) and the index stream, each starting on a 64-byte boundary.
+// Opening a cache maps the file and the streams are used in place: positions feed the SoA batch kernels directly.
+class CachedMesh {
+public:
+    static constexpr std::uint32_t version = 1;
+
+    // Throws std::runtime_error when the file is missing, of another version or malformed
+    explicit CachedMesh(const std::filesystem::path & cache);
+
+    // Opens the cache when it was built from the current contents of `source`. A matching size and mtime is
+    // trusted; when only the mtime differs the source is hashed, and a matching hash records the new mtime in the
+    // cache so later opens skip hashing. Returns nullopt for stale or unreadable caches.
+    static std::optional<CachedMesh> open(const std::filesystem::path & cache, const std::filesystem::path & source, ThreadPool * pool = nullptr);
+
+    const SourceStamp & stamp() const { return stamp_; }
+    std::size_t vertex_count() const { return vertex_count_; }
+    std::size_t triangle_count() const { return indices_.size() / 3; }
+    bool has_normals() const { return has_normals_; }
+    bool has_texcoords() const { return has_texcoords_; }
+
+    SoaConstSpan<3> positions() const { return {{streams_[0], streams_[1], streams_[2]}, vertex_count_}; }
+    SoaConstSpan<3> normals() const { return {{streams_[3], streams_[4], streams_[5]}, has_normals_ ? vertex_count_ : 0}; }
+    SoaConstSpan<2> texcoords() const { return {{streams_[6], streams_[7]}, has_texcoords_ ? vertex_count_ : 0}; }
+    std::span<const std::uint32_t> indices() const { return indices_; }
+
+    // Copies the streams into an AoS mesh
+    Mesh to_mesh() const;
+
+private:
+    MappedFile file_;
+    SourceStamp stamp_;
+    std::size_t vertex_count_ = 0;
+    bool has_normals_ = false;
+    bool has_texcoords_ = false;
+    std::array<const float *, 8> streams_{};
+    std::span<const std::uint32_t> indices_;
+};
+
+// Writes `mesh` as a cache of the source described by `stamp` through write_file_atomic(), so concurrent readers
+// see either the old or the new cache and concurrent writers never interleave.
+void write_mesh_cache(const std::filesystem::path & cache, const Mesh & mesh, const SourceStamp & stamp);
+
+// Loads an OBJ file through the cache at `cache`, parsing the source and rewriting the cache when it is stale
+CachedMesh load_mesh_cached(const std::filesystem::path & source, const std::filesystem::path & cache, ThreadPool * pool = nullptr);
+
+}
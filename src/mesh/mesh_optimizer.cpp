@@ -0,0 +1,178 @@
+#include "mesh_optimizer.hpp"
+
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace goob {
+
+namespace {
+    void validate(std::span<const std::uint32_t> indices, std::size_t vertex_count) {
+        if (indices.size() % 3 != 0) {
+            throw std::invalid_argument("Index count is not a multiple of three");
+        }
+        for (std::uint32_t index : indices) {
+            if (index >= vertex_count) {
+                throw std::invalid_argument("Vertex index out of range");
+            }
+        }
+    }
+
+    // Triangles around each vertex, as offsets into one flat list
+    struct Adjacency {
+        std::vector<std::uint32_t> offsets;
+        std::vector<std::uint32_t> triangles;
+
+        Adjacency(std::span<const std::uint32_t> indices, std::size_t vertex_count) : offsets(vertex_count + 1, 0), triangles(indices.size()) {
+            for (std::uint32_t index : indices) {
+                ++offsets[index + 1];
+            }
+            for (std::size_t v = 0; v < vertex_count; ++v) {
+                offsets[v + 1] += offsets[v];
+            }
+            std::vector<std::uint32_t> next(offsets.begin(), offsets.end() - 1);
+            for (std::size_t i = 0; i < indices.size(); ++i) {
+                triangles[next[indices[i]]++] = static_cast<std::uint32_t>(i / 3);
+            }
+        }
+
+        std::span<const std::uint32_t> of(std::uint32_t vertex) const {
+            return std::span(triangles).subspan(offsets[vertex], offsets[vertex + 1] - offsets[vertex]);
+        }
+    };
+}
+
+std::vector<std::uint32_t> optimize_vertex_cache(std::span<const std::uint32_t> indices, std::size_t vertex_count, unsigned cache_size) {
+    validate(indices, vertex_count);
+    const Adjacency adjacency(indices, vertex_count);
+
+    std::vector<std::uint32_t> live(vertex_count);
+    for (std::size_t v = 0; v < vertex_count; ++v) {
+        live[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+    }
+    // A vertex is in the cache while time - cached[v] <= cache_size
+    std::vector<std::uint64_t> cached(vertex_count, 0);
+    std::uint64_t time = cache_size + 1;
+    std::vector<bool> emitted(indices.size() / 3, false);
+    std::vector<std::uint32_t> dead_ends;
+    std::vector<std::uint32_t> candidates;
+    std::uint32_t cursor = 0;
+
+    std::vector<std::uint32_t> out;
+    out.reserve(indices.size());
+
+    // Any vertex with triangles left: the most recent dead end, else the next one in input order
+    const auto restart = [&]() -> std::int64_t {
+        while (!dead_ends.empty()) {
+            const std::uint32_t v = dead_ends.back();
+            dead_ends.pop_back();
+            if (live[v] > 0) {
+                return v;
+            }
+        }
+        for (; cursor < vertex_count; ++cursor) {
+            if (live[cursor] > 0) {
+                return cursor;
+            }
+        }
+        return -1;
+    };
+
+    std::int64_t fan = restart();
+    while (fan >= 0) {
+        candidates.clear();
+        for (std::uint32_t t : adjacency.of(static_cast<std::uint32_t>(fan))) {
+            if (emitted[t]) {
+                continue;
+            }
+            emitted[t] = true;
+            for (int c = 0; c < 3; ++c) {
+                const std::uint32_t v = indices[3 * t + c];
+                out.push_back(v);
+                dead_ends.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                if (time - cached[v] > cache_size) {
+                    cached[v] = time++;
+                }
+            }
+        }
+
+        // Prefer the candidate that stays in the cache while its remaining triangles are emitted, and among
+        // those the one that entered the cache first
+        std::int64_t best = -1;
+        std::int64_t best_priority = -1;
+        for (std::uint32_t v : candidates) {
+            if (live[v] == 0) {
+                continue;
+            }
+            std::int64_t priority = 0;
+            if (time - cached[v] + 2 * live[v] <= cache_size) {
+                priority = static_cast<std::int64_t>(time - cached[v]);
+            }
+            if (priority > best_priority) {
+                best = v;
+                best_priority = priority;
+            }
+        }
+        fan = best >= 0 ? best : restart();
+    }
+    return out;
+}
+
+void optimize_vertex_fetch(Mesh & mesh) {
+    const std::size_t n = mesh.vertex_count();
+    validate(mesh.indices, n);
+    if ((!mesh.normals.empty() && mesh.normals.size() != n) || (!mesh.texcoords.empty() && mesh.texcoords.size() != n)) {
+        throw std::invalid_argument("Mesh attribute arrays differ in length");
+    }
+
+    constexpr std::uint32_t unused = ~0u;
+    std::vector<std::uint32_t> remap(n, unused);
+    std::uint32_t next = 0;
+    for (std::uint32_t & index : mesh.indices) {
+        if (remap[index] == unused) {
+            remap[index] = next++;
+        }
+        index = remap[index];
+    }
+
+    const auto permute = [&](auto & attribute) {
+        if (attribute.empty()) {
+            return;
+        }
+        std::remove_reference_t<decltype(attribute)> reordered(next);
+        for (std::size_t v = 0; v < n; ++v) {
+            if (remap[v] != unused) {
+                reordered[remap[v]] = attribute[v];
+            }
+        }
+        attribute = std::move(reordered);
+    };
+    permute(mesh.positions);
+    permute(mesh.normals);
+    permute(mesh.texcoords);
+}
+
+void optimize_mesh(Mesh & mesh, unsigned cache_size) {
+    mesh.indices = optimize_vertex_cache(mesh.indices, mesh.vertex_count(), cache_size);
+    optimize_vertex_fetch(mesh);
+}
+
+double average_cache_miss_ratio(std::span<const std::uint32_t> indices, std::size_t vertex_count, unsigned cache_size) {
+    validate(indices, vertex_count);
+    if (indices.empty()) {
+        return 0.0;
+    }
+    // FIFO: a vertex is cached while fewer than cache_size misses happened since its own
+    std::vector<std::uint64_t> inserted(vertex_count, 0);
+    std::uint64_t misses = 0;
+    for (std::uint32_t index : indices) {
+        if (inserted[index] == 0 || misses - inserted[index] >= cache_size) {
+            inserted[index] = ++misses;
+        }
+    }
+    return static_cast<double>(misses) / static_cast<double>(indices.size() / 3);
+}
+
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "mesh.hpp"
+
+namespace goob {
+
+// Offline reordering of indexed meshes for the renderer's indexed draw path.
+//
+// Triangles that share vertices should be close in the index stream so a vertex is shaded once rather than
+// once per batch of triangles referencing it, and vertices should be stored in the order they are fetched.
+// All functions throw std::invalid_argument when the index count is not a multiple of three or an index is out
+// of range. Triangle windings are preserved.
+
+// Reorders the triangles of `indices` for a post-transform vertex cache of `cache_size` entries (Tipsify,
+// Sander et al. 2007): triangles are emitted in fans around a vertex, moving to the adjacent vertex that is
+// still in the cache and has the fewest remaining triangles. Linear in the size of the mesh.
+std::vector<std::uint32_t> optimize_vertex_cache(std::span<const std::uint32_t> indices, std::size_t vertex_count, unsigned cache_size = 16);
+
+// Renumbers the vertices of `mesh` in order of first use by its indices, so vertex fetches walk the attribute
+// arrays forward. Vertices no triangle references are dropped.
+void optimize_vertex_fetch(Mesh & mesh);
+
+// optimize_vertex_cache() followed by optimize_vertex_fetch()
+void optimize_mesh(Mesh & mesh, unsigned cache_size = 16);
+
+// Vertices transformed per triangle when drawing `indices` through a FIFO cache of `cache_size` entries,
+// between 3 (no reuse) and about 0.5 (every vertex transformed once on a closed mesh)
+double average_cache_miss_ratio(std::span<const std::uint32_t> indices, std::size_t vertex_count, unsigned cache_size = 16);
+
+}
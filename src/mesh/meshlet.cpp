@@ -0,0 +1,149 @@
+#include "meshlet.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace goob {
+
+namespace {
+    // Cones wider than this (dot of the axis with some triangle normal below it) cull too rarely to be worth
+    // the test and make the apex run off to infinity
+    constexpr float min_cone_dot = 0.1f;
+
+    void compute_bounds(Meshlets & out, Meshlet & m, std::span<const linalg::vec<float,3>> positions) {
+        Aabb box;
+        for (std::uint32_t v = 0; v < m.vertex_count; ++v) {
+            box.extend(positions[out.vertices[m.vertex_offset + v]]);
+        }
+        m.center = box.center();
+        m.radius = 0.0f;
+        for (std::uint32_t v = 0; v < m.vertex_count; ++v) {
+            m.radius = std::max(m.radius, linalg::distance(m.center, positions[out.vertices[m.vertex_offset + v]]));
+        }
+
+        // Area-weighted average normal as the axis, the widest normal deviation as the cone angle
+        linalg::vec<float,3> axis = {0, 0, 0};
+        for (std::uint32_t t = 0; t < m.triangle_count; ++t) {
+            const linalg::vec<float,3> p0 = positions[out.index(m, t, 0)];
+            axis += linalg::cross(positions[out.index(m, t, 1)] - p0, positions[out.index(m, t, 2)] - p0);
+        }
+        m.cone_apex = m.center;
+        m.cone_axis = {0, 0, 0};
+        m.cone_cutoff = 2.0f;
+        const float axis_length = linalg::length(axis);
+        if (!(axis_length > 0.0f)) {
+            return;
+        }
+        axis /= axis_length;
+
+        float min_dot = 1.0f;
+        for (std::uint32_t t = 0; t < m.triangle_count; ++t) {
+            const linalg::vec<float,3> p0 = positions[out.index(m, t, 0)];
+            const linalg::vec<float,3> n = linalg::cross(positions[out.index(m, t, 1)] - p0, positions[out.index(m, t, 2)] - p0);
+            const float length = linalg::length(n);
+            if (length > 0.0f) {
+                min_dot = std::min(min_dot, linalg::dot(axis, n / length));
+            }
+        }
+        if (min_dot < min_cone_dot) {
+            return;
+        }
+
+        // Move the apex back along the axis until it lies behind every triangle's plane, so a camera in front
+        // of the apex sees all triangles from behind once it is inside the cone
+        float max_t = 0.0f;
+        for (std::uint32_t t = 0; t < m.triangle_count; ++t) {
+            const linalg::vec<float,3> p0 = positions[out.index(m, t, 0)];
+            const linalg::vec<float,3> n = linalg::cross(positions[out.index(m, t, 1)] - p0, positions[out.index(m, t, 2)] - p0);
+            const float length = linalg::length(n);
+            if (length > 0.0f) {
+                const linalg::vec<float,3> normal = n / length;
+                max_t = std::max(max_t, linalg::dot(m.center - p0, normal) / linalg::dot(axis, normal));
+            }
+        }
+        m.cone_apex = m.center - axis * max_t;
+        m.cone_axis = axis;
+        m.cone_cutoff = std::sqrt(1.0f - min_dot * min_dot);
+    }
+}
+
+Meshlets build_meshlets(std::span<const linalg::vec<float,3>> positions, std::span<const std::uint32_t> indices) {
+    if (indices.size() % 3 != 0) {
+        throw std::invalid_argument("Index count is not a multiple of three");
+    }
+    for (std::uint32_t index : indices) {
+        if (index >= positions.size()) {
+            throw std::invalid_argument("Vertex index out of range");
+        }
+    }
+
+    Meshlets out;
+    // Local index of each mesh vertex in the current meshlet, valid when its stamp matches the meshlet number
+    std::vector<std::uint8_t> local(positions.size());
+    std::vector<std::uint32_t> stamp(positions.size(), ~0u);
+
+    Meshlet current{};
+    const auto finish = [&] {
+        if (current.triangle_count == 0) {
+            return;
+        }
+        compute_bounds(out, current, positions);
+        out.meshlets.push_back(current);
+        current = {};
+        current.vertex_offset = static_cast<std::uint32_t>(out.vertices.size());
+        current.triangle_offset = static_cast<std::uint32_t>(out.triangles.size() / 3);
+    };
+
+    for (std::size_t i = 0; i < indices.size(); i += 3) {
+        const std::uint32_t id = static_cast<std::uint32_t>(out.meshlets.size());
+        int added = 0;
+        for (int c = 0; c < 3; ++c) {
+            const std::uint32_t v = indices[i + c];
+            added += stamp[v] != id && (c < 1 || v != indices[i]) && (c < 2 || v != indices[i + 1]);
+        }
+        if (current.vertex_count + added > Meshlets::max_vertices || current.triangle_count + 1 > Meshlets::max_triangles) {
+            finish();
+        }
+        const std::uint32_t meshlet = static_cast<std::uint32_t>(out.meshlets.size());
+        for (int c = 0; c < 3; ++c) {
+            const std::uint32_t v = indices[i + c];
+            if (stamp[v] != meshlet) {
+                stamp[v] = meshlet;
+                local[v] = static_cast<std::uint8_t>(current.vertex_count++);
+                out.vertices.push_back(v);
+            }
+            out.triangles.push_back(local[v]);
+        }
+        ++current.triangle_count;
+    }
+    finish();
+    return out;
+}
+
+bool meshlet_visible(const Meshlet & meshlet, const Frustum & frustum, const linalg::vec<float,3> & camera) {
+    if (frustum.classify(meshlet.center, meshlet.radius) == Visibility::outside) {
+        return false;
+    }
+    const linalg::vec<float,3> view = meshlet.cone_apex - camera;
+    const float distance = linalg::length(view);
+    return !(distance > 0.0f && linalg::dot(view, meshlet.cone_axis) >= meshlet.cone_cutoff * distance);
+}
+
+std::size_t cull_meshlets(const Meshlets & meshlets, const Frustum & frustum, const linalg::vec<float,3> & camera, std::vector<std::uint32_t> & out) {
+    std::size_t visible = 0;
+    for (const Meshlet & m : meshlets.meshlets) {
+        if (!meshlet_visible(m, frustum, camera)) {
+            continue;
+        }
+        ++visible;
+        for (std::uint32_t t = 0; t < m.triangle_count; ++t) {
+            for (int c = 0; c < 3; ++c) {
+                out.push_back(meshlets.index(m, t, c));
+            }
+        }
+    }
+    return visible;
+}
+
+}
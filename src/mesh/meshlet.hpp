@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "bounds.hpp"
+#include "mesh.hpp"
+
+namespace goob {
+
+// A cluster of up to Meshlets::max_vertices vertices and Meshlets::max_triangles triangles with the data to
+// reject it as a whole
+struct Meshlet {
+    std::uint32_t vertex_offset;        // first entry in Meshlets::vertices
+    std::uint32_t triangle_offset;      // first triangle in Meshlets::triangles (three entries each)
+    std::uint32_t vertex_count;
+    std::uint32_t triangle_count;
+
+    // Bounding sphere
+    linalg::vec<float,3> center;
+    float radius;
+
+    // Normal cone: every triangle is back-facing for a camera at c when
+    // dot(normalize(cone_apex - c), cone_axis) >= cone_cutoff. A cutoff above 1 never culls.
+    linalg::vec<float,3> cone_apex;
+    linalg::vec<float,3> cone_axis;
+    float cone_cutoff;
+};
+
+// A mesh split into meshlets. Triangles reference vertices local to their meshlet, which map to mesh vertices
+// through `vertices`.
+struct Meshlets {
+    static constexpr std::size_t max_vertices = 64;
+    static constexpr std::size_t max_triangles = 124;
+
+    std::vector<Meshlet> meshlets;
+    std::vector<std::uint32_t> vertices;
+    std::vector<std::uint8_t> triangles;
+
+    // Mesh vertex index of corner c (0..2) of triangle t of a meshlet
+    std::uint32_t index(const Meshlet & m, std::size_t t, int c) const { return vertices[m.vertex_offset + triangles[3 * (m.triangle_offset + t) + c]]; }
+};
+
+// Splits the triangles into meshlets in index order, starting a new one when either limit would be exceeded.
+// Reorder the mesh with optimize_mesh() first so consecutive triangles are neighbours and the meshlets compact.
+// Triangles are front-facing when counter-clockwise, matching the renderer's CullMode. Throws
+// std::invalid_argument for malformed index buffers.
+Meshlets build_meshlets(std::span<const linalg::vec<float,3>> positions, std::span<const std::uint32_t> indices);
+inline Meshlets build_meshlets(const Mesh & mesh) { return build_meshlets(mesh.positions, mesh.indices); }
+
+// Whether a meshlet may have a front-facing triangle inside the frustum, with the frustum and the camera
+// position in the mesh's space
+bool meshlet_visible(const Meshlet & meshlet, const Frustum & frustum, const linalg::vec<float,3> & camera);
+
+// Appends the mesh indices of the meshlets passing meshlet_visible() to `out`, for an indexed draw that then
+// shades only the vertices of visible meshlets. Returns the number of visible meshlets.
+std::size_t cull_meshlets(const Meshlets & meshlets, const Frustum & frustum, const linalg::vec<float,3> & camera, std::vector<std::uint32_t> & out);
+
+}
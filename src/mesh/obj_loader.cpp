@@ -0,0 +1,396 @@
+#include "obj_loader.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "mapped_file.hpp"
+#include "thread_pool.hpp"
+
+namespace goob {
+
+namespace {
+    // Chunks smaller than this are not worth a separate task
+    constexpr std::size_t min_chunk_bytes = 256 * 1024;
+    constexpr std::int32_t missing = std::numeric_limits<std::int32_t>::min();
+
+    // Face corner. Indices are 0-based; a set bit in `relative` marks an index counted from the first element
+    // of the chunk (possibly negative) that is made absolute once the sizes of the preceding chunks are known.
+    struct Corner {
+        std::int32_t v, t, n;
+        std::uint8_t relative;
+    };
+
+    struct ParseError {
+        const char * where;
+        const char * message;
+    };
+
+    struct Chunk {
+        std::string_view text;
+        std::vector<linalg::vec<float,3>> positions;
+        std::vector<linalg::vec<float,3>> normals;
+        std::vector<linalg::vec<float,2>> texcoords;
+        std::vector<Corner> corners;
+        bool uses_texcoords = false;
+        bool uses_normals = false;
+    };
+
+    template<class F>
+    void for_each_index(std::size_t count, ThreadPool * pool, F && body) {
+        if (pool) {
+            pool->parallel_for(count, [&](std::size_t i, unsigned) { body(i); });
+        } else {
+            for (std::size_t i = 0; i < count; ++i) {
+                body(i);
+            }
+        }
+    }
+
+    class LineParser {
+    public:
+        LineParser(const char * begin, const char * end) : p_(begin), end_(end) {}
+
+        bool at_end() {
+            skip_spaces();
+            return p_ == end_ || *p_ == '#' || *p_ == '\r';
+        }
+
+        // Consumes `keyword` when it is the next word of the line
+        bool keyword(std::string_view word) {
+            skip_spaces();
+            const std::size_t n = word.size();
+            if (static_cast<std::size_t>(end_ - p_) < n || std::memcmp(p_, word.data(), n) != 0) {
+                return false;
+            }
+            if (p_ + n != end_ && p_[n] != ' ' && p_[n] != '\t') {
+                return false;
+            }
+            p_ += n;
+            return true;
+        }
+
+        float number() {
+            skip_spaces();
+            if (p_ != end_ && *p_ == '+') {
+                ++p_;
+            }
+            float value;
+            const auto [next, error] = std::from_chars(p_, end_, value);
+            if (error != std::errc()) {
+                throw ParseError{p_, "expected a number"};
+            }
+            p_ = next;
+            return value;
+        }
+
+        // Reads an OBJ index relative to `count` elements seen so far in the chunk; returns false when absent
+        bool index(std::int32_t count, std::int32_t & out, bool & relative) {
+            if (p_ == end_ || *p_ == '/' || *p_ == ' ' || *p_ == '\t' || *p_ == '\r') {
+                return false;
+            }
+            std::int32_t value;
+            const auto [next, error] = std::from_chars(p_, end_, value);
+            if (error != std::errc() || value == 0) {
+                throw ParseError{p_, "invalid vertex index"};
+            }
+            p_ = next;
+            relative = value < 0;
+            out = relative ? count + value : value - 1;
+            return true;
+        }
+
+        bool slash() {
+            if (p_ != end_ && *p_ == '/') {
+                ++p_;
+                return true;
+            }
+            return false;
+        }
+
+        void skip_spaces() {
+            while (p_ != end_ && (*p_ == ' ' || *p_ == '\t')) {
+                ++p_;
+            }
+        }
+
+        const char * position() const { return p_; }
+
+    private:
+        const char * p_;
+        const char * end_;
+    };
+
+    Corner parse_corner(LineParser & line, const Chunk & chunk) {
+        Corner corner{missing, missing, missing, 0};
+        bool relative = false;
+        line.skip_spaces();
+        const char * start = line.position();
+        if (!line.index(static_cast<std::int32_t>(chunk.positions.size()), corner.v, relative)) {
+            throw ParseError{start, "expected a vertex index"};
+        }
+        corner.relative |= relative ? 1 : 0;
+        if (line.slash()) {
+            if (line.index(static_cast<std::int32_t>(chunk.texcoords.size()), corner.t, relative)) {
+                corner.relative |= relative ? 2 : 0;
+            }
+            if (line.slash() && line.index(static_cast<std::int32_t>(chunk.normals.size()), corner.n, relative)) {
+                corner.relative |= relative ? 4 : 0;
+            }
+        }
+        return corner;
+    }
+
+    void parse_chunk(Chunk & chunk) {
+        const char * p = chunk.text.data();
+        const char * const end = p + chunk.text.size();
+        while (p < end) {
+            const char * line_end = static_cast<const char *>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+            if (!line_end) {
+                line_end = end;
+            }
+            LineParser line(p, line_end);
+            if (line.keyword("v")) {
+                const float x = line.number(), y = line.number(), z = line.number();
+                chunk.positions.push_back({x, y, z});
+            } else if (line.keyword("vn")) {
+                const float x = line.number(), y = line.number(), z = line.number();
+                chunk.normals.push_back({x, y, z});
+            } else if (line.keyword("vt")) {
+                const float u = line.number();
+                const float v = line.at_end() ? 0.0f : line.number();
+                chunk.texcoords.push_back({u, v});
+            } else if (line.keyword("f")) {
+                // Fan triangulation: (first, previous, current) for every corner after the second
+                Corner first{}, previous{};
+                int count = 0;
+                for (; !line.at_end(); ++count) {
+                    const Corner corner = parse_corner(line, chunk);
+                    chunk.uses_texcoords |= corner.t != missing;
+                    chunk.uses_normals |= corner.n != missing;
+                    if (count == 0) {
+                        first = corner;
+                    } else if (count >= 2) {
+                        chunk.corners.insert(chunk.corners.end(), {first, previous, corner});
+                    }
+                    previous = corner;
+                }
+                if (count < 3) {
+                    throw ParseError{p, "face with fewer than three vertices"};
+                }
+            }
+            p = line_end + 1;
+        }
+    }
+
+    // Makes a chunk-relative index absolute and checks it against the number of elements in the file
+    std::int32_t resolve(std::int32_t index, bool relative, std::size_t offset, std::size_t count) {
+        if (index == missing) {
+            return missing;
+        }
+        const std::int64_t absolute = relative ? static_cast<std::int64_t>(offset) + index : index;
+        if (absolute < 0 || absolute >= static_cast<std::int64_t>(count)) {
+            throw std::runtime_error("OBJ face index out of range");
+        }
+        return static_cast<std::int32_t>(absolute);
+    }
+
+    std::uint64_t hash(const Corner & c) {
+        std::uint64_t h = static_cast<std::uint32_t>(c.v) * 0x9e3779b97f4a7c15ull;
+        h ^= static_cast<std::uint32_t>(c.t) * 0xc2b2ae3d27d4eb4full;
+        h ^= static_cast<std::uint32_t>(c.n) * 0x165667b19e3779f9ull;
+        return h ^ (h >> 31);
+    }
+
+    bool same(const Corner & a, const Corner & b) {
+        return a.v == b.v && a.t == b.t && a.n == b.n;
+    }
+
+    // Numbers the distinct corners in order of first use and gathers their attributes.
+    //
+    // Corners are scattered into hash partitions that are deduplicated independently; each corner learns the
+    // first corner with the same key. First uses are then numbered with a prefix sum over blocks of corners.
+    void build_vertices(const std::vector<Corner> & corners, const Chunk & attributes, Mesh & mesh, ThreadPool * pool) {
+        const std::size_t count = corners.size();
+        const std::size_t partitions = pool ? std::bit_ceil(std::size_t(pool->size()) * 4) : 1;
+        const int partition_shift = 64 - std::countr_zero(partitions);
+        const auto partition_of = [&](const Corner & c) {
+            return partitions == 1 ? std::size_t(0) : static_cast<std::size_t>(hash(c) >> partition_shift);
+        };
+        const std::size_t blocks = partitions;
+        const auto block_begin = [&](std::size_t b) { return count * b / blocks; };
+
+        // Stable scatter of corner indices by partition
+        std::vector<std::size_t> offsets(partitions * blocks + 1, 0);
+        for_each_index(blocks, pool, [&](std::size_t b) {
+            for (std::size_t c = block_begin(b); c < block_begin(b + 1); ++c) {
+                ++offsets[partition_of(corners[c]) * blocks + b + 1];
+            }
+        });
+        for (std::size_t i = 1; i < offsets.size(); ++i) {
+            offsets[i] += offsets[i - 1];
+        }
+        std::vector<std::uint32_t> order(count);
+        for_each_index(blocks, pool, [&](std::size_t b) {
+            std::vector<std::size_t> next(partitions);
+            for (std::size_t p = 0; p < partitions; ++p) {
+                next[p] = offsets[p * blocks + b];
+            }
+            for (std::size_t c = block_begin(b); c < block_begin(b + 1); ++c) {
+                order[next[partition_of(corners[c])]++] = static_cast<std::uint32_t>(c);
+            }
+        });
+
+        // first[c] is the smallest corner index with the key of c
+        std::vector<std::uint32_t> first(count);
+        for_each_index(partitions, pool, [&](std::size_t p) {
+            const std::size_t begin = offsets[p * blocks], end = offsets[(p + 1) * blocks];
+            const std::size_t mask = std::bit_ceil(2 * (end - begin) + 1) - 1;
+            std::vector<std::uint32_t> table(mask + 1, std::numeric_limits<std::uint32_t>::max());
+            for (std::size_t i = begin; i < end; ++i) {
+                const std::uint32_t c = order[i];
+                for (std::size_t slot = hash(corners[c]) & mask;; slot = (slot + 1) & mask) {
+                    if (table[slot] == std::numeric_limits<std::uint32_t>::max()) {
+                        table[slot] = c;
+                        first[c] = c;
+                        break;
+                    }
+                    if (same(corners[table[slot]], corners[c])) {
+                        first[c] = table[slot];
+                        break;
+                    }
+                }
+            }
+        });
+
+        std::vector<std::uint32_t> block_vertices(blocks + 1, 0);
+        for_each_index(blocks, pool, [&](std::size_t b) {
+            for (std::size_t c = block_begin(b); c < block_begin(b + 1); ++c) {
+                block_vertices[b + 1] += first[c] == c;
+            }
+        });
+        for (std::size_t b = 1; b <= blocks; ++b) {
+            block_vertices[b] += block_vertices[b - 1];
+        }
+
+        const bool texcoords = !attributes.texcoords.empty(), normals = !attributes.normals.empty();
+        mesh.positions.resize(block_vertices[blocks]);
+        mesh.texcoords.resize(texcoords ? block_vertices[blocks] : 0);
+        mesh.normals.resize(normals ? block_vertices[blocks] : 0);
+        mesh.indices.resize(count);
+        for_each_index(blocks, pool, [&](std::size_t b) {
+            std::uint32_t vertex = block_vertices[b];
+            for (std::size_t c = block_begin(b); c < block_begin(b + 1); ++c) {
+                if (first[c] != c) {
+                    continue;
+                }
+                const Corner & corner = corners[c];
+                mesh.positions[vertex] = attributes.positions[corner.v];
+                if (texcoords) {
+                    mesh.texcoords[vertex] = corner.t == missing ? linalg::vec<float,2>() : attributes.texcoords[corner.t];
+                }
+                if (normals) {
+                    mesh.normals[vertex] = corner.n == missing ? linalg::vec<float,3>() : attributes.normals[corner.n];
+                }
+                mesh.indices[c] = vertex++;
+            }
+        });
+        for_each_index(blocks, pool, [&](std::size_t b) {
+            for (std::size_t c = block_begin(b); c < block_begin(b + 1); ++c) {
+                mesh.indices[c] = mesh.indices[first[c]];
+            }
+        });
+    }
+}
+
+Mesh parse_obj(std::string_view text, ThreadPool * pool) {
+    // Chunks start at line boundaries
+    const std::size_t chunk_count = pool ? std::clamp<std::size_t>(text.size() / min_chunk_bytes, 1, 4 * pool->size()) : 1;
+    std::vector<Chunk> chunks(chunk_count);
+    std::size_t begin = 0;
+    for (std::size_t i = 0; i < chunk_count; ++i) {
+        std::size_t end = i + 1 == chunk_count ? text.size() : std::max(begin, text.size() * (i + 1) / chunk_count);
+        if (end < text.size()) {
+            const std::size_t newline = text.find('\n', end);
+            end = newline == std::string_view::npos ? text.size() : newline + 1;
+        }
+        chunks[i].text = text.substr(begin, end - begin);
+        begin = end;
+    }
+
+    try {
+        for_each_index(chunk_count, pool, [&](std::size_t i) { parse_chunk(chunks[i]); });
+    } catch (const ParseError & error) {
+        const std::size_t offset = static_cast<std::size_t>(error.where - text.data());
+        const std::size_t line = 1 + std::count(text.begin(), text.begin() + offset, '\n');
+        throw std::runtime_error("OBJ line " + std::to_string(line) + ": " + error.message);
+    }
+
+    // Offsets of every chunk's elements in the whole file
+    struct Offsets {
+        std::size_t positions = 0, texcoords = 0, normals = 0, corners = 0;
+    };
+    std::vector<Offsets> offsets(chunk_count + 1);
+    bool uses_texcoords = false, uses_normals = false;
+    for (std::size_t i = 0; i < chunk_count; ++i) {
+        offsets[i + 1].positions = offsets[i].positions + chunks[i].positions.size();
+        offsets[i + 1].texcoords = offsets[i].texcoords + chunks[i].texcoords.size();
+        offsets[i + 1].normals = offsets[i].normals + chunks[i].normals.size();
+        offsets[i + 1].corners = offsets[i].corners + chunks[i].corners.size();
+        uses_texcoords |= chunks[i].uses_texcoords;
+        uses_normals |= chunks[i].uses_normals;
+    }
+    const Offsets & total = offsets[chunk_count];
+    if (total.corners > std::numeric_limits<std::uint32_t>::max() || total.positions > std::numeric_limits<std::int32_t>::max()) {
+        throw std::runtime_error("OBJ mesh too large");
+    }
+
+    Chunk attributes;
+    attributes.positions.resize(total.positions);
+    attributes.texcoords.resize(uses_texcoords ? total.texcoords : 0);
+    attributes.normals.resize(uses_normals ? total.normals : 0);
+    std::vector<Corner> corners(total.corners);
+    for_each_index(chunk_count, pool, [&](std::size_t i) {
+        const Chunk & chunk = chunks[i];
+        const Offsets & offset = offsets[i];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), attributes.positions.begin() + offset.positions);
+        if (uses_texcoords) {
+            std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), attributes.texcoords.begin() + offset.texcoords);
+        }
+        if (uses_normals) {
+            std::copy(chunk.normals.begin(), chunk.normals.end(), attributes.normals.begin() + offset.normals);
+        }
+        Corner * out = corners.data() + offset.corners;
+        for (const Corner & c : chunk.corners) {
+            *out++ = {resolve(c.v, c.relative & 1, offset.positions, total.positions),
+                      uses_texcoords ? resolve(c.t, c.relative & 2, offset.texcoords, total.texcoords) : missing,
+                      uses_normals ? resolve(c.n, c.relative & 4, offset.normals, total.normals) : missing, 0};
+        }
+    });
+
+    Mesh mesh;
+    if (!uses_texcoords && !uses_normals) {
+        // Positions are the vertices already
+        mesh.positions = std::move(attributes.positions);
+        mesh.indices.resize(corners.size());
+        for_each_index(chunk_count, pool, [&](std::size_t i) {
+            for (std::size_t c = offsets[i].corners; c < offsets[i + 1].corners; ++c) {
+                mesh.indices[c] = static_cast<std::uint32_t>(corners[c].v);
+            }
+        });
+        return mesh;
+    }
+    build_vertices(corners, attributes, mesh, pool);
+    return mesh;
+}
+
+Mesh load_obj(const std::filesystem::path & path, ThreadPool * pool) {
+    const MappedFile file(path);
+    return parse_obj({reinterpret_cast<const char *>(file.data()), file.size()}, pool);
+}
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+
+#include "mesh.hpp"
+
+namespace goob {
+
+class ThreadPool;
+
+// Wavefront OBJ reader for triangle meshes.
+//
+// Reads v, vt, vn and f statements; polygons are triangulated as fans and every other statement (groups,
+// materials, smoothing, lines) is ignored. Each distinct position/texcoord/normal index triple of the faces
+// becomes one vertex, numbered in order of first use; when the faces reference positions only, the positions
+// are the vertices as listed. Normals and texcoords are dropped when no face references them, and a face corner
+// without one gets zero.
+//
+// The text is split into chunks at line boundaries that are parsed in parallel on `pool`, as is the
+// deduplication of the face corners. Throws std::runtime_error on malformed input, naming the line for
+// syntax errors.
+Mesh parse_obj(std::string_view text, ThreadPool * pool = nullptr);
+
+// Maps the file and parses it with parse_obj()
+Mesh load_obj(const std::filesystem::path & path, ThreadPool * pool = nullptr);
+
+}
@@ -0,0 +1,96 @@
+#include "clipper.hpp"
+
+#include <algorithm>
+
+#include "coverage.hpp"
+
+namespace goob {
+
+namespace {
+    // Signed distance to a plane, >= 0 inside
+    float distance(const ClipSpace & space, std::uint16_t plane, const linalg::vec<float,4> & p) {
+        switch (plane) {
+            case clip_near:         return space.depth_range == linalg::zero_to_one ? p.z : p.z + p.w;
+            case clip_far:          return p.w - p.z;
+            case clip_guard_left:   return p.x + space.guard.x * p.w;
+            case clip_guard_right:  return space.guard.x * p.w - p.x;
+            case clip_guard_bottom: return p.y + space.guard.y * p.w;
+            case clip_guard_top:    return space.guard.y * p.w - p.y;
+        }
+        return 0.0f;
+    }
+}
+
+ClipSpace ClipSpace::for_viewport(int width, int height, linalg::z_range depth_range) {
+    // Screen x = (ndc + 1) * width / 2 must stay within +-max_raster_coordinate; keep a pixel of margin for the
+    // rounding of the perspective division
+    const float limit = max_raster_coordinate - 1.0f;
+    return {depth_range, {2.0f * limit / static_cast<float>(width) - 1.0f, 2.0f * limit / static_cast<float>(height) - 1.0f}};
+}
+
+std::uint16_t ClipSpace::outcode(const linalg::vec<float,4> & p) const {
+    std::uint16_t code = 0;
+    code |= p.x < -p.w ? clip_left : 0;
+    code |= p.x > p.w ? clip_right : 0;
+    code |= p.y < -p.w ? clip_bottom : 0;
+    code |= p.y > p.w ? clip_top : 0;
+    code |= (depth_range == linalg::zero_to_one ? p.z < 0.0f : p.z < -p.w) ? clip_near : 0;
+    code |= p.z > p.w ? clip_far : 0;
+    code |= p.x < -guard.x * p.w ? clip_guard_left : 0;
+    code |= p.x > guard.x * p.w ? clip_guard_right : 0;
+    code |= p.y < -guard.y * p.w ? clip_guard_bottom : 0;
+    code |= p.y > guard.y * p.w ? clip_guard_top : 0;
+    // NaN positions compare false everywhere; treat them as outside so they are rejected
+    if (!(p.x == p.x && p.y == p.y && p.z == p.z && p.w == p.w)) {
+        code = clip_frustum | clip_cut;
+    }
+    return static_cast<std::uint16_t>(code);
+}
+
+int clip_triangle(const std::array<linalg::vec<float,4>,3> & triangle, std::uint16_t planes, const ClipSpace & space,
+                  std::span<ClipVertex, max_clip_vertices> out) {
+    std::array<ClipVertex, max_clip_vertices> buffer;
+    ClipVertex * polygon = out.data();
+    ClipVertex * next = buffer.data();
+    int count = 3;
+    for (int i = 0; i < 3; ++i) {
+        polygon[i] = {triangle[i], {i == 0 ? 1.0f : 0.0f, i == 1 ? 1.0f : 0.0f, i == 2 ? 1.0f : 0.0f}, i};
+    }
+
+    // Sutherland-Hodgman, one plane at a time
+    for (std::uint16_t plane = clip_near; plane <= clip_guard_top; plane = static_cast<std::uint16_t>(plane << 1)) {
+        if (!(planes & plane & clip_cut)) {
+            continue;
+        }
+        int kept = 0;
+        for (int i = 0; i < count; ++i) {
+            const ClipVertex & a = polygon[i];
+            const ClipVertex & b = polygon[(i + 1) % count];
+            const float da = distance(space, plane, a.position), db = distance(space, plane, b.position);
+            if (da >= 0.0f) {
+                next[kept++] = a;
+            }
+            if ((da >= 0.0f) != (db >= 0.0f)) {
+                // Interpolate from the inside vertex so shared edges of neighbours produce the same point
+                const bool a_inside = da >= 0.0f;
+                const ClipVertex & from = a_inside ? a : b;
+                const ClipVertex & to = a_inside ? b : a;
+                const float d_from = a_inside ? da : db, d_to = a_inside ? db : da;
+                const float t = d_from / (d_from - d_to);
+                next[kept++] = {from.position + (to.position - from.position) * t, from.weights + (to.weights - from.weights) * t, -1};
+            }
+        }
+        count = kept;
+        std::swap(polygon, next);
+        if (count < 3) {
+            return 0;
+        }
+    }
+
+    if (polygon != out.data()) {
+        std::copy(polygon, polygon + count, out.data());
+    }
+    return count;
+}
+
+}
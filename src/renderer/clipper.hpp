@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include "vector.hpp"
+
+namespace goob {
+
+// Outcode bits of a clip-space position, one per plane it lies outside of
+enum ClipPlane : std::uint16_t {
+    clip_left = 1 << 0,
+    clip_right = 1 << 1,
+    clip_bottom = 1 << 2,
+    clip_top = 1 << 3,
+    clip_near = 1 << 4,
+    clip_far = 1 << 5,
+    clip_guard_left = 1 << 6,
+    clip_guard_right = 1 << 7,
+    clip_guard_bottom = 1 << 8,
+    clip_guard_top = 1 << 9,
+};
+
+// A triangle entirely outside one of these planes is invisible
+constexpr std::uint16_t clip_frustum = clip_left | clip_right | clip_bottom | clip_top | clip_near | clip_far;
+// Planes triangles are actually cut against. Crossing the viewport sides inside the guard band needs no cut,
+// since the rasterizer handles such triangles exactly and only visits on-screen tiles.
+constexpr std::uint16_t clip_cut = clip_near | clip_far | clip_guard_left | clip_guard_right | clip_guard_bottom | clip_guard_top;
+
+// Clip-space conventions of a viewport.
+//
+// Visible points satisfy -w <= x,y <= w and, following linalg's projection matrices, -w <= z <= w for
+// linalg::neg_one_to_one or 0 <= z <= w for linalg::zero_to_one. Both linalg::fwd_axis choices produce w > 0 in
+// front of the eye, so the forward axis needs no handling here. The guard band is the region |x|,|y| <= guard * w
+// whose screen positions the rasterizer still accepts (see max_raster_coordinate).
+struct ClipSpace {
+    linalg::z_range depth_range = linalg::neg_one_to_one;
+    linalg::vec<float,2> guard = {1.0f, 1.0f};
+
+    static ClipSpace for_viewport(int width, int height, linalg::z_range depth_range = linalg::neg_one_to_one);
+
+    std::uint16_t outcode(const linalg::vec<float,4> & p) const;
+};
+
+// Vertex of a clipped polygon: its position and its weights relative to the three vertices of the source triangle
+// (for interpolating varyings, which are affine in clip space). `source` is the source vertex index when the
+// vertex was not created by clipping, -1 otherwise.
+struct ClipVertex {
+    linalg::vec<float,4> position;
+    linalg::vec<float,3> weights;
+    int source;
+};
+
+// Polygon size bound: three vertices plus at most one more per cut plane
+constexpr int max_clip_vertices = 9;
+
+// Cuts a triangle against the `clip_cut` planes set in `planes` (usually the union of the vertex outcodes).
+// Writes the convex polygon in the triangle's winding and returns its vertex count, 0 when nothing remains.
+int clip_triangle(const std::array<linalg::vec<float,4>,3> & triangle, std::uint16_t planes, const ClipSpace & space,
+                  std::span<ClipVertex, max_clip_vertices> out);
+
+}
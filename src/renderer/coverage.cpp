@@ -0,0 +1,275 @@
+#include "coverage.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef GOOB_X86
+#include <immintrin.h>
+#endif
+
+namespace goob {
+
+namespace {
+    enum class EdgeClass { outside, inside, partial };
+
+    // Classifies edge i against the N x N block at (x,y) using the block corners. Only partial edges need
+    // per-pixel evaluation; for those the value at the block origin is guaranteed to fit in 32 bits.
+    template<int N>
+    EdgeClass classify(const EdgeSetup & e, int i, int x, int y, std::int32_t & origin) {
+        const std::int64_t value = e.c[i] + std::int64_t(e.dx[i]) * x + std::int64_t(e.dy[i]) * y;
+        const std::int64_t hi = value + std::int64_t(std::max(e.dx[i], 0) + std::max(e.dy[i], 0)) * (N - 1);
+        const std::int64_t lo = value + std::int64_t(std::min(e.dx[i], 0) + std::min(e.dy[i], 0)) * (N - 1);
+        if (hi < 0) {
+            return EdgeClass::outside;
+        }
+        if (lo >= 0) {
+            return EdgeClass::inside;
+        }
+        origin = static_cast<std::int32_t>(value);
+        return EdgeClass::partial;
+    }
+
+    template<int N, class Mask>
+    Mask coverage_scalar(const EdgeSetup & e, int x, int y) {
+        Mask mask = static_cast<Mask>(~Mask(0));
+        for (int i = 0; i < 3; ++i) {
+            std::int32_t row;
+            switch (classify<N>(e, i, x, y, row)) {
+                case EdgeClass::outside: return 0;
+                case EdgeClass::inside: continue;
+                case EdgeClass::partial: break;
+            }
+            Mask edge = 0;
+            for (int r = 0; r < N; ++r, row += e.dy[i]) {
+                std::int32_t value = row;
+                for (int column = 0; column < N; ++column, value += e.dx[i]) {
+                    edge |= static_cast<Mask>(Mask(value >= 0) << (r * N + column));
+                }
+            }
+            mask &= edge;
+        }
+        return mask;
+    }
+
+    std::uint16_t coverage4x4_scalar(const EdgeSetup & e, int x, int y) { return coverage_scalar<4, std::uint16_t>(e, x, y); }
+    std::uint64_t coverage8x8_scalar(const EdgeSetup & e, int x, int y) { return coverage_scalar<8, std::uint64_t>(e, x, y); }
+
+#ifdef GOOB_X86
+    GOOB_TARGET("sse2")
+    std::uint16_t coverage4x4_sse2(const EdgeSetup & e, int x, int y) {
+        std::uint16_t mask = 0xffff;
+        for (int i = 0; i < 3; ++i) {
+            std::int32_t origin;
+            switch (classify<4>(e, i, x, y, origin)) {
+                case EdgeClass::outside: return 0;
+                case EdgeClass::inside: continue;
+                case EdgeClass::partial: break;
+            }
+            const std::int32_t dx = e.dx[i];
+            const __m128i minus_one = _mm_set1_epi32(-1);
+            const __m128i dy = _mm_set1_epi32(e.dy[i]);
+            __m128i row = _mm_setr_epi32(origin, origin + dx, origin + 2 * dx, origin + 3 * dx);
+            unsigned edge = 0;
+            for (int r = 0; r < 4; ++r, row = _mm_add_epi32(row, dy)) {
+                edge |= unsigned(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(row, minus_one)))) << (r * 4);
+            }
+            mask &= static_cast<std::uint16_t>(edge);
+        }
+        return mask;
+    }
+
+    GOOB_TARGET("sse2")
+    std::uint64_t coverage8x8_sse2(const EdgeSetup & e, int x, int y) {
+        std::uint64_t mask = ~0ull;
+        for (int i = 0; i < 3; ++i) {
+            std::int32_t origin;
+            switch (classify<8>(e, i, x, y, origin)) {
+                case EdgeClass::outside: return 0;
+                case EdgeClass::inside: continue;
+                case EdgeClass::partial: break;
+            }
+            const std::int32_t dx = e.dx[i];
+            const __m128i minus_one = _mm_set1_epi32(-1);
+            const __m128i dy = _mm_set1_epi32(e.dy[i]);
+            __m128i left = _mm_setr_epi32(origin, origin + dx, origin + 2 * dx, origin + 3 * dx);
+            __m128i right = _mm_add_epi32(left, _mm_set1_epi32(4 * dx));
+            std::uint64_t edge = 0;
+            for (int r = 0; r < 8; ++r, left = _mm_add_epi32(left, dy), right = _mm_add_epi32(right, dy)) {
+                const unsigned bits = unsigned(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(left, minus_one))))
+                                    | unsigned(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(right, minus_one)))) << 4;
+                edge |= std::uint64_t(bits) << (r * 8);
+            }
+            mask &= edge;
+        }
+        return mask;
+    }
+
+    GOOB_TARGET("avx2")
+    std::uint16_t coverage4x4_avx2(const EdgeSetup & e, int x, int y) {
+        std::uint16_t mask = 0xffff;
+        for (int i = 0; i < 3; ++i) {
+            std::int32_t origin;
+            switch (classify<4>(e, i, x, y, origin)) {
+                case EdgeClass::outside: return 0;
+                case EdgeClass::inside: continue;
+                case EdgeClass::partial: break;
+            }
+            // Two rows per register
+            const __m256i offsets = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(e.dx[i]), _mm256_setr_epi32(0, 1, 2, 3, 0, 1, 2, 3)),
+                                                     _mm256_mullo_epi32(_mm256_set1_epi32(e.dy[i]), _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1)));
+            const __m256i minus_one = _mm256_set1_epi32(-1);
+            const __m256i top = _mm256_add_epi32(_mm256_set1_epi32(origin), offsets);
+            const __m256i bottom = _mm256_add_epi32(top, _mm256_set1_epi32(2 * e.dy[i]));
+            const unsigned edge = unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(top, minus_one))))
+                                | unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(bottom, minus_one)))) << 8;
+            mask &= static_cast<std::uint16_t>(edge);
+        }
+        return mask;
+    }
+
+    GOOB_TARGET("avx2")
+    std::uint64_t coverage8x8_avx2(const EdgeSetup & e, int x, int y) {
+        std::uint64_t mask = ~0ull;
+        for (int i = 0; i < 3; ++i) {
+            std::int32_t origin;
+            switch (classify<8>(e, i, x, y, origin)) {
+                case EdgeClass::outside: return 0;
+                case EdgeClass::inside: continue;
+                case EdgeClass::partial: break;
+            }
+            const __m256i minus_one = _mm256_set1_epi32(-1);
+            const __m256i dy = _mm256_set1_epi32(e.dy[i]);
+            __m256i row = _mm256_add_epi32(_mm256_set1_epi32(origin),
+                                           _mm256_mullo_epi32(_mm256_set1_epi32(e.dx[i]), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+            std::uint64_t edge = 0;
+            for (int r = 0; r < 8; ++r, row = _mm256_add_epi32(row, dy)) {
+                edge |= std::uint64_t(unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(row, minus_one))))) << (r * 8);
+            }
+            mask &= edge;
+        }
+        return mask;
+    }
+
+    GOOB_TARGET("avx512f")
+    std::uint16_t coverage4x4_avx512(const EdgeSetup & e, int x, int y) {
+        std::uint16_t mask = 0xffff;
+        for (int i = 0; i < 3; ++i) {
+            std::int32_t origin;
+            switch (classify<4>(e, i, x, y, origin)) {
+                case EdgeClass::outside: return 0;
+                case EdgeClass::inside: continue;
+                case EdgeClass::partial: break;
+            }
+            // The whole block in one register
+            const __m512i columns = _mm512_setr_epi32(0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3);
+            const __m512i rows = _mm512_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+            const __m512i values = _mm512_add_epi32(_mm512_set1_epi32(origin),
+                                                    _mm512_add_epi32(_mm512_mullo_epi32(_mm512_set1_epi32(e.dx[i]), columns),
+                                                                     _mm512_mullo_epi32(_mm512_set1_epi32(e.dy[i]), rows)));
+            mask &= static_cast<std::uint16_t>(_mm512_cmpge_epi32_mask(values, _mm512_setzero_si512()));
+        }
+        return mask;
+    }
+
+    GOOB_TARGET("avx512f")
+    std::uint64_t coverage8x8_avx512(const EdgeSetup & e, int x, int y) {
+        std::uint64_t mask = ~0ull;
+        for (int i = 0; i < 3; ++i) {
+            std::int32_t origin;
+            switch (classify<8>(e, i, x, y, origin)) {
+                case EdgeClass::outside: return 0;
+                case EdgeClass::inside: continue;
+                case EdgeClass::partial: break;
+            }
+            // Two rows per register
+            const __m512i columns = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 0, 1, 2, 3, 4, 5, 6, 7);
+            const __m512i rows = _mm512_setr_epi32(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1);
+            const __m512i dy2 = _mm512_set1_epi32(2 * e.dy[i]);
+            __m512i values = _mm512_add_epi32(_mm512_set1_epi32(origin),
+                                              _mm512_add_epi32(_mm512_mullo_epi32(_mm512_set1_epi32(e.dx[i]), columns),
+                                                               _mm512_mullo_epi32(_mm512_set1_epi32(e.dy[i]), rows)));
+            std::uint64_t edge = 0;
+            for (int r = 0; r < 8; r += 2, values = _mm512_add_epi32(values, dy2)) {
+                edge |= std::uint64_t(_mm512_cmpge_epi32_mask(values, _mm512_setzero_si512())) << (r * 8);
+            }
+            mask &= edge;
+        }
+        return mask;
+    }
+#endif
+
+    constexpr CoverageKernel scalar_kernel{SimdLevel::scalar, coverage4x4_scalar, coverage8x8_scalar};
+#ifdef GOOB_X86
+    constexpr CoverageKernel sse2_kernel{SimdLevel::sse2, coverage4x4_sse2, coverage8x8_sse2};
+    constexpr CoverageKernel avx2_kernel{SimdLevel::avx2, coverage4x4_avx2, coverage8x8_avx2};
+    constexpr CoverageKernel avx512_kernel{SimdLevel::avx512, coverage4x4_avx512, coverage8x8_avx512};
+#endif
+}
+
+bool setup_edges(const linalg::vec<float,2> & p0, const linalg::vec<float,2> & p1, const linalg::vec<float,2> & p2, EdgeSetup & out,
+                 int sample_margin) {
+    const linalg::vec<float,2> p[3] = {p0, p1, p2};
+    std::int64_t fx[3], fy[3];
+    for (int i = 0; i < 3; ++i) {
+        if (!(std::abs(p[i].x) <= max_raster_coordinate && std::abs(p[i].y) <= max_raster_coordinate)) {
+            return false;
+        }
+        fx[i] = std::lround(p[i].x * subpixel_scale);
+        fy[i] = std::lround(p[i].y * subpixel_scale);
+    }
+
+    std::int64_t area = (fx[1] - fx[0]) * (fy[2] - fy[0]) - (fy[1] - fy[0]) * (fx[2] - fx[0]);
+    if (area == 0) {
+        return false;
+    }
+    const std::int64_t sign = area < 0 ? -1 : 1;
+    out.area = area * sign;
+
+    // Pixel centers sit at +half a pixel
+    constexpr std::int64_t half = subpixel_scale / 2;
+    for (int i = 0; i < 3; ++i) {
+        const int j = (i + 1) % 3, k = (i + 2) % 3;
+        const std::int64_t a = -(fy[k] - fy[j]) * sign;
+        const std::int64_t b = (fx[k] - fx[j]) * sign;
+        out.dx[i] = static_cast<std::int32_t>(a * subpixel_scale);
+        out.dy[i] = static_cast<std::int32_t>(b * subpixel_scale);
+        out.c[i] = a * (half - fx[j]) + b * (half - fy[j]);
+        // Interior to the right (left edge) or below (top edge) in y-down window coordinates owns the boundary
+        const bool top_left = a > 0 || (a == 0 && b > 0);
+        if (!top_left) {
+            out.c[i] -= 1;
+        }
+    }
+
+    // ceil((v - half) / scale) and floor((v - half) / scale) with arithmetic shifts rounding toward -inf
+    const std::int64_t min_x = std::min({fx[0], fx[1], fx[2]}), max_x = std::max({fx[0], fx[1], fx[2]});
+    const std::int64_t min_y = std::min({fy[0], fy[1], fy[2]}), max_y = std::max({fy[0], fy[1], fy[2]});
+    const std::int64_t first = half + sample_margin, last = half - sample_margin;
+    out.min = {static_cast<int>((min_x - first + subpixel_scale - 1) >> subpixel_bits), static_cast<int>((min_y - first + subpixel_scale - 1) >> subpixel_bits)};
+    out.max = {static_cast<int>((max_x - last) >> subpixel_bits), static_cast<int>((max_y - last) >> subpixel_bits)};
+    return true;
+}
+
+const CoverageKernel * coverage_kernel(SimdLevel level) {
+    if (!simd_supported(level)) {
+        return nullptr;
+    }
+    switch (level) {
+        case SimdLevel::scalar: return &scalar_kernel;
+#ifdef GOOB_X86
+        case SimdLevel::sse2:   return &sse2_kernel;
+        case SimdLevel::avx2:   return &avx2_kernel;
+        case SimdLevel::avx512: return &avx512_kernel;
+#else
+        default:                return nullptr;
+#endif
+    }
+    return nullptr;
+}
+
+const CoverageKernel & coverage_kernel() {
+    static const CoverageKernel & kernel = *coverage_kernel(simd_level());
+    return kernel;
+}
+
+}
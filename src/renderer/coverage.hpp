@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "cpu_features.hpp"
+#include "vector.hpp"
+
+namespace goob {
+
+// Vertex positions are snapped to 1/16 pixel before coverage is computed. All edge arithmetic after
+// snapping is exact integer math, so adjacent triangles never leave gaps or double-cover pixels.
+constexpr int subpixel_bits = 4;
+constexpr int subpixel_scale = 1 << subpixel_bits;
+
+// Largest |x| or |y| in pixels accepted by setup_edges(). Keeps per-block edge values within 32 bits
+// so the block kernels can step them in 32-bit SIMD lanes.
+constexpr float max_raster_coordinate = 16384.0f;
+
+// Fixed-point edge functions of a triangle with consistent (positive inside) orientation.
+// The value of edge i at the center of pixel (x,y) is c[i] + dx[i]*x + dy[i]*y and the pixel is inside the
+// edge when that value is >= 0; the top-left fill rule is folded into c[i].
+struct EdgeSetup {
+    std::array<std::int32_t,3> dx, dy;
+    std::array<std::int64_t,3> c;
+    std::int64_t area;              // sum of the three edge values (without fill rule bias), twice the triangle area
+    linalg::vec<int,2> min, max;    // inclusive bounds of the pixel centers the triangle may cover, not clipped
+};
+
+// Snaps the triangle's x,y to the subpixel grid and computes its edge functions.
+// Returns false for degenerate triangles and for vertices outside of +-max_raster_coordinate.
+// With multisampling, `sample_margin` is the largest x or y distance of a sample position from the pixel center in
+// subpixels, and min/max bound the pixels with a sample the triangle may cover.
+bool setup_edges(const linalg::vec<float,2> & p0, const linalg::vec<float,2> & p1, const linalg::vec<float,2> & p2, EdgeSetup & out,
+                 int sample_margin = 0);
+
+// Coverage masks of a block whose top-left pixel is (x,y): bit (row * N + column) is set when the pixel center is inside
+using Coverage4x4 = std::uint16_t (*)(const EdgeSetup & edges, int x, int y);
+using Coverage8x8 = std::uint64_t (*)(const EdgeSetup & edges, int x, int y);
+
+struct CoverageKernel {
+    SimdLevel level;
+    Coverage4x4 block4x4;
+    Coverage8x8 block8x8;
+};
+
+// Kernel for the best instruction set available on this CPU (see simd_level()), selected once
+const CoverageKernel & coverage_kernel();
+
+// Kernel for a specific instruction set, nullptr when it is not compiled in or not supported by the CPU
+const CoverageKernel * coverage_kernel(SimdLevel level);
+
+}
@@ -0,0 +1,238 @@
+#include "culling.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "coverage.hpp"
+
+#ifdef GOOB_X86
+#include <immintrin.h>
+#endif
+
+namespace goob {
+
+namespace {
+    constexpr int floats_per_triangle = 12;
+    static_assert(sizeof(ScreenTriangle) == floats_per_triangle * sizeof(float));
+    constexpr float half_pixel = subpixel_scale / 2;
+    constexpr float inv_subpixel_scale = 1.0f / subpixel_scale;
+
+    bool visible(const ScreenTriangle & t, const CullSetup & setup) {
+        std::int64_t fx[3], fy[3];
+        for (int i = 0; i < 3; ++i) {
+            if (!(std::abs(t[i].x) <= max_raster_coordinate && std::abs(t[i].y) <= max_raster_coordinate)) {
+                return false;
+            }
+            fx[i] = std::lround(t[i].x * subpixel_scale);
+            fy[i] = std::lround(t[i].y * subpixel_scale);
+        }
+        const std::int64_t area = (fx[1] - fx[0]) * (fy[2] - fy[0]) - (fy[1] - fy[0]) * (fx[2] - fx[0]);
+        if (area == 0 || (setup.mode == CullMode::back && area < 0) || (setup.mode == CullMode::front && area > 0)) {
+            return false;
+        }
+        // Pixel center bounds as in setup_edges(), clipped to the viewport as in setup_triangle()
+        const std::int64_t first = subpixel_scale / 2 + setup.sample_margin, last = subpixel_scale / 2 - setup.sample_margin;
+        const std::int64_t min_x = (std::min({fx[0], fx[1], fx[2]}) - first + subpixel_scale - 1) >> subpixel_bits;
+        const std::int64_t min_y = (std::min({fy[0], fy[1], fy[2]}) - first + subpixel_scale - 1) >> subpixel_bits;
+        const std::int64_t max_x = (std::max({fx[0], fx[1], fx[2]}) - last) >> subpixel_bits;
+        const std::int64_t max_y = (std::max({fy[0], fy[1], fy[2]}) - last) >> subpixel_bits;
+        return std::max<std::int64_t>(min_x, 0) <= std::min<std::int64_t>(max_x, setup.width - 1)
+            && std::max<std::int64_t>(min_y, 0) <= std::min<std::int64_t>(max_y, setup.height - 1);
+    }
+
+    std::uint64_t cull_scalar(const ScreenTriangle * triangles, std::size_t count, const CullSetup & setup) {
+        std::uint64_t mask = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            mask |= std::uint64_t(visible(triangles[i], setup)) << i;
+        }
+        return mask;
+    }
+
+#ifdef GOOB_X86
+    // std::lround of exactly representable products: truncate, then step away from zero on halves
+    GOOB_TARGET("avx2")
+    __m256 snap_avx2(__m256 v) {
+        const __m256 scaled = _mm256_mul_ps(v, _mm256_set1_ps(subpixel_scale));
+        const __m256 truncated = _mm256_round_ps(scaled, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        const __m256 sign = _mm256_and_ps(scaled, _mm256_set1_ps(-0.0f));
+        const __m256 fraction = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), _mm256_sub_ps(scaled, truncated));
+        const __m256 step = _mm256_and_ps(_mm256_cmp_ps(fraction, _mm256_set1_ps(0.5f), _CMP_GE_OQ), _mm256_or_ps(sign, _mm256_set1_ps(1.0f)));
+        return _mm256_add_ps(truncated, step);
+    }
+
+    // Twice the signed area of four snapped triangles. Snapped deltas are integers below 2^20, so the products
+    // are exact in double precision and the sign matches setup_edges().
+    GOOB_TARGET("avx2")
+    __m256d area_avx2(__m128 ax, __m128 ay, __m128 bx, __m128 by) {
+        return _mm256_sub_pd(_mm256_mul_pd(_mm256_cvtps_pd(ax), _mm256_cvtps_pd(by)), _mm256_mul_pd(_mm256_cvtps_pd(ay), _mm256_cvtps_pd(bx)));
+    }
+
+    // Lanes with a snapped area above and below zero
+    GOOB_TARGET("avx2")
+    void area_signs_avx2(__m256 ax, __m256 ay, __m256 bx, __m256 by, unsigned & positive, unsigned & negative) {
+        const __m256d lo = area_avx2(_mm256_castps256_ps128(ax), _mm256_castps256_ps128(ay), _mm256_castps256_ps128(bx), _mm256_castps256_ps128(by));
+        const __m256d hi = area_avx2(_mm256_extractf128_ps(ax, 1), _mm256_extractf128_ps(ay, 1), _mm256_extractf128_ps(bx, 1), _mm256_extractf128_ps(by, 1));
+        const __m256d zero = _mm256_setzero_pd();
+        positive = unsigned(_mm256_movemask_pd(_mm256_cmp_pd(lo, zero, _CMP_GT_OQ))) | unsigned(_mm256_movemask_pd(_mm256_cmp_pd(hi, zero, _CMP_GT_OQ))) << 4;
+        negative = unsigned(_mm256_movemask_pd(_mm256_cmp_pd(lo, zero, _CMP_LT_OQ))) | unsigned(_mm256_movemask_pd(_mm256_cmp_pd(hi, zero, _CMP_LT_OQ))) << 4;
+    }
+
+    GOOB_TARGET("avx2")
+    std::uint64_t cull_avx2(const ScreenTriangle * triangles, std::size_t count, const CullSetup & setup) {
+        const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256i index = _mm256_mullo_epi32(lane, _mm256_set1_epi32(floats_per_triangle));
+        const __m256 limit = _mm256_set1_ps(max_raster_coordinate);
+        const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+        const __m256 first_offset = _mm256_set1_ps(half_pixel + static_cast<float>(setup.sample_margin));
+        const __m256 last_offset = _mm256_set1_ps(half_pixel - static_cast<float>(setup.sample_margin));
+        const __m256 scale = _mm256_set1_ps(inv_subpixel_scale);
+
+        std::uint64_t mask = 0;
+        for (std::size_t first = 0; first < count; first += 8) {
+            const float * base = reinterpret_cast<const float *>(triangles + first);
+            const __m256 active = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(count - first)), lane));
+
+            __m256 in_range = active;
+            __m256 x[3], y[3];
+            for (int v = 0; v < 3; ++v) {
+                const __m256 px = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), base + 4 * v, index, active, 4);
+                const __m256 py = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), base + 4 * v + 1, index, active, 4);
+                in_range = _mm256_and_ps(in_range, _mm256_cmp_ps(_mm256_and_ps(px, abs_mask), limit, _CMP_LE_OQ));
+                in_range = _mm256_and_ps(in_range, _mm256_cmp_ps(_mm256_and_ps(py, abs_mask), limit, _CMP_LE_OQ));
+                x[v] = snap_avx2(px);
+                y[v] = snap_avx2(py);
+            }
+
+            unsigned positive, negative;
+            area_signs_avx2(_mm256_sub_ps(x[1], x[0]), _mm256_sub_ps(y[1], y[0]), _mm256_sub_ps(x[2], x[0]), _mm256_sub_ps(y[2], y[0]), positive, negative);
+            unsigned facing = positive | negative;
+            facing &= setup.mode == CullMode::back ? positive : setup.mode == CullMode::front ? negative : 0xffu;
+
+            // Pixel center bounds, ceil((min - half) / scale) and floor((max - half) / scale), exact in float
+            const __m256 min_x = _mm256_ceil_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_min_ps(x[0], _mm256_min_ps(x[1], x[2])), first_offset), scale));
+            const __m256 min_y = _mm256_ceil_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_min_ps(y[0], _mm256_min_ps(y[1], y[2])), first_offset), scale));
+            const __m256 max_x = _mm256_floor_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_max_ps(x[0], _mm256_max_ps(x[1], x[2])), last_offset), scale));
+            const __m256 max_y = _mm256_floor_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_max_ps(y[0], _mm256_max_ps(y[1], y[2])), last_offset), scale));
+            const __m256 lo_x = _mm256_max_ps(min_x, _mm256_setzero_ps()), hi_x = _mm256_min_ps(max_x, _mm256_set1_ps(static_cast<float>(setup.width - 1)));
+            const __m256 lo_y = _mm256_max_ps(min_y, _mm256_setzero_ps()), hi_y = _mm256_min_ps(max_y, _mm256_set1_ps(static_cast<float>(setup.height - 1)));
+            const __m256 covers = _mm256_and_ps(_mm256_cmp_ps(lo_x, hi_x, _CMP_LE_OQ), _mm256_cmp_ps(lo_y, hi_y, _CMP_LE_OQ));
+
+            const unsigned keep = unsigned(_mm256_movemask_ps(_mm256_and_ps(in_range, covers))) & facing;
+            mask |= std::uint64_t(keep) << first;
+        }
+        return mask;
+    }
+
+    GOOB_AVX512_WARNINGS_PUSH
+    GOOB_TARGET("avx512f")
+    __m512 snap_avx512(__m512 v) {
+        const __m512 scaled = _mm512_mul_ps(v, _mm512_set1_ps(subpixel_scale));
+        const __m512 truncated = _mm512_roundscale_ps(scaled, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        const __m512 fraction = _mm512_abs_ps(_mm512_sub_ps(scaled, truncated));
+        const __mmask16 away = _mm512_cmp_ps_mask(fraction, _mm512_set1_ps(0.5f), _CMP_GE_OQ);
+        const __mmask16 negative = _mm512_cmp_ps_mask(scaled, _mm512_setzero_ps(), _CMP_LT_OQ);
+        const __m512 step = _mm512_mask_blend_ps(negative, _mm512_set1_ps(1.0f), _mm512_set1_ps(-1.0f));
+        return _mm512_mask_add_ps(truncated, away, truncated, step);
+    }
+
+    GOOB_TARGET("avx512f")
+    __m512d area_avx512(__m256 ax, __m256 ay, __m256 bx, __m256 by) {
+        return _mm512_sub_pd(_mm512_mul_pd(_mm512_cvtps_pd(ax), _mm512_cvtps_pd(by)), _mm512_mul_pd(_mm512_cvtps_pd(ay), _mm512_cvtps_pd(bx)));
+    }
+
+    GOOB_TARGET("avx512f")
+    __m256 upper_avx512(__m512 v) {
+        return _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1));
+    }
+
+    // First and last pixel center covered by the snapped coordinates a, b, c, with the offsets of the pixel center
+    // (widened by the sample margin) from the pixel's origin
+    GOOB_TARGET("avx512f")
+    __m512 first_center_avx512(__m512 a, __m512 b, __m512 c, __m512 offset) {
+        const __m512 bound = _mm512_min_ps(a, _mm512_min_ps(b, c));
+        return _mm512_roundscale_ps(_mm512_mul_ps(_mm512_sub_ps(bound, offset), _mm512_set1_ps(inv_subpixel_scale)),
+                                    _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+    }
+
+    GOOB_TARGET("avx512f")
+    __m512 last_center_avx512(__m512 a, __m512 b, __m512 c, __m512 offset) {
+        const __m512 bound = _mm512_max_ps(a, _mm512_max_ps(b, c));
+        return _mm512_roundscale_ps(_mm512_mul_ps(_mm512_sub_ps(bound, offset), _mm512_set1_ps(inv_subpixel_scale)),
+                                    _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    }
+
+    GOOB_TARGET("avx512f")
+    std::uint64_t cull_avx512(const ScreenTriangle * triangles, std::size_t count, const CullSetup & setup) {
+        const __m512i lane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        const __m512i index = _mm512_mullo_epi32(lane, _mm512_set1_epi32(floats_per_triangle));
+        const __m512 limit = _mm512_set1_ps(max_raster_coordinate);
+        const __m512 first_offset = _mm512_set1_ps(half_pixel + static_cast<float>(setup.sample_margin));
+        const __m512 last_offset = _mm512_set1_ps(half_pixel - static_cast<float>(setup.sample_margin));
+
+        std::uint64_t mask = 0;
+        for (std::size_t first = 0; first < count; first += 16) {
+            const float * base = reinterpret_cast<const float *>(triangles + first);
+            const __mmask16 active = static_cast<__mmask16>(count - first >= 16 ? 0xffffu : (1u << (count - first)) - 1);
+
+            __mmask16 keep = active;
+            __m512 x[3], y[3];
+            for (int v = 0; v < 3; ++v) {
+                const __m512 px = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), active, index, base + 4 * v, 4);
+                const __m512 py = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), active, index, base + 4 * v + 1, 4);
+                keep &= _mm512_cmp_ps_mask(_mm512_abs_ps(px), limit, _CMP_LE_OQ) & _mm512_cmp_ps_mask(_mm512_abs_ps(py), limit, _CMP_LE_OQ);
+                x[v] = snap_avx512(px);
+                y[v] = snap_avx512(py);
+            }
+
+            // Exact double precision area, as in area_signs_avx2()
+            const __m512 ax = _mm512_sub_ps(x[1], x[0]), ay = _mm512_sub_ps(y[1], y[0]);
+            const __m512 bx = _mm512_sub_ps(x[2], x[0]), by = _mm512_sub_ps(y[2], y[0]);
+            const __m512d lo = area_avx512(_mm512_castps512_ps256(ax), _mm512_castps512_ps256(ay), _mm512_castps512_ps256(bx), _mm512_castps512_ps256(by));
+            const __m512d hi = area_avx512(upper_avx512(ax), upper_avx512(ay), upper_avx512(bx), upper_avx512(by));
+            const unsigned positive = unsigned(_mm512_cmp_pd_mask(lo, _mm512_setzero_pd(), _CMP_GT_OQ)) | unsigned(_mm512_cmp_pd_mask(hi, _mm512_setzero_pd(), _CMP_GT_OQ)) << 8;
+            const unsigned negative = unsigned(_mm512_cmp_pd_mask(lo, _mm512_setzero_pd(), _CMP_LT_OQ)) | unsigned(_mm512_cmp_pd_mask(hi, _mm512_setzero_pd(), _CMP_LT_OQ)) << 8;
+            keep &= static_cast<__mmask16>(setup.mode == CullMode::back ? positive : setup.mode == CullMode::front ? negative : positive | negative);
+
+            const __m512 lo_x = _mm512_max_ps(first_center_avx512(x[0], x[1], x[2], first_offset), _mm512_setzero_ps());
+            const __m512 lo_y = _mm512_max_ps(first_center_avx512(y[0], y[1], y[2], first_offset), _mm512_setzero_ps());
+            const __m512 hi_x = _mm512_min_ps(last_center_avx512(x[0], x[1], x[2], last_offset), _mm512_set1_ps(static_cast<float>(setup.width - 1)));
+            const __m512 hi_y = _mm512_min_ps(last_center_avx512(y[0], y[1], y[2], last_offset), _mm512_set1_ps(static_cast<float>(setup.height - 1)));
+            keep &= _mm512_cmp_ps_mask(lo_x, hi_x, _CMP_LE_OQ) & _mm512_cmp_ps_mask(lo_y, hi_y, _CMP_LE_OQ);
+
+            mask |= std::uint64_t(keep) << first;
+        }
+        return mask;
+    }
+    GOOB_AVX512_WARNINGS_POP
+#endif
+
+    constexpr CullKernel scalar_kernel{SimdLevel::scalar, 1, cull_scalar};
+#ifdef GOOB_X86
+    constexpr CullKernel avx2_kernel{SimdLevel::avx2, 8, cull_avx2};
+    constexpr CullKernel avx512_kernel{SimdLevel::avx512, 16, cull_avx512};
+#endif
+}
+
+const CullKernel * cull_kernel(SimdLevel level) {
+    if (!simd_supported(level)) {
+        return nullptr;
+    }
+    switch (level) {
+        case SimdLevel::scalar:
+        case SimdLevel::sse2:   return &scalar_kernel;
+#ifdef GOOB_X86
+        case SimdLevel::avx2:   return &avx2_kernel;
+        case SimdLevel::avx512: return &avx512_kernel;
+#else
+        default:                return nullptr;
+#endif
+    }
+    return nullptr;
+}
+
+const CullKernel & cull_kernel() {
+    static const CullKernel & kernel = *cull_kernel(simd_level());
+    return kernel;
+}
+
+}
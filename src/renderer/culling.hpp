@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "cpu_features.hpp"
+#include "vector.hpp"
+
+namespace goob {
+
+// Vertex after perspective division and viewport transform: x,y in pixels, z is window depth in [0,1]
+// and w holds 1/w_clip for perspective-correct interpolation
+using ScreenVertex = linalg::vec<float,4>;
+using ScreenTriangle = std::array<ScreenVertex,3>;
+
+// Front faces are counter-clockwise in NDC (y up), i.e. clockwise in window coordinates
+enum class CullMode { none, back, front };
+
+struct CullSetup {
+    int width;
+    int height;
+    CullMode mode = CullMode::none;
+    int sample_margin = 0;  // see setup_edges()
+};
+
+// Visibility of up to 64 consecutive triangles: bit i is set unless triangles[i] is
+//   - facing the culled side,
+//   - of zero area or has a vertex outside of +-max_raster_coordinate,
+//   - so small that its bounds contain no pixel center (no sample position with a sample margin), or
+//   - outside of the width x height viewport.
+// Snapping and bounds follow setup_edges() exactly, so a culled triangle would have covered no pixel.
+using CullBatch = std::uint64_t (*)(const ScreenTriangle * triangles, std::size_t count, const CullSetup & setup);
+
+struct CullKernel {
+    SimdLevel level;
+    int lanes;          // triangles tested per step
+    CullBatch batch;
+};
+
+// Kernel for the best instruction set available on this CPU (see simd_level()), selected once
+const CullKernel & cull_kernel();
+
+// Kernel for a specific instruction set, nullptr when it is not compiled in or not supported by the CPU.
+// SSE2 has no dedicated kernel and gets the scalar one.
+const CullKernel * cull_kernel(SimdLevel level);
+
+}
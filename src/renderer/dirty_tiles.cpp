@@ -0,0 +1,85 @@
+#include "dirty_tiles.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace goob {
+
+DirtyTiles::DirtyTiles(int width, int height) : width_(width), height_(height) {
+    if (width <= 0 || height <= 0) {
+        throw std::invalid_argument("DirtyTiles dimensions must be positive");
+    }
+    tiles_x_ = (width + tile_size - 1) / tile_size;
+    tiles_y_ = (height + tile_size - 1) / tile_size;
+    tiles_.assign(static_cast<std::size_t>(tiles_x_) * tiles_y_, 1);
+}
+
+std::size_t DirtyTiles::count() const {
+    return static_cast<std::size_t>(std::count(tiles_.begin(), tiles_.end(), std::uint8_t(1)));
+}
+
+void DirtyTiles::mark(int x0, int y0, int x1, int y1) {
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, width_ - 1);
+    y1 = std::min(y1, height_ - 1);
+    if (x0 > x1 || y0 > y1) {
+        return;
+    }
+    for (int ty = y0 / tile_size; ty <= y1 / tile_size; ++ty) {
+        std::fill_n(tiles_.begin() + static_cast<std::ptrdiff_t>(ty) * tiles_x_ + x0 / tile_size, x1 / tile_size - x0 / tile_size + 1, std::uint8_t(1));
+    }
+}
+
+void DirtyTiles::mark(const linalg::vec<float,3> & min, const linalg::vec<float,3> & max, const linalg::mat<float,4,4> & view_projection) {
+    const Rect rect = screen_rect(min, max, view_projection);
+    mark(rect.x0, rect.y0, rect.x1, rect.y1);
+}
+
+void DirtyTiles::mark_all() {
+    std::fill(tiles_.begin(), tiles_.end(), std::uint8_t(1));
+}
+
+void DirtyTiles::clear() {
+    std::fill(tiles_.begin(), tiles_.end(), std::uint8_t(0));
+}
+
+bool DirtyTiles::overlaps(const linalg::vec<float,3> & min, const linalg::vec<float,3> & max, const linalg::mat<float,4,4> & view_projection) const {
+    const Rect rect = screen_rect(min, max, view_projection);
+    if (rect.x0 > rect.x1 || rect.y0 > rect.y1) {
+        return false;
+    }
+    for (int ty = rect.y0 / tile_size; ty <= rect.y1 / tile_size; ++ty) {
+        for (int tx = rect.x0 / tile_size; tx <= rect.x1 / tile_size; ++tx) {
+            if (dirty(tx, ty)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+DirtyTiles::Rect DirtyTiles::screen_rect(const linalg::vec<float,3> & min, const linalg::vec<float,3> & max,
+                                         const linalg::mat<float,4,4> & view_projection) const {
+    linalg::vec<float,2> lo(std::numeric_limits<float>::infinity()), hi(-std::numeric_limits<float>::infinity());
+    for (int corner = 0; corner < 8; ++corner) {
+        const linalg::vec<float,3> p((corner & 1) ? max.x : min.x, (corner & 2) ? max.y : min.y, (corner & 4) ? max.z : min.z);
+        const linalg::vec<float,4> clip = linalg::mul(view_projection, linalg::vec<float,4>(p, 1.0f));
+        if (!(clip.w > 0.0f)) {
+            return {0, 0, width_ - 1, height_ - 1};
+        }
+        // Window coordinates as in Pipeline::to_screen(): x right, y down
+        const linalg::vec<float,2> window((clip.x / clip.w + 1.0f) * 0.5f * width_, (1.0f - clip.y / clip.w) * 0.5f * height_);
+        lo = linalg::min(lo, window);
+        hi = linalg::max(hi, window);
+    }
+    // One pixel of slack covers vertex snapping and multisample positions; clamping keeps huge values out of int
+    lo = linalg::clamp(lo, -2.0f, static_cast<float>(std::max(width_, height_)) + 2.0f);
+    hi = linalg::clamp(hi, -2.0f, static_cast<float>(std::max(width_, height_)) + 2.0f);
+    return {static_cast<int>(std::floor(lo.x)) - 1, static_cast<int>(std::floor(lo.y)) - 1,
+            static_cast<int>(std::ceil(hi.x)), static_cast<int>(std::ceil(hi.y))};
+}
+
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "vector.hpp"
+
+namespace goob {
+
+// Screen tiles whose contents changed since the last frame, for incremental re-rendering.
+//
+// With a fixed camera, a frame in which a few objects moved only differs from the previous one within the screen
+// bounds of those objects, at their old and at their new place. Marking both bounds and handing the set to the
+// rasterizer (see Rasterizer::set_dirty_tiles()) re-rasterizes just those tiles: clearing a target with the set
+// resets only them, and every other tile keeps the previous frame's color and depth. Objects whose bounds touch
+// no dirty tile (see overlaps()) need not be drawn at all.
+//
+// Tiles are the rasterizer's 64x64 pixel tiles. A new set is entirely dirty, so the first frame is drawn in full.
+class DirtyTiles {
+public:
+    static constexpr int tile_size = 64;
+
+    // Throws std::invalid_argument for non-positive dimensions
+    DirtyTiles(int width, int height);
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    int tiles_x() const { return tiles_x_; }
+    int tiles_y() const { return tiles_y_; }
+    std::size_t tile_count() const { return tiles_.size(); }
+
+    bool dirty(std::size_t tile) const { return tiles_[tile] != 0; }
+    bool dirty(int tx, int ty) const { return dirty(static_cast<std::size_t>(ty) * tiles_x_ + tx); }
+    // Number of dirty tiles
+    std::size_t count() const;
+
+    // Marks the tiles of the inclusive pixel rectangle, clipped to the screen
+    void mark(int x0, int y0, int x1, int y1);
+    // Marks the tiles the box [min, max] may cover on screen under `view_projection` (window coordinates as in
+    // Pipeline). Boxes reaching behind the eye mark every tile.
+    void mark(const linalg::vec<float,3> & min, const linalg::vec<float,3> & max, const linalg::mat<float,4,4> & view_projection);
+    void mark_all();
+    // Marks every tile clean, once the frame is drawn
+    void clear();
+
+    // Whether the box may cover a dirty tile
+    bool overlaps(const linalg::vec<float,3> & min, const linalg::vec<float,3> & max, const linalg::mat<float,4,4> & view_projection) const;
+
+private:
+    struct Rect {
+        int x0, y0, x1, y1;     // inclusive pixels, empty when x0 > x1 or y0 > y1
+    };
+
+    Rect screen_rect(const linalg::vec<float,3> & min, const linalg::vec<float,3> & max, const linalg::mat<float,4,4> & view_projection) const;
+
+    int width_;
+    int height_;
+    int tiles_x_;
+    int tiles_y_;
+    std::vector<std::uint8_t> tiles_;
+};
+
+}
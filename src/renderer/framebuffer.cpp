@@ -0,0 +1,153 @@
+#include "framebuffer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+#include "thread_pool.hpp"
+
+namespace goob {
+
+namespace {
+    template<class T>
+    void resolve(const Framebuffer & fb, const T * storage, std::span<T> out, ThreadPool * pool) {
+        if (out.size() < static_cast<std::size_t>(fb.width()) * fb.height()) {
+            throw std::invalid_argument("Framebuffer resolve target too small");
+        }
+        const auto row = [&](std::size_t y) {
+            T * dst = out.data() + y * fb.width();
+            if (fb.layout() == SurfaceLayout::linear) {
+                std::memcpy(dst, storage + fb.index(0, static_cast<int>(y)), sizeof(T) * fb.width());
+                return;
+            }
+            for (int x = 0; x < fb.width(); x += 8) {
+                const T * block = storage + fb.block_offset(x, static_cast<int>(y) & ~7);
+                const int row_bit = (static_cast<int>(y) & 7) * 8;
+                for (int c = 0; c < 8 && x + c < fb.width(); ++c) {
+                    dst[x + c] = block[fb.block_pixel_offset(row_bit + c)];
+                }
+            }
+        };
+        if (pool) {
+            pool->parallel_for(static_cast<std::size_t>(fb.height()), [&](std::size_t y, unsigned) { row(y); });
+        } else {
+            for (std::size_t y = 0; y < static_cast<std::size_t>(fb.height()); ++y) {
+                row(y);
+            }
+        }
+    }
+}
+
+Framebuffer::Framebuffer(int width, int height, SurfaceLayout layout)
+    : width_(width), height_(height), layout_(layout) {
+    if (width <= 0 || height <= 0) {
+        throw std::invalid_argument("Framebuffer dimensions must be positive");
+    }
+
+    std::size_t pixels = 0;
+    switch (layout) {
+        case SurfaceLayout::linear:
+            // Blocks at the right and bottom border may address pixels outside the image; the rasterizer masks them
+            stride_ = static_cast<std::size_t>(width);
+            pixels = stride_ * height;
+            break;
+        case SurfaceLayout::tiled:
+            stride_ = static_cast<std::size_t>(width + 7) / 8;
+            pixels = stride_ * ((height + 7) / 8) * 64;
+            break;
+        case SurfaceLayout::morton:
+            stride_ = static_cast<std::size_t>(width + 63) / 64;
+            pixels = stride_ * ((height + 63) / 64) * 4096;
+            break;
+    }
+    for (int bit = 0; bit < 64; ++bit) {
+        const int column = bit & 7, row = bit >> 3;
+        switch (layout) {
+            case SurfaceLayout::linear: block_pixels_[bit] = static_cast<std::uint32_t>(row * stride_ + column); break;
+            case SurfaceLayout::tiled:  block_pixels_[bit] = static_cast<std::uint32_t>(bit); break;
+            case SurfaceLayout::morton: block_pixels_[bit] = static_cast<std::uint32_t>(morton_interleave(column, row)); break;
+        }
+    }
+
+    blocks_x_ = (width + 7) / 8;
+    color_.resize(pixels);
+    depth_.resize(pixels);
+    bounds_.resize(static_cast<std::size_t>(blocks_x_) * ((height + 7) / 8));
+    clear();
+}
+
+void Framebuffer::clear(std::uint32_t color, float depth) {
+    std::fill(color_.begin(), color_.end(), color);
+    std::fill(depth_.begin(), depth_.end(), depth);
+    std::fill(bounds_.begin(), bounds_.end(), DepthBounds{depth, depth});
+}
+
+void Framebuffer::clear(const DirtyTiles & tiles, std::uint32_t color, float depth) {
+    if (tiles.width() != width_ || tiles.height() != height_) {
+        throw std::invalid_argument("Dirty tiles do not match the framebuffer");
+    }
+    for (int ty = 0; ty < tiles.tiles_y(); ++ty) {
+        for (int tx = 0; tx < tiles.tiles_x(); ++tx) {
+            if (!tiles.dirty(tx, ty)) {
+                continue;
+            }
+            const int x0 = tx * DirtyTiles::tile_size, y0 = ty * DirtyTiles::tile_size;
+            const int x1 = std::min(x0 + DirtyTiles::tile_size, width_), y1 = std::min(y0 + DirtyTiles::tile_size, height_);
+            for (int by = y0; by < y1; by += 8) {
+                for (int bx = x0; bx < x1; bx += 8) {
+                    const std::size_t block = block_offset(bx, by);
+                    for (std::uint64_t mask = detail::block_rect_mask(bx, by, 0, 0, width_ - 1, height_ - 1); mask != 0; mask &= mask - 1) {
+                        const std::size_t pixel = block + block_pixels_[std::countr_zero(mask)];
+                        color_[pixel] = color;
+                        depth_[pixel] = depth;
+                    }
+                    depth_bounds(bx, by) = {depth, depth};
+                }
+            }
+        }
+    }
+}
+
+void Framebuffer::update_depth_bounds(int bx, int by) {
+    bx &= ~7;
+    by &= ~7;
+    const float * block = depth_.data() + block_offset(bx, by);
+    DepthBounds bounds{block[0], block[0]};
+    // Pixels of border blocks outside the image are either padding or belong to the next row
+    for (std::uint64_t mask = detail::block_rect_mask(bx, by, 0, 0, width_ - 1, height_ - 1); mask != 0; mask &= mask - 1) {
+        const float z = block[block_pixels_[std::countr_zero(mask)]];
+        bounds.min = std::min(bounds.min, z);
+        bounds.max = std::max(bounds.max, z);
+    }
+    depth_bounds(bx, by) = bounds;
+}
+
+void Framebuffer::update_depth_bounds() {
+    for (int by = 0; by < height_; by += 8) {
+        for (int bx = 0; bx < width_; bx += 8) {
+            update_depth_bounds(bx, by);
+        }
+    }
+}
+
+void Framebuffer::resolve_color(std::span<std::uint32_t> out, ThreadPool * pool) const {
+    resolve(*this, color_.data(), out, pool);
+}
+
+void Framebuffer::resolve_depth(std::span<float> out, ThreadPool * pool) const {
+    resolve(*this, depth_.data(), out, pool);
+}
+
+ImageView Framebuffer::color_view(std::vector<std::uint32_t> & scratch, ThreadPool * pool) const {
+    const std::uint32_t * pixels = color_.data();
+    if (layout_ != SurfaceLayout::linear) {
+        scratch.resize(static_cast<std::size_t>(width_) * height_);
+        resolve_color(scratch, pool);
+        pixels = scratch.data();
+    }
+    return {reinterpret_cast<const std::uint8_t *>(pixels), width_, height_, PixelFormat::bgra,
+            static_cast<std::ptrdiff_t>(width_) * 4, 4};
+}
+
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "dirty_tiles.hpp"
+#include "thread_pool.hpp"
+#include "tga_image.hpp"
+#include "vector.hpp"
+
+namespace goob {
+
+// Packs a [0,1] RGBA color into 32 bits laid out as B,G,R,A bytes in memory (the TGA pixel order)
+inline std::uint32_t pack_color(const linalg::vec<float,4> & c) {
+    const auto q = linalg::vec<std::uint32_t,4>(linalg::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+    return q.z | (q.y << 8) | (q.x << 16) | (q.w << 24);
+}
+
+inline linalg::vec<float,4> unpack_color(std::uint32_t c) {
+    return linalg::vec<float,4>(float((c >> 16) & 0xff), float((c >> 8) & 0xff), float(c & 0xff), float(c >> 24)) / 255.0f;
+}
+
+namespace detail {
+    // Mask of the pixels of the 8x8 block at (bx,by) that lie within the inclusive rectangle [x0,x1] x [y0,y1]
+    inline std::uint64_t block_rect_mask(int bx, int by, int x0, int y0, int x1, int y1) {
+        const int c0 = std::max(x0 - bx, 0), c1 = std::min(x1 - bx, 7);
+        const int r0 = std::max(y0 - by, 0), r1 = std::min(y1 - by, 7);
+        const std::uint64_t columns = (0xffull >> (7 - c1 + c0)) << c0;
+        const std::uint64_t rows = (~0ull >> (8 * (7 - r1 + r0))) << (8 * r0);
+        return columns * 0x0101010101010101ull & rows;
+    }
+}
+
+// Depth range of the pixels of an 8x8 block
+struct DepthBounds {
+    float min;
+    float max;
+};
+
+// Memory order of the pixels of a render target
+enum class SurfaceLayout {
+    linear,     // row-major scanlines
+    tiled,      // 8x8 pixel blocks stored contiguously, blocks in row-major order
+    morton,     // 64x64 pixel tiles in row-major order, pixels inside a tile in Z-order
+};
+
+// Color and depth targets of a render pass. Depth is stored as window-space z in [0,1], smaller is closer.
+//
+// The rasterizer addresses pixels as 8x8 blocks: block_offset() of the block's top-left pixel plus
+// block_pixel_offset() of the pixel's bit (row * 8 + column). Blocked layouts keep the pixels a triangle
+// touches on few cache lines; they are converted back to scanlines only by the resolve functions.
+//
+// Depth is also summarized per 8x8 block (hierarchical Z) so the rasterizer can reject occluded blocks and
+// tiles without reading their pixels. The rasterizer keeps the bounds exact; code writing through depth()
+// must call update_depth_bounds() afterwards.
+class Framebuffer {
+public:
+    Framebuffer(int width, int height, SurfaceLayout layout = SurfaceLayout::linear);
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    SurfaceLayout layout() const { return layout_; }
+    // Elements per buffer, including the padding of blocked layouts; buffers sharing the layout are this long
+    std::size_t storage_size() const { return color_.size(); }
+
+    void clear(std::uint32_t color = 0, float depth = 1.0f);
+    // Clears only the dirty tiles; throws std::invalid_argument when `tiles` is for another size
+    void clear(const DirtyTiles & tiles, std::uint32_t color = 0, float depth = 1.0f);
+
+    // Storage offset of the block with top-left pixel (bx,by), both multiples of 8
+    std::size_t block_offset(int bx, int by) const {
+        switch (layout_) {
+            case SurfaceLayout::linear: return static_cast<std::size_t>(by) * stride_ + bx;
+            case SurfaceLayout::tiled:  return (static_cast<std::size_t>(by >> 3) * stride_ + (bx >> 3)) * 64;
+            case SurfaceLayout::morton: return (static_cast<std::size_t>(by >> 6) * stride_ + (bx >> 6)) * 4096 + morton_interleave(bx & 63, by & 63);
+        }
+        return 0;
+    }
+    // Offset of pixel (bit & 7, bit >> 3) relative to its block
+    std::size_t block_pixel_offset(int bit) const { return block_pixels_[bit]; }
+
+    std::size_t index(int x, int y) const { return block_offset(x & ~7, y & ~7) + block_pixel_offset((y & 7) * 8 + (x & 7)); }
+
+    DepthBounds & depth_bounds(int bx, int by) { return bounds_[static_cast<std::size_t>(by >> 3) * blocks_x_ + (bx >> 3)]; }
+    const DepthBounds & depth_bounds(int bx, int by) const { return bounds_[static_cast<std::size_t>(by >> 3) * blocks_x_ + (bx >> 3)]; }
+    // Recomputes the bounds of the block containing (bx,by), or of every block
+    void update_depth_bounds(int bx, int by);
+    void update_depth_bounds();
+
+    std::uint32_t * color() { return color_.data(); }
+    const std::uint32_t * color() const { return color_.data(); }
+    float * depth() { return depth_.data(); }
+    const float * depth() const { return depth_.data(); }
+
+    std::uint32_t color_at(int x, int y) const { return color_[index(x, y)]; }
+    float depth_at(int x, int y) const { return depth_[index(x, y)]; }
+
+    // Calls f(x, y, pixel, worker) for every pixel whose depth is below `depth`, with `pixel` its storage offset. Runs
+    // in parallel over 64x64 tiles when a pool is given (worker 0 otherwise), and skips 8x8 blocks whose depth
+    // bounds show no such pixel, so passes over the pixels a draw wrote do not scan the cleared rest.
+    template<class F>
+    void for_each_covered(float depth, F && f, ThreadPool * pool = nullptr) const;
+
+    // Copy into row-major width * height arrays, in parallel over rows when a pool is given
+    void resolve_color(std::span<std::uint32_t> out, ThreadPool * pool = nullptr) const;
+    void resolve_depth(std::span<float> out, ThreadPool * pool = nullptr) const;
+
+    // Top-down BGRA view for encoding: linear buffers are viewed in place, other layouts are resolved into `scratch`
+    ImageView color_view(std::vector<std::uint32_t> & scratch, ThreadPool * pool = nullptr) const;
+
+    // Interleaves the bits of x and y (each < 64): x in even bits, y in odd bits
+    static std::size_t morton_interleave(int x, int y) {
+        return spread_bits(static_cast<unsigned>(x)) | (spread_bits(static_cast<unsigned>(y)) << 1);
+    }
+
+private:
+    static std::size_t spread_bits(unsigned v) {
+        v &= 0x3f;
+        v = (v | (v << 4)) & 0x30f;
+        v = (v | (v << 2)) & 0x1333;
+        v = (v | (v << 1)) & 0x5555;
+        return v;
+    }
+
+    int width_;
+    int height_;
+    SurfaceLayout layout_;
+    std::size_t stride_;    // pixels per row, blocks per block row or tiles per tile row
+    int blocks_x_;
+    std::array<std::uint32_t,64> block_pixels_;
+    std::vector<std::uint32_t> color_;
+    std::vector<float> depth_;
+    std::vector<DepthBounds> bounds_;
+};
+
+template<class F>
+void Framebuffer::for_each_covered(float depth, F && f, ThreadPool * pool) const {
+    constexpr int tile_size = 64;
+    const int tiles_x = (width_ + tile_size - 1) / tile_size;
+    const int tiles_y = (height_ + tile_size - 1) / tile_size;
+    const auto tile = [&](std::size_t index, unsigned worker) {
+        const int x0 = static_cast<int>(index % tiles_x) * tile_size;
+        const int y0 = static_cast<int>(index / tiles_x) * tile_size;
+        const int x1 = std::min(x0 + tile_size, width_), y1 = std::min(y0 + tile_size, height_);
+        for (int by = y0; by < y1; by += 8) {
+            for (int bx = x0; bx < x1; bx += 8) {
+                if (!(depth_bounds(bx, by).min < depth)) {
+                    continue;
+                }
+                const std::size_t block = block_offset(bx, by);
+                for (std::uint64_t mask = detail::block_rect_mask(bx, by, 0, 0, width_ - 1, height_ - 1); mask != 0; mask &= mask - 1) {
+                    const int bit = std::countr_zero(mask);
+                    const std::size_t pixel = block + block_pixels_[bit];
+                    if (depth_[pixel] < depth) {
+                        f(bx + (bit & 7), by + (bit >> 3), pixel, worker);
+                    }
+                }
+            }
+        }
+    };
+
+    const std::size_t count = static_cast<std::size_t>(tiles_x) * tiles_y;
+    if (pool) {
+        pool->parallel_for(count, tile);
+    } else {
+        for (std::size_t index = 0; index < count; ++index) {
+            tile(index, 0);
+        }
+    }
+}
+
+}
@@ -0,0 +1,45 @@
+#include "gbuffer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace goob {
+
+namespace {
+    float sign_not_zero(float v) { return v >= 0.0f ? 1.0f : -1.0f; }
+
+    std::uint32_t to_snorm16(float v) {
+        return static_cast<std::uint16_t>(static_cast<std::int16_t>(std::lround(std::clamp(v, -1.0f, 1.0f) * 32767.0f)));
+    }
+
+    float from_snorm16(std::uint32_t v) {
+        return std::max(static_cast<float>(static_cast<std::int16_t>(static_cast<std::uint16_t>(v))) / 32767.0f, -1.0f);
+    }
+}
+
+std::uint32_t encode_normal(const linalg::vec<float,3> & n) {
+    const float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    if (!(l1 > 0.0f)) {
+        return 0;
+    }
+    float x = n.x / l1, y = n.y / l1;
+    // The lower hemisphere is folded over the diagonals onto the corners of the square
+    if (n.z < 0.0f) {
+        const float fx = (1.0f - std::abs(y)) * sign_not_zero(x);
+        const float fy = (1.0f - std::abs(x)) * sign_not_zero(y);
+        x = fx;
+        y = fy;
+    }
+    return to_snorm16(x) | (to_snorm16(y) << 16);
+}
+
+linalg::vec<float,3> decode_normal(std::uint32_t encoded) {
+    linalg::vec<float,3> n(from_snorm16(encoded & 0xffff), from_snorm16(encoded >> 16), 0.0f);
+    n.z = 1.0f - std::abs(n.x) - std::abs(n.y);
+    const float fold = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -fold : fold;
+    n.y += n.y >= 0.0f ? -fold : fold;
+    return linalg::normalize(n);
+}
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include "framebuffer.hpp"
+#include "profiler.hpp"
+#include "texel_target.hpp"
+#include "thread_pool.hpp"
+#include "vector.hpp"
+
+namespace goob {
+
+// Surface attributes returned by the fragment stage of a deferred draw
+struct Surface {
+    linalg::vec<float,3> normal;    // need not be normalized
+    linalg::vec<float,3> albedo;    // [0,1] RGB
+    std::uint8_t material = 0;
+};
+
+// A Surface packed into 8 bytes: the normal octahedral-encoded as two 16-bit snorms (see encode_normal()), and
+// the albedo packed like pack_color() with the material id in place of alpha
+struct GBufferTexel {
+    std::uint32_t normal;
+    std::uint32_t albedo;
+};
+
+// Maps a direction onto the octahedron unfolded into [-1,1]^2 and stores x in the low and y in the high 16 bits.
+// The zero vector encodes +z.
+std::uint32_t encode_normal(const linalg::vec<float,3> & n);
+// Unit normal of an encoded one, within about 1e-4 of the original direction
+linalg::vec<float,3> decode_normal(std::uint32_t encoded);
+
+inline GBufferTexel pack_surface(const Surface & surface) {
+    const std::uint32_t albedo = pack_color(linalg::vec<float,4>(surface.albedo, 0.0f)) & 0xffffff;
+    return {encode_normal(surface.normal), albedo | (std::uint32_t(surface.material) << 24)};
+}
+
+inline Surface unpack_surface(const GBufferTexel & texel) {
+    return {decode_normal(texel.normal), unpack_color(texel.albedo).xyz(), static_cast<std::uint8_t>(texel.albedo >> 24)};
+}
+
+// A covered pixel passed to the lighting function of GBuffer::light()
+struct GBufferSample {
+    int x;
+    int y;
+    float depth;    // window-space z in [0,1]
+    Surface surface;
+};
+
+// Render target of the deferred path.
+//
+// Deferred draws (see Pipeline) write depth and a packed Surface for every fragment passing the depth test, and
+// light() then evaluates lighting once per covered pixel, so lights are never computed for fragments that are
+// overwritten later.
+class GBuffer : public TexelTarget<GBufferTexel> {
+public:
+    using TexelTarget::TexelTarget;
+
+    Surface surface_at(int x, int y) const { return unpack_surface(texel_at(x, y)); }
+
+    // Sets the color of every covered pixel to shade(const GBufferSample &), which returns a [0,1] RGBA color or a
+    // packed one, in parallel over tiles when a pool is given (see Framebuffer::for_each_covered()). Uncovered
+    // pixels keep the clear color. The pass is reported as the shade stage of `profiler` when given; throws
+    // std::invalid_argument when it has fewer threads than the pool.
+    template<class Shade>
+    void light(Shade && shade, ThreadPool * pool = nullptr, Profiler * profiler = nullptr);
+};
+
+template<class Shade>
+void GBuffer::light(Shade && shade, ThreadPool * pool, Profiler * profiler) {
+    if (profiler && pool && profiler->threads() < pool->size()) {
+        throw std::invalid_argument("Profiler has fewer threads than the pool");
+    }
+    GOOB_PROFILE_STAGE(profiler, shade);
+    std::uint32_t * color = target().color();
+    const float * depth = target().depth();
+    const GBufferTexel * texels = this->texels();
+    target().for_each_covered(clear_depth(), [&](int x, int y, std::size_t pixel, [[maybe_unused]] unsigned worker) {
+        const auto lit = shade(GBufferSample{x, y, depth[pixel], unpack_surface(texels[pixel])});
+        if constexpr (std::same_as<decltype(lit), const std::uint32_t>) {
+            color[pixel] = lit;
+        } else {
+            color[pixel] = pack_color(lit);
+        }
+        GOOB_PROFILE_COUNT(profiler, worker, pixels_resolved, 1);
+    }, pool);
+}
+
+}
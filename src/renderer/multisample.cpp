@@ -0,0 +1,137 @@
+#include "multisample.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace goob {
+
+namespace {
+    constexpr std::array<linalg::vec<int,2>,2> positions_2x = {{{4, 4}, {-4, -4}}};
+    constexpr std::array<linalg::vec<int,2>,4> positions_4x = {{{-2, -6}, {6, -2}, {-6, 2}, {2, 6}}};
+    constexpr std::array<linalg::vec<int,2>,8> positions_8x = {{
+        {1, -3}, {-1, 3}, {5, 1}, {-3, -5}, {-5, 5}, {-7, -1}, {3, 7}, {7, -7},
+    }};
+
+    // Per-channel mean of n packed colors, rounded to nearest
+    std::uint32_t average(const std::uint32_t * colors, int n) {
+        std::uint32_t sum[4] = {};
+        for (int i = 0; i < n; ++i) {
+            for (int channel = 0; channel < 4; ++channel) {
+                sum[channel] += colors[i] >> (8 * channel) & 0xff;
+            }
+        }
+        std::uint32_t out = 0;
+        for (int channel = 0; channel < 4; ++channel) {
+            out |= (sum[channel] + n / 2) / n << (8 * channel);
+        }
+        return out;
+    }
+}
+
+std::span<const linalg::vec<int,2>> sample_positions(int samples) {
+    switch (samples) {
+        case 2: return positions_2x;
+        case 4: return positions_4x;
+        case 8: return positions_8x;
+    }
+    throw std::invalid_argument("Multisampling supports 2, 4 or 8 samples");
+}
+
+int sample_margin(int samples) {
+    int margin = 0;
+    for (const linalg::vec<int,2> & p : sample_positions(samples)) {
+        margin = std::max({margin, std::abs(p.x), std::abs(p.y)});
+    }
+    return margin;
+}
+
+MultisampleFramebuffer::MultisampleFramebuffer(int width, int height, int samples, SurfaceLayout layout)
+    : pixels_(width, height, layout), samples_(samples), full_mask_((1u << samples) - 1), positions_(sample_positions(samples)),
+      margin_(sample_margin(samples)), tiles_x_((width + tile_size - 1) / tile_size),
+      sample_depth_(pixels_.storage_size() * samples), expanded_(pixels_.storage_size(), none),
+      tile_samples_(static_cast<std::size_t>(tiles_x_) * ((height + tile_size - 1) / tile_size)) {
+    clear();
+}
+
+void MultisampleFramebuffer::clear(std::uint32_t color, float depth) {
+    pixels_.clear(color, depth);
+    std::fill(sample_depth_.begin(), sample_depth_.end(), depth);
+    for (std::uint32_t & entry : expanded_) {
+        entry |= uniform_bit;
+    }
+}
+
+void MultisampleFramebuffer::clear(const DirtyTiles & tiles, std::uint32_t color, float depth) {
+    pixels_.clear(tiles, color, depth);
+    for (int ty = 0; ty < tiles.tiles_y(); ++ty) {
+        for (int tx = 0; tx < tiles.tiles_x(); ++tx) {
+            if (!tiles.dirty(tx, ty)) {
+                continue;
+            }
+            const int x0 = tx * DirtyTiles::tile_size, y0 = ty * DirtyTiles::tile_size;
+            for (int y = y0; y < std::min(y0 + DirtyTiles::tile_size, height()); ++y) {
+                for (int x = x0; x < std::min(x0 + DirtyTiles::tile_size, width()); ++x) {
+                    const std::size_t pixel = pixels_.index(x, y);
+                    std::fill_n(sample_depths(pixel), samples_, depth);
+                    expanded_[pixel] |= uniform_bit;
+                }
+            }
+        }
+    }
+}
+
+std::uint32_t MultisampleFramebuffer::sample_color(int x, int y, int sample) const {
+    const std::size_t pixel = pixels_.index(x, y);
+    const std::uint32_t entry = expanded_[pixel];
+    if (entry & uniform_bit) {
+        return pixels_.color()[pixel];
+    }
+    return tile_samples_[tile_index(x, y)][static_cast<std::size_t>(entry) * samples_ + sample];
+}
+
+std::size_t MultisampleFramebuffer::expanded_pixels() const {
+    std::size_t count = 0;
+    for (int y = 0; y < height(); ++y) {
+        for (int x = 0; x < width(); ++x) {
+            count += !uniform(x, y);
+        }
+    }
+    return count;
+}
+
+void MultisampleFramebuffer::resolve_color(std::span<std::uint32_t> out, ThreadPool * pool) const {
+    if (out.size() < static_cast<std::size_t>(width()) * height()) {
+        throw std::invalid_argument("Framebuffer resolve target too small");
+    }
+    const std::uint32_t * color = pixels_.color();
+    const auto row = [&](std::size_t y) {
+        std::uint32_t * dst = out.data() + y * width();
+        for (int x = 0; x < width(); ++x) {
+            const std::size_t pixel = pixels_.index(x, static_cast<int>(y));
+            const std::uint32_t entry = expanded_[pixel];
+            if (entry & uniform_bit) {
+                dst[x] = color[pixel];
+            } else {
+                dst[x] = average(&tile_samples_[tile_index(x, static_cast<int>(y))][static_cast<std::size_t>(entry) * samples_], samples_);
+            }
+        }
+    };
+    if (pool) {
+        pool->parallel_for(static_cast<std::size_t>(height()), [&](std::size_t y, unsigned) { row(y); });
+    } else {
+        for (std::size_t y = 0; y < static_cast<std::size_t>(height()); ++y) {
+            row(y);
+        }
+    }
+}
+
+TGAImage MultisampleFramebuffer::resolve(ThreadPool * pool) const {
+    TGAImage image(width(), height(), PixelFormat::bgra);
+    const std::span<std::uint8_t> bytes = image.pixels();
+    resolve_color({reinterpret_cast<std::uint32_t *>(bytes.data()), bytes.size() / 4}, pool);
+    return image;
+}
+
+}
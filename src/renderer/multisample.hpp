@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "framebuffer.hpp"
+#include "thread_pool.hpp"
+#include "tga_image.hpp"
+#include "vector.hpp"
+
+namespace goob {
+
+// Sample positions of a pixel in subpixels (1/16 pixel) relative to its center, the standard D3D patterns for 2, 4
+// and 8 samples. Throws std::invalid_argument for other counts.
+std::span<const linalg::vec<int,2>> sample_positions(int samples);
+
+// Largest x or y distance of a sample position from the pixel center in subpixels (see setup_edges())
+int sample_margin(int samples);
+
+// Render target of multisampled draws: coverage and depth are kept per sample, color is shaded once per pixel.
+//
+// Depth is stored for every sample. Colors are compressed: a pixel whose samples all hold the same color (every
+// pixel a single triangle covers entirely) stores it once, in pixels(). A pixel that an edge crosses expands into
+// a block of one color per sample, taken from a pool of the pixel's 64x64 tile; the pixel keeps that block while
+// it is cleared or covered entirely again, so repeated expansion allocates nothing. Tiles match the rasterizer's,
+// so a tile's pool is only ever written by the worker rasterizing the tile.
+//
+// pixels() also holds the farthest sample depth of every pixel, which keeps its hierarchical Z bounds valid for
+// culling whole blocks and tiles.
+class MultisampleFramebuffer {
+public:
+    static constexpr int tile_size = 64;
+
+    // Throws std::invalid_argument unless samples is 2, 4 or 8
+    MultisampleFramebuffer(int width, int height, int samples, SurfaceLayout layout = SurfaceLayout::linear);
+
+    int width() const { return pixels_.width(); }
+    int height() const { return pixels_.height(); }
+    int samples() const { return samples_; }
+    std::span<const linalg::vec<int,2>> positions() const { return positions_; }
+    int margin() const { return margin_; }
+
+    Framebuffer & pixels() { return pixels_; }
+    const Framebuffer & pixels() const { return pixels_; }
+
+    // Clears every sample, or those of the dirty tiles; expanded pixels keep their blocks for reuse
+    void clear(std::uint32_t color = 0, float depth = 1.0f);
+    void clear(const DirtyTiles & tiles, std::uint32_t color = 0, float depth = 1.0f);
+
+    // Depth of the samples of the pixel at storage offset `pixel`, samples() contiguous values
+    float * sample_depths(std::size_t pixel) { return sample_depth_.data() + pixel * samples_; }
+    const float * sample_depths(std::size_t pixel) const { return sample_depth_.data() + pixel * samples_; }
+
+    // Writes `color` to the samples of pixel (x,y) at storage offset `pixel` selected by `mask`, bit s for sample s
+    void write(int x, int y, std::size_t pixel, unsigned mask, std::uint32_t color) {
+        if (mask == full_mask_) {
+            pixels_.color()[pixel] = color;
+            expanded_[pixel] |= uniform_bit;
+            return;
+        }
+        std::uint32_t * block = expand(x, y, pixel);
+        for (; mask != 0; mask &= mask - 1) {
+            block[std::countr_zero(mask)] = color;
+        }
+    }
+
+    // Whether all samples of pixel (x,y) hold one color, stored once
+    bool uniform(int x, int y) const { return (expanded_[pixels_.index(x, y)] & uniform_bit) != 0; }
+    std::uint32_t sample_color(int x, int y, int sample) const;
+    float sample_depth(int x, int y, int sample) const { return sample_depths(pixels_.index(x, y))[sample]; }
+    // Pixels currently storing one color per sample
+    std::size_t expanded_pixels() const;
+
+    // Averages the samples of every pixel into row-major width * height arrays or an image, in parallel over rows
+    // when a pool is given
+    void resolve_color(std::span<std::uint32_t> out, ThreadPool * pool = nullptr) const;
+    TGAImage resolve(ThreadPool * pool = nullptr) const;
+
+private:
+    // Pixels that never expanded carry `none`; others the index of their block in the tile pool, with uniform_bit
+    // set while the block is stale
+    static constexpr std::uint32_t none = ~0u;
+    static constexpr std::uint32_t uniform_bit = 1u << 31;
+
+    std::size_t tile_index(int x, int y) const { return static_cast<std::size_t>(y / tile_size) * tiles_x_ + x / tile_size; }
+
+    // Sample colors of an expanded pixel, filled from its uniform color when it was not expanded
+    std::uint32_t * expand(int x, int y, std::size_t pixel) {
+        std::uint32_t & entry = expanded_[pixel];
+        std::vector<std::uint32_t> & pool = tile_samples_[tile_index(x, y)];
+        if (entry == none) {
+            entry = static_cast<std::uint32_t>(pool.size() / samples_) | uniform_bit;
+            pool.resize(pool.size() + samples_);
+        }
+        std::uint32_t * block = pool.data() + static_cast<std::size_t>(entry & ~uniform_bit) * samples_;
+        if (entry & uniform_bit) {
+            std::fill(block, block + samples_, pixels_.color()[pixel]);
+            entry &= ~uniform_bit;
+        }
+        return block;
+    }
+
+    Framebuffer pixels_;
+    int samples_;
+    unsigned full_mask_;
+    std::span<const linalg::vec<int,2>> positions_;
+    int margin_;
+    int tiles_x_;
+    std::vector<float> sample_depth_;
+    std::vector<std::uint32_t> expanded_;
+    std::vector<std::vector<std::uint32_t>> tile_samples_;
+};
+
+}
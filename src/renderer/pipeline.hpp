@@ -0,0 +1,479 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "arena.hpp"
+#include "clipper.hpp"
+#include "framebuffer.hpp"
+#include "gbuffer.hpp"
+#include "multisample.hpp"
+#include "profiler.hpp"
+#include "rasterizer.hpp"
+#include "thread_pool.hpp"
+#include "vector.hpp"
+#include "visibility_buffer.hpp"
+
+namespace goob {
+
+namespace detail {
+    template<class T> struct is_varying_pack : std::false_type {};
+    template<int M> struct is_varying_pack<linalg::vec<float,M>> : std::true_type {};
+    template<int M, int N> struct is_varying_pack<linalg::mat<float,M,N>> : std::true_type {};
+}
+
+// Values interpolated across a triangle: a float vector or matrix whose size is known at compile time
+template<class T>
+concept VaryingPack = detail::is_varying_pack<T>::value;
+
+// Shader output: a [0,1] RGBA color or an already packed one (see pack_color())
+template<class T>
+concept FragmentColor = std::same_as<T, std::uint32_t> || std::convertible_to<T, linalg::vec<float,4>>;
+
+// Fragment stage result: a color for forward draws into a Framebuffer or a Surface for deferred draws into a GBuffer
+template<class T>
+concept FragmentOutput = FragmentColor<T> || std::same_as<T, Surface>;
+
+// A shader is a type with
+//   Vertex                          the vertex input
+//   Varyings                        a VaryingPack passed from the vertex to the fragment stage
+//   vertex(vertex, varyings&)       returns the clip-space position and writes the varyings
+//   fragment(const Varyings&)       returns the FragmentOutput of a fragment from the interpolated varyings
+// Both stages are called concurrently from several workers and must not modify shared state.
+template<class S>
+concept Shader = requires { typename S::Vertex; typename S::Varyings; }
+    && VaryingPack<typename S::Varyings>
+    && requires(const S & shader, const typename S::Vertex & vertex, typename S::Varyings & varyings, const typename S::Varyings & interpolated) {
+        { shader.vertex(vertex, varyings) } -> std::convertible_to<linalg::vec<float,4>>;
+        { shader.fragment(interpolated) } -> FragmentOutput;
+    };
+
+// A draw made into a VisibilityBuffer, passed back to Pipeline::resolve(). Empty `indices` stand for a draw of
+// every three consecutive vertices.
+template<Shader S>
+struct DrawCall {
+    const S * shader;
+    std::span<const typename S::Vertex> vertices;
+    std::span<const std::uint32_t> indices;
+};
+
+// Vertex processing, primitive assembly and shading around the Rasterizer.
+//
+// The shader is a template parameter, so the fragment stage is inlined into the rasterizer's per-pixel loop;
+// no per-fragment indirection remains. The vertex stage runs in parallel, over the vertex array for non-indexed
+// draws and over batches of triangles with a post-transform vertex cache for indexed ones, so shared vertices
+// are shaded once per batch (see shade_indexed()). Clip space follows linalg's projection matrices: NDC y points
+// up and NDC z in `depth_range` maps to window depth [0,1].
+//
+// Triangles are clipped in homogeneous space against the near and far planes of `depth_range`. Left, right,
+// bottom and top are handled by a guard band (see ClipSpace): triangles crossing the viewport sides are passed to
+// the rasterizer unsplit, and only those reaching beyond the guard band are cut, so clipping rarely adds
+// triangles. Triangles entirely outside one frustum plane are rejected before setup.
+//
+// Color draws into a MultisampleFramebuffer are antialiased: coverage and depth are tested per sample and the
+// fragment stage still runs once per pixel.
+//
+// Shaders returning a Surface draw into a GBuffer instead (deferred shading): fragments store their packed surface
+// and lighting runs afterwards in GBuffer::light(), once per visible pixel.
+//
+// Visibility draws into a VisibilityBuffer store only the ids of the visible triangles. resolve() then runs the
+// vertex stage again for the three corners of each visible triangle, cached per worker, and the fragment stage once
+// per pixel, with perspective-correct barycentrics solved in homogeneous clip space (so near-clipped triangles
+// interpolate exactly as when drawn forward).
+//
+// Transient vertex and triangle data is allocated from a FrameArena, owned and reset on every draw unless one
+// is shared through the constructor (see Rasterizer). Per-worker scratch, such as the vertex cache tables, comes
+// from the worker arenas.
+template<Shader S>
+class Pipeline {
+public:
+    using Vertex = typename S::Vertex;
+    using Varyings = typename S::Varyings;
+    using Output = std::remove_cvref_t<decltype(std::declval<const S &>().fragment(std::declval<const Varyings &>()))>;
+
+    explicit Pipeline(ThreadPool & pool)
+        : pool_(pool), owned_arena_(std::make_unique<FrameArena>(pool.size())), arena_(*owned_arena_), rasterizer_(pool, arena_) {}
+    // Throws std::invalid_argument when `arena` has fewer worker arenas than the pool has workers
+    Pipeline(ThreadPool & pool, FrameArena & arena) : pool_(pool), arena_(arena), rasterizer_(pool, arena) {
+        if (arena.worker_count() < pool.size()) {
+            throw std::invalid_argument("FrameArena has fewer worker arenas than the pool has workers");
+        }
+    }
+
+    Rasterizer & rasterizer() { return rasterizer_; }
+
+    void set_depth_range(linalg::z_range range) { depth_range_ = range; }
+
+    // Reports stage timings and counters of draws and resolves to `profiler` (see Rasterizer::set_profiler())
+    void set_profiler(Profiler * profiler) { rasterizer_.set_profiler(profiler); }
+
+    // Redraws only the dirty tiles of `tiles`, or every tile when null (see Rasterizer::set_dirty_tiles())
+    void set_dirty_tiles(const DirtyTiles * tiles) { rasterizer_.set_dirty_tiles(tiles); }
+
+    // Draws every three consecutive vertices as a triangle
+    void draw(const S & shader, std::span<const Vertex> vertices, Framebuffer & target) requires FragmentColor<Output> {
+        assemble_vertices(shader, vertices, target);
+        raster(shader, target);
+    }
+
+    // Draws the triangles listed by `indices`, three per triangle. Throws std::out_of_range for an index past the
+    // end of `vertices`.
+    void draw(const S & shader, std::span<const Vertex> vertices, std::span<const std::uint32_t> indices, Framebuffer & target)
+        requires FragmentColor<Output> {
+        assemble_indexed(shader, vertices, indices, target);
+        raster(shader, target);
+    }
+
+    // Multisampled variants (see Rasterizer's multisampled draw())
+    void draw(const S & shader, std::span<const Vertex> vertices, MultisampleFramebuffer & target) requires FragmentColor<Output> {
+        assemble_vertices(shader, vertices, target.pixels());
+        raster(shader, target);
+    }
+
+    void draw(const S & shader, std::span<const Vertex> vertices, std::span<const std::uint32_t> indices, MultisampleFramebuffer & target)
+        requires FragmentColor<Output> {
+        assemble_indexed(shader, vertices, indices, target.pixels());
+        raster(shader, target);
+    }
+
+    // Deferred variants: write depth and the packed surface of the visible fragments into `target`
+    void draw(const S & shader, std::span<const Vertex> vertices, GBuffer & target) requires std::same_as<Output, Surface> {
+        assemble_vertices(shader, vertices, target.target());
+        raster(shader, target);
+    }
+
+    void draw(const S & shader, std::span<const Vertex> vertices, std::span<const std::uint32_t> indices, GBuffer & target)
+        requires std::same_as<Output, Surface> {
+        assemble_indexed(shader, vertices, indices, target.target());
+        raster(shader, target);
+    }
+
+    // Visibility variants: write depth and the visible triangle's ids, tagged with `instance`, into `target`
+    void draw(const S & shader, std::span<const Vertex> vertices, VisibilityBuffer & target, std::uint32_t instance) {
+        assemble_vertices(shader, vertices, target.target());
+        raster(target, instance);
+    }
+
+    void draw(const S & shader, std::span<const Vertex> vertices, std::span<const std::uint32_t> indices, VisibilityBuffer & target,
+              std::uint32_t instance) {
+        assemble_indexed(shader, vertices, indices, target.target());
+        raster(target, instance);
+    }
+
+    // Shades every covered pixel of `target` once into its color, tile-parallel. `draws[i]` must describe the draw
+    // made with instance i. Throws std::out_of_range for ids outside of `draws`.
+    void resolve(std::span<const DrawCall<S>> draws, VisibilityBuffer & target) requires FragmentColor<Output> {
+        GOOB_PROFILE_STAGE(rasterizer_.profiler(), resolve);
+        if (owned_arena_) {
+            owned_arena_->reset();
+        }
+        // Each worker sets its cache up in its own arena on first use
+        const std::span<ResolvedTriangle *> caches = arena_.frame().allocate_array<ResolvedTriangle *>(pool_.size());
+        std::fill(caches.begin(), caches.end(), nullptr);
+        const float half_width = 0.5f * target.width(), half_height = 0.5f * target.height();
+        std::uint32_t * color = target.target().color();
+        const VisibilityTexel * texels = target.texels();
+
+        target.target().for_each_covered(target.clear_depth(), [&](int x, int y, std::size_t pixel, unsigned worker) {
+            const VisibilityTexel texel = texels[pixel];
+            const std::size_t slot = ((texel.instance * 0x9e3779b1u) ^ texel.triangle) & (resolve_cache_size - 1);
+            if (!caches[worker]) {
+                caches[worker] = arena_.worker(worker).allocate_array<ResolvedTriangle>(resolve_cache_size).data();
+                for (std::size_t i = 0; i < resolve_cache_size; ++i) {
+                    caches[worker][i].instance = empty_slot;
+                }
+            }
+            ResolvedTriangle & t = caches[worker][slot];
+            if (t.instance != texel.instance || t.triangle != texel.triangle) {
+                fetch_triangle(draws, texel, t);
+            }
+            const float ndc_x = (x + 0.5f) / half_width - 1.0f, ndc_y = 1.0f - (y + 0.5f) / half_height;
+            const linalg::vec<float,3> b = t.a + t.b * ndc_x + t.c * ndc_y;
+            const linalg::vec<float,3> bary = b / linalg::sum(b);
+            const auto shaded = t.shader->fragment(t.varyings[0] * bary.x + t.varyings[1] * bary.y + t.varyings[2] * bary.z);
+            if constexpr (std::same_as<decltype(shaded), const std::uint32_t>) {
+                color[pixel] = shaded;
+            } else {
+                color[pixel] = pack_color(shaded);
+            }
+            GOOB_PROFILE_COUNT(rasterizer_.profiler(), worker, pixels_resolved, 1);
+        }, &pool_);
+    }
+
+private:
+    static constexpr std::size_t vertex_batch = 256;
+    static constexpr std::uint32_t empty_slot = ~0u;
+    // Indexed draws shade per batch of triangles through a hash table of the batch's vertices
+    static constexpr std::size_t triangle_batch = 512;
+    static constexpr std::size_t cache_slots = 2048;
+    static_assert(cache_slots >= 3 * triangle_batch && std::has_single_bit(cache_slots));
+    // Direct-mapped per-worker cache of the triangles resolve() has set up
+    static constexpr std::size_t resolve_cache_size = 64;
+
+    struct ResolvedTriangle {
+        std::uint32_t instance;
+        std::uint32_t triangle;
+        const S * shader;
+        // Unnormalized barycentrics at NDC (x,y) are a + b * x + c * y
+        linalg::vec<float,3> a, b, c;
+        std::array<Varyings,3> varyings;
+    };
+
+    void begin(std::size_t max_triangles) {
+        if (owned_arena_) {
+            owned_arena_->reset();
+        }
+        // Dropping the old storage rather than clearing keeps vectors from reusing memory of a reset arena
+        std::pmr::memory_resource * frame = &arena_.frame();
+        triangles_ = std::pmr::vector<ScreenTriangle>(frame);
+        corners_ = std::pmr::vector<std::array<std::uint32_t,3>>(frame);
+        primitives_ = std::pmr::vector<std::uint32_t>(frame);
+        triangles_.reserve(max_triangles);
+        corners_.reserve(max_triangles);
+        primitives_.reserve(max_triangles);
+    }
+
+    void assemble_vertices(const S & shader, std::span<const Vertex> vertices, const Framebuffer & target) {
+        begin(vertices.size() / 3);
+        shade_vertices(shader, vertices, target);
+        GOOB_PROFILE_STAGE(rasterizer_.profiler(), clip);
+        for (std::uint32_t i = 0; i + 2 < vertices.size(); i += 3) {
+            assemble({i, i + 1, i + 2}, i / 3);
+        }
+    }
+
+    void assemble_indexed(const S & shader, std::span<const Vertex> vertices, std::span<const std::uint32_t> indices, const Framebuffer & target) {
+        begin(indices.size() / 3);
+        const std::span<const std::uint32_t> slots = shade_indexed(shader, vertices, indices, target);
+        GOOB_PROFILE_STAGE(rasterizer_.profiler(), clip);
+        for (std::size_t i = 0; i + 2 < slots.size(); i += 3) {
+            assemble({slots[i], slots[i + 1], slots[i + 2]}, static_cast<std::uint32_t>(i / 3));
+        }
+    }
+
+    ScreenVertex to_screen(const linalg::vec<float,4> & clip) const {
+        // w <= 0 is kept in the screen vertex to reject the triangle during assembly
+        const float inv_w = clip.w > 0.0f ? 1.0f / clip.w : 0.0f;
+        const linalg::vec<float,3> ndc = clip.xyz() * inv_w;
+        const float depth = depth_range_ == linalg::zero_to_one ? ndc.z : 0.5f * ndc.z + 0.5f;
+        return {(ndc.x + 1.0f) * half_width_, (1.0f - ndc.y) * half_height_, depth, inv_w};
+    }
+
+    // Allocates `count` shaded vertex slots; vertices created by clipping are appended after them
+    void prepare_vertices(std::size_t count, const Framebuffer & target) {
+        clip_ = arena_.frame().allocate_array<linalg::vec<float,4>>(count);
+        outcodes_ = arena_.frame().allocate_array<std::uint16_t>(count);
+        screen_ = std::pmr::vector<ScreenVertex>(&arena_.frame());
+        varyings_ = std::pmr::vector<Varyings>(&arena_.frame());
+        screen_.reserve(count + count / 8);
+        varyings_.reserve(count + count / 8);
+        screen_.resize(count);
+        varyings_.resize(count);
+        half_width_ = 0.5f * target.width();
+        half_height_ = 0.5f * target.height();
+        clip_space_ = ClipSpace::for_viewport(target.width(), target.height(), depth_range_);
+    }
+
+    void shade_vertex(const S & shader, const Vertex & vertex, std::size_t slot) {
+        clip_[slot] = shader.vertex(vertex, varyings_[slot]);
+        outcodes_[slot] = clip_space_.outcode(clip_[slot]);
+        screen_[slot] = to_screen(clip_[slot]);
+    }
+
+    void shade_vertices(const S & shader, std::span<const Vertex> vertices, const Framebuffer & target) {
+        GOOB_PROFILE_STAGE(rasterizer_.profiler(), vertex);
+        prepare_vertices(vertices.size(), target);
+        const std::size_t batches = (vertices.size() + vertex_batch - 1) / vertex_batch;
+        pool_.parallel_for(batches, [&](std::size_t batch, [[maybe_unused]] unsigned worker) {
+            const std::size_t end = std::min(vertices.size(), (batch + 1) * vertex_batch);
+            for (std::size_t i = batch * vertex_batch; i < end; ++i) {
+                shade_vertex(shader, vertices[i], i);
+            }
+            GOOB_PROFILE_COUNT(rasterizer_.profiler(), worker, vertices_shaded, end - batch * vertex_batch);
+        });
+    }
+
+    // Post-transform vertex cache: the index stream is split into batches shaded in parallel, and a vertex is
+    // shaded once per batch that references it, into the slot range of that batch. Vertices no triangle uses are
+    // never shaded. Returns the shaded slot of every corner. How often a vertex is shaded again by a later
+    // batch depends on the triangle order (see optimize_vertex_cache()).
+    std::span<const std::uint32_t> shade_indexed(const S & shader, std::span<const Vertex> vertices, std::span<const std::uint32_t> indices,
+                                                 const Framebuffer & target) {
+        GOOB_PROFILE_STAGE(rasterizer_.profiler(), vertex);
+        const std::size_t corners = indices.size() - indices.size() % 3;
+        const std::size_t batch_corners = 3 * triangle_batch;
+        const std::size_t batches = (corners + batch_corners - 1) / batch_corners;
+        // A batch shades each distinct vertex once, so it never needs more slots than the mesh has vertices
+        const std::size_t batch_slots = std::min(batch_corners, vertices.size());
+        prepare_vertices(batches * batch_slots, target);
+        const std::span<std::uint32_t> slots = arena_.frame().allocate_array<std::uint32_t>(corners);
+        // Vertex cache tables come from the worker arenas, allocated by the first batch of each worker
+        const std::span<std::uint32_t *> tables = arena_.frame().allocate_array<std::uint32_t *>(pool_.size());
+        std::fill(tables.begin(), tables.end(), nullptr);
+
+        pool_.parallel_for(batches, [&](std::size_t batch, unsigned worker) {
+            if (!tables[worker]) {
+                tables[worker] = arena_.worker(worker).allocate_array<std::uint32_t>(2 * cache_slots).data();
+            }
+            std::uint32_t * keys = tables[worker];
+            std::uint32_t * values = keys + cache_slots;
+            std::fill(keys, keys + cache_slots, empty_slot);
+
+            const std::size_t end = std::min(corners, (batch + 1) * batch_corners);
+            std::uint32_t next = static_cast<std::uint32_t>(batch * batch_slots);
+            for (std::size_t i = batch * batch_corners; i < end; ++i) {
+                const std::uint32_t index = indices[i];
+                if (index >= vertices.size()) {
+                    throw std::out_of_range("Pipeline vertex index out of range");
+                }
+                std::size_t h = (index * 0x9e3779b1u) >> (32 - std::countr_zero(cache_slots));
+                while (keys[h] != empty_slot && keys[h] != index) {
+                    h = (h + 1) & (cache_slots - 1);
+                }
+                if (keys[h] == empty_slot) {
+                    keys[h] = index;
+                    values[h] = next;
+                    shade_vertex(shader, vertices[index], next++);
+                }
+                slots[i] = values[h];
+            }
+            GOOB_PROFILE_COUNT(rasterizer_.profiler(), worker, vertices_shaded, next - batch * batch_slots);
+        });
+        return slots;
+    }
+
+    // `primitive` is the triangle's index within the draw, kept for visibility draws
+    void assemble(const std::array<std::uint32_t,3> & corners, std::uint32_t primitive) {
+        const std::uint16_t a = outcodes_[corners[0]], b = outcodes_[corners[1]], c = outcodes_[corners[2]];
+        if (a & b & c & clip_frustum) {
+            return;
+        }
+        if (!((a | b | c) & clip_cut)) {
+            push_triangle(corners, primitive);
+            return;
+        }
+
+        std::array<ClipVertex, max_clip_vertices> polygon;
+        const int count = clip_triangle({clip_[corners[0]], clip_[corners[1]], clip_[corners[2]]}, a | b | c, clip_space_, polygon);
+        std::array<std::uint32_t, max_clip_vertices> indices;
+        for (int i = 0; i < count; ++i) {
+            const ClipVertex & v = polygon[i];
+            if (v.source >= 0) {
+                indices[i] = corners[v.source];
+                continue;
+            }
+            // Varyings are affine in clip space, so the clip weights interpolate them exactly
+            indices[i] = static_cast<std::uint32_t>(screen_.size());
+            varyings_.push_back(varyings_[corners[0]] * v.weights.x + varyings_[corners[1]] * v.weights.y + varyings_[corners[2]] * v.weights.z);
+            screen_.push_back(to_screen(v.position));
+        }
+        for (int i = 1; i + 1 < count; ++i) {
+            push_triangle({indices[0], indices[i], indices[i + 1]}, primitive);
+        }
+    }
+
+    void push_triangle(const std::array<std::uint32_t,3> & corners, std::uint32_t primitive) {
+        const ScreenTriangle triangle = {screen_[corners[0]], screen_[corners[1]], screen_[corners[2]]};
+        if (triangle[0].w <= 0.0f || triangle[1].w <= 0.0f || triangle[2].w <= 0.0f) {
+            return;
+        }
+        triangles_.push_back(triangle);
+        corners_.push_back(corners);
+        primitives_.push_back(primitive);
+    }
+
+    Varyings interpolate(std::uint32_t triangle, const linalg::vec<float,3> & bary) const {
+        const std::array<std::uint32_t,3> & c = corners_[triangle];
+        return varyings_[c[0]] * bary.x + varyings_[c[1]] * bary.y + varyings_[c[2]] * bary.z;
+    }
+
+    // Fragment of color draws: the shader's color, packed
+    auto color_fragment(const S & shader) const {
+        return [this, &shader](std::uint32_t triangle, const linalg::vec<float,3> & bary) -> std::uint32_t {
+            const auto color = shader.fragment(interpolate(triangle, bary));
+            if constexpr (std::same_as<decltype(color), const std::uint32_t>) {
+                return color;
+            } else {
+                return pack_color(color);
+            }
+        };
+    }
+
+    void raster(const S & shader, Framebuffer & target) {
+        rasterizer_.draw(triangles_, target, color_fragment(shader));
+    }
+
+    void raster(const S & shader, MultisampleFramebuffer & target) {
+        rasterizer_.draw(triangles_, target, color_fragment(shader));
+    }
+
+    void raster(const S & shader, GBuffer & target) {
+        GBufferTexel * texels = target.texels();
+        rasterizer_.draw(triangles_, target.target(), [&](std::uint32_t triangle, const linalg::vec<float,3> & bary, std::size_t pixel) {
+            texels[pixel] = pack_surface(shader.fragment(interpolate(triangle, bary)));
+        });
+    }
+
+    void raster(VisibilityBuffer & target, std::uint32_t instance) {
+        VisibilityTexel * texels = target.texels();
+        rasterizer_.draw(triangles_, target.target(), [&](std::uint32_t triangle, const linalg::vec<float,3> &, std::size_t pixel) {
+            texels[pixel] = {primitives_[triangle], instance};
+        });
+    }
+
+    void fetch_triangle(std::span<const DrawCall<S>> draws, const VisibilityTexel & texel, ResolvedTriangle & out) const {
+        if (texel.instance >= draws.size()) {
+            throw std::out_of_range("Pipeline resolve instance out of range");
+        }
+        const DrawCall<S> & draw = draws[texel.instance];
+        const std::size_t first = 3 * static_cast<std::size_t>(texel.triangle);
+        if (first + 3 > (draw.indices.empty() ? draw.vertices.size() : draw.indices.size())) {
+            throw std::out_of_range("Pipeline resolve triangle out of range");
+        }
+        std::array<linalg::vec<float,4>,3> clip;
+        for (int i = 0; i < 3; ++i) {
+            const std::size_t vertex = draw.indices.empty() ? first + i : draw.indices[first + i];
+            clip[i] = draw.shader->vertex(draw.vertices[vertex], out.varyings[i]);
+        }
+        // The clip-space point with weights w projecting onto NDC p solves dot(w, X - p.x W) = dot(w, Y - p.y W) = 0
+        // for the corner coordinate vectors X, Y and W, so w is parallel to the cross product of those two vectors
+        const linalg::vec<float,3> xs(clip[0].x, clip[1].x, clip[2].x);
+        const linalg::vec<float,3> ys(clip[0].y, clip[1].y, clip[2].y);
+        const linalg::vec<float,3> ws(clip[0].w, clip[1].w, clip[2].w);
+        out.a = linalg::cross(xs, ys);
+        out.b = linalg::cross(ys, ws);
+        out.c = linalg::cross(ws, xs);
+        out.shader = draw.shader;
+        out.instance = texel.instance;
+        out.triangle = texel.triangle;
+    }
+
+    ThreadPool & pool_;
+    std::unique_ptr<FrameArena> owned_arena_;
+    FrameArena & arena_;
+    Rasterizer rasterizer_;
+    linalg::z_range depth_range_ = linalg::neg_one_to_one;
+    ClipSpace clip_space_;
+    float half_width_ = 0.0f;
+    float half_height_ = 0.0f;
+    std::span<linalg::vec<float,4>> clip_;
+    std::span<std::uint16_t> outcodes_;
+    std::pmr::vector<ScreenVertex> screen_{&arena_.frame()};
+    std::pmr::vector<Varyings> varyings_{&arena_.frame()};
+    std::pmr::vector<ScreenTriangle> triangles_{&arena_.frame()};
+    std::pmr::vector<std::array<std::uint32_t,3>> corners_{&arena_.frame()}; // vertex indices of triangles_
+    std::pmr::vector<std::uint32_t> primitives_{&arena_.frame()};             // draw triangle of triangles_
+};
+
+}
@@ -0,0 +1,167 @@
+#include "rasterizer.hpp"
+
+#include <stdexcept>
+
+namespace goob {
+
+namespace {
+    // Triangles per binning chunk below which splitting the work is not worth waking the workers
+    constexpr std::size_t min_chunk_triangles = 256;
+}
+
+bool setup_triangle(const ScreenTriangle & triangle, int width, int height, TriangleSetup & out, int sample_margin) {
+    if (!setup_edges(triangle[0].xy(), triangle[1].xy(), triangle[2].xy(), out.edges, sample_margin)) {
+        return false;
+    }
+
+    out.min = linalg::max(out.edges.min, linalg::vec<int,2>(0));
+    out.max = linalg::min(out.edges.max, linalg::vec<int,2>(width - 1, height - 1));
+    if (out.min.x > out.max.x || out.min.y > out.max.y) {
+        return false;
+    }
+
+    // Barycentrics derived from the snapped edge functions, so interpolation agrees with coverage
+    const double inv_area = 1.0 / static_cast<double>(out.edges.area);
+    for (int i = 0; i < 3; ++i) {
+        out.a[i] = static_cast<float>(out.edges.dx[i] * inv_area);
+        out.b[i] = static_cast<float>(out.edges.dy[i] * inv_area);
+        // c is the value at the center of pixel (0,0) while the planes are evaluated at x + 0.5, y + 0.5
+        out.c[i] = static_cast<float>((static_cast<double>(out.edges.c[i]) - 0.5 * (out.edges.dx[i] + out.edges.dy[i])) * inv_area);
+    }
+    out.z = {triangle[0].z, triangle[1].z, triangle[2].z};
+    out.z_plane = {linalg::dot(out.a, out.z), linalg::dot(out.b, out.z), linalg::dot(out.c, out.z)};
+    out.z_min = linalg::minelem(out.z);
+    out.z_max = linalg::maxelem(out.z);
+    out.inv_w = {triangle[0].w, triangle[1].w, triangle[2].w};
+    return true;
+}
+
+RasterStats & RasterStats::operator+=(const RasterStats & other) {
+    triangles_culled += other.triangles_culled;
+    tiles_culled += other.tiles_culled;
+    blocks_culled += other.blocks_culled;
+    pixels_culled += other.pixels_culled;
+    pixels_depth_failed += other.pixels_depth_failed;
+    pixels_shaded += other.pixels_shaded;
+    return *this;
+}
+
+Rasterizer::Rasterizer(ThreadPool & pool)
+    : pool_(pool), owned_arena_(std::make_unique<FrameArena>(pool.size())), arena_(*owned_arena_), kernel_(coverage_kernel()), cull_kernel_(cull_kernel()),
+      worker_stats_(pool.size()) {
+}
+
+Rasterizer::Rasterizer(ThreadPool & pool, FrameArena & arena)
+    : pool_(pool), arena_(arena), kernel_(coverage_kernel()), cull_kernel_(cull_kernel()), worker_stats_(pool.size()) {
+}
+
+RasterStats Rasterizer::stats() const {
+    RasterStats total;
+    for (const WorkerStats & worker : worker_stats_) {
+        total += worker.stats;
+    }
+    return total;
+}
+
+void Rasterizer::set_profiler(Profiler * profiler) {
+    if (profiler && profiler->threads() < pool_.size()) {
+        throw std::invalid_argument("Profiler has fewer threads than the rasterizer's pool");
+    }
+    profiler_ = profiler;
+}
+
+void Rasterizer::reset_stats() {
+    for (WorkerStats & worker : worker_stats_) {
+        worker.stats = {};
+    }
+}
+
+std::size_t Rasterizer::binned_count(std::size_t tile) const {
+    return tile_begin_[tile + 1] - tile_begin_[tile];
+}
+
+// Binning counts the triangles of every (chunk, tile) pair, turns the counts into write cursors with a prefix sum
+// in tile-major order and then fills one flat array. Chunks cover consecutive triangle ranges, so each tile's
+// triangles end up contiguous and in submission order without any per-bin allocation.
+void Rasterizer::bin(std::span<const ScreenTriangle> triangles, int width, int height, int sample_margin) {
+    static_assert(DirtyTiles::tile_size == tile_size);
+    if (dirty_tiles_ && (dirty_tiles_->width() != width || dirty_tiles_->height() != height)) {
+        throw std::invalid_argument("Dirty tiles do not match the render target");
+    }
+    tiles_x_ = (width + tile_size - 1) / tile_size;
+    tiles_y_ = (height + tile_size - 1) / tile_size;
+    const std::size_t tiles = tile_count();
+
+    const std::size_t max_chunks = std::max<std::size_t>(1, triangles.size() / min_chunk_triangles);
+    const std::size_t chunks = std::min<std::size_t>(2 * pool_.size(), max_chunks);
+    const auto chunk_begin = [&](std::size_t chunk) { return triangles.size() * chunk / chunks; };
+
+    Arena & arena = arena_.frame();
+    setups_ = arena.allocate_array<TriangleSetup>(triangles.size());
+    const std::span<std::uint32_t> cursors = arena.allocate_array<std::uint32_t>(chunks * tiles);
+    std::fill(cursors.begin(), cursors.end(), 0u);
+
+    const DirtyTiles * dirty = dirty_tiles_;
+    const auto for_each_tile = [&](const TriangleSetup & setup, auto && body) {
+        const linalg::vec<int,2> first = setup.min / tile_size, last = setup.max / tile_size;
+        for (int ty = first.y; ty <= last.y; ++ty) {
+            for (int tx = first.x; tx <= last.x; ++tx) {
+                if (!dirty || dirty->dirty(tx, ty)) {
+                    body(static_cast<std::size_t>(ty) * tiles_x_ + tx);
+                }
+            }
+        }
+    };
+
+    const CullSetup cull = {width, height, cull_mode_, sample_margin};
+    {
+        GOOB_PROFILE_STAGE(profiler_, cull);
+        pool_.parallel_for(chunks, [&](std::size_t chunk, unsigned worker) {
+            std::uint32_t * counts = &cursors[chunk * tiles];
+            std::uint64_t culled = 0;
+            for (std::size_t first = chunk_begin(chunk); first < chunk_begin(chunk + 1); first += 64) {
+                const std::size_t count = std::min<std::size_t>(64, chunk_begin(chunk + 1) - first);
+                const std::uint64_t visible = cull_kernel_.batch(&triangles[first], count, cull);
+                for (std::size_t i = first; i < first + count; ++i) {
+                    TriangleSetup & setup = setups_[i];
+                    const bool kept = visible >> (i - first) & 1;
+                    culled += !kept;
+                    if (!kept || !setup_triangle(triangles[i], width, height, setup, sample_margin)) {
+                        // Empty bounds bin the triangle nowhere in the fill pass
+                        setup.min = {0, 0};
+                        setup.max = {-tile_size, -tile_size};
+                        continue;
+                    }
+                    for_each_tile(setup, [&](std::size_t tile) { ++counts[tile]; });
+                }
+            }
+            worker_stats_[worker].stats.triangles_culled += culled;
+            GOOB_PROFILE_COUNT(profiler_, worker, triangles_in, chunk_begin(chunk + 1) - chunk_begin(chunk));
+            GOOB_PROFILE_COUNT(profiler_, worker, triangles_culled, culled);
+        });
+    }
+
+    GOOB_PROFILE_STAGE(profiler_, bin);
+
+    tile_begin_ = arena.allocate_array<std::uint32_t>(tiles + 1);
+    std::uint32_t total = 0;
+    for (std::size_t tile = 0; tile < tiles; ++tile) {
+        tile_begin_[tile] = total;
+        for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+            const std::uint32_t count = cursors[chunk * tiles + tile];
+            cursors[chunk * tiles + tile] = total;
+            total += count;
+        }
+    }
+    tile_begin_[tiles] = total;
+
+    bin_triangles_ = arena.allocate_array<std::uint32_t>(total);
+    pool_.parallel_for(chunks, [&](std::size_t chunk, unsigned) {
+        std::uint32_t * next = &cursors[chunk * tiles];
+        for (std::size_t i = chunk_begin(chunk); i < chunk_begin(chunk + 1); ++i) {
+            for_each_tile(setups_[i], [&](std::size_t tile) { bin_triangles_[next[tile]++] = static_cast<std::uint32_t>(i); });
+        }
+    });
+}
+
+}
@@ -0,0 +1,404 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "arena.hpp"
+#include "coverage.hpp"
+#include "culling.hpp"
+#include "framebuffer.hpp"
+#include "multisample.hpp"
+#include "profiler.hpp"
+#include "thread_pool.hpp"
+#include "vector.hpp"
+
+namespace goob {
+
+// Per-triangle data computed once and shared by every tile the triangle touches
+struct TriangleSetup {
+    EdgeSetup edges;
+    // Screen-space barycentric planes: lambda_i(x,y) = a[i]*x + b[i]*y + c[i] at pixel centers
+    linalg::vec<float,3> a, b, c;
+    linalg::vec<float,3> z;
+    linalg::vec<float,3> z_plane;   // depth as dz/dx, dz/dy and offset, evaluated like the barycentric planes
+    float z_min, z_max;             // depth range of the vertices
+    linalg::vec<float,3> inv_w;
+    linalg::vec<int,2> min, max;    // inclusive pixel bounds, clipped to the viewport
+};
+
+// Computes the setup of a triangle for a width x height viewport.
+// Returns false when the triangle covers no pixel center (degenerate or outside of the viewport), or no sample
+// position for a nonzero sample margin (see setup_edges()).
+bool setup_triangle(const ScreenTriangle & triangle, int width, int height, TriangleSetup & out, int sample_margin = 0);
+
+// Culling, hierarchical Z and depth test counters, accumulated over draws until reset_stats()
+struct RasterStats {
+    std::uint64_t triangles_culled = 0;     // rejected by the cull kernel before setup
+    std::uint64_t tiles_culled = 0;         // triangle/tile pairs rejected against the farthest depth of the tile
+    std::uint64_t blocks_culled = 0;        // covered 8x8 blocks rejected against the farthest depth of the block
+    std::uint64_t pixels_culled = 0;        // covered pixels of the culled blocks
+    std::uint64_t pixels_depth_failed = 0;  // covered pixels failing the per-pixel depth test
+    std::uint64_t pixels_shaded = 0;
+
+    RasterStats & operator+=(const RasterStats & other);
+};
+
+// Sort-middle rasterizer: triangles are culled, set up and binned into fixed-size screen tiles, then tiles are
+// rasterized in parallel on the thread pool. A tile is owned by exactly one worker, so depth test and
+// color writes need no synchronization, and triangles are processed in submission order within a tile.
+// Inside a tile coverage is computed for 8x8 pixel blocks at a time by the SIMD coverage kernel.
+//
+// Before setup the SIMD cull kernel rejects back- or front-facing (see set_cull_mode()), degenerate, off-screen
+// and sub-pixel triangles 8 or 16 at a time, so dense distant meshes do not pay for setup of triangles that
+// cover no pixel center.
+//
+// With hierarchical Z a triangle is skipped for a whole tile when its nearest vertex is behind every pixel of
+// the tile, and a covered block is skipped when the triangle's depth plane over the block is behind the block's
+// farthest pixel. On single-sampled targets, blocks entirely in front of the nearest pixel skip the per-pixel
+// depth reads; multisampled targets always test their samples.
+//
+// Incremental frames restrict binning and rasterization to the tiles marked in a DirtyTiles set.
+//
+// Triangle setups and bins live in a FrameArena. A rasterizer created without one owns an arena and resets it
+// at the start of every draw; with a shared arena the data of a draw stays valid until the owner resets it.
+class Rasterizer {
+public:
+    static constexpr int tile_size = 64;
+
+    explicit Rasterizer(ThreadPool & pool);
+    Rasterizer(ThreadPool & pool, FrameArena & arena);
+
+    // Rasterizes `triangles` into `target`. For every fragment passing the depth test (less) `fragment` is called
+    // with the triangle index and the perspective-correct barycentric coordinates and returns the packed color.
+    // A fragment taking the pixel's storage offset (see Framebuffer::index()) as a third argument writes its own
+    // outputs instead and the color is left alone, which is how buffers in the target's layout are filled.
+    // Concurrent calls happen only for fragments of different tiles.
+    template<class Fragment>
+    void draw(std::span<const ScreenTriangle> triangles, Framebuffer & target, Fragment && fragment) {
+        if (owned_arena_) {
+            owned_arena_->reset();
+        }
+        bin(triangles, target.width(), target.height());
+        GOOB_PROFILE_STAGE(profiler_, raster);
+        pool_.parallel_for(tile_count(), [&](std::size_t tile, unsigned worker) {
+            raster_tile(tile, target, fragment, worker);
+        });
+    }
+
+    // Multisampled draw: coverage and depth are tested per sample and `fragment` runs once per pixel with at least
+    // one sample passing, at the pixel center when every sample is covered and at the first covered sample
+    // otherwise. Its color is written to the passing samples (see MultisampleFramebuffer).
+    template<class Fragment>
+    void draw(std::span<const ScreenTriangle> triangles, MultisampleFramebuffer & target, Fragment && fragment) {
+        static_assert(MultisampleFramebuffer::tile_size == tile_size, "sample pools must be owned by one raster tile");
+        if (owned_arena_) {
+            owned_arena_->reset();
+        }
+        bin(triangles, target.width(), target.height(), target.margin());
+        GOOB_PROFILE_STAGE(profiler_, raster);
+        pool_.parallel_for(tile_count(), [&](std::size_t tile, unsigned worker) {
+            raster_tile(tile, target, fragment, worker);
+        });
+    }
+
+    void set_cull_mode(CullMode mode) { cull_mode_ = mode; }
+    CullMode cull_mode() const { return cull_mode_; }
+
+    // Restricts draws to the dirty tiles of `tiles` (see DirtyTiles), or lifts the restriction when null. Other
+    // tiles are neither binned nor rasterized and keep their contents. The set must outlive the draws using it;
+    // draws throw std::invalid_argument when it does not match the target's size.
+    void set_dirty_tiles(const DirtyTiles * tiles) { dirty_tiles_ = tiles; }
+    const DirtyTiles * dirty_tiles() const { return dirty_tiles_; }
+
+    void set_hierarchical_z(bool enabled) { hierarchical_z_ = enabled; }
+    bool hierarchical_z() const { return hierarchical_z_; }
+
+    RasterStats stats() const;
+    void reset_stats();
+
+    // Reports cull, bin and raster timings and triangle and fragment counters to `profiler`, or stops reporting
+    // when null. Throws std::invalid_argument when the profiler has fewer threads than the pool.
+    void set_profiler(Profiler * profiler);
+    Profiler * profiler() const { return profiler_; }
+
+    int tiles_x() const { return tiles_x_; }
+    int tiles_y() const { return tiles_y_; }
+    std::size_t tile_count() const { return static_cast<std::size_t>(tiles_x_) * tiles_y_; }
+
+    // Number of triangles binned into a tile by the last draw()
+    std::size_t binned_count(std::size_t tile) const;
+
+private:
+    void bin(std::span<const ScreenTriangle> triangles, int width, int height, int sample_margin = 0);
+
+    template<class Fragment>
+    void raster_tile(std::size_t tile, Framebuffer & target, Fragment & fragment, unsigned worker);
+    template<class Fragment>
+    void raster_tile(std::size_t tile, MultisampleFramebuffer & target, Fragment & fragment, unsigned worker);
+
+    struct alignas(64) WorkerStats {
+        RasterStats stats;
+    };
+
+    ThreadPool & pool_;
+    std::unique_ptr<FrameArena> owned_arena_;
+    FrameArena & arena_;
+    const CoverageKernel & kernel_;
+    const CullKernel & cull_kernel_;
+    int tiles_x_ = 0;
+    int tiles_y_ = 0;
+    std::span<TriangleSetup> setups_;
+    // Triangles of tile t are bin_triangles_[tile_begin_[t] .. tile_begin_[t + 1]), in submission order
+    std::span<std::uint32_t> tile_begin_;
+    std::span<std::uint32_t> bin_triangles_;
+    CullMode cull_mode_ = CullMode::none;
+    bool hierarchical_z_ = true;
+    const DirtyTiles * dirty_tiles_ = nullptr;
+    std::vector<WorkerStats> worker_stats_;
+    Profiler * profiler_ = nullptr;
+};
+
+namespace detail {
+    // Slack on conservative depth bounds covering the rounding of the per-pixel depth interpolation
+    constexpr float depth_bounds_epsilon = 1.0f / (1 << 16);
+
+    // Farthest depth over the blocks of the inclusive pixel rectangle
+    inline float depth_max(const Framebuffer & target, int x0, int y0, int x1, int y1) {
+        float far = -std::numeric_limits<float>::infinity();
+        for (int by = y0 & ~7; by <= y1; by += 8) {
+            for (int bx = x0 & ~7; bx <= x1; bx += 8) {
+                far = std::max(far, target.depth_bounds(bx, by).max);
+            }
+        }
+        return far;
+    }
+
+    // Conservative depth range of a triangle over the pixel centers of the 8x8 block at (bx,by), or over its
+    // sample positions when they lie up to `margin` pixels from the centers
+    inline DepthBounds block_depth_range(const TriangleSetup & t, int bx, int by, float margin = 0.0f) {
+        const float x0 = t.z_plane.x * (bx + 0.5f - margin), x1 = t.z_plane.x * (bx + 7.5f + margin);
+        const float y0 = t.z_plane.y * (by + 0.5f - margin), y1 = t.z_plane.y * (by + 7.5f + margin);
+        const float lo = t.z_plane.z + std::min(x0, x1) + std::min(y0, y1);
+        const float hi = t.z_plane.z + std::max(x0, x1) + std::max(y0, y1);
+        return {std::max(lo, t.z_min) - depth_bounds_epsilon, std::min(hi, t.z_max) + depth_bounds_epsilon};
+    }
+}
+
+template<class Fragment>
+void Rasterizer::raster_tile(std::size_t tile, Framebuffer & target, Fragment & fragment, unsigned worker) {
+    const int tile_x0 = static_cast<int>(tile % tiles_x_) * tile_size;
+    const int tile_y0 = static_cast<int>(tile / tiles_x_) * tile_size;
+    const int tile_x1 = std::min(tile_x0 + tile_size, target.width()) - 1;
+    const int tile_y1 = std::min(tile_y0 + tile_size, target.height()) - 1;
+
+    const Coverage8x8 coverage = kernel_.block8x8;
+    const bool hiz = hierarchical_z_;
+    std::uint32_t * color = target.color();
+    float * depth = target.depth();
+    RasterStats local;
+
+    float tile_far = hiz ? detail::depth_max(target, tile_x0, tile_y0, tile_x1, tile_y1) : 1.0f;
+    for (std::uint32_t index : bin_triangles_.subspan(tile_begin_[tile], tile_begin_[tile + 1] - tile_begin_[tile])) {
+        const TriangleSetup & t = setups_[index];
+        const int x0 = std::max(t.min.x, tile_x0), x1 = std::min(t.max.x, tile_x1);
+        const int y0 = std::max(t.min.y, tile_y0), y1 = std::min(t.max.y, tile_y1);
+        if (x0 > x1 || y0 > y1) {
+            continue;
+        }
+        if (hiz && t.z_min - detail::depth_bounds_epsilon >= tile_far) {
+            ++local.tiles_culled;
+            continue;
+        }
+
+        // Tiles are multiples of 8 pixels, so blocks aligned to 8 never straddle tiles
+        bool far_changed = false;
+        for (int by = y0 & ~7; by <= y1; by += 8) {
+            for (int bx = x0 & ~7; bx <= x1; bx += 8) {
+                std::uint64_t mask = coverage(t.edges, bx, by);
+                if (mask == 0) {
+                    continue;
+                }
+                mask &= detail::block_rect_mask(bx, by, x0, y0, x1, y1);
+
+                DepthBounds & bounds = target.depth_bounds(bx, by);
+                bool test_depth = true;
+                if (hiz) {
+                    const DepthBounds range = detail::block_depth_range(t, bx, by);
+                    if (range.min >= bounds.max) {
+                        ++local.blocks_culled;
+                        local.pixels_culled += std::popcount(mask);
+                        continue;
+                    }
+                    test_depth = !(range.max < bounds.min);
+                }
+
+                const std::size_t block = target.block_offset(bx, by);
+                // A block in front of the nearest pixel overwrites without reading depth, so assume its farthest
+                // pixel was among them
+                bool max_overwritten = !test_depth;
+                for (; mask != 0; mask &= mask - 1) {
+                    const int bit = std::countr_zero(mask);
+                    const int x = bx + (bit & 7), y = by + (bit >> 3);
+                    const linalg::vec<float,3> bary = t.a * (x + 0.5f) + t.b * (y + 0.5f) + t.c;
+                    const float z = linalg::dot(bary, t.z);
+                    const std::size_t pixel = block + target.block_pixel_offset(bit);
+                    if (test_depth && !(z < depth[pixel])) {
+                        ++local.pixels_depth_failed;
+                        continue;
+                    }
+                    const linalg::vec<float,3> perspective = bary * t.inv_w;
+                    max_overwritten = max_overwritten || depth[pixel] >= bounds.max;
+                    bounds.min = std::min(bounds.min, z);
+                    depth[pixel] = z;
+                    if constexpr (std::is_invocable_v<Fragment &, std::uint32_t, const linalg::vec<float,3> &, std::size_t>) {
+                        fragment(index, perspective / linalg::sum(perspective), pixel);
+                    } else {
+                        color[pixel] = fragment(index, perspective / linalg::sum(perspective));
+                    }
+                    ++local.pixels_shaded;
+                }
+                // The block's farthest pixel can only move closer when it was overwritten
+                if (max_overwritten) {
+                    target.update_depth_bounds(bx, by);
+                    far_changed |= bounds.max < tile_far;
+                }
+            }
+        }
+        if (hiz && far_changed) {
+            tile_far = detail::depth_max(target, tile_x0, tile_y0, tile_x1, tile_y1);
+        }
+    }
+    worker_stats_[worker].stats += local;
+    GOOB_PROFILE_COUNT(profiler_, worker, fragments_shaded, local.pixels_shaded);
+    GOOB_PROFILE_COUNT(profiler_, worker, fragments_killed, local.pixels_depth_failed + local.pixels_culled);
+}
+
+
+template<class Fragment>
+void Rasterizer::raster_tile(std::size_t tile, MultisampleFramebuffer & target, Fragment & fragment, unsigned worker) {
+    const int tile_x0 = static_cast<int>(tile % tiles_x_) * tile_size;
+    const int tile_y0 = static_cast<int>(tile / tiles_x_) * tile_size;
+    const int tile_x1 = std::min(tile_x0 + tile_size, target.width()) - 1;
+    const int tile_y1 = std::min(tile_y0 + tile_size, target.height()) - 1;
+
+    const Coverage8x8 coverage = kernel_.block8x8;
+    const bool hiz = hierarchical_z_;
+    const int samples = target.samples();
+    const unsigned all_samples = (1u << samples) - 1;
+    const std::span<const linalg::vec<int,2>> positions = target.positions();
+    const float margin = static_cast<float>(target.margin()) / subpixel_scale;
+    Framebuffer & pixels = target.pixels();
+    float * far_depth = pixels.depth();
+    RasterStats local;
+
+    float tile_far = hiz ? detail::depth_max(pixels, tile_x0, tile_y0, tile_x1, tile_y1) : 1.0f;
+    for (std::uint32_t index : bin_triangles_.subspan(tile_begin_[tile], tile_begin_[tile + 1] - tile_begin_[tile])) {
+        const TriangleSetup & t = setups_[index];
+        const int x0 = std::max(t.min.x, tile_x0), x1 = std::min(t.max.x, tile_x1);
+        const int y0 = std::max(t.min.y, tile_y0), y1 = std::min(t.max.y, tile_y1);
+        if (x0 > x1 || y0 > y1) {
+            continue;
+        }
+        if (hiz && t.z_min - detail::depth_bounds_epsilon >= tile_far) {
+            ++local.tiles_culled;
+            continue;
+        }
+
+        // Edges at each sample position: the value at the center shifted by the offset, exactly in fixed point as
+        // dx and dy are per pixel, 16 times the per-subpixel step
+        std::array<EdgeSetup, 8> sample_edges;
+        for (int s = 0; s < samples; ++s) {
+            sample_edges[s] = t.edges;
+            for (int i = 0; i < 3; ++i) {
+                sample_edges[s].c[i] += std::int64_t(t.edges.dx[i] / subpixel_scale) * positions[s].x
+                                      + std::int64_t(t.edges.dy[i] / subpixel_scale) * positions[s].y;
+            }
+        }
+
+        bool far_changed = false;
+        for (int by = y0 & ~7; by <= y1; by += 8) {
+            for (int bx = x0 & ~7; bx <= x1; bx += 8) {
+                std::array<std::uint64_t, 8> sample_masks;
+                std::uint64_t mask = 0;
+                for (int s = 0; s < samples; ++s) {
+                    sample_masks[s] = coverage(sample_edges[s], bx, by);
+                    mask |= sample_masks[s];
+                }
+                if (mask == 0) {
+                    continue;
+                }
+                mask &= detail::block_rect_mask(bx, by, x0, y0, x1, y1);
+
+                // Pixels hold their farthest sample, so only the block's upper bound is valid for samples
+                DepthBounds & bounds = pixels.depth_bounds(bx, by);
+                if (hiz && detail::block_depth_range(t, bx, by, margin).min >= bounds.max) {
+                    ++local.blocks_culled;
+                    local.pixels_culled += std::popcount(mask);
+                    continue;
+                }
+
+                const std::size_t block = pixels.block_offset(bx, by);
+                bool max_overwritten = false;
+                for (; mask != 0; mask &= mask - 1) {
+                    const int bit = std::countr_zero(mask);
+                    const int x = bx + (bit & 7), y = by + (bit >> 3);
+                    const std::size_t pixel = block + pixels.block_pixel_offset(bit);
+                    const linalg::vec<float,3> center = t.a * (x + 0.5f) + t.b * (y + 0.5f) + t.c;
+                    const float z = linalg::dot(center, t.z);
+                    float * depth = target.sample_depths(pixel);
+
+                    unsigned covered = 0, passed = 0;
+                    for (int s = 0; s < samples; ++s) {
+                        if ((sample_masks[s] >> bit & 1) == 0) {
+                            continue;
+                        }
+                        covered |= 1u << s;
+                        const float zs = z + (t.z_plane.x * positions[s].x + t.z_plane.y * positions[s].y) / subpixel_scale;
+                        if (zs < depth[s]) {
+                            depth[s] = zs;
+                            passed |= 1u << s;
+                        }
+                    }
+                    if (passed == 0) {
+                        ++local.pixels_depth_failed;
+                        continue;
+                    }
+
+                    linalg::vec<float,3> bary = center;
+                    if (covered != all_samples) {
+                        const linalg::vec<int,2> & p = positions[std::countr_zero(covered)];
+                        bary += (t.a * static_cast<float>(p.x) + t.b * static_cast<float>(p.y)) / subpixel_scale;
+                    }
+                    const linalg::vec<float,3> perspective = bary * t.inv_w;
+                    target.write(x, y, pixel, passed, fragment(index, perspective / linalg::sum(perspective)));
+                    ++local.pixels_shaded;
+
+                    const float far = *std::max_element(depth, depth + samples);
+                    max_overwritten |= far_depth[pixel] >= bounds.max;
+                    far_depth[pixel] = far;
+                    bounds.min = std::min(bounds.min, far);
+                }
+                if (max_overwritten) {
+                    pixels.update_depth_bounds(bx, by);
+                    far_changed |= bounds.max < tile_far;
+                }
+            }
+        }
+        if (hiz && far_changed) {
+            tile_far = detail::depth_max(pixels, tile_x0, tile_y0, tile_x1, tile_y1);
+        }
+    }
+    worker_stats_[worker].stats += local;
+    GOOB_PROFILE_COUNT(profiler_, worker, fragments_shaded, local.pixels_shaded);
+    GOOB_PROFILE_COUNT(profiler_, worker, fragments_killed, local.pixels_depth_failed + local.pixels_culled);
+}
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "framebuffer.hpp"
+
+namespace goob {
+
+// Render target of the passes that rasterize per-pixel data first and shade covered pixels afterwards (see GBuffer
+// and VisibilityBuffer). Depth and the shaded color live in target(); the texels are a parallel array in the same
+// layout, so the rasterizer addresses both with one storage offset.
+template<class Texel>
+class TexelTarget {
+public:
+    TexelTarget(int width, int height, SurfaceLayout layout = SurfaceLayout::linear)
+        : target_(width, height, layout), texels_(target_.storage_size()) {
+        clear();
+    }
+
+    int width() const { return target_.width(); }
+    int height() const { return target_.height(); }
+    Framebuffer & target() { return target_; }
+    const Framebuffer & target() const { return target_; }
+
+    // Clears color and depth. A pixel's texel is meaningful only while its depth is below the cleared depth; clear
+    // through here rather than target() so the shading pass knows that depth.
+    void clear(std::uint32_t color = 0, float depth = 1.0f) {
+        target_.clear(color, depth);
+        clear_depth_ = depth;
+    }
+    float clear_depth() const { return clear_depth_; }
+
+    Texel * texels() { return texels_.data(); }
+    const Texel * texels() const { return texels_.data(); }
+    const Texel & texel_at(int x, int y) const { return texels_[target_.index(x, y)]; }
+
+    // Whether a draw since the last clear() wrote the pixel
+    bool covered(int x, int y) const { return target_.depth_at(x, y) < clear_depth_; }
+
+private:
+    Framebuffer target_;
+    std::vector<Texel> texels_;
+    float clear_depth_ = 1.0f;
+};
+
+}
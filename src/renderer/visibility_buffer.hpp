@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+#include "texel_target.hpp"
+
+namespace goob {
+
+// The triangle visible at a pixel: its index within the draw (before clipping) and the draw's instance id
+struct VisibilityTexel {
+    std::uint32_t triangle;
+    std::uint32_t instance;
+};
+
+// Render target of the visibility-buffer path.
+//
+// Visibility draws (see Pipeline) rasterize depth and 8 bytes of ids per pixel and run no fragment shading at all.
+// The resolve pass then shades every covered pixel exactly once, reconstructing its barycentrics from the ids, so
+// shading cost follows the pixel count rather than the overdraw.
+class VisibilityBuffer : public TexelTarget<VisibilityTexel> {
+public:
+    using TexelTarget::TexelTarget;
+};
+
+}
@@ -0,0 +1,149 @@
+#include "batch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include "batch_kernels.hpp"
+
+namespace goob {
+
+// Defined by the per-instruction-set translation units
+const BatchKernels * batch_kernels_sse2();
+const BatchKernels * batch_kernels_avx2();
+const BatchKernels * batch_kernels_avx512();
+
+namespace {
+    struct ScalarPack {
+        using reg = float;
+        static constexpr std::size_t width = 1;
+        static reg load(const float * p) { return *p; }
+        static void store(float * p, reg v) { *p = v; }
+        static reg set1(float v) { return v; }
+        static reg add(reg a, reg b) { return a + b; }
+        static reg sub(reg a, reg b) { return a - b; }
+        static reg mul(reg a, reg b) { return a * b; }
+        static reg fma(reg a, reg b, reg c) { return a * b + c; }
+        static reg div(reg a, reg b) { return a / b; }
+        static reg sqrt(reg a) { return std::sqrt(a); }
+        // Return `b` when either operand is NaN, like the SSE instructions
+        static reg min(reg a, reg b) { return a < b ? a : b; }
+        static reg max(reg a, reg b) { return a > b ? a : b; }
+        // Conversions from and to int32 lanes; store_int() rounds to nearest even
+        static reg load_int(const std::int32_t * p) { return static_cast<float>(*p); }
+        static void store_int(std::int32_t * p, reg v) { *p = detail::round_to_int<std::int32_t>(v); }
+        // Conversions from and to binary16 lanes, false for packs that fall back to the scalar kernels
+        static constexpr bool native_half = true;
+        static reg load_half(const std::uint16_t * p) { return half_bits_to_float(*p); }
+        static void store_half(std::uint16_t * p, reg v) { *p = float_to_half_bits(v); }
+    };
+
+    constexpr BatchKernels scalar_kernels = BatchImpl<ScalarPack>::table(SimdLevel::scalar);
+
+    // Vectors per stack block of the AoS wrappers
+    constexpr std::size_t aos_block = 256;
+
+    template<int M>
+    std::array<const float *, M> pointers(const SoaConstSpan<M> & s) { return s.components; }
+    template<int M>
+    std::array<float *, M> pointers(const SoaSpan<M> & s) { return s.components; }
+}
+
+void detail::check_batch_size(std::size_t size, std::size_t needed) {
+    if (size < needed) {
+        throw std::invalid_argument("Batch span of " + std::to_string(size) + " elements is shorter than its input of " + std::to_string(needed));
+    }
+}
+
+const BatchKernels & batch_kernels_scalar() { return scalar_kernels; }
+
+const BatchKernels * batch_kernels(SimdLevel level) {
+    if (!simd_supported(level)) {
+        return nullptr;
+    }
+    switch (level) {
+        case SimdLevel::scalar: return &scalar_kernels;
+        case SimdLevel::sse2:   return batch_kernels_sse2();
+        case SimdLevel::avx2:   return batch_kernels_avx2();
+        case SimdLevel::avx512: return batch_kernels_avx512();
+    }
+    return nullptr;
+}
+
+const BatchKernels & batch_kernels() {
+    static const BatchKernels & kernels = [] {
+        for (SimdLevel level = simd_level(); level != SimdLevel::scalar; level = static_cast<SimdLevel>(static_cast<int>(level) - 1)) {
+            if (const BatchKernels * k = batch_kernels(level)) {
+                return *k;
+            }
+        }
+        return scalar_kernels;
+    }();
+    return kernels;
+}
+
+void transform(const linalg::mat<float,4,4> & m, SoaConstSpan<4> in, SoaSpan<4> out) {
+    detail::check_batch_size(out.size, in.size);
+    batch_kernels().transform(&m.x.x, pointers(in).data(), pointers(out).data(), in.size);
+}
+
+void transform_points(const linalg::mat<float,4,4> & m, SoaConstSpan<3> in, SoaSpan<4> out) {
+    detail::check_batch_size(out.size, in.size);
+    batch_kernels().transform_points(&m.x.x, pointers(in).data(), pointers(out).data(), in.size);
+}
+
+void transform_vectors(const linalg::mat<float,3,3> & m, SoaConstSpan<3> in, SoaSpan<3> out) {
+    detail::check_batch_size(out.size, in.size);
+    batch_kernels().transform_vectors(&m.x.x, pointers(in).data(), pointers(out).data(), in.size);
+}
+
+void dot(SoaConstSpan<3> a, SoaConstSpan<3> b, std::span<float> out) {
+    detail::check_batch_size(b.size, a.size);
+    detail::check_batch_size(out.size(), a.size);
+    batch_kernels().dot(pointers(a).data(), pointers(b).data(), out.data(), a.size);
+}
+
+void cross(SoaConstSpan<3> a, SoaConstSpan<3> b, SoaSpan<3> out) {
+    detail::check_batch_size(b.size, a.size);
+    detail::check_batch_size(out.size, a.size);
+    batch_kernels().cross(pointers(a).data(), pointers(b).data(), pointers(out).data(), a.size);
+}
+
+void normalize(SoaConstSpan<3> in, SoaSpan<3> out) {
+    detail::check_batch_size(out.size, in.size);
+    batch_kernels().normalize(pointers(in).data(), pointers(out).data(), in.size);
+}
+
+void convert(std::span<const float> in, std::span<Half> out) {
+    detail::check_batch_size(out.size(), in.size());
+    batch_kernels().to_half(in.data(), reinterpret_cast<std::uint16_t *>(out.data()), in.size());
+}
+
+void convert(std::span<const Half> in, std::span<float> out) {
+    detail::check_batch_size(out.size(), in.size());
+    batch_kernels().from_half(reinterpret_cast<const std::uint16_t *>(in.data()), out.data(), in.size());
+}
+
+void transform_points(const linalg::mat<float,4,4> & m, std::span<const linalg::vec<float,3>> in, std::span<linalg::vec<float,4>> out) {
+    detail::check_batch_size(out.size(), in.size());
+    alignas(64) float soa_in[3][aos_block];
+    alignas(64) float soa_out[4][aos_block];
+    const float * in_components[3] = {soa_in[0], soa_in[1], soa_in[2]};
+    float * out_components[4] = {soa_out[0], soa_out[1], soa_out[2], soa_out[3]};
+
+    for (std::size_t begin = 0; begin < in.size(); begin += aos_block) {
+        const std::size_t n = std::min(aos_block, in.size() - begin);
+        for (std::size_t i = 0; i < n; ++i) {
+            soa_in[0][i] = in[begin + i].x;
+            soa_in[1][i] = in[begin + i].y;
+            soa_in[2][i] = in[begin + i].z;
+        }
+        batch_kernels().transform_points(&m.x.x, in_components, out_components, n);
+        for (std::size_t i = 0; i < n; ++i) {
+            out[begin + i] = {soa_out[0][i], soa_out[1][i], soa_out[2][i], soa_out[3][i]};
+        }
+    }
+}
+
+}
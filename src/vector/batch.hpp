@@ -0,0 +1,218 @@
+#pragma once
+
+// Structure-of-arrays batch operations for the linalg types in vector.hpp.
+//
+// Streams hold one array per component (all x, then all y, ...), so SIMD lanes map to consecutive
+// vectors. Kernels exist for SSE2, AVX2/FMA and AVX-512 plus a portable fallback; the widest one the
+// CPU supports is selected at runtime (see goob::simd_level()). Results match the per-vector linalg
+// functions up to floating point rounding (FMA contraction).
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+
+#include "cpu_features.hpp"
+#include "packed_scalar.hpp"
+#include "vector.hpp"
+
+namespace goob {
+
+// Mutable view of `size` vectors with M float components stored in separate arrays
+template<int M>
+struct SoaSpan {
+    std::array<float *, M> components;
+    std::size_t size;
+
+    linalg::vec<float,M> get(std::size_t i) const {
+        linalg::vec<float,M> v;
+        for (int c = 0; c < M; ++c) {
+            v[c] = components[c][i];
+        }
+        return v;
+    }
+    void set(std::size_t i, const linalg::vec<float,M> & v) const {
+        for (int c = 0; c < M; ++c) {
+            components[c][i] = v[c];
+        }
+    }
+};
+
+template<int M>
+struct SoaConstSpan {
+    std::array<const float *, M> components;
+    std::size_t size;
+
+    SoaConstSpan(const std::array<const float *, M> & components_, std::size_t size_) : components(components_), size(size_) {}
+    SoaConstSpan(const SoaSpan<M> & s) : size(s.size) {
+        for (int c = 0; c < M; ++c) {
+            components[c] = s.components[c];
+        }
+    }
+
+    linalg::vec<float,M> get(std::size_t i) const {
+        linalg::vec<float,M> v;
+        for (int c = 0; c < M; ++c) {
+            v[c] = components[c][i];
+        }
+        return v;
+    }
+};
+
+// Owning SoA storage. Component arrays start on 64-byte boundaries (their stride is padded to 16 floats).
+template<int M>
+class SoaBuffer {
+public:
+    static constexpr std::size_t alignment = 64;
+    static constexpr std::size_t padding = 16;
+
+    SoaBuffer() = default;
+    explicit SoaBuffer(std::size_t size) { resize(size); }
+    explicit SoaBuffer(std::span<const linalg::vec<float,M>> vectors) {
+        resize(vectors.size());
+        for (std::size_t i = 0; i < vectors.size(); ++i) {
+            span().set(i, vectors[i]);
+        }
+    }
+
+    // Contents are not preserved
+    void resize(std::size_t size) {
+        stride_ = (size + padding - 1) / padding * padding;
+        data_.reset(stride_ ? static_cast<float *>(::operator new(stride_ * M * sizeof(float), std::align_val_t(alignment))) : nullptr);
+        size_ = size;
+    }
+
+    std::size_t size() const { return size_; }
+    float * component(int c) { return data_.get() + stride_ * c; }
+    const float * component(int c) const { return data_.get() + stride_ * c; }
+
+    SoaSpan<M> span() {
+        SoaSpan<M> s{{}, size_};
+        for (int c = 0; c < M; ++c) {
+            s.components[c] = component(c);
+        }
+        return s;
+    }
+    SoaConstSpan<M> span() const {
+        std::array<const float *, M> components;
+        for (int c = 0; c < M; ++c) {
+            components[c] = component(c);
+        }
+        return {components, size_};
+    }
+
+    linalg::vec<float,M> operator[](std::size_t i) const { return span().get(i); }
+
+    void copy_to(std::span<linalg::vec<float,M>> vectors) const {
+        for (std::size_t i = 0; i < vectors.size() && i < size_; ++i) {
+            vectors[i] = span().get(i);
+        }
+    }
+
+private:
+    struct AlignedDelete {
+        void operator()(float * p) const { ::operator delete(p, std::align_val_t(alignment)); }
+    };
+
+    std::unique_ptr<float, AlignedDelete> data_;
+    std::size_t size_ = 0;
+    std::size_t stride_ = 0;
+};
+
+namespace detail {
+    // Throws std::invalid_argument when a span of `size` elements is shorter than the `needed` of the input
+    void check_batch_size(std::size_t size, std::size_t needed);
+}
+
+// Outputs may alias inputs of the same call. Every other span must hold at least as many vectors as the first
+// input; shorter ones throw std::invalid_argument before anything is written.
+
+// out[i] = mul(m, in[i])
+void transform(const linalg::mat<float,4,4> & m, SoaConstSpan<4> in, SoaSpan<4> out);
+// out[i] = mul(m, {in[i], 1})
+void transform_points(const linalg::mat<float,4,4> & m, SoaConstSpan<3> in, SoaSpan<4> out);
+// out[i] = mul(m, in[i]), e.g. normals with the inverse transpose of the model matrix
+void transform_vectors(const linalg::mat<float,3,3> & m, SoaConstSpan<3> in, SoaSpan<3> out);
+// out[i] = dot(a[i], b[i])
+void dot(SoaConstSpan<3> a, SoaConstSpan<3> b, std::span<float> out);
+// out[i] = cross(a[i], b[i])
+void cross(SoaConstSpan<3> a, SoaConstSpan<3> b, SoaSpan<3> out);
+// out[i] = normalize(in[i]); zero vectors produce NaN like linalg::normalize
+void normalize(SoaConstSpan<3> in, SoaSpan<3> out);
+
+// AoS convenience wrapper: transposes blocks into SoA on the stack, so existing vec arrays can use the batch kernels
+void transform_points(const linalg::mat<float,4,4> & m, std::span<const linalg::vec<float,3>> in, std::span<linalg::vec<float,4>> out);
+
+// Bulk conversions between float and the compact scalar types of packed_scalar.hpp, e.g. to pack varyings or
+// G-buffer channels, with the rounding of their scalar conversions. Vector spans convert component by component.
+// Unlike above, outputs must not overlap inputs; they must be at least as long as them, or std::invalid_argument
+// is thrown.
+void convert(std::span<const float> in, std::span<Half> out);
+void convert(std::span<const Half> in, std::span<float> out);
+template<class S, int F>
+void convert(std::span<const float> in, std::span<Fixed<S,F>> out);
+template<class S, int F>
+void convert(std::span<const Fixed<S,F>> in, std::span<float> out);
+template<class T, class U, int M>
+void convert(std::span<const linalg::vec<T,M>> in, std::span<linalg::vec<U,M>> out);
+
+// Kernel table of one instruction set. Pointers are component arrays, matrices are column-major.
+struct BatchKernels {
+    SimdLevel level;
+    void (*transform)(const float * m, const float * const * in, float * const * out, std::size_t n);
+    void (*transform_points)(const float * m, const float * const * in, float * const * out, std::size_t n);
+    void (*transform_vectors)(const float * m, const float * const * in, float * const * out, std::size_t n);
+    void (*dot)(const float * const * a, const float * const * b, float * out, std::size_t n);
+    void (*cross)(const float * const * a, const float * const * b, float * const * out, std::size_t n);
+    void (*normalize)(const float * const * in, float * const * out, std::size_t n);
+    // Plain arrays; fixed point is 32-bit with out = round(in * scale), saturated, and out = in * scale back
+    void (*to_half)(const float * in, std::uint16_t * out, std::size_t n);
+    void (*from_half)(const std::uint16_t * in, float * out, std::size_t n);
+    void (*to_fixed)(const float * in, std::int32_t * out, float scale, std::size_t n);
+    void (*from_fixed)(const std::int32_t * in, float * out, float scale, std::size_t n);
+};
+
+// Kernels used by the functions above, selected once
+const BatchKernels & batch_kernels();
+// Kernels for a specific instruction set, nullptr when not compiled in or not supported by the CPU
+const BatchKernels * batch_kernels(SimdLevel level);
+
+template<class S, int F>
+void convert(std::span<const float> in, std::span<Fixed<S,F>> out) {
+    detail::check_batch_size(out.size(), in.size());
+    const std::size_t n = in.size();
+    if constexpr (std::is_same_v<S, std::int32_t>) {
+        static_assert(sizeof(Fixed<S,F>) == sizeof(S));
+        batch_kernels().to_fixed(in.data(), reinterpret_cast<std::int32_t *>(out.data()), 1.0f / Fixed<S,F>::resolution, n);
+    } else {
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = Fixed<S,F>(in[i]);
+        }
+    }
+}
+
+template<class S, int F>
+void convert(std::span<const Fixed<S,F>> in, std::span<float> out) {
+    detail::check_batch_size(out.size(), in.size());
+    const std::size_t n = in.size();
+    if constexpr (std::is_same_v<S, std::int32_t>) {
+        batch_kernels().from_fixed(reinterpret_cast<const std::int32_t *>(in.data()), out.data(), Fixed<S,F>::resolution, n);
+    } else {
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = in[i];
+        }
+    }
+}
+
+template<class T, class U, int M>
+void convert(std::span<const linalg::vec<T,M>> in, std::span<linalg::vec<U,M>> out) {
+    static_assert(sizeof(linalg::vec<T,M>) == sizeof(T) * M && sizeof(linalg::vec<U,M>) == sizeof(U) * M);
+    convert(std::span<const T>(reinterpret_cast<const T *>(in.data()), in.size() * M),
+            std::span<U>(reinterpret_cast<U *>(out.data()), out.size() * M));
+}
+
+}
@@ -0,0 +1,42 @@
+#include "batch_kernels.hpp"
+
+#ifdef GOOB_X86
+#include <immintrin.h>
+
+namespace goob {
+namespace {
+
+struct Avx2Pack {
+    using reg = __m256;
+    static constexpr std::size_t width = 8;
+    static reg load(const float * p) { return _mm256_loadu_ps(p); }
+    static void store(float * p, reg v) { _mm256_storeu_ps(p, v); }
+    static reg set1(float v) { return _mm256_set1_ps(v); }
+    static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+    static reg fma(reg a, reg b, reg c) { return _mm256_fmadd_ps(a, b, c); }
+    static reg div(reg a, reg b) { return _mm256_div_ps(a, b); }
+    static reg sqrt(reg a) { return _mm256_sqrt_ps(a); }
+    static reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+    static reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+    static reg load_int(const std::int32_t * p) { return _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p))); }
+    static void store_int(std::int32_t * p, reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), _mm256_cvtps_epi32(v)); }
+    // F16C, which the avx2 level requires
+    static constexpr bool native_half = true;
+    static reg load_half(const std::uint16_t * p) { return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))); }
+    static void store_half(std::uint16_t * p, reg v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT)); }
+};
+
+constexpr BatchKernels avx2_kernels = BatchImpl<Avx2Pack>::table(SimdLevel::avx2);
+
+}
+
+const BatchKernels * batch_kernels_avx2() { return &avx2_kernels; }
+
+}
+#else
+namespace goob {
+const BatchKernels * batch_kernels_avx2() { return nullptr; }
+}
+#endif
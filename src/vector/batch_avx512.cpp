@@ -0,0 +1,45 @@
+#include "batch_kernels.hpp"
+
+#ifdef GOOB_X86
+#include <immintrin.h>
+
+GOOB_AVX512_WARNINGS_PUSH
+
+namespace goob {
+namespace {
+
+struct Avx512Pack {
+    using reg = __m512;
+    static constexpr std::size_t width = 16;
+    static reg load(const float * p) { return _mm512_loadu_ps(p); }
+    static void store(float * p, reg v) { _mm512_storeu_ps(p, v); }
+    static reg set1(float v) { return _mm512_set1_ps(v); }
+    static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+    static reg fma(reg a, reg b, reg c) { return _mm512_fmadd_ps(a, b, c); }
+    static reg div(reg a, reg b) { return _mm512_div_ps(a, b); }
+    static reg sqrt(reg a) { return _mm512_sqrt_ps(a); }
+    static reg min(reg a, reg b) { return _mm512_min_ps(a, b); }
+    static reg max(reg a, reg b) { return _mm512_max_ps(a, b); }
+    static reg load_int(const std::int32_t * p) { return _mm512_cvtepi32_ps(_mm512_loadu_si512(p)); }
+    static void store_int(std::int32_t * p, reg v) { _mm512_storeu_si512(p, _mm512_cvtps_epi32(v)); }
+    static constexpr bool native_half = true;
+    static reg load_half(const std::uint16_t * p) { return _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p))); }
+    static void store_half(std::uint16_t * p, reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), _mm512_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT)); }
+};
+
+constexpr BatchKernels avx512_kernels = BatchImpl<Avx512Pack>::table(SimdLevel::avx512);
+
+}
+
+const BatchKernels * batch_kernels_avx512() { return &avx512_kernels; }
+
+}
+
+GOOB_AVX512_WARNINGS_POP
+#else
+namespace goob {
+const BatchKernels * batch_kernels_avx512() { return nullptr; }
+}
+#endif
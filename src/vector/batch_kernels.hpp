@@ -0,0 +1,179 @@
+#pragma once
+
+// Batch kernels written once against a small "pack" interface and instantiated per instruction set by
+// batch_<isa>.cpp, each compiled with its own target flags. Everything here lives in an anonymous namespace,
+// but that only covers code defined in it: any inline function from another header that a wide-ISA kernel calls
+// is emitted there as a weak symbol, and the linker may keep that copy for every caller. So the kernels use only
+// their pack, and tails call the scalar kernels of batch.cpp through batch_kernels_scalar().
+
+#include <cstddef>
+#include <cstdint>
+
+#include "batch.hpp"
+
+namespace goob {
+
+// Scalar kernel table, defined in batch.cpp with the only scalar pack
+const BatchKernels & batch_kernels_scalar();
+
+namespace {
+
+template<class P>
+struct BatchImpl {
+    using reg = typename P::reg;
+
+    // Runs `body(i)` for every full pack and finishes the tail with `tail(i)`
+    template<class Body, class Tail>
+    static void loop(std::size_t n, Body body, Tail tail) {
+        std::size_t i = 0;
+        for (; i + P::width <= n; i += P::width) {
+            body(i);
+        }
+        if (i < n) {
+            tail(i);
+        }
+    }
+
+    static void transform(const float * m, const float * const * in, float * const * out, std::size_t n) {
+        reg c[16];
+        for (int k = 0; k < 16; ++k) {
+            c[k] = P::set1(m[k]);
+        }
+        loop(n, [&](std::size_t i) {
+            const reg x = P::load(in[0] + i), y = P::load(in[1] + i), z = P::load(in[2] + i), w = P::load(in[3] + i);
+            for (int r = 0; r < 4; ++r) {
+                P::store(out[r] + i, P::fma(c[r], x, P::fma(c[4 + r], y, P::fma(c[8 + r], z, P::mul(c[12 + r], w)))));
+            }
+        }, [&](std::size_t i) {
+            const float * tail_in[4] = {in[0] + i, in[1] + i, in[2] + i, in[3] + i};
+            float * tail_out[4] = {out[0] + i, out[1] + i, out[2] + i, out[3] + i};
+            batch_kernels_scalar().transform(m, tail_in, tail_out, n - i);
+        });
+    }
+
+    static void transform_points(const float * m, const float * const * in, float * const * out, std::size_t n) {
+        reg c[16];
+        for (int k = 0; k < 16; ++k) {
+            c[k] = P::set1(m[k]);
+        }
+        loop(n, [&](std::size_t i) {
+            const reg x = P::load(in[0] + i), y = P::load(in[1] + i), z = P::load(in[2] + i);
+            for (int r = 0; r < 4; ++r) {
+                P::store(out[r] + i, P::fma(c[r], x, P::fma(c[4 + r], y, P::fma(c[8 + r], z, c[12 + r]))));
+            }
+        }, [&](std::size_t i) {
+            const float * tail_in[3] = {in[0] + i, in[1] + i, in[2] + i};
+            float * tail_out[4] = {out[0] + i, out[1] + i, out[2] + i, out[3] + i};
+            batch_kernels_scalar().transform_points(m, tail_in, tail_out, n - i);
+        });
+    }
+
+    static void transform_vectors(const float * m, const float * const * in, float * const * out, std::size_t n) {
+        reg c[9];
+        for (int k = 0; k < 9; ++k) {
+            c[k] = P::set1(m[k]);
+        }
+        loop(n, [&](std::size_t i) {
+            const reg x = P::load(in[0] + i), y = P::load(in[1] + i), z = P::load(in[2] + i);
+            for (int r = 0; r < 3; ++r) {
+                P::store(out[r] + i, P::fma(c[r], x, P::fma(c[3 + r], y, P::mul(c[6 + r], z))));
+            }
+        }, [&](std::size_t i) {
+            const float * tail_in[3] = {in[0] + i, in[1] + i, in[2] + i};
+            float * tail_out[3] = {out[0] + i, out[1] + i, out[2] + i};
+            batch_kernels_scalar().transform_vectors(m, tail_in, tail_out, n - i);
+        });
+    }
+
+    static void dot(const float * const * a, const float * const * b, float * out, std::size_t n) {
+        loop(n, [&](std::size_t i) {
+            P::store(out + i, P::fma(P::load(a[0] + i), P::load(b[0] + i),
+                              P::fma(P::load(a[1] + i), P::load(b[1] + i),
+                              P::mul(P::load(a[2] + i), P::load(b[2] + i)))));
+        }, [&](std::size_t i) {
+            const float * tail_a[3] = {a[0] + i, a[1] + i, a[2] + i};
+            const float * tail_b[3] = {b[0] + i, b[1] + i, b[2] + i};
+            batch_kernels_scalar().dot(tail_a, tail_b, out + i, n - i);
+        });
+    }
+
+    static void cross(const float * const * a, const float * const * b, float * const * out, std::size_t n) {
+        loop(n, [&](std::size_t i) {
+            const reg ax = P::load(a[0] + i), ay = P::load(a[1] + i), az = P::load(a[2] + i);
+            const reg bx = P::load(b[0] + i), by = P::load(b[1] + i), bz = P::load(b[2] + i);
+            P::store(out[0] + i, P::sub(P::mul(ay, bz), P::mul(az, by)));
+            P::store(out[1] + i, P::sub(P::mul(az, bx), P::mul(ax, bz)));
+            P::store(out[2] + i, P::sub(P::mul(ax, by), P::mul(ay, bx)));
+        }, [&](std::size_t i) {
+            const float * tail_a[3] = {a[0] + i, a[1] + i, a[2] + i};
+            const float * tail_b[3] = {b[0] + i, b[1] + i, b[2] + i};
+            float * tail_out[3] = {out[0] + i, out[1] + i, out[2] + i};
+            batch_kernels_scalar().cross(tail_a, tail_b, tail_out, n - i);
+        });
+    }
+
+    static void normalize(const float * const * in, float * const * out, std::size_t n) {
+        loop(n, [&](std::size_t i) {
+            const reg x = P::load(in[0] + i), y = P::load(in[1] + i), z = P::load(in[2] + i);
+            const reg length = P::sqrt(P::fma(x, x, P::fma(y, y, P::mul(z, z))));
+            P::store(out[0] + i, P::div(x, length));
+            P::store(out[1] + i, P::div(y, length));
+            P::store(out[2] + i, P::div(z, length));
+        }, [&](std::size_t i) {
+            const float * tail_in[3] = {in[0] + i, in[1] + i, in[2] + i};
+            float * tail_out[3] = {out[0] + i, out[1] + i, out[2] + i};
+            batch_kernels_scalar().normalize(tail_in, tail_out, n - i);
+        });
+    }
+
+    static void to_half(const float * in, std::uint16_t * out, std::size_t n) {
+        if constexpr (P::native_half) {
+            loop(n, [&](std::size_t i) {
+                P::store_half(out + i, P::load(in + i));
+            }, [&](std::size_t i) {
+                batch_kernels_scalar().to_half(in + i, out + i, n - i);
+            });
+        } else {
+            batch_kernels_scalar().to_half(in, out, n);
+        }
+    }
+
+    static void from_half(const std::uint16_t * in, float * out, std::size_t n) {
+        if constexpr (P::native_half) {
+            loop(n, [&](std::size_t i) {
+                P::store(out + i, P::load_half(in + i));
+            }, [&](std::size_t i) {
+                batch_kernels_scalar().from_half(in + i, out + i, n - i);
+            });
+        } else {
+            batch_kernels_scalar().from_half(in, out, n);
+        }
+    }
+
+    static void to_fixed(const float * in, std::int32_t * out, float scale, std::size_t n) {
+        // max() first, so NaN becomes the lowest value as in detail::saturate_round()
+        const reg s = P::set1(scale);
+        const reg lowest = P::set1(detail::saturate_lowest<std::int32_t>), highest = P::set1(detail::saturate_highest<std::int32_t>);
+        loop(n, [&](std::size_t i) {
+            P::store_int(out + i, P::min(P::max(P::mul(P::load(in + i), s), lowest), highest));
+        }, [&](std::size_t i) {
+            batch_kernels_scalar().to_fixed(in + i, out + i, scale, n - i);
+        });
+    }
+
+    static void from_fixed(const std::int32_t * in, float * out, float scale, std::size_t n) {
+        const reg s = P::set1(scale);
+        loop(n, [&](std::size_t i) {
+            P::store(out + i, P::mul(P::load_int(in + i), s));
+        }, [&](std::size_t i) {
+            batch_kernels_scalar().from_fixed(in + i, out + i, scale, n - i);
+        });
+    }
+
+    static constexpr BatchKernels table(SimdLevel level) {
+        return {level, transform, transform_points, transform_vectors, dot, cross, normalize, to_half, from_half, to_fixed, from_fixed};
+    }
+};
+
+}
+}
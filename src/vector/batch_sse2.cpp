@@ -0,0 +1,40 @@
+#include "batch_kernels.hpp"
+
+#ifdef GOOB_X86
+#include <immintrin.h>
+
+namespace goob {
+namespace {
+
+struct Sse2Pack {
+    using reg = __m128;
+    static constexpr std::size_t width = 4;
+    static reg load(const float * p) { return _mm_loadu_ps(p); }
+    static void store(float * p, reg v) { _mm_storeu_ps(p, v); }
+    static reg set1(float v) { return _mm_set1_ps(v); }
+    static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+    static reg fma(reg a, reg b, reg c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static reg div(reg a, reg b) { return _mm_div_ps(a, b); }
+    static reg sqrt(reg a) { return _mm_sqrt_ps(a); }
+    static reg min(reg a, reg b) { return _mm_min_ps(a, b); }
+    static reg max(reg a, reg b) { return _mm_max_ps(a, b); }
+    static reg load_int(const std::int32_t * p) { return _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))); }
+    static void store_int(std::int32_t * p, reg v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm_cvtps_epi32(v)); }
+    // Half conversions need F16C
+    static constexpr bool native_half = false;
+};
+
+constexpr BatchKernels sse2_kernels = BatchImpl<Sse2Pack>::table(SimdLevel::sse2);
+
+}
+
+const BatchKernels * batch_kernels_sse2() { return &sse2_kernels; }
+
+}
+#else
+namespace goob {
+const BatchKernels * batch_kernels_sse2() { return nullptr; }
+}
+#endif
@@ -0,0 +1,212 @@
+#pragma once
+
+// Compact scalar types for bandwidth-bound data such as varyings and G-buffer channels: a 16-bit float and
+// signed fixed-point numbers. Both convert explicitly from float and implicitly to float, so they can be stored
+// in linalg vectors and matrices and fed straight into float math. Arithmetic between two values of the same type
+// stays in that type; mixing with other types computes in float. Bulk conversions of whole arrays, with SIMD
+// kernels, are in batch.hpp.
+
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#if __has_include(<stdfloat>)
+#include <stdfloat>
+#endif
+
+#include "vector.hpp"
+
+namespace goob {
+
+// IEEE 754 binary16 bits of `v`, rounded to nearest even. Overflow gives infinity; NaNs stay NaN with the quiet
+// bit set and the top payload bits kept, as the F16C instructions do.
+constexpr std::uint16_t float_to_half_bits(float v) {
+    const std::uint32_t f = std::bit_cast<std::uint32_t>(v);
+    const std::uint16_t sign = static_cast<std::uint16_t>((f >> 16) & 0x8000u);
+    const std::uint32_t abs = f & 0x7fffffffu;
+    if (abs >= 0x7f800000u) {
+        return sign | 0x7c00u | (abs > 0x7f800000u ? 0x200u | ((abs >> 13) & 0x3ffu) : 0u);
+    }
+    if (abs >= 0x47800000u) {
+        return sign | 0x7c00u;
+    }
+    if (abs < 0x38800000u) {
+        // Subnormal half: the mantissa with its implicit bit, shifted to units of 2^-24
+        if (abs < 0x33000000u) {
+            return sign;
+        }
+        const std::uint32_t shift = 126u - (abs >> 23);
+        const std::uint32_t mantissa = (abs & 0x7fffffu) | 0x800000u;
+        std::uint32_t bits = mantissa >> shift;
+        const std::uint32_t rest = mantissa & ((1u << shift) - 1), halfway = 1u << (shift - 1);
+        bits += rest > halfway || (rest == halfway && (bits & 1));
+        return sign | static_cast<std::uint16_t>(bits);
+    }
+    // Rebias the exponent; a carry out of the mantissa correctly rounds up into the next binade or infinity
+    const std::uint32_t rebiased = abs - 0x38000000u;
+    std::uint32_t bits = rebiased >> 13;
+    const std::uint32_t rest = rebiased & 0x1fffu;
+    bits += rest > 0x1000u || (rest == 0x1000u && (bits & 1));
+    return sign | static_cast<std::uint16_t>(bits);
+}
+
+// Exact float value of binary16 bits; NaNs get the quiet bit like float_to_half_bits()
+constexpr float half_bits_to_float(std::uint16_t bits) {
+    const std::uint32_t sign = static_cast<std::uint32_t>(bits & 0x8000u) << 16;
+    const std::uint32_t exponent = (bits >> 10) & 0x1fu, mantissa = bits & 0x3ffu;
+    if (exponent == 0x1f) {
+        return std::bit_cast<float>(sign | 0x7f800000u | (mantissa ? 0x400000u | (mantissa << 13) : 0u));
+    }
+    if (exponent == 0) {
+        const float magnitude = static_cast<float>(mantissa) * 0x1p-24f;
+        return std::bit_cast<float>(sign | std::bit_cast<std::uint32_t>(magnitude));
+    }
+    return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+#ifdef __STDCPP_FLOAT16_T__
+using Half = std::float16_t;
+#else
+// Software binary16 for compilers without std::float16_t. Values are stored as their bit pattern and every
+// operation goes through float, so results match std::float16_t computing in float and rounding once.
+class Half {
+public:
+    constexpr Half() = default;
+    constexpr explicit Half(float v) : bits_(float_to_half_bits(v)) {}
+
+    constexpr operator float() const { return half_bits_to_float(bits_); }
+
+    friend constexpr Half operator+(Half a) { return a; }
+    friend constexpr Half operator-(Half a) { return std::bit_cast<Half>(static_cast<std::uint16_t>(a.bits_ ^ 0x8000u)); }
+    friend constexpr Half operator+(Half a, Half b) { return Half(float(a) + float(b)); }
+    friend constexpr Half operator-(Half a, Half b) { return Half(float(a) - float(b)); }
+    friend constexpr Half operator*(Half a, Half b) { return Half(float(a) * float(b)); }
+    friend constexpr Half operator/(Half a, Half b) { return Half(float(a) / float(b)); }
+
+    constexpr Half & operator+=(float b) { return *this = Half(float(*this) + b); }
+    constexpr Half & operator-=(float b) { return *this = Half(float(*this) - b); }
+    constexpr Half & operator*=(float b) { return *this = Half(float(*this) * b); }
+    constexpr Half & operator/=(float b) { return *this = Half(float(*this) / b); }
+
+private:
+    std::uint16_t bits_ = 0;
+};
+#endif
+
+static_assert(sizeof(Half) == 2);
+
+constexpr std::uint16_t half_bits(Half h) { return std::bit_cast<std::uint16_t>(h); }
+constexpr Half half_from_bits(std::uint16_t bits) { return std::bit_cast<Half>(bits); }
+
+namespace detail {
+    // Largest float not above the maximum of Storage
+    template<std::signed_integral Storage>
+    constexpr float largest_float_in() {
+        constexpr int digits = std::numeric_limits<Storage>::digits;
+        if constexpr (digits <= std::numeric_limits<float>::digits) {
+            return static_cast<float>(std::numeric_limits<Storage>::max());
+        } else {
+            return static_cast<float>(std::numeric_limits<Storage>::max() - ((Storage(1) << (digits - std::numeric_limits<float>::digits)) - 1));
+        }
+    }
+
+    // Range of floats that convert to Storage without overflow
+    template<std::signed_integral Storage>
+    constexpr float saturate_lowest = static_cast<float>(std::numeric_limits<Storage>::min());
+    template<std::signed_integral Storage>
+    constexpr float saturate_highest = largest_float_in<Storage>();
+
+    // `v` rounded to nearest even, for v in [saturate_lowest, saturate_highest]
+    template<std::signed_integral Storage>
+    constexpr Storage round_to_int(float v) {
+        Storage t = static_cast<Storage>(v);
+        const float rest = v - static_cast<float>(t);
+        if (rest > 0.5f || (rest == 0.5f && (t & 1))) {
+            ++t;
+        } else if (rest < -0.5f || (rest == -0.5f && (t & 1))) {
+            --t;
+        }
+        return t;
+    }
+
+    // `v` rounded to nearest even and saturated; NaN gives the lowest value
+    template<std::signed_integral Storage>
+    constexpr Storage saturate_round(float v) {
+        if (!(v > saturate_lowest<Storage>)) {
+            return std::numeric_limits<Storage>::min();
+        }
+        return round_to_int<Storage>(v < saturate_highest<Storage> ? v : saturate_highest<Storage>);
+    }
+}
+
+// Signed fixed-point number with FractionBits fractional bits stored in a Storage integer, e.g. 24.8 in
+// Fixed<std::int32_t, 8>. Conversions from float round to nearest even and saturate, NaN converts to the lowest
+// value. Sums and differences wrap like the storage integer; products round toward negative infinity and
+// quotients toward zero.
+template<std::signed_integral Storage, int FractionBits>
+class Fixed {
+    static_assert(sizeof(Storage) <= 4, "products are computed in 64 bits");
+    static_assert(FractionBits > 0 && FractionBits < std::numeric_limits<Storage>::digits);
+    using Wide = std::conditional_t<sizeof(Storage) < 4, std::int32_t, std::int64_t>;
+
+public:
+    using storage_type = Storage;
+    static constexpr int fraction_bits = FractionBits;
+    // Value of one unit in the last place
+    static constexpr float resolution = 1.0f / static_cast<float>(Wide(1) << FractionBits);
+
+    constexpr Fixed() = default;
+    constexpr explicit Fixed(float v) : raw_(detail::saturate_round<Storage>(v * static_cast<float>(Wide(1) << FractionBits))) {}
+
+    static constexpr Fixed from_raw(Storage raw) {
+        Fixed f;
+        f.raw_ = raw;
+        return f;
+    }
+    constexpr Storage raw() const { return raw_; }
+
+    constexpr operator float() const { return static_cast<float>(raw_) * resolution; }
+
+    friend constexpr Fixed operator+(Fixed a) { return a; }
+    friend constexpr Fixed operator-(Fixed a) { return from_raw(static_cast<Storage>(-Wide(a.raw_))); }
+    friend constexpr Fixed operator+(Fixed a, Fixed b) { return from_raw(static_cast<Storage>(Wide(a.raw_) + b.raw_)); }
+    friend constexpr Fixed operator-(Fixed a, Fixed b) { return from_raw(static_cast<Storage>(Wide(a.raw_) - b.raw_)); }
+    friend constexpr Fixed operator*(Fixed a, Fixed b) { return from_raw(static_cast<Storage>((Wide(a.raw_) * b.raw_) >> FractionBits)); }
+    friend constexpr Fixed operator/(Fixed a, Fixed b) { return from_raw(static_cast<Storage>((Wide(a.raw_) << FractionBits) / b.raw_)); }
+
+    constexpr Fixed & operator+=(Fixed b) { return *this = *this + b; }
+    constexpr Fixed & operator-=(Fixed b) { return *this = *this - b; }
+    constexpr Fixed & operator*=(Fixed b) { return *this = *this * b; }
+    constexpr Fixed & operator/=(Fixed b) { return *this = *this / b; }
+
+private:
+    Storage raw_ = 0;
+};
+
+// 16.8 does not fit a native integer, so the 16-bit format is 8.8
+using Fixed8_8 = Fixed<std::int16_t, 8>;
+using Fixed24_8 = Fixed<std::int32_t, 8>;
+using Fixed16_16 = Fixed<std::int32_t, 16>;
+
+}
+
+namespace linalg
+{
+#ifndef __STDCPP_FLOAT16_T__
+    template<> struct is_scalar<goob::Half> : std::true_type {};
+#endif
+    template<class S, int F> struct is_scalar<goob::Fixed<S,F>> : std::true_type {};
+
+    // Implicit conversions between float vectors and vectors of the compact types
+    template<int M> struct converter<vec<goob::Half,M>, vec<float,M>> { constexpr vec<goob::Half,M> operator() (const vec<float,M> & v) const { return vec<goob::Half,M>(v); } };
+    template<int M> struct converter<vec<float,M>, vec<goob::Half,M>> { constexpr vec<float,M> operator() (const vec<goob::Half,M> & v) const { return vec<float,M>(v); } };
+    template<class S, int F, int M> struct converter<vec<goob::Fixed<S,F>,M>, vec<float,M>> { constexpr vec<goob::Fixed<S,F>,M> operator() (const vec<float,M> & v) const { return vec<goob::Fixed<S,F>,M>(v); } };
+    template<class S, int F, int M> struct converter<vec<float,M>, vec<goob::Fixed<S,F>,M>> { constexpr vec<float,M> operator() (const vec<goob::Fixed<S,F>,M> & v) const { return vec<float,M>(v); } };
+
+    namespace aliases
+    {
+        typedef vec<goob::Half,1> half1; typedef vec<goob::Half,2> half2; typedef vec<goob::Half,3> half3; typedef vec<goob::Half,4> half4;
+        typedef mat<goob::Half,2,2> half2x2; typedef mat<goob::Half,3,3> half3x3; typedef mat<goob::Half,4,4> half4x4;
+    }
+}
@@ -74,10 +74,19 @@ namespace linalg
 
     // Specialize converter<T,U> with a function application operator that converts type U to type T to enable implicit conversions
     template<class T, class U> struct converter {};
+
+    // Specialize is_scalar<T> to let a non-arithmetic element type (e.g. a fixed-point class) act as a scalar operand of vector and matrix operators
+    template<class T> struct is_scalar : std::is_arithmetic<T> {};
     namespace detail
     {
         template<class T, class U> using conv_t = typename std::enable_if<!std::is_same<T,U>::value, decltype(converter<T,U>{}(std::declval<U>()))>::type;
 
+        // Conversion operators leave conversions into vectors and matrices to the target's converting constructor, so the two never compete
+        template<class A> struct is_linalg_type : std::false_type {};
+        template<class T, int M       > struct is_linalg_type<vec<T,M  >> : std::true_type {};
+        template<class T, int M, int N> struct is_linalg_type<mat<T,M,N>> : std::true_type {};
+        template<class T, class U> using conv_out_t = typename std::enable_if<!is_linalg_type<T>::value, conv_t<T,U>>::type;
+
         // Trait for retrieving scalar type of any linear algebra object
         template<class A> struct scalar_type {};
         template<class T, int M       > struct scalar_type<vec<T,M  >> { using type = T; };
@@ -129,7 +138,7 @@ namespace linalg
         struct empty {};
         template<class... T> struct scalars;
         template<> struct scalars<> { using type=void; };
-        template<class T, class... U> struct scalars<T,U...> : std::conditional<std::is_arithmetic<T>::value, scalars<U...>, empty>::type {};
+        template<class T, class... U> struct scalars<T,U...> : std::conditional<is_scalar<T>::value, scalars<U...>, empty>::type {};
         template<class... T> using scalars_t = typename scalars<T...>::type;
 
         // Helpers which indicate how apply(F, ...) should be called for various arguments
@@ -219,7 +228,7 @@ namespace linalg
         LINALG_CONSTEXPR14 T &      operator[] (int)                  { return x; }
 
         template<class U, class=detail::conv_t<vec,U>> constexpr vec(const U & u) : vec(converter<vec,U>{}(u)) {}
-        template<class U, class=detail::conv_t<U,vec>> constexpr operator U () const { return converter<U,vec>{}(*this); }
+        template<class U, class=detail::conv_out_t<U,vec>> constexpr operator U () const { return converter<U,vec>{}(*this); }
     };
     template<class T> struct vec<T,2>
     {
@@ -234,7 +243,7 @@ namespace linalg
         LINALG_CONSTEXPR14 T &      operator[] (int i)                  { return i==0?x:y; }
 
         template<class U, class=detail::conv_t<vec,U>> constexpr vec(const U & u) : vec(converter<vec,U>{}(u)) {}
-        template<class U, class=detail::conv_t<U,vec>> constexpr operator U () const { return converter<U,vec>{}(*this); }
+        template<class U, class=detail::conv_out_t<U,vec>> constexpr operator U () const { return converter<U,vec>{}(*this); }
     };
     template<class T> struct vec<T,3>
     {
@@ -254,7 +263,7 @@ namespace linalg
         vec<T,2> &                  xy()                                { return *reinterpret_cast<vec<T,2> *>(this); }
 
         template<class U, class=detail::conv_t<vec,U>> constexpr vec(const U & u) : vec(converter<vec,U>{}(u)) {}
-        template<class U, class=detail::conv_t<U,vec>> constexpr operator U () const { return converter<U,vec>{}(*this); }
+        template<class U, class=detail::conv_out_t<U,vec>> constexpr operator U () const { return converter<U,vec>{}(*this); }
     };
     template<class T> struct vec<T,4>
     {
@@ -278,7 +287,7 @@ namespace linalg
         vec<T,3> &                  xyz()                               { return *reinterpret_cast<vec<T,3> *>(this); }
 
         template<class U, class=detail::conv_t<vec,U>> constexpr vec(const U & u) : vec(converter<vec,U>{}(u)) {}
-        template<class U, class=detail::conv_t<U,vec>> constexpr operator U () const { return converter<U,vec>{}(*this); }
+        template<class U, class=detail::conv_out_t<U,vec>> constexpr operator U () const { return converter<U,vec>{}(*this); }
     };
 
     // Small, fixed-size matrix type, consisting of exactly M rows and N columns of type T, stored in column-major order.
@@ -297,7 +306,7 @@ namespace linalg
         LINALG_CONSTEXPR14 V &      operator[] (int)                  { return x; }
 
         template<class U, class=detail::conv_t<mat,U>> constexpr mat(const U & u) : mat(converter<mat,U>{}(u)) {}
-        template<class U, class=detail::conv_t<U,mat>> constexpr operator U () const { return converter<U,mat>{}(*this); }
+        template<class U, class=detail::conv_out_t<U,mat>> constexpr operator U () const { return converter<U,mat>{}(*this); }
     };
     template<class T, int M> struct mat<T,M,2>
     {
@@ -314,7 +323,7 @@ namespace linalg
         LINALG_CONSTEXPR14 V &      operator[] (int j)                  { return j==0?x:y; }
 
         template<class U, class=detail::conv_t<mat,U>> constexpr mat(const U & u) : mat(converter<mat,U>{}(u)) {}
-        template<class U, class=detail::conv_t<U,mat>> constexpr operator U () const { return converter<U,mat>{}(*this); }
+        template<class U, class=detail::conv_out_t<U,mat>> constexpr operator U () const { return converter<U,mat>{}(*this); }
     };
     template<class T, int M> struct mat<T,M,3>
     {
@@ -332,7 +341,7 @@ namespace linalg
         LINALG_CONSTEXPR14 V &      operator[] (int j)                  { return j==0?x:j==1?y:z; }
 
         template<class U, class=detail::conv_t<mat,U>> constexpr mat(const U & u) : mat(converter<mat,U>{}(u)) {}
-        template<class U, class=detail::conv_t<U,mat>> constexpr operator U () const { return converter<U,mat>{}(*this); }
+        template<class U, class=detail::conv_out_t<U,mat>> constexpr operator U () const { return converter<U,mat>{}(*this); }
     };
     template<class T, int M> struct mat<T,M,4>
     {
@@ -350,7 +359,7 @@ namespace linalg
         LINALG_CONSTEXPR14 V &      operator[] (int j)                  { return j==0?x:j==1?y:j==2?z:w; }
 
         template<class U, class=detail::conv_t<mat,U>> constexpr mat(const U & u) : mat(converter<mat,U>{}(u)) {}
-        template<class U, class=detail::conv_t<U,mat>> constexpr operator U () const { return converter<U,mat>{}(*this); }
+        template<class U, class=detail::conv_out_t<U,mat>> constexpr operator U () const { return converter<U,mat>{}(*this); }
     };
 
     // Define a type which will convert to the multiplicative identity of any square matrix
@@ -0,0 +1,100 @@
+#include "asset_cache.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    std::filesystem::path write_text(const std::string & name, const std::string & text) {
+        const auto path = std::filesystem::temp_directory_path() / name;
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << text;
+        return path;
+    }
+
+    const std::string triangle = "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n";
+    const std::string quad = "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nf 1 2 3 4\n";
+}
+
+TEST_CASE( "Asset cache shares loaded meshes and reloads changed files", "[asset_cache]" ) {
+    const auto path = write_text("goob_test_asset.obj", triangle);
+    goob::AssetCache cache;
+
+    const std::shared_ptr<const goob::Mesh> first = cache.mesh(path);
+    REQUIRE(first->triangle_count() == 1);
+    REQUIRE(cache.mesh(path) == first);
+    REQUIRE(cache.mesh(std::filesystem::temp_directory_path() / "." / "goob_test_asset.obj") == first);
+    REQUIRE(cache.stats().loads == 1);
+    REQUIRE(cache.stats().hits == 2);
+    REQUIRE(cache.bytes() > 0);
+
+    write_text("goob_test_asset.obj", quad);
+    const std::shared_ptr<const goob::Mesh> second = cache.mesh(path);
+    REQUIRE(second != first);
+    REQUIRE(second->triangle_count() == 2);
+    // Holders of the old version keep it
+    REQUIRE(first->triangle_count() == 1);
+    REQUIRE(cache.size() == 1);
+
+    cache.clear();
+    REQUIRE(cache.size() == 0);
+    REQUIRE(second->triangle_count() == 2);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE( "Asset cache evicts unused assets beyond its budget", "[asset_cache]" ) {
+    const auto a = write_text("goob_test_asset_a.obj", triangle);
+    const auto b = write_text("goob_test_asset_b.obj", quad);
+    const auto c = write_text("goob_test_asset_c.obj", triangle);
+    goob::AssetCache cache(1);
+
+    // Everything is in use while it loads
+    std::shared_ptr<const goob::Mesh> held = cache.mesh(a);
+    cache.mesh(b);
+    REQUIRE(cache.size() == 2);
+    REQUIRE(cache.stats().evictions == 0);
+
+    // Loads drop what no job holds, least recently used first
+    cache.mesh(c);
+    REQUIRE(cache.size() == 2);
+    REQUIRE(cache.stats().evictions == 1);
+    REQUIRE(cache.mesh(a) == held);
+
+    held.reset();
+    cache.mesh(b);
+    REQUIRE(cache.size() == 1);
+    REQUIRE(cache.stats().evictions == 3);
+    REQUIRE(cache.stats().loads == 4);
+    for (const auto & path : {a, b, c}) {
+        std::filesystem::remove(path);
+    }
+}
+
+TEST_CASE( "Asset cache loads textures and reports missing files", "[asset_cache]" ) {
+    const auto path = std::filesystem::temp_directory_path() / "goob_test_asset.tga";
+    goob::TGAImage image(4, 2, goob::PixelFormat::bgra);
+    image.pixels()[0] = 255;
+    image.write(path);
+
+    const auto mesh_cache = std::filesystem::temp_directory_path() / "goob_test_asset_meshes";
+    std::filesystem::remove_all(mesh_cache);
+    goob::AssetCache cache(std::size_t(1) << 20, nullptr, mesh_cache);
+    const std::shared_ptr<const goob::Texture> texture = cache.texture(path);
+    REQUIRE(texture->width() == 4);
+    REQUIRE(texture->height() == 2);
+    REQUIRE(cache.texture(path) == texture);
+
+    REQUIRE_THROWS_AS(cache.mesh(std::filesystem::temp_directory_path() / "goob_test_missing.obj"), std::runtime_error);
+    REQUIRE(cache.size() == 1);
+
+    // Meshes go through the binary mesh cache when it has a directory
+    const auto obj = write_text("goob_test_asset_cached.obj", triangle);
+    REQUIRE(cache.mesh(obj)->triangle_count() == 1);
+    REQUIRE(!std::filesystem::is_empty(mesh_cache));
+    std::filesystem::remove(obj);
+    std::filesystem::remove(path);
+    std::filesystem::remove_all(mesh_cache);
+}
@@ -0,0 +1,150 @@
+#include "batch_renderer.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+    // A square facing +z, with normals, over [-1,1]^2
+    const std::string square =
+        "v -1 -1 0\nv 1 -1 0\nv 1 1 0\nv -1 1 0\n"
+        "vn 0 0 1\n"
+        "f 1//1 2//1 3//1 4//1\n";
+
+    std::uint32_t pixel(const goob::TGAImage & image, int x, int y) {
+        const std::uint8_t * p = image.view().pixel(x, y);
+        return p[0] | (p[1] << 8) | (p[2] << 16) | (std::uint32_t(p[3]) << 24);
+    }
+}
+
+TEST_CASE( "Batch renderer renders, encodes and writes jobs in order", "[batch_renderer]" ) {
+    const auto dir = std::filesystem::temp_directory_path() / "goob_test_batch";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir / "square.obj") << square;
+
+    goob::ThreadPool pool(3);
+    goob::AssetCache assets;
+    std::vector<goob::JobResult> results;
+    {
+        goob::BatchRenderer renderer(pool, assets, [&](const goob::JobResult & result) { results.push_back(result); }, {1});
+        for (int i = 0; i < 6; ++i) {
+            goob::RenderJob job;
+            job.mesh = dir / "square.obj";
+            job.output = dir / "out" / ("frame" + std::to_string(i) + ".tga");
+            job.width = 64 + 16 * (i % 2);
+            job.height = 48;
+            job.samples = i < 3 ? 1 : 4;
+            job.background = {0, 0, 1};
+            REQUIRE(renderer.submit(job) == static_cast<std::uint64_t>(i));
+        }
+        goob::RenderJob missing;
+        missing.mesh = dir / "missing.obj";
+        missing.output = dir / "out" / "missing.tga";
+        renderer.submit(missing);
+        renderer.wait();
+        REQUIRE(results.size() == 7);
+
+        // Submitting after wait() keeps the pipeline going
+        goob::RenderJob again;
+        again.mesh = dir / "square.obj";
+        again.output = dir / "out" / "again.tga";
+        renderer.submit(again);
+    }
+
+    REQUIRE(results.size() == 8);
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        REQUIRE(results[i].sequence == i);
+        REQUIRE(results[i].succeeded() == (i != 6));
+    }
+    REQUIRE(!results[6].error.empty());
+    REQUIRE(!std::filesystem::exists(dir / "out" / "missing.tga"));
+    // The mesh was loaded once for all jobs
+    REQUIRE(assets.stats().loads == 1);
+
+    for (int i = 0; i < 6; ++i) {
+        const goob::TGAImage image = goob::TGAImage::load(dir / "out" / ("frame" + std::to_string(i) + ".tga"));
+        REQUIRE(image.width() == 64 + 16 * (i % 2));
+        REQUIRE(image.height() == 48);
+        // Lit head-on in the middle, background in the corner
+        REQUIRE(pixel(image, image.width() / 2, 24) == 0xffccccccu);
+        REQUIRE(pixel(image, 0, 0) == 0xff0000ffu);
+    }
+    REQUIRE(std::filesystem::exists(dir / "out" / "again.tga"));
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE( "Batch renderer samples minified textures from the mip chain", "[batch_renderer]" ) {
+    const auto dir = std::filesystem::temp_directory_path() / "goob_test_batch_mips";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    // Without normals the square is unlit, so pixels show the texture as sampled
+    std::ofstream(dir / "square.obj") << "v -1 -1 0\nv 1 -1 0\nv 1 1 0\nv -1 1 0\n"
+                                         "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+                                         "f 1/1 2/2 3/3 4/4\n";
+
+    // A 64x64 checkerboard of single texels averages to grey from mip level 1 on
+    std::vector<std::uint8_t> checker(64 * 64 * 4, 255);
+    for (int y = 0; y < 64; ++y) {
+        for (int x = 0; x < 64; ++x) {
+            std::uint8_t * p = &checker[(static_cast<std::size_t>(y) * 64 + x) * 4];
+            p[0] = p[1] = p[2] = (x + y) % 2 ? 255 : 0;
+        }
+    }
+    const std::vector<std::uint8_t> file = goob::encode_tga({checker.data(), 64, 64, goob::PixelFormat::bgra, 64 * 4, 4});
+    std::ofstream(dir / "checker.tga", std::ios::binary).write(reinterpret_cast<const char *>(file.data()), static_cast<std::streamsize>(file.size()));
+
+    goob::ThreadPool pool(2);
+    goob::AssetCache assets;
+    std::vector<goob::JobResult> results;
+    {
+        goob::BatchRenderer renderer(pool, assets, [&](const goob::JobResult & result) { results.push_back(result); });
+        // The square spans about 18 pixels for 64 texels
+        goob::RenderJob job;
+        job.mesh = dir / "square.obj";
+        job.texture = dir / "checker.tga";
+        job.output = dir / "small.tga";
+        job.width = job.height = 32;
+        renderer.submit(job);
+    }
+    REQUIRE(results.size() == 1);
+    REQUIRE(results[0].succeeded());
+
+    const goob::TGAImage image = goob::TGAImage::load(dir / "small.tga");
+    for (int y = 12; y < 20; ++y) {
+        for (int x = 12; x < 20; ++x) {
+            const std::uint8_t grey = image.view().pixel(x, y)[0];
+            REQUIRE(grey > 100);
+            REQUIRE(grey < 160);
+        }
+    }
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE( "Batch renderer leaves no temporary behind when writing fails", "[batch_renderer]" ) {
+    const auto dir = std::filesystem::temp_directory_path() / "goob_test_batch_write";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir / "blocked" / "child");
+    std::ofstream(dir / "square.obj") << square;
+
+    goob::ThreadPool pool(2);
+    goob::AssetCache assets;
+    std::vector<goob::JobResult> results;
+    {
+        goob::BatchRenderer renderer(pool, assets, [&](const goob::JobResult & result) { results.push_back(result); });
+        // A non-empty directory cannot be replaced by the rendered image
+        goob::RenderJob job;
+        job.mesh = dir / "square.obj";
+        job.output = dir / "blocked";
+        job.width = job.height = 16;
+        renderer.submit(job);
+    }
+    REQUIRE(results.size() == 1);
+    REQUIRE(!results[0].succeeded());
+    for (const auto & entry : std::filesystem::directory_iterator(dir)) {
+        REQUIRE(entry.path().extension() != ".tmp");
+    }
+    std::filesystem::remove_all(dir);
+}
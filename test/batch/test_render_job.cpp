@@ -0,0 +1,76 @@
+#include "render_job.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+TEST_CASE( "Job lines set every field", "[render_job]" ) {
+    const std::optional<goob::RenderJob> job = goob::parse_job(
+        "  mesh=head.obj texture=/tex/head.tga output=out/1.tga width=800 height=600 samples=4 eye=1,2,3.5 target=0,0.5,0 "
+        "up=0,0,1 fov=45 near=0.5 far=50 background=0.1,0.2,0.3 compression=none  # trailing comment", "jobs");
+    REQUIRE(job);
+    REQUIRE(job->mesh == std::filesystem::path("jobs/head.obj"));
+    REQUIRE(job->texture == std::filesystem::path("/tex/head.tga"));
+    REQUIRE(job->output == std::filesystem::path("jobs/out/1.tga"));
+    REQUIRE(job->width == 800);
+    REQUIRE(job->height == 600);
+    REQUIRE(job->samples == 4);
+    REQUIRE(job->eye == linalg::vec<float,3>(1, 2, 3.5f));
+    REQUIRE(job->target == linalg::vec<float,3>(0, 0.5f, 0));
+    REQUIRE(job->up == linalg::vec<float,3>(0, 0, 1));
+    REQUIRE(job->fov == 45.0f);
+    REQUIRE(job->near == 0.5f);
+    REQUIRE(job->far == 50.0f);
+    REQUIRE(job->background == linalg::vec<float,3>(0.1f, 0.2f, 0.3f));
+    REQUIRE(job->compression == goob::TGACompression::none);
+
+    const std::optional<goob::RenderJob> minimal = goob::parse_job("mesh=a.obj output=a.tga");
+    REQUIRE(minimal);
+    REQUIRE(minimal->texture.empty());
+    REQUIRE(minimal->width == 512);
+    REQUIRE(minimal->samples == 1);
+    REQUIRE(minimal->compression == goob::TGACompression::rle);
+}
+
+TEST_CASE( "Blank lines and comments hold no job, malformed lines throw", "[render_job]" ) {
+    REQUIRE(!goob::parse_job(""));
+    REQUIRE(!goob::parse_job("   \t\r"));
+    REQUIRE(!goob::parse_job("# mesh=a.obj output=a.tga"));
+
+    REQUIRE_THROWS_AS(goob::parse_job("output=a.tga"), std::invalid_argument);
+    REQUIRE_THROWS_AS(goob::parse_job("mesh=a.obj"), std::invalid_argument);
+    REQUIRE_THROWS_AS(goob::parse_job("mesh=a.obj output=a.tga colour=1"), std::invalid_argument);
+    REQUIRE_THROWS_AS(goob::parse_job("mesh=a.obj output=a.tga samples=3"), std::invalid_argument);
+    REQUIRE_THROWS_AS(goob::parse_job("mesh=a.obj output=a.tga width=0"), std::invalid_argument);
+    REQUIRE_THROWS_AS(goob::parse_job("mesh=a.obj output=a.tga eye=1,2"), std::invalid_argument);
+    REQUIRE_THROWS_AS(goob::parse_job("mesh=a.obj output=a.tga eye=1,2,3,4"), std::invalid_argument);
+    REQUIRE_THROWS_AS(goob::parse_job("mesh=a.obj output=a.tga fov=wide"), std::invalid_argument);
+    REQUIRE_THROWS_AS(goob::parse_job("mesh=a.obj output=a.tga near=2 far=1"), std::invalid_argument);
+    REQUIRE_THROWS_AS(goob::parse_job("mesh=a.obj output"), std::invalid_argument);
+}
+
+TEST_CASE( "Spool files are claimed once, in name order", "[render_job]" ) {
+    const auto dir = std::filesystem::temp_directory_path() / "goob_test_spool";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    for (const char * name : {"b.job", "a.job", "c.txt"}) {
+        std::ofstream(dir / name) << "mesh=a.obj output=a.tga\n";
+    }
+
+    goob::JobSpool spool(dir);
+    const std::optional<std::filesystem::path> first = spool.claim();
+    REQUIRE(first == dir / "a.job.work");
+    const std::optional<std::filesystem::path> second = spool.claim();
+    REQUIRE(second == dir / "b.job.work");
+    REQUIRE(!spool.claim());
+
+    spool.finish(*first, true);
+    spool.finish(*second, false);
+    REQUIRE(std::filesystem::exists(dir / "a.job.done"));
+    REQUIRE(std::filesystem::exists(dir / "b.job.failed"));
+    REQUIRE(!spool.claim());
+
+    REQUIRE_THROWS_AS(goob::JobSpool(dir / "missing"), std::runtime_error);
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,69 @@
+#include "arena.hpp"
+#include "thread_pool.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <vector>
+
+TEST_CASE( "Arena allocations are aligned and do not overlap", "[arena]" ) {
+    goob::Arena arena(256);
+    auto * a = static_cast<std::uint8_t *>(arena.allocate(3, 1));
+    auto * b = static_cast<std::uint8_t *>(arena.allocate(16, 16));
+    auto * c = static_cast<std::uint8_t *>(arena.allocate(1000, 64));
+
+    REQUIRE(reinterpret_cast<std::uintptr_t>(b) % 16 == 0);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(c) % 64 == 0);
+    REQUIRE(b >= a + 3);
+    REQUIRE(arena.used() == 1019);
+    // The large request did not fit the first block
+    REQUIRE(arena.block_allocations() == 2);
+}
+
+TEST_CASE( "Arena reset reuses its blocks", "[arena]" ) {
+    goob::Arena arena(1024);
+    const auto frame = [&] {
+        std::pmr::vector<int> values(&arena);
+        for (int i = 0; i < 5000; ++i) {
+            values.push_back(i);
+        }
+        const std::span<double> scratch = arena.allocate_array<double>(300);
+        scratch[299] = values.back();
+        return values.data();
+    };
+
+    const int * first = frame();
+    const std::size_t blocks = arena.block_allocations();
+    REQUIRE(blocks > 1);
+    for (int i = 0; i < 10; ++i) {
+        arena.reset();
+        REQUIRE(arena.used() == 0);
+        frame();
+    }
+    REQUIRE(arena.block_allocations() == blocks);
+
+    arena.reset();
+    REQUIRE(arena.allocate(1, 1) != nullptr);
+    REQUIRE(first != nullptr);
+}
+
+TEST_CASE( "Frame arena gives every worker its own arena", "[arena]" ) {
+    goob::ThreadPool pool(4);
+    goob::FrameArena frame(pool.size());
+    REQUIRE(frame.worker_count() == 4);
+
+    std::vector<std::uint32_t *> results(64);
+    pool.parallel_for(results.size(), [&](std::size_t i, unsigned worker) {
+        const std::span<std::uint32_t> values = frame.worker(worker).allocate_array<std::uint32_t>(100);
+        values[0] = static_cast<std::uint32_t>(i);
+        results[i] = values.data();
+    });
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        REQUIRE(*results[i] == i);
+    }
+
+    frame.reset();
+    for (unsigned w = 0; w < frame.worker_count(); ++w) {
+        REQUIRE(frame.worker(w).used() == 0);
+    }
+    REQUIRE(frame.frame().used() == 0);
+}
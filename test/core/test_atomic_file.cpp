@@ -0,0 +1,41 @@
+#include "atomic_file.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace {
+    std::vector<std::uint8_t> read_all(const std::filesystem::path & path) {
+        std::ifstream in(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+
+    std::size_t file_count(const std::filesystem::path & dir) {
+        return static_cast<std::size_t>(std::distance(std::filesystem::directory_iterator(dir), std::filesystem::directory_iterator()));
+    }
+}
+
+TEST_CASE( "Atomic writes replace the file and leave no temporaries", "[atomic_file]" ) {
+    const auto dir = std::filesystem::temp_directory_path() / "goob_test_atomic_file";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    const std::vector<std::uint8_t> first = {1, 2, 3}, second(100000, 7);
+    goob::write_file_atomic(dir / "out.bin", first);
+    REQUIRE(read_all(dir / "out.bin") == first);
+    goob::write_file_atomic(dir / "out.bin", second);
+    REQUIRE(read_all(dir / "out.bin") == second);
+    REQUIRE(file_count(dir) == 1);
+
+    // Renaming over a non-empty directory fails; the temporary must not stay behind
+    std::filesystem::create_directories(dir / "busy" / "child");
+    REQUIRE_THROWS_AS(goob::write_file_atomic(dir / "busy", first), std::filesystem::filesystem_error);
+    REQUIRE(file_count(dir) == 2);
+
+    // Opening fails in a missing directory
+    REQUIRE_THROWS_AS(goob::write_file_atomic(dir / "missing" / "out.bin", first), std::runtime_error);
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,37 @@
+#include "channel.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <thread>
+#include <vector>
+
+TEST_CASE( "Channel hands items over in order and blocks while full", "[channel]" ) {
+    goob::Channel<int> channel(2);
+    std::vector<int> received;
+    std::thread consumer([&] {
+        while (std::optional<int> item = channel.pop()) {
+            received.push_back(*item);
+        }
+    });
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(channel.push(i));
+        REQUIRE(channel.size() <= 2);
+    }
+    channel.close();
+    consumer.join();
+
+    REQUIRE(received.size() == 1000);
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(received[i] == i);
+    }
+}
+
+TEST_CASE( "Closed channels drain and refuse new items", "[channel]" ) {
+    goob::Channel<int> channel(4);
+    REQUIRE(channel.push(1));
+    REQUIRE(channel.push(2));
+    channel.close();
+    REQUIRE(!channel.push(3));
+    REQUIRE(channel.pop() == 1);
+    REQUIRE(channel.pop() == 2);
+    REQUIRE(!channel.pop());
+}
@@ -0,0 +1,100 @@
+#include "profiler.hpp"
+#include "thread_pool.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+TEST_CASE( "Per-thread counters are merged at the end of a frame", "[profiler]" ) {
+    goob::ThreadPool pool(4);
+    goob::Profiler profiler(pool.size());
+
+    profiler.begin_frame();
+    pool.parallel_for(1000, [&](std::size_t, unsigned worker) {
+        profiler.count(worker, goob::Counter::fragments_shaded, 2);
+    });
+    profiler.count(0, goob::Counter::triangles_in, 7);
+    const goob::FrameStats & stats = profiler.end_frame();
+
+    REQUIRE(stats.frame == 0);
+    REQUIRE(stats.count(goob::Counter::fragments_shaded) == 2000);
+    REQUIRE(stats.count(goob::Counter::triangles_in) == 7);
+    REQUIRE(stats.thread_counters.size() == 4);
+    std::uint64_t sum = 0;
+    for (const auto & counters : stats.thread_counters) {
+        sum += counters[static_cast<std::size_t>(goob::Counter::fragments_shaded)];
+    }
+    REQUIRE(sum == 2000);
+
+    // Counters start over every frame
+    profiler.begin_frame();
+    REQUIRE(profiler.end_frame().count(goob::Counter::fragments_shaded) == 0);
+    REQUIRE(profiler.last_frame().frame == 1);
+}
+
+TEST_CASE( "Stage scopes time the frame and overflow is counted", "[profiler]" ) {
+    goob::Profiler profiler(1, 2);
+    profiler.begin_frame();
+    {
+        goob::StageScope scope(&profiler, goob::Stage::raster);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    profiler.record(goob::Stage::raster, 0, 1000);
+    profiler.record(goob::Stage::shade, 0, 1000);
+    const goob::FrameStats & stats = profiler.end_frame();
+
+    REQUIRE(stats.time(goob::Stage::raster) >= 2000000 + 1000);
+    REQUIRE(stats.time(goob::Stage::shade) == 0);
+    REQUIRE(stats.duration_ns >= 2000000);
+    REQUIRE(profiler.dropped_events() == 1);
+
+    // A null profiler is ignored
+    const goob::StageScope scope(nullptr, goob::Stage::vertex);
+}
+
+TEST_CASE( "Traced frames export as Chrome trace events", "[profiler]" ) {
+    goob::Profiler profiler(2);
+    profiler.set_tracing(true);
+    for (int frame = 0; frame < 3; ++frame) {
+        profiler.begin_frame();
+        GOOB_PROFILE_STAGE(&profiler, vertex);
+        GOOB_PROFILE_COUNT(&profiler, 1, vertices_shaded, 12);
+        const std::int64_t begin = goob::Profiler::now();
+        profiler.record(goob::Stage::bin, begin, begin + 1500);
+        profiler.end_frame();
+    }
+
+    std::ostringstream out;
+    profiler.write_chrome_trace(out);
+    const std::string trace = out.str();
+    REQUIRE(trace.starts_with("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["));
+    REQUIRE(trace.find("\"name\":\"bin\"") != std::string::npos);
+    REQUIRE(trace.find("\"dur\":1.500") != std::string::npos);
+    REQUIRE(trace.find("\"frame\":2") != std::string::npos);
+#if GOOB_ENABLE_STATS
+    REQUIRE(trace.find("\"vertices_shaded\":12") != std::string::npos);
+#else
+    REQUIRE(trace.find("\"vertices_shaded\":0") != std::string::npos);
+#endif
+
+    // A stage opened before the first traced frame began gets a negative timestamp
+    profiler.clear_trace();
+    {
+        const std::int64_t early = goob::Profiler::now() - 2500;
+        profiler.begin_frame();
+        profiler.record(goob::Stage::cull, early, early + 1000);
+        profiler.end_frame();
+        std::ostringstream negative;
+        profiler.write_chrome_trace(negative);
+        const std::string negative_trace = negative.str();
+        const std::size_t ts = negative_trace.find("\"ts\":", negative_trace.find("\"name\":\"cull\"")) + 5;
+        REQUIRE(negative_trace[ts] == '-');
+        REQUIRE(negative_trace.find_first_not_of("0123456789.", ts + 1) == negative_trace.find(",\"dur\":1.000", ts));
+    }
+
+    profiler.clear_trace();
+    std::ostringstream empty;
+    profiler.write_chrome_trace(empty);
+    REQUIRE(empty.str().find("\"ph\":\"X\"") == std::string::npos);
+}
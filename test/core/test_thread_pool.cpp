@@ -0,0 +1,96 @@
+#include "thread_pool.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST_CASE( "Thread pool visits every index exactly once", "[thread_pool]" ) {
+    goob::ThreadPool pool(4);
+    REQUIRE(pool.size() == 4);
+
+    std::vector<std::atomic<int>> visits(10007);
+    std::atomic<bool> worker_in_range = true;
+    pool.parallel_for(visits.size(), [&](std::size_t i, unsigned worker) {
+        visits[i].fetch_add(1);
+        if (worker >= pool.size()) {
+            worker_in_range = false;
+        }
+    });
+
+    REQUIRE(worker_in_range);
+    for (const auto & v : visits) {
+        REQUIRE(v.load() == 1);
+    }
+}
+
+TEST_CASE( "Thread pool runs consecutive jobs", "[thread_pool]" ) {
+    goob::ThreadPool pool(3);
+    std::atomic<std::size_t> total = 0;
+    for (int job = 0; job < 100; ++job) {
+        pool.parallel_for(job, [&](std::size_t i, unsigned) { total += i; });
+    }
+    std::size_t expected = 0;
+    for (std::size_t job = 0; job < 100; ++job) {
+        expected += job * (job - (job > 0 ? 1 : 0)) / 2;
+    }
+    REQUIRE(total == expected);
+}
+
+TEST_CASE( "Thread pool runs nested jobs on the calling worker", "[thread_pool]" ) {
+    goob::ThreadPool pool(4);
+    std::atomic<int> inner = 0;
+    std::atomic<bool> same_worker = true;
+    pool.parallel_for(8, [&](std::size_t, unsigned worker) {
+        pool.parallel_for(16, [&](std::size_t, unsigned nested_worker) {
+            ++inner;
+            if (nested_worker != worker || goob::ThreadPool::current_worker() != worker) {
+                same_worker = false;
+            }
+        });
+    });
+    REQUIRE(inner == 8 * 16);
+    REQUIRE(same_worker);
+}
+
+TEST_CASE( "Thread pool jobs started from another pool's workers use their own indices", "[thread_pool]" ) {
+    goob::ThreadPool outer(8);
+    goob::ThreadPool inner(2);
+    std::atomic<int> calls = 0;
+    std::atomic<bool> in_range = true, restored = true;
+    outer.parallel_for(64, [&](std::size_t, unsigned worker) {
+        // Slow enough that every outer worker takes part
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        inner.parallel_for(16, [&](std::size_t, unsigned inner_worker) {
+            ++calls;
+            if (inner_worker >= inner.size() || goob::ThreadPool::current_worker() != inner_worker) {
+                in_range = false;
+            }
+        });
+        if (goob::ThreadPool::current_worker() != worker) {
+            restored = false;
+        }
+    });
+    REQUIRE(calls == 64 * 16);
+    REQUIRE(in_range);
+    REQUIRE(restored);
+}
+
+TEST_CASE( "Thread pool propagates exceptions", "[thread_pool]" ) {
+    goob::ThreadPool pool(4);
+    std::atomic<int> calls = 0;
+    REQUIRE_THROWS_AS(pool.parallel_for(100, [&](std::size_t i, unsigned) {
+        ++calls;
+        if (i == 42) {
+            throw std::runtime_error("boom");
+        }
+    }), std::runtime_error);
+    REQUIRE(calls == 100);
+
+    // The pool stays usable afterwards
+    std::atomic<int> after = 0;
+    pool.parallel_for(10, [&](std::size_t, unsigned) { ++after; });
+    REQUIRE(after == 10);
+}
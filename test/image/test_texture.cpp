@@ -0,0 +1,134 @@
+#include "texture.hpp"
+#include "thread_pool.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    // Owned BGRA pixels with a view
+    struct Pixels {
+        int width, height;
+        std::vector<std::uint8_t> bytes;
+
+        Pixels(int w, int h) : width(w), height(h), bytes(static_cast<std::size_t>(w) * h * 4, 255) {}
+
+        void set(int x, int y, std::uint8_t b, std::uint8_t g, std::uint8_t r, std::uint8_t a = 255) {
+            std::uint8_t * p = &bytes[(static_cast<std::size_t>(y) * width + x) * 4];
+            p[0] = b; p[1] = g; p[2] = r; p[3] = a;
+        }
+        goob::ImageView view() const { return {bytes.data(), width, height, goob::PixelFormat::bgra, width * 4, 4}; }
+    };
+
+    Pixels noise(int w, int h) {
+        Pixels pixels(w, h);
+        std::mt19937 rng(7);
+        for (std::uint8_t & byte : pixels.bytes) {
+            byte = static_cast<std::uint8_t>(rng());
+        }
+        return pixels;
+    }
+}
+
+TEST_CASE( "Mip chain halves down to one texel", "[texture]" ) {
+    goob::ThreadPool pool(3);
+    const Pixels pixels = noise(37, 10);
+    const goob::Texture texture(pixels.view(), &pool);
+
+    REQUIRE(texture.level_count() == 6);
+    REQUIRE(texture.level(1).width == 18);
+    REQUIRE(texture.level(1).height == 5);
+    REQUIRE(texture.level(5).width == 1);
+    REQUIRE(texture.level(5).height == 1);
+    for (int i = 0; i < texture.level_count(); ++i) {
+        REQUIRE(texture.level(i).offset % 16 == 0);
+    }
+
+    // The base level keeps every texel through the swizzle
+    for (int y = 0; y < pixels.height; ++y) {
+        for (int x = 0; x < pixels.width; ++x) {
+            const std::uint8_t * p = &pixels.bytes[(static_cast<std::size_t>(y) * pixels.width + x) * 4];
+            REQUIRE(texture.texel(0, x, y) == (p[0] | (p[1] << 8) | (p[2] << 16) | (std::uint32_t(p[3]) << 24)));
+        }
+    }
+    REQUIRE_THROWS_AS(goob::Texture(goob::ImageView()), std::invalid_argument);
+}
+
+TEST_CASE( "Mip levels average 2x2 texels", "[texture]" ) {
+    Pixels pixels(2, 2);
+    pixels.set(0, 0, 0, 0, 0, 0);
+    pixels.set(1, 0, 100, 0, 0, 0);
+    pixels.set(0, 1, 100, 40, 0, 0);
+    pixels.set(1, 1, 200, 40, 255, 4);
+    const goob::Texture texture(pixels.view());
+
+    REQUIRE(texture.level_count() == 2);
+    REQUIRE(texture.texel(1, 0, 0) == (100u | (20u << 8) | (64u << 16) | (1u << 24)));
+}
+
+TEST_CASE( "Filters and wrap modes sample the expected texels", "[texture]" ) {
+    Pixels pixels(4, 1);
+    pixels.set(0, 0, 0, 0, 0);
+    pixels.set(1, 0, 0, 0, 255);
+    pixels.set(2, 0, 0, 0, 0);
+    pixels.set(3, 0, 0, 0, 255);
+    const goob::Texture texture(pixels.view());
+
+    const goob::Sampler nearest{goob::TextureFilter::nearest, goob::TextureWrap::repeat};
+    REQUIRE(texture.sample(nearest, {0.375f, 0.5f}).x == 1.0f);
+    REQUIRE(texture.sample(nearest, {1.125f, 0.5f}).x == 0.0f);
+
+    // Between the centers of texels 0 and 1
+    const goob::Sampler bilinear{goob::TextureFilter::bilinear, goob::TextureWrap::repeat};
+    REQUIRE(texture.sample(bilinear, {0.25f, 0.5f}).x == Catch::Approx(0.5f));
+    // At u = 0 repeat blends the last and the first texel, clamp stays on the first
+    REQUIRE(texture.sample(bilinear, {0.0f, 0.5f}).x == Catch::Approx(0.5f));
+    REQUIRE(texture.sample({goob::TextureFilter::bilinear, goob::TextureWrap::clamp}, {0.0f, 0.5f}).x == 0.0f);
+
+    // Level 1 is uniformly half red; trilinear halfway between the levels at a red texel center
+    const goob::Sampler trilinear{goob::TextureFilter::trilinear, goob::TextureWrap::repeat};
+    const float level1 = texture.sample(bilinear, {0.375f, 0.5f}, 1.0f).x;
+    REQUIRE(level1 == Catch::Approx(128.0f / 255.0f));
+    REQUIRE(texture.sample(trilinear, {0.375f, 0.5f}, 0.5f).x == Catch::Approx(0.5f * (1.0f + level1)));
+    REQUIRE(texture.sample(trilinear, {0.375f, 0.5f}, 100.0f).x == Catch::Approx(texture.sample(bilinear, {0.375f, 0.5f}, 2.0f).x));
+
+    REQUIRE(texture.lod({0.25f, 0}, {0, 0}) == Catch::Approx(0.0f));
+    REQUIRE(texture.lod({1.0f, 0}, {0, 0}) == Catch::Approx(2.0f));
+}
+
+TEST_CASE( "Batch sampling matches single samples", "[texture]" ) {
+    const Pixels pixels = noise(45, 29);
+    const goob::Texture texture(pixels.view());
+
+    constexpr std::size_t count = 203;
+    goob::SoaBuffer<2> uv(count);
+    std::vector<float> lod(count);
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> coordinate(-2.0f, 3.0f), level(-1.0f, 7.0f);
+    for (std::size_t i = 0; i < count; ++i) {
+        uv.span().set(i, {coordinate(rng), coordinate(rng)});
+        lod[i] = level(rng);
+    }
+    // Coordinates that are not finite fall onto the first texel on every path
+    constexpr float nan = std::numeric_limits<float>::quiet_NaN(), infinity = std::numeric_limits<float>::infinity();
+    uv.span().set(0, {nan, 0.5f});
+    uv.span().set(1, {0.5f, nan});
+    uv.span().set(2, {infinity, -infinity});
+
+    for (goob::TextureFilter filter : {goob::TextureFilter::nearest, goob::TextureFilter::bilinear, goob::TextureFilter::trilinear}) {
+        for (goob::TextureWrap wrap : {goob::TextureWrap::repeat, goob::TextureWrap::clamp}) {
+            const goob::Sampler sampler{filter, wrap};
+            goob::SoaBuffer<4> out(count);
+            texture.sample(sampler, uv.span(), lod, out.span());
+            for (std::size_t i = 0; i < count; ++i) {
+                const linalg::vec<float,4> expected = texture.sample(sampler, uv[i], lod[i]);
+                for (int c = 0; c < 4; ++c) {
+                    REQUIRE(out[i][c] == Catch::Approx(expected[c]).margin(1e-5));
+                }
+            }
+        }
+    }
+}
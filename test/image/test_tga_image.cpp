@@ -0,0 +1,174 @@
+#include "tga_image.hpp"
+#include "thread_pool.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    std::vector<std::uint8_t> tga_header(std::uint8_t type, int width, int height, int bits, std::uint8_t descriptor) {
+        std::vector<std::uint8_t> bytes(18, 0);
+        bytes[2] = type;
+        bytes[12] = width & 0xff; bytes[13] = width >> 8;
+        bytes[14] = height & 0xff; bytes[15] = height >> 8;
+        bytes[16] = static_cast<std::uint8_t>(bits);
+        bytes[17] = descriptor;
+        return bytes;
+    }
+
+    std::filesystem::path write_file(const std::string & name, const std::vector<std::uint8_t> & bytes) {
+        const auto path = std::filesystem::temp_directory_path() / name;
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        return path;
+    }
+}
+
+TEST_CASE( "Uncompressed bottom-up BGR image is mapped and flipped lazily", "[tga]" ) {
+    // 2x2, stored bottom row first
+    auto bytes = tga_header(2, 2, 2, 24, 0x00);
+    const std::uint8_t pixels[] = {1, 2, 3, 4, 5, 6,   7, 8, 9, 10, 11, 12};
+    bytes.insert(bytes.end(), std::begin(pixels), std::end(pixels));
+    const auto path = write_file("goob_bottom_up.tga", bytes);
+
+    goob::TGAImage image = goob::TGAImage::load(path);
+    REQUIRE(image.is_mapped());
+    REQUIRE(image.format() == goob::PixelFormat::bgr);
+
+    const goob::ImageView view = image.view();
+    REQUIRE(view.row_stride() == -6);
+    REQUIRE(view.bgra(0, 0) == linalg::vec<std::uint8_t,4>(7, 8, 9, 255));
+    REQUIRE(view.bgra(1, 1) == linalg::vec<std::uint8_t,4>(4, 5, 6, 255));
+
+    // Materializing the pixels produces top-down rows
+    const auto owned = image.pixels();
+    REQUIRE_FALSE(image.is_mapped());
+    REQUIRE(owned[0] == 7);
+    REQUIRE(owned[6] == 1);
+    REQUIRE(image.view().row_stride() == 6);
+}
+
+TEST_CASE( "RLE packets decode across scanlines", "[tga]" ) {
+    for (int bits : {8, 24, 32}) {
+        const int bpp = bits / 8;
+        const int width = 13, height = 5;
+        auto bytes = tga_header(bits == 8 ? 11 : 10, width, height, bits, 0x20);
+
+        // One run of 40 pixels crossing three rows, a raw packet of 5 pixels, then a run filling the rest
+        std::vector<std::uint8_t> expected;
+        auto push_pixel = [&](std::vector<std::uint8_t> & out, int seed) {
+            for (int c = 0; c < bpp; ++c) {
+                out.push_back(static_cast<std::uint8_t>(seed * 10 + c));
+            }
+        };
+        bytes.push_back(0x80 | 39);
+        push_pixel(bytes, 1);
+        for (int i = 0; i < 40; ++i) {
+            push_pixel(expected, 1);
+        }
+        bytes.push_back(4);
+        for (int i = 0; i < 5; ++i) {
+            push_pixel(bytes, 2 + i);
+            push_pixel(expected, 2 + i);
+        }
+        const int rest = width * height - 45;
+        bytes.push_back(static_cast<std::uint8_t>(0x80 | (rest - 1)));
+        push_pixel(bytes, 9);
+        for (int i = 0; i < rest; ++i) {
+            push_pixel(expected, 9);
+        }
+
+        goob::TGAImage image = goob::TGAImage::decode(bytes);
+        REQUIRE_FALSE(image.is_mapped());
+        REQUIRE(bytes_per_pixel(image.format()) == bpp);
+        const goob::ImageView view = image.view();
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                const std::uint8_t * p = view.pixel(x, y);
+                for (int c = 0; c < bpp; ++c) {
+                    REQUIRE(p[c] == expected[(y * width + x) * bpp + c]);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE( "Grayscale pixels expand to BGRA", "[tga]" ) {
+    auto bytes = tga_header(3, 2, 1, 8, 0x20);
+    bytes.push_back(17);
+    bytes.push_back(200);
+    goob::TGAImage image = goob::TGAImage::decode(bytes);
+    REQUIRE(image.format() == goob::PixelFormat::grayscale);
+    REQUIRE(image.view().bgra(1, 0) == linalg::vec<std::uint8_t,4>(200, 200, 200, 255));
+}
+
+TEST_CASE( "Malformed TGA files are rejected", "[tga]" ) {
+    REQUIRE_THROWS_AS(goob::TGAImage::load(std::filesystem::temp_directory_path() / "goob_does_not_exist.tga"), std::runtime_error);
+
+    auto truncated = tga_header(2, 4, 4, 32, 0x20);
+    truncated.resize(truncated.size() + 10);
+    REQUIRE_THROWS_AS(goob::TGAImage::decode(truncated), std::runtime_error);
+
+    auto truncated_rle = tga_header(10, 4, 4, 24, 0x20);
+    truncated_rle.push_back(0x80 | 3);
+    REQUIRE_THROWS_AS(goob::TGAImage::decode(truncated_rle), std::runtime_error);
+
+    auto colormapped = tga_header(1, 4, 4, 8, 0x20);
+    REQUIRE_THROWS_AS(goob::TGAImage::decode(colormapped), std::runtime_error);
+}
+
+TEST_CASE( "Blank images reject dimensions that are not positive", "[tga]" ) {
+    REQUIRE_THROWS_AS(goob::TGAImage(-1, 1, goob::PixelFormat::bgra), std::invalid_argument);
+    REQUIRE_THROWS_AS(goob::TGAImage(1, -1, goob::PixelFormat::bgr), std::invalid_argument);
+    REQUIRE_THROWS_AS(goob::TGAImage(0, 8, goob::PixelFormat::grayscale), std::invalid_argument);
+    const goob::TGAImage image(3, 2, goob::PixelFormat::bgra);
+    REQUIRE(image.width() == 3);
+    REQUIRE(image.height() == 2);
+}
+
+TEST_CASE( "Encoded images decode to the same pixels", "[tga]" ) {
+    goob::ThreadPool pool(4);
+    for (goob::PixelFormat format : {goob::PixelFormat::grayscale, goob::PixelFormat::bgr, goob::PixelFormat::bgra}) {
+        goob::TGAImage image(300, 37, format);
+        auto pixels = image.pixels();
+        // Mix of long runs, short runs and noise
+        for (std::size_t i = 0; i < pixels.size(); ++i) {
+            const std::size_t pixel = i / bytes_per_pixel(format);
+            pixels[i] = static_cast<std::uint8_t>(pixel % 300 < 150 ? pixel / 300 : (pixel * 2654435761u) >> 13);
+        }
+
+        for (goob::TGACompression compression : {goob::TGACompression::none, goob::TGACompression::rle}) {
+            const auto serial = goob::encode_tga(image.view(), compression);
+            const auto parallel = goob::encode_tga(image.view(), compression, &pool);
+            REQUIRE(serial == parallel);
+
+            goob::TGAImage decoded = goob::TGAImage::decode(serial);
+            REQUIRE(decoded.width() == image.width());
+            REQUIRE(decoded.height() == image.height());
+            REQUIRE(decoded.format() == format);
+            const auto round_trip = decoded.pixels();
+            REQUIRE(std::equal(round_trip.begin(), round_trip.end(), pixels.begin(), pixels.end()));
+        }
+
+        // Runs compress
+        REQUIRE(goob::encode_tga(image.view()).size() < goob::encode_tga(image.view(), goob::TGACompression::none).size());
+    }
+}
+
+TEST_CASE( "Writing a flipped view stores it top-down", "[tga]" ) {
+    goob::TGAImage image(1, 2, goob::PixelFormat::grayscale);
+    image.pixels()[0] = 10;
+    image.pixels()[1] = 20;
+
+    const auto path = std::filesystem::temp_directory_path() / "goob_flipped.tga";
+    const auto file = goob::encode_tga(image.view().flipped_vertically(), goob::TGACompression::none);
+    goob::TGAImage decoded = goob::TGAImage::decode(file);
+    REQUIRE(decoded.view().bgra(0, 0).x == 20);
+    REQUIRE(decoded.view().bgra(0, 1).x == 10);
+
+    image.write(path);
+    REQUIRE(goob::TGAImage::load(path).view().bgra(0, 1).x == 20);
+}
@@ -0,0 +1,39 @@
+#include "tga_writer.hpp"
+#include "thread_pool.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+TEST_CASE( "Background writer writes every submitted frame", "[tga_writer]" ) {
+    goob::ThreadPool pool(2);
+    const auto directory = std::filesystem::temp_directory_path();
+    {
+        goob::TGAWriter writer(2);
+        for (int frame = 0; frame < 8; ++frame) {
+            goob::TGAImage image(64, 16, goob::PixelFormat::bgra);
+            for (auto & byte : image.pixels()) {
+                byte = static_cast<std::uint8_t>(frame);
+            }
+            writer.submit(directory / ("goob_frame_" + std::to_string(frame) + ".tga"), image.view(), goob::TGACompression::rle, &pool);
+            REQUIRE(writer.pending() <= 2);
+        }
+        writer.flush();
+        REQUIRE(writer.pending() == 0);
+    }
+
+    for (int frame = 0; frame < 8; ++frame) {
+        goob::TGAImage image = goob::TGAImage::load(directory / ("goob_frame_" + std::to_string(frame) + ".tga"));
+        REQUIRE(image.width() == 64);
+        REQUIRE(image.view().bgra(63, 15) == linalg::vec<std::uint8_t,4>(std::uint8_t(frame)));
+    }
+}
+
+TEST_CASE( "Background writer reports write errors on flush", "[tga_writer]" ) {
+    goob::TGAWriter writer;
+    goob::TGAImage image(4, 4, goob::PixelFormat::bgr);
+    writer.submit(std::filesystem::temp_directory_path() / "goob_missing_dir" / "x" / "frame.tga", image.view());
+    REQUIRE_THROWS_AS(writer.flush(), std::runtime_error);
+    REQUIRE_NOTHROW(writer.flush());
+}
@@ -0,0 +1,160 @@
+#include "bvh.hpp"
+#include "thread_pool.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+
+namespace {
+    // Random small triangles scattered through a box, like the facets of a scanned scene
+    goob::Mesh triangle_soup(std::size_t count, unsigned seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+        std::uniform_real_distribution<float> offset(-0.6f, 0.6f);
+        goob::Mesh mesh;
+        for (std::size_t t = 0; t < count; ++t) {
+            const linalg::vec<float,3> p = {position(rng), position(rng), position(rng)};
+            for (int c = 0; c < 3; ++c) {
+                mesh.indices.push_back(static_cast<std::uint32_t>(mesh.positions.size()));
+                mesh.positions.push_back(p + linalg::vec<float,3>{offset(rng), offset(rng), offset(rng)});
+            }
+        }
+        return mesh;
+    }
+
+    goob::RayHit brute_force(const goob::Mesh & mesh, const goob::Ray & ray) {
+        goob::RayHit best;
+        for (std::uint32_t t = 0; t < mesh.triangle_count(); ++t) {
+            const linalg::vec<float,3> v0 = mesh.positions[mesh.indices[3 * t]];
+            const linalg::vec<float,3> e1 = mesh.positions[mesh.indices[3 * t + 1]] - v0, e2 = mesh.positions[mesh.indices[3 * t + 2]] - v0;
+            const linalg::vec<float,3> p = linalg::cross(ray.direction, e2);
+            const float det = linalg::dot(e1, p);
+            if (det == 0.0f) {
+                continue;
+            }
+            const linalg::vec<float,3> s = ray.origin - v0, q = linalg::cross(s, e1);
+            const float u = linalg::dot(s, p) / det, v = linalg::dot(ray.direction, q) / det, d = linalg::dot(e2, q) / det;
+            if (u >= 0 && v >= 0 && u + v <= 1 && d > 0 && d < ray.t_max && d < best.t) {
+                best = {d, t, {u, v}};
+            }
+        }
+        return best;
+    }
+
+    // Every primitive appears once, children lie inside their parents and leaves are within the size limit
+    void check_structure(const goob::Bvh & bvh, std::size_t primitives) {
+        std::vector<std::uint32_t> ids(bvh.primitives().begin(), bvh.primitives().end());
+        std::sort(ids.begin(), ids.end());
+        REQUIRE(ids.size() == primitives);
+        for (std::size_t i = 0; i < ids.size(); ++i) {
+            REQUIRE(ids[i] == i);
+        }
+        std::size_t covered = 0;
+        const auto nodes = bvh.nodes();
+        for (std::size_t i = 0; i < nodes.size(); ++i) {
+            if (nodes[i].leaf()) {
+                REQUIRE(nodes[i].count <= 4);
+                covered += nodes[i].count;
+                continue;
+            }
+            REQUIRE(nodes[i].offset > i + 1);
+            REQUIRE(nodes[i].offset < nodes.size());
+            REQUIRE(nodes[i].bounds().contains(nodes[i + 1].bounds()));
+            REQUIRE(nodes[i].bounds().contains(nodes[nodes[i].offset].bounds()));
+        }
+        REQUIRE(covered == primitives);
+    }
+}
+
+TEST_CASE( "Serial and parallel builds produce valid trees", "[bvh]" ) {
+    const goob::Mesh mesh = triangle_soup(20000, 1);
+    goob::ThreadPool pool(4);
+    const goob::MeshBvh serial(mesh);
+    const goob::MeshBvh parallel(mesh, &pool);
+    check_structure(serial.bvh(), mesh.triangle_count());
+    check_structure(parallel.bvh(), mesh.triangle_count());
+    REQUIRE(parallel.bvh().nodes().size() > mesh.triangle_count() / 4);
+
+    // Coincident boxes still split down to small leaves
+    const std::vector<goob::Aabb> same(100, goob::Aabb{{0, 0, 0}, {1, 1, 1}});
+    check_structure(goob::Bvh(same), same.size());
+    REQUIRE_THROWS_AS(goob::Bvh(same, nullptr, 0), std::invalid_argument);
+}
+
+TEST_CASE( "Ray queries match brute force", "[bvh]" ) {
+    const goob::Mesh mesh = triangle_soup(3000, 2);
+    goob::ThreadPool pool(3);
+    const goob::MeshBvh bvh(mesh, &pool);
+
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> spread(-1.0f, 1.0f);
+    for (int packet = 0; packet < 40; ++packet) {
+        // Coherent packets: a bundle of rays from one point
+        const linalg::vec<float,3> origin = {spread(rng) * 15, spread(rng) * 15, -20};
+        const linalg::vec<float,3> target = {spread(rng) * 5, spread(rng) * 5, 0};
+        std::array<goob::Ray,8> rays;
+        for (goob::Ray & ray : rays) {
+            ray = {origin, target - origin + linalg::vec<float,3>{spread(rng), spread(rng), spread(rng)}, packet % 4 == 0 ? 0.9f : 1e30f};
+        }
+
+        std::array<goob::RayHit,8> hits8;
+        std::array<goob::RayHit,4> hits4;
+        bvh.intersect(rays, hits8);
+        bvh.intersect(std::span<const goob::Ray,4>(rays.data(), 4), hits4);
+        for (int i = 0; i < 8; ++i) {
+            const goob::RayHit expected = brute_force(mesh, rays[i]);
+            const goob::RayHit single = bvh.intersect(rays[i]);
+            REQUIRE(single.hit() == expected.hit());
+            REQUIRE(hits8[i].hit() == expected.hit());
+            REQUIRE(bvh.occluded(rays[i]) == expected.hit());
+            if (expected.hit()) {
+                REQUIRE(single.triangle == expected.triangle);
+                REQUIRE(single.t == Catch::Approx(expected.t));
+                REQUIRE(single.barycentric.x == Catch::Approx(expected.barycentric.x).margin(1e-5));
+                REQUIRE(hits8[i].triangle == expected.triangle);
+                REQUIRE(hits8[i].t == Catch::Approx(expected.t));
+            }
+            if (i < 4) {
+                REQUIRE(hits4[i].triangle == expected.triangle);
+            }
+        }
+    }
+}
+
+TEST_CASE( "Frustum culling keeps every triangle in view", "[bvh]" ) {
+    const goob::Mesh mesh = triangle_soup(5000, 3);
+    const goob::MeshBvh bvh(mesh);
+
+    const auto projection = linalg::perspective_matrix(0.5f, 1.0f, 0.5f, 8.0f);
+    const auto view = linalg::lookat_matrix(linalg::vec<float,3>{0, 0, 12}, linalg::vec<float,3>{0, 0, 0}, linalg::vec<float,3>{0, 1, 0});
+    const linalg::mat<float,4,4> view_projection = linalg::mul(projection, view);
+    const goob::Frustum frustum = goob::Frustum::from_matrix(view_projection);
+
+    std::vector<std::uint32_t> visible;
+    bvh.visible_indices(frustum, visible);
+    REQUIRE(visible.size() % 3 == 0);
+    REQUIRE(visible.size() < mesh.indices.size() / 4);
+
+    // Any triangle with a vertex inside the clip volume must be kept
+    std::vector<std::array<std::uint32_t,3>> kept;
+    for (std::size_t i = 0; i < visible.size(); i += 3) {
+        kept.push_back({visible[i], visible[i + 1], visible[i + 2]});
+    }
+    std::sort(kept.begin(), kept.end());
+    std::size_t in_view = 0;
+    for (std::size_t t = 0; t < mesh.triangle_count(); ++t) {
+        bool inside = false;
+        for (int c = 0; c < 3; ++c) {
+            const linalg::vec<float,4> clip = linalg::mul(view_projection, linalg::vec<float,4>{mesh.positions[mesh.indices[3 * t + c]], 1});
+            inside |= std::abs(clip.x) <= clip.w && std::abs(clip.y) <= clip.w && std::abs(clip.z) <= clip.w;
+        }
+        if (inside) {
+            ++in_view;
+            const std::array<std::uint32_t,3> triangle = {mesh.indices[3 * t], mesh.indices[3 * t + 1], mesh.indices[3 * t + 2]};
+            REQUIRE(std::binary_search(kept.begin(), kept.end(), triangle));
+        }
+    }
+    REQUIRE(in_view > 0);
+}
@@ -0,0 +1,96 @@
+#include "mesh_cache.hpp"
+#include "thread_pool.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    std::filesystem::path write_text(const std::string & name, const std::string & text) {
+        const auto path = std::filesystem::temp_directory_path() / name;
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << text;
+        return path;
+    }
+
+    const std::string quad =
+        "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+        "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+        "vn 0 0 1\n"
+        "f 1/1/1 2/2/1 3/3/1 4/4/1\n";
+}
+
+TEST_CASE( "Mesh cache round-trips every stream", "[mesh_cache]" ) {
+    goob::Mesh mesh;
+    mesh.positions = {{0, 1, 2}, {3, 4, 5}, {6, 7, 8}};
+    mesh.normals = {{0, 0, 1}, {0, 1, 0}, {1, 0, 0}};
+    mesh.texcoords = {{0.25f, 0.5f}, {0.75f, 1}, {0, 0}};
+    mesh.indices = {0, 1, 2, 2, 1, 0};
+
+    const auto path = std::filesystem::temp_directory_path() / "goob_test_roundtrip.gmesh";
+    goob::write_mesh_cache(path, mesh, {123, 456, 789});
+    const goob::CachedMesh cached(path);
+
+    REQUIRE(cached.stamp().size == 123);
+    REQUIRE(cached.stamp().hash == 789);
+    REQUIRE(cached.vertex_count() == 3);
+    REQUIRE(cached.triangle_count() == 2);
+    REQUIRE(cached.positions().components[1][2] == 7.0f);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(cached.positions().components[2]) % 64 == 0);
+    REQUIRE(cached.texcoords().get(1) == linalg::vec<float,2>(0.75f, 1));
+
+    const goob::Mesh copy = cached.to_mesh();
+    REQUIRE(copy.positions == mesh.positions);
+    REQUIRE(copy.normals == mesh.normals);
+    REQUIRE(copy.texcoords == mesh.texcoords);
+    REQUIRE(copy.indices == mesh.indices);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE( "Cached loads reuse the cache until the source changes", "[mesh_cache]" ) {
+    goob::ThreadPool pool(2);
+    const auto source = write_text("goob_test_cached.obj", quad);
+    const auto cache = std::filesystem::temp_directory_path() / "goob_test_cached.gmesh";
+    std::filesystem::remove(cache);
+
+    REQUIRE(!goob::CachedMesh::open(cache, source));
+    const goob::CachedMesh built = goob::load_mesh_cached(source, cache, &pool);
+    REQUIRE(built.triangle_count() == 2);
+    REQUIRE(built.has_normals());
+    REQUIRE(built.stamp().hash == goob::SourceStamp::of(source).hash);
+    REQUIRE(goob::CachedMesh::open(cache, source, &pool));
+
+    // Same contents with a new mtime is still valid through the hash, which records the new mtime
+    std::filesystem::last_write_time(source, std::filesystem::last_write_time(source) + std::chrono::seconds(5));
+    const std::int64_t touched = static_cast<std::int64_t>(std::filesystem::last_write_time(source).time_since_epoch().count());
+    REQUIRE(built.stamp().mtime != touched);
+    const std::optional<goob::CachedMesh> reopened = goob::CachedMesh::open(cache, source);
+    REQUIRE(reopened);
+    REQUIRE(reopened->stamp().mtime == touched);
+    REQUIRE(goob::CachedMesh(cache).stamp().mtime == touched);
+
+    // Changed contents of the same size are stale
+    write_text("goob_test_cached.obj", std::string(quad).replace(quad.find("v 1 1 0"), 7, "v 2 2 0"));
+    std::filesystem::last_write_time(source, std::filesystem::last_write_time(source) + std::chrono::seconds(10));
+    REQUIRE(!goob::CachedMesh::open(cache, source));
+    const goob::CachedMesh rebuilt = goob::load_mesh_cached(source, cache);
+    REQUIRE(rebuilt.positions().get(2) == linalg::vec<float,3>(2, 2, 0));
+
+    // No temporary files are left behind
+    for (const auto & entry : std::filesystem::directory_iterator(cache.parent_path())) {
+        REQUIRE(entry.path().filename().string().find("goob_test_cached.gmesh.") == std::string::npos);
+    }
+
+    std::filesystem::remove(source);
+    std::filesystem::remove(cache);
+}
+
+TEST_CASE( "Malformed caches are rejected", "[mesh_cache]" ) {
+    const auto path = write_text("goob_test_bad.gmesh", "GOOBMESH but not much else");
+    REQUIRE_THROWS_AS(goob::CachedMesh(path), std::runtime_error);
+    REQUIRE(!goob::CachedMesh::open(path, path));
+    std::filesystem::remove(path);
+}
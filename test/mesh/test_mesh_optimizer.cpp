@@ -0,0 +1,99 @@
+#include "mesh_optimizer.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <stdexcept>
+
+namespace {
+    // n x n quads as triangle pairs, in shuffled triangle order
+    goob::Mesh shuffled_grid(int n) {
+        goob::Mesh mesh;
+        for (int y = 0; y <= n; ++y) {
+            for (int x = 0; x <= n; ++x) {
+                mesh.positions.push_back({float(x), float(y), 0});
+                mesh.texcoords.push_back({float(x) / n, float(y) / n});
+            }
+        }
+        std::vector<std::array<std::uint32_t,3>> triangles;
+        for (int y = 0; y < n; ++y) {
+            for (int x = 0; x < n; ++x) {
+                const std::uint32_t v = y * (n + 1) + x;
+                triangles.push_back({v, v + 1, v + n + 2});
+                triangles.push_back({v, v + n + 2, v + n + 1});
+            }
+        }
+        std::shuffle(triangles.begin(), triangles.end(), std::mt19937(3));
+        for (const auto & t : triangles) {
+            mesh.indices.insert(mesh.indices.end(), t.begin(), t.end());
+        }
+        return mesh;
+    }
+
+    // Triangles as corner positions rotated to start at the smallest index, sorted
+    std::vector<std::array<linalg::vec<float,3>,3>> triangle_set(const goob::Mesh & mesh) {
+        std::vector<std::array<linalg::vec<float,3>,3>> set;
+        for (std::size_t i = 0; i < mesh.indices.size(); i += 3) {
+            std::array<linalg::vec<float,3>,3> t = {mesh.positions[mesh.indices[i]], mesh.positions[mesh.indices[i + 1]], mesh.positions[mesh.indices[i + 2]]};
+            const auto less = [](const auto & a, const auto & b) { return std::lexicographical_compare(begin(a), end(a), begin(b), end(b)); };
+            std::rotate(t.begin(), std::min_element(t.begin(), t.end(), less), t.end());
+            set.push_back(t);
+        }
+        std::sort(set.begin(), set.end(), [](const auto & a, const auto & b) {
+            for (int c = 0; c < 3; ++c) {
+                for (int k = 0; k < 3; ++k) {
+                    if (a[c][k] != b[c][k]) {
+                        return a[c][k] < b[c][k];
+                    }
+                }
+            }
+            return false;
+        });
+        return set;
+    }
+}
+
+TEST_CASE( "Vertex cache optimization lowers the miss ratio and keeps the triangles", "[mesh_optimizer]" ) {
+    const goob::Mesh original = shuffled_grid(40);
+    const double before = goob::average_cache_miss_ratio(original.indices, original.vertex_count());
+
+    goob::Mesh mesh = original;
+    mesh.indices = goob::optimize_vertex_cache(mesh.indices, mesh.vertex_count());
+    const double after = goob::average_cache_miss_ratio(mesh.indices, mesh.vertex_count());
+
+    REQUIRE(before > 2.0);
+    REQUIRE(after < 0.9);
+    REQUIRE(mesh.indices.size() == original.indices.size());
+    REQUIRE(triangle_set(mesh) == triangle_set(original));
+}
+
+TEST_CASE( "Vertex fetch optimization numbers vertices in order of first use", "[mesh_optimizer]" ) {
+    goob::Mesh mesh = shuffled_grid(6);
+    // An unreferenced vertex is dropped
+    mesh.positions.push_back({-1, -1, -1});
+    mesh.texcoords.push_back({0, 0});
+    const goob::Mesh original = mesh;
+
+    goob::optimize_mesh(mesh);
+    REQUIRE(mesh.vertex_count() == original.vertex_count() - 1);
+    REQUIRE(mesh.texcoords.size() == mesh.vertex_count());
+    REQUIRE(triangle_set(mesh) == triangle_set(original));
+
+    std::uint32_t next = 0;
+    for (std::uint32_t index : mesh.indices) {
+        REQUIRE(index <= next);
+        next = std::max(next, index + 1);
+    }
+    for (std::size_t v = 0; v < mesh.vertex_count(); ++v) {
+        REQUIRE(mesh.texcoords[v].x * 6 == mesh.positions[v].x);
+    }
+}
+
+TEST_CASE( "Optimizer rejects malformed index buffers", "[mesh_optimizer]" ) {
+    const std::uint32_t partial[] = {0, 1};
+    const std::uint32_t out_of_range[] = {0, 1, 3};
+    REQUIRE_THROWS_AS(goob::optimize_vertex_cache(partial, 3), std::invalid_argument);
+    REQUIRE_THROWS_AS(goob::optimize_vertex_cache(out_of_range, 3), std::invalid_argument);
+    REQUIRE_THROWS_AS(goob::average_cache_miss_ratio(out_of_range, 3), std::invalid_argument);
+}
@@ -0,0 +1,107 @@
+#include "meshlet.hpp"
+#include "mesh_optimizer.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+
+namespace {
+    // Closed UV sphere with counter-clockwise (outward) triangles
+    goob::Mesh sphere(int rings, int segments) {
+        goob::Mesh mesh;
+        for (int r = 0; r <= rings; ++r) {
+            const float theta = std::numbers::pi_v<float> * r / rings;
+            for (int s = 0; s <= segments; ++s) {
+                const float phi = 2 * std::numbers::pi_v<float> * s / segments;
+                mesh.positions.push_back({std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)});
+            }
+        }
+        for (int r = 0; r < rings; ++r) {
+            for (int s = 0; s < segments; ++s) {
+                const std::uint32_t a = r * (segments + 1) + s, b = a + segments + 1;
+                if (r != 0) {
+                    mesh.indices.insert(mesh.indices.end(), {a, a + 1, b});
+                }
+                if (r != rings - 1) {
+                    mesh.indices.insert(mesh.indices.end(), {a + 1, b + 1, b});
+                }
+            }
+        }
+        return mesh;
+    }
+
+    linalg::vec<float,3> normal(const goob::Mesh & mesh, std::size_t t) {
+        const linalg::vec<float,3> p0 = mesh.positions[mesh.indices[3 * t]];
+        return linalg::cross(mesh.positions[mesh.indices[3 * t + 1]] - p0, mesh.positions[mesh.indices[3 * t + 2]] - p0);
+    }
+}
+
+TEST_CASE( "Meshlets respect the limits and cover every triangle once", "[meshlet]" ) {
+    goob::Mesh mesh = sphere(40, 60);
+    goob::optimize_mesh(mesh);
+    REQUIRE(linalg::dot(normal(mesh, 0), mesh.positions[mesh.indices[0]]) > 0);
+    const goob::Meshlets meshlets = goob::build_meshlets(mesh);
+
+    std::vector<std::array<std::uint32_t,3>> triangles;
+    for (const goob::Meshlet & m : meshlets.meshlets) {
+        REQUIRE(m.vertex_count <= goob::Meshlets::max_vertices);
+        REQUIRE(m.triangle_count <= goob::Meshlets::max_triangles);
+        for (std::uint32_t t = 0; t < m.triangle_count; ++t) {
+            triangles.push_back({meshlets.index(m, t, 0), meshlets.index(m, t, 1), meshlets.index(m, t, 2)});
+            for (int c = 0; c < 3; ++c) {
+                REQUIRE(linalg::distance(mesh.positions[triangles.back()[c]], m.center) <= m.radius * 1.0001f);
+            }
+        }
+    }
+    std::vector<std::array<std::uint32_t,3>> expected;
+    for (std::size_t i = 0; i < mesh.indices.size(); i += 3) {
+        expected.push_back({mesh.indices[i], mesh.indices[i + 1], mesh.indices[i + 2]});
+    }
+    REQUIRE(triangles == expected);
+
+    // Reordered meshes fill their meshlets
+    REQUIRE(meshlets.meshlets.size() < 2 * mesh.triangle_count() / goob::Meshlets::max_triangles);
+
+    const std::uint32_t bad[] = {0, 1, 99999};
+    REQUIRE_THROWS_AS(goob::build_meshlets(mesh.positions, bad), std::invalid_argument);
+}
+
+TEST_CASE( "Cluster culling rejects back-facing and off-screen meshlets only", "[meshlet]" ) {
+    goob::Mesh mesh = sphere(40, 60);
+    goob::optimize_mesh(mesh);
+    const goob::Meshlets meshlets = goob::build_meshlets(mesh);
+
+    const linalg::vec<float,3> camera = {0, 0, 4};
+    const auto projection = linalg::perspective_matrix(0.3f, 1.0f, 0.1f, 10.0f);
+    const auto view = linalg::lookat_matrix(camera, linalg::vec<float,3>{0.6f, 0, 0}, linalg::vec<float,3>{0, 1, 0});
+    const linalg::mat<float,4,4> view_projection = linalg::mul(projection, view);
+    const goob::Frustum frustum = goob::Frustum::from_matrix(view_projection);
+
+    std::vector<std::uint32_t> indices;
+    const std::size_t visible = goob::cull_meshlets(meshlets, frustum, camera, indices);
+    REQUIRE(visible > 0);
+    REQUIRE(visible < meshlets.meshlets.size() / 2);
+    REQUIRE(indices.size() < mesh.indices.size() / 2);
+
+    // Every front-facing triangle with a vertex on screen survives
+    std::size_t checked = 0;
+    for (const goob::Meshlet & m : meshlets.meshlets) {
+        const bool kept = goob::meshlet_visible(m, frustum, camera);
+        for (std::uint32_t t = 0; t < m.triangle_count && !kept; ++t) {
+            const linalg::vec<float,3> p0 = mesh.positions[meshlets.index(m, t, 0)];
+            const linalg::vec<float,3> n = linalg::cross(mesh.positions[meshlets.index(m, t, 1)] - p0, mesh.positions[meshlets.index(m, t, 2)] - p0);
+            bool on_screen = false;
+            for (int c = 0; c < 3; ++c) {
+                const linalg::vec<float,4> clip = linalg::mul(view_projection, linalg::vec<float,4>{mesh.positions[meshlets.index(m, t, c)], 1});
+                on_screen |= std::abs(clip.x) <= clip.w && std::abs(clip.y) <= clip.w && std::abs(clip.z) <= clip.w;
+            }
+            if (on_screen && linalg::dot(n, p0 - camera) < 0) {
+                FAIL("Culled a visible front-facing triangle");
+            }
+            ++checked;
+        }
+    }
+    REQUIRE(checked > 0);
+}
@@ -0,0 +1,110 @@
+#include "obj_loader.hpp"
+#include "thread_pool.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    // Grid of quads with texcoords and normals shared by the adjacent faces
+    std::string grid_obj(int n) {
+        std::string text = "# grid\no grid\n";
+        for (int y = 0; y <= n; ++y) {
+            for (int x = 0; x <= n; ++x) {
+                text += "v " + std::to_string(x) + " " + std::to_string(y) + " 0.5\n";
+                text += "vt " + std::to_string(x / float(n)) + " " + std::to_string(y / float(n)) + "\n";
+            }
+        }
+        text += "vn 0 0 1\n";
+        for (int y = 0; y < n; ++y) {
+            for (int x = 0; x < n; ++x) {
+                const int i = y * (n + 1) + x + 1;
+                const int j = i + n + 1;
+                text += "f " + std::to_string(i) + "/" + std::to_string(i) + "/1 " + std::to_string(i + 1) + "/" + std::to_string(i + 1)
+                      + "/1 " + std::to_string(j + 1) + "/" + std::to_string(j + 1) + "/1 " + std::to_string(j) + "/" + std::to_string(j) + "/1\n";
+            }
+        }
+        return text;
+    }
+}
+
+TEST_CASE( "Positions-only faces index the positions directly", "[obj]" ) {
+    const goob::Mesh mesh = goob::parse_obj(
+        "v 0 0 0\r\n"
+        "v 1 0 0 # trailing comment\r\n"
+        "v 1 1 0\r\n"
+        "v 0 1 +0\r\n"
+        "s off\n"
+        "usemtl none\n"
+        "f 1 2 3 4\n"
+        "\n"
+        "f -4 -2 -1");
+
+    REQUIRE(mesh.vertex_count() == 4);
+    REQUIRE(mesh.normals.empty());
+    REQUIRE(mesh.texcoords.empty());
+    REQUIRE(mesh.indices == std::vector<std::uint32_t>{0, 1, 2, 0, 2, 3, 0, 2, 3});
+    REQUIRE(mesh.positions[2] == linalg::vec<float,3>(1, 1, 0));
+}
+
+TEST_CASE( "Corners with the same attribute triple share a vertex", "[obj]" ) {
+    const goob::Mesh mesh = goob::parse_obj(
+        "v 0 0 0\nv 1 0 0\nv 1 1 0\n"
+        "vt 0 0\nvt 1 0\nvt 1 1\n"
+        "vn 0 0 1\nvn 0 0 -1\n"
+        "f 1/1/1 2/2/1 3/3/1\n"
+        "f 3/3/1 2/2/1 1/1/2\n"
+        "f 1//1 2//1 3//1\n");
+
+    // 1/1/1, 2/2/1, 3/3/1, 1/1/2, then 1//1, 2//1, 3//1 without texcoords
+    REQUIRE(mesh.vertex_count() == 7);
+    REQUIRE(mesh.indices == std::vector<std::uint32_t>{0, 1, 2, 2, 1, 3, 4, 5, 6});
+    REQUIRE(mesh.normals[3] == linalg::vec<float,3>(0, 0, -1));
+    REQUIRE(mesh.texcoords[1] == linalg::vec<float,2>(1, 0));
+    REQUIRE(mesh.texcoords[5] == linalg::vec<float,2>(0, 0));
+}
+
+TEST_CASE( "Parallel parsing matches the serial result", "[obj]" ) {
+    // Large enough to be split into several chunks
+    const std::string text = grid_obj(160);
+    goob::ThreadPool pool(4);
+
+    const goob::Mesh serial = goob::parse_obj(text);
+    const goob::Mesh parallel = goob::parse_obj(text, &pool);
+
+    REQUIRE(serial.vertex_count() == 161 * 161);
+    REQUIRE(serial.triangle_count() == 2 * 160 * 160);
+    REQUIRE(parallel.indices == serial.indices);
+    REQUIRE(parallel.positions == serial.positions);
+    REQUIRE(parallel.texcoords == serial.texcoords);
+    REQUIRE(parallel.normals == serial.normals);
+}
+
+TEST_CASE( "OBJ files are loaded through a mapping", "[obj]" ) {
+    const auto path = std::filesystem::temp_directory_path() / "goob_test_triangle.obj";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n";
+    }
+    goob::ThreadPool pool(2);
+    const goob::Mesh mesh = goob::load_obj(path, &pool);
+    REQUIRE(mesh.triangle_count() == 1);
+    REQUIRE(mesh.positions[1] == linalg::vec<float,3>(1, 0, 0));
+    std::filesystem::remove(path);
+}
+
+TEST_CASE( "Malformed OBJ input is rejected", "[obj]" ) {
+    REQUIRE_THROWS_AS(goob::parse_obj("v 0 0 0\nv 1 x 0\n"), std::runtime_error);
+    REQUIRE_THROWS_AS(goob::parse_obj("v 0 0 0\nv 1 0 0\nf 1 2\n"), std::runtime_error);
+    REQUIRE_THROWS_AS(goob::parse_obj("v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 4\n"), std::runtime_error);
+    REQUIRE_THROWS_AS(goob::parse_obj("v 0 0 0\nf 0 1 1\n"), std::runtime_error);
+
+    try {
+        goob::parse_obj("v 0 0 0\n\nvn 1 0\n");
+        FAIL();
+    } catch (const std::runtime_error & error) {
+        REQUIRE(std::string(error.what()).find("line 3") != std::string::npos);
+    }
+}
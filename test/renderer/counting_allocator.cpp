@@ -0,0 +1,33 @@
+#include "counting_allocator.hpp"
+
+#include <cstdlib>
+#include <new>
+
+std::atomic<bool> counting_allocations = false;
+std::atomic<std::size_t> heap_allocations = 0;
+
+void * operator new(std::size_t size) {
+    if (counting_allocations) {
+        ++heap_allocations;
+    }
+    if (void * p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void * operator new(std::size_t size, std::align_val_t alignment) {
+    if (counting_allocations) {
+        ++heap_allocations;
+    }
+    const std::size_t a = static_cast<std::size_t>(alignment);
+    if (void * p = std::aligned_alloc(a, (size + a - 1) / a * a)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void * p) noexcept { std::free(p); }
+void operator delete(void * p, std::size_t) noexcept { std::free(p); }
+void operator delete(void * p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void * p, std::size_t, std::align_val_t) noexcept { std::free(p); }
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// The test binary replaces the global operator new and delete in counting_allocator.cpp, which holds no other
+// code, so optimized builds never inline the replacements next to a new-expression. They count heap allocations
+// of every thread while `counting_allocations` is set.
+extern std::atomic<bool> counting_allocations;
+extern std::atomic<std::size_t> heap_allocations;
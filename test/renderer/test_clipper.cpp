@@ -0,0 +1,66 @@
+#include "clipper.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <array>
+
+TEST_CASE( "Outcodes follow the depth range", "[clipper]" ) {
+    const goob::ClipSpace gl = goob::ClipSpace::for_viewport(100, 50);
+    const goob::ClipSpace d3d = goob::ClipSpace::for_viewport(100, 50, linalg::zero_to_one);
+
+    REQUIRE(gl.outcode({0, 0, 0, 1}) == 0);
+    REQUIRE(gl.outcode({0, 0, -0.5f, 1}) == 0);
+    REQUIRE(d3d.outcode({0, 0, -0.5f, 1}) == goob::clip_near);
+    REQUIRE(gl.outcode({0, 0, 2, 1}) == goob::clip_far);
+    REQUIRE(gl.outcode({2, 0, 0, 1}) == goob::clip_right);
+    REQUIRE(gl.outcode({0, -2, 0, 1}) == goob::clip_bottom);
+
+    // The guard band is wider on the narrower side, in NDC units
+    REQUIRE(gl.guard.x > 1.0f);
+    REQUIRE(gl.guard.y > gl.guard.x);
+    REQUIRE(gl.outcode({gl.guard.x * 2.0f, 0, 0, 1}) == (goob::clip_right | goob::clip_guard_right));
+    REQUIRE(gl.outcode({0, 0, -2, -1}) & goob::clip_near);
+}
+
+TEST_CASE( "Triangles inside the cut planes pass unchanged", "[clipper]" ) {
+    const goob::ClipSpace space = goob::ClipSpace::for_viewport(64, 64);
+    const std::array<linalg::vec<float,4>,3> triangle = {{{-3, -3, 0, 1}, {3, -3, 0, 1}, {0, 3, 0, 1}}};
+    std::array<goob::ClipVertex, goob::max_clip_vertices> out;
+
+    REQUIRE(goob::clip_triangle(triangle, goob::clip_left | goob::clip_right, space, out) == 3);
+    for (int i = 0; i < 3; ++i) {
+        REQUIRE(out[i].source == i);
+        REQUIRE(out[i].position == triangle[i]);
+    }
+}
+
+TEST_CASE( "Near plane cut interpolates positions and weights", "[clipper]" ) {
+    const goob::ClipSpace space = goob::ClipSpace::for_viewport(64, 64);
+    const std::array<linalg::vec<float,4>,3> triangle = {{{-1, -1, -3, 1}, {3, -1, 1, 1}, {-1, 3, 1, 1}}};
+    std::array<goob::ClipVertex, goob::max_clip_vertices> out;
+
+    const std::uint16_t planes = space.outcode(triangle[0]) | space.outcode(triangle[1]) | space.outcode(triangle[2]);
+    const int count = goob::clip_triangle(triangle, planes, space, out);
+    REQUIRE(count == 4);
+
+    int created = 0;
+    for (int i = 0; i < count; ++i) {
+        REQUIRE(out[i].position.z >= -out[i].position.w - 1e-6f);
+        REQUIRE(out[i].weights.x + out[i].weights.y + out[i].weights.z == Catch::Approx(1.0f));
+        const linalg::vec<float,4> blended = triangle[0] * out[i].weights.x + triangle[1] * out[i].weights.y + triangle[2] * out[i].weights.z;
+        REQUIRE(blended.x == Catch::Approx(out[i].position.x));
+        REQUIRE(blended.y == Catch::Approx(out[i].position.y));
+        if (out[i].source < 0) {
+            ++created;
+            REQUIRE(out[i].position.z == Catch::Approx(-1.0f));
+        }
+    }
+    REQUIRE(created == 2);
+}
+
+TEST_CASE( "Triangles behind a cut plane vanish", "[clipper]" ) {
+    const goob::ClipSpace space = goob::ClipSpace::for_viewport(64, 64, linalg::zero_to_one);
+    const std::array<linalg::vec<float,4>,3> triangle = {{{0, 0, -1, 1}, {1, 0, -1, 1}, {0, 1, -0.5f, 1}}};
+    std::array<goob::ClipVertex, goob::max_clip_vertices> out;
+    REQUIRE(goob::clip_triangle(triangle, goob::clip_near, space, out) == 0);
+}
@@ -0,0 +1,105 @@
+#include "coverage.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <bit>
+#include <random>
+#include <vector>
+
+namespace {
+    // Reference: evaluate every pixel center with 64-bit arithmetic
+    bool covered(const goob::EdgeSetup & e, int x, int y) {
+        for (int i = 0; i < 3; ++i) {
+            if (e.c[i] + std::int64_t(e.dx[i]) * x + std::int64_t(e.dy[i]) * y < 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<int N>
+    std::uint64_t reference_mask(const goob::EdgeSetup & e, int x, int y) {
+        std::uint64_t mask = 0;
+        for (int r = 0; r < N; ++r) {
+            for (int c = 0; c < N; ++c) {
+                mask |= std::uint64_t(covered(e, x + c, y + r)) << (r * N + c);
+            }
+        }
+        return mask;
+    }
+
+    std::vector<const goob::CoverageKernel *> available_kernels() {
+        std::vector<const goob::CoverageKernel *> kernels;
+        for (goob::SimdLevel level : {goob::SimdLevel::scalar, goob::SimdLevel::sse2, goob::SimdLevel::avx2, goob::SimdLevel::avx512}) {
+            if (const goob::CoverageKernel * kernel = goob::coverage_kernel(level)) {
+                kernels.push_back(kernel);
+            }
+        }
+        return kernels;
+    }
+}
+
+TEST_CASE( "Coverage kernels match per-pixel evaluation", "[coverage]" ) {
+    const auto kernels = available_kernels();
+    REQUIRE(!kernels.empty());
+    REQUIRE(goob::coverage_kernel().level == goob::simd_level());
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> coordinate(-40.0f, 104.0f);
+    for (int n = 0; n < 300; ++n) {
+        goob::EdgeSetup edges;
+        if (!goob::setup_edges({coordinate(rng), coordinate(rng)}, {coordinate(rng), coordinate(rng)}, {coordinate(rng), coordinate(rng)}, edges)) {
+            continue;
+        }
+        for (int y = 0; y < 64; y += 8) {
+            for (int x = 0; x < 64; x += 8) {
+                const std::uint64_t expected8 = reference_mask<8>(edges, x, y);
+                const std::uint64_t expected4 = reference_mask<4>(edges, x + 4, y + 4);
+                for (const goob::CoverageKernel * kernel : kernels) {
+                    INFO(goob::to_string(kernel->level));
+                    REQUIRE(kernel->block8x8(edges, x, y) == expected8);
+                    REQUIRE(kernel->block4x4(edges, x + 4, y + 4) == expected4);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE( "Coverage of a triangle fan is watertight", "[coverage]" ) {
+    // Triangles around a shared center with off-grid vertices cover every pixel at most once
+    const linalg::vec<float,2> center{31.37f, 29.91f};
+    std::vector<linalg::vec<float,2>> ring;
+    for (int i = 0; i < 17; ++i) {
+        const float angle = 6.2831853f * float(i) / 17.0f;
+        ring.push_back(center + linalg::vec<float,2>{std::cos(angle), std::sin(angle)} * (25.0f + float(i % 3) * 3.3f));
+    }
+
+    for (const goob::CoverageKernel * kernel : available_kernels()) {
+        INFO(goob::to_string(kernel->level));
+        int overlaps = 0, covered_pixels = 0;
+        for (int y = 0; y < 64; y += 8) {
+            for (int x = 0; x < 64; x += 8) {
+                std::uint64_t block = 0;
+                for (std::size_t i = 0; i < ring.size(); ++i) {
+                    goob::EdgeSetup edges;
+                    REQUIRE(goob::setup_edges(center, ring[i], ring[(i + 1) % ring.size()], edges));
+                    const std::uint64_t mask = kernel->block8x8(edges, x, y);
+                    overlaps += std::popcount(block & mask);
+                    block |= mask;
+                }
+                covered_pixels += std::popcount(block);
+            }
+        }
+        REQUIRE(overlaps == 0);
+        REQUIRE(covered_pixels > 1500);
+    }
+}
+
+TEST_CASE( "Edge setup rejects degenerate and out of range triangles", "[coverage]" ) {
+    goob::EdgeSetup edges;
+    REQUIRE_FALSE(goob::setup_edges({0, 0}, {10, 10}, {20, 20}, edges));
+    REQUIRE_FALSE(goob::setup_edges({0, 0}, {1e6f, 0}, {0, 10}, edges));
+    REQUIRE(goob::setup_edges({0, 0}, {10, 0}, {0, 10}, edges));
+    REQUIRE(edges.area == 10 * 10 * goob::subpixel_scale * goob::subpixel_scale);
+    REQUIRE(edges.min == linalg::vec<int,2>(0, 0));
+    REQUIRE(edges.max == linalg::vec<int,2>(9, 9));
+}
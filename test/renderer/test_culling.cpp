@@ -0,0 +1,108 @@
+#include "culling.hpp"
+#include "rasterizer.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+    // Reference: a triangle is visible when the rasterizer's setup accepts it and it faces the kept side
+    bool reference_visible(const goob::ScreenTriangle & t, const goob::CullSetup & cull) {
+        goob::TriangleSetup setup;
+        if (!goob::setup_triangle(t, cull.width, cull.height, setup, cull.sample_margin)) {
+            return false;
+        }
+        std::int64_t fx[3], fy[3];
+        for (int i = 0; i < 3; ++i) {
+            fx[i] = std::lround(t[i].x * goob::subpixel_scale);
+            fy[i] = std::lround(t[i].y * goob::subpixel_scale);
+        }
+        const std::int64_t area = (fx[1] - fx[0]) * (fy[2] - fy[0]) - (fy[1] - fy[0]) * (fx[2] - fx[0]);
+        return cull.mode == goob::CullMode::none || (cull.mode == goob::CullMode::back ? area > 0 : area < 0);
+    }
+
+    std::vector<goob::ScreenTriangle> random_triangles(std::size_t count) {
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> position(-40.0f, 140.0f);
+        std::uniform_real_distribution<float> offset(-1.5f, 1.5f);
+        std::uniform_int_distribution<int> kind(0, 5);
+        std::vector<goob::ScreenTriangle> triangles;
+        for (std::size_t i = 0; i < count; ++i) {
+            const linalg::vec<float,2> p = {position(rng), position(rng)};
+            goob::ScreenTriangle t;
+            switch (kind(rng)) {
+                case 0:     // large
+                    t = {{{p, 0.5f, 1}, {position(rng), position(rng), 0.5f, 1}, {position(rng), position(rng), 0.5f, 1}}};
+                    break;
+                case 1:     // degenerate
+                    t = {{{p, 0.5f, 1}, {p.x + 3, p.y + 3, 0.5f, 1}, {p.x + 6, p.y + 6, 0.5f, 1}}};
+                    break;
+                case 2:     // vertices on subpixel halves, where rounding direction matters
+                    t = {{{std::floor(p.x) + 1.0f / 32, std::floor(p.y) + 0.5f + 1.0f / 32, 0.5f, 1},
+                          {std::floor(p.x) - 1.0f / 32, std::floor(p.y) + 0.5f + 3.0f / 32, 0.5f, 1},
+                          {std::floor(p.x) + 0.5f - 1.0f / 32, std::floor(p.y) + 1.0f / 32, 0.5f, 1}}};
+                    break;
+                case 3:     // out of the rasterizer's range
+                    t = {{{p, 0.5f, 1}, {1e6f, p.y, 0.5f, 1}, {p.x, p.y + 10, 0.5f, 1}}};
+                    break;
+                default:    // sub-pixel to a few pixels
+                    t = {{{p, 0.5f, 1}, {p.x + offset(rng), p.y + offset(rng), 0.5f, 1}, {p.x + offset(rng), p.y + offset(rng), 0.5f, 1}}};
+                    break;
+            }
+            triangles.push_back(t);
+        }
+        return triangles;
+    }
+}
+
+TEST_CASE( "Cull kernels agree with triangle setup", "[culling]" ) {
+    REQUIRE((goob::cull_kernel().level == goob::simd_level() || goob::simd_level() == goob::SimdLevel::sse2));
+    const std::vector<goob::ScreenTriangle> triangles = random_triangles(64 * 40 + 13);
+
+    for (goob::SimdLevel level : {goob::SimdLevel::scalar, goob::SimdLevel::sse2, goob::SimdLevel::avx2, goob::SimdLevel::avx512}) {
+        const goob::CullKernel * kernel = goob::cull_kernel(level);
+        if (!kernel) {
+            continue;
+        }
+        INFO(goob::to_string(level));
+        for (int margin : {0, 6}) {
+        for (goob::CullMode mode : {goob::CullMode::none, goob::CullMode::back, goob::CullMode::front}) {
+            const goob::CullSetup cull = {100, 80, mode, margin};
+            for (std::size_t first = 0; first < triangles.size(); first += 64) {
+                const std::size_t count = std::min<std::size_t>(64, triangles.size() - first);
+                const std::uint64_t mask = kernel->batch(&triangles[first], count, cull);
+                for (std::size_t i = 0; i < 64; ++i) {
+                    const bool expected = i < count && reference_visible(triangles[first + i], cull);
+                    REQUIRE(((mask >> i & 1) != 0) == expected);
+                }
+            }
+        }
+        }
+    }
+}
+
+TEST_CASE( "Rasterizer culls back faces and counts rejected triangles", "[culling]" ) {
+    goob::ThreadPool pool(2);
+    goob::Rasterizer rasterizer(pool);
+    goob::Framebuffer fb(32, 32);
+
+    // Counter-clockwise with NDC y up is clockwise in window coordinates
+    const goob::ScreenTriangle front = {{{0, 0, 0.5f, 1}, {32, 0, 0.5f, 1}, {0, 32, 0.5f, 1}}};
+    const goob::ScreenTriangle back = {{{0, 0, 0.5f, 1}, {0, 32, 0.5f, 1}, {32, 32, 0.5f, 1}}};
+    const goob::ScreenTriangle tiny = {{{4.6f, 4.6f, 0.5f, 1}, {4.9f, 4.6f, 0.5f, 1}, {4.6f, 4.9f, 0.5f, 1}}};
+    const goob::ScreenTriangle triangles[] = {front, back, tiny};
+    const auto shade = [](std::uint32_t triangle, const linalg::vec<float,3> &) { return triangle + 1; };
+
+    rasterizer.draw(triangles, fb, shade);
+    REQUIRE(rasterizer.stats().triangles_culled == 1);
+    REQUIRE(fb.color_at(2, 30) == 2u);
+
+    fb.clear();
+    rasterizer.reset_stats();
+    rasterizer.set_cull_mode(goob::CullMode::back);
+    rasterizer.draw(triangles, fb, shade);
+    REQUIRE(rasterizer.stats().triangles_culled == 2);
+    REQUIRE(fb.color_at(2, 2) == 1u);
+    REQUIRE(fb.color_at(30, 30) == 0u);
+}
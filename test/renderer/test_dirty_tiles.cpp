@@ -0,0 +1,167 @@
+#include "dirty_tiles.hpp"
+#include "multisample.hpp"
+#include "pipeline.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    struct ColorVertex {
+        linalg::vec<float,3> position;
+        linalg::vec<float,3> color;
+    };
+
+    // Draws the square below at `offset`
+    struct ObjectShader {
+        using Vertex = ColorVertex;
+        using Varyings = linalg::vec<float,3>;
+
+        linalg::mat<float,4,4> view_projection;
+        linalg::vec<float,3> offset;
+
+        linalg::vec<float,4> vertex(const Vertex & v, Varyings & out) const {
+            out = v.color;
+            return linalg::mul(view_projection, linalg::vec<float,4>(v.position + offset, 1.0f));
+        }
+        linalg::vec<float,4> fragment(const Varyings & color) const { return {color, 1.0f}; }
+    };
+
+    constexpr float half_side = 0.3f;
+
+    const std::vector<ColorVertex> square = {
+        {{-half_side, -half_side, 0}, {1, 0, 0}}, {{half_side, -half_side, 0}, {0, 1, 0}}, {{half_side, half_side, 0}, {0, 0, 1}},
+        {{-half_side, -half_side, 0}, {1, 0, 0}}, {{half_side, half_side, 0}, {0, 0, 1}}, {{-half_side, half_side, 0}, {1, 1, 0}},
+    };
+
+    linalg::mat<float,4,4> camera(int width, int height) {
+        return linalg::mul(linalg::perspective_matrix(1.0f, static_cast<float>(width) / height, 0.1f, 10.0f),
+                           linalg::lookat_matrix(linalg::vec<float,3>{0, 0, 3}, linalg::vec<float,3>{0, 0, 0}, linalg::vec<float,3>{0, 1, 0}));
+    }
+
+    // Clears `target`, or its dirty tiles, and draws the objects that may touch them; returns the number of draws
+    template<class Target>
+    int draw_scene(goob::Pipeline<ObjectShader> & pipeline, Target & target, const std::vector<linalg::vec<float,3>> & objects,
+                   const goob::DirtyTiles * dirty) {
+        const linalg::mat<float,4,4> view_projection = camera(target.width(), target.height());
+        if (dirty) {
+            target.clear(*dirty, 0xff202020u);
+        } else {
+            target.clear(0xff202020u);
+        }
+        pipeline.set_dirty_tiles(dirty);
+        int draws = 0;
+        for (const linalg::vec<float,3> & offset : objects) {
+            const linalg::vec<float,3> extent(half_side, half_side, 0);
+            if (!dirty || dirty->overlaps(offset - extent, offset + extent, view_projection)) {
+                pipeline.draw(ObjectShader{view_projection, offset}, square, target);
+                ++draws;
+            }
+        }
+        return draws;
+    }
+}
+
+TEST_CASE( "Dirty tiles mark rectangles clipped to the screen", "[dirty_tiles]" ) {
+    goob::DirtyTiles tiles(200, 130);
+    REQUIRE(tiles.tiles_x() == 4);
+    REQUIRE(tiles.tiles_y() == 3);
+    REQUIRE(tiles.count() == 12);
+
+    tiles.clear();
+    REQUIRE(tiles.count() == 0);
+    tiles.mark(60, 10, 70, 64);
+    REQUIRE(tiles.count() == 4);
+    REQUIRE(tiles.dirty(0, 0));
+    REQUIRE(tiles.dirty(1, 1));
+    REQUIRE(!tiles.dirty(2, 0));
+
+    tiles.mark(-100, 128, 1000, 1000);
+    REQUIRE(tiles.count() == 8);
+    tiles.mark(300, 0, 400, 50);
+    REQUIRE(tiles.count() == 8);
+    tiles.mark_all();
+    REQUIRE(tiles.count() == 12);
+
+    REQUIRE_THROWS_AS(goob::DirtyTiles(0, 10), std::invalid_argument);
+}
+
+TEST_CASE( "Dirty tiles mark the screen bounds of boxes", "[dirty_tiles]" ) {
+    goob::DirtyTiles tiles(256, 256);
+    tiles.clear();
+    const linalg::mat<float,4,4> identity = linalg::identity;
+
+    // NDC [-0.1, 0.1] is pixels 115.2 .. 140.8, across the four middle tiles
+    tiles.mark(linalg::vec<float,3>(-0.1f), linalg::vec<float,3>(0.1f), identity);
+    REQUIRE(tiles.count() == 4);
+    REQUIRE(tiles.dirty(1, 1));
+    REQUIRE(tiles.dirty(2, 2));
+    REQUIRE(tiles.overlaps(linalg::vec<float,3>(-0.5f, -0.5f, 0), linalg::vec<float,3>(-0.4f, -0.4f, 0), identity));
+    REQUIRE(!tiles.overlaps(linalg::vec<float,3>(-0.9f, -0.9f, 0), linalg::vec<float,3>(-0.8f, -0.8f, 0), identity));
+    REQUIRE(!tiles.overlaps(linalg::vec<float,3>(2, 2, 0), linalg::vec<float,3>(3, 3, 0), identity));
+
+    // Boxes reaching behind the eye mark everything
+    const linalg::mat<float,4,4> projection = linalg::perspective_matrix(1.0f, 1.0f, 0.1f, 10.0f);
+    tiles.mark(linalg::vec<float,3>(-0.1f, -0.1f, -1), linalg::vec<float,3>(0.1f, 0.1f, 1), projection);
+    REQUIRE(tiles.count() == 16);
+}
+
+TEST_CASE( "Incremental frames match full redraws", "[dirty_tiles]" ) {
+    goob::ThreadPool pool(3);
+    goob::Pipeline<ObjectShader> pipeline(pool);
+    constexpr int width = 300, height = 220;
+
+    // Overlapping squares at different depths
+    std::vector<linalg::vec<float,3>> objects;
+    for (int i = 0; i < 6; ++i) {
+        objects.push_back({-1.6f + 0.55f * i, -0.9f + 0.3f * i, -0.1f * i});
+    }
+    const linalg::mat<float,4,4> view_projection = camera(width, height);
+    const linalg::vec<float,3> extent(half_side, half_side, 0);
+
+    for (goob::SurfaceLayout layout : {goob::SurfaceLayout::linear, goob::SurfaceLayout::morton}) {
+        goob::Framebuffer incremental(width, height, layout);
+        goob::MultisampleFramebuffer incremental_msaa(width, height, 4, layout);
+        goob::DirtyTiles dirty(width, height);
+        REQUIRE(draw_scene(pipeline, incremental, objects, &dirty) == 6);
+        REQUIRE(draw_scene(pipeline, incremental_msaa, objects, &dirty) == 6);
+
+        // Move one object: its old and new bounds are dirty
+        std::vector<linalg::vec<float,3>> moved = objects;
+        moved[2] += linalg::vec<float,3>(0.07f, 0.1f, 0.3f);
+        dirty.clear();
+        dirty.mark(objects[2] - extent, objects[2] + extent, view_projection);
+        dirty.mark(moved[2] - extent, moved[2] + extent, view_projection);
+        REQUIRE(dirty.count() < dirty.tile_count());
+
+        REQUIRE(draw_scene(pipeline, incremental, moved, &dirty) < 6);
+        for (std::size_t tile = 0; tile < pipeline.rasterizer().tile_count(); ++tile) {
+            if (!dirty.dirty(tile)) {
+                REQUIRE(pipeline.rasterizer().binned_count(tile) == 0);
+            }
+        }
+        draw_scene(pipeline, incremental_msaa, moved, &dirty);
+
+        goob::Framebuffer full(width, height, layout);
+        goob::MultisampleFramebuffer full_msaa(width, height, 4, layout);
+        draw_scene(pipeline, full, moved, nullptr);
+        draw_scene(pipeline, full_msaa, moved, nullptr);
+
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                REQUIRE(incremental.color_at(x, y) == full.color_at(x, y));
+                REQUIRE(incremental.depth_at(x, y) == full.depth_at(x, y));
+                for (int s = 0; s < 4; ++s) {
+                    REQUIRE(incremental_msaa.sample_color(x, y, s) == full_msaa.sample_color(x, y, s));
+                    REQUIRE(incremental_msaa.sample_depth(x, y, s) == full_msaa.sample_depth(x, y, s));
+                }
+            }
+        }
+    }
+
+    goob::Framebuffer other(64, 64);
+    goob::DirtyTiles mismatched(32, 32);
+    REQUIRE_THROWS_AS(other.clear(mismatched), std::invalid_argument);
+    pipeline.set_dirty_tiles(&mismatched);
+    REQUIRE_THROWS_AS(pipeline.draw(ObjectShader{camera(64, 64), {0, 0, 0}}, square, other), std::invalid_argument);
+}
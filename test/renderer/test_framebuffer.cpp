@@ -0,0 +1,88 @@
+#include "framebuffer.hpp"
+#include "rasterizer.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <set>
+
+namespace {
+    constexpr goob::SurfaceLayout layouts[] = {goob::SurfaceLayout::linear, goob::SurfaceLayout::tiled, goob::SurfaceLayout::morton};
+}
+
+TEST_CASE( "Every layout maps pixels to distinct offsets", "[framebuffer]" ) {
+    for (goob::SurfaceLayout layout : layouts) {
+        goob::Framebuffer fb(100, 70, layout);
+        std::set<std::size_t> offsets;
+        for (int y = 0; y < fb.height(); ++y) {
+            for (int x = 0; x < fb.width(); ++x) {
+                offsets.insert(fb.index(x, y));
+            }
+        }
+        REQUIRE(offsets.size() == 100u * 70u);
+    }
+}
+
+TEST_CASE( "Blocked layouts keep an 8x8 block contiguous", "[framebuffer]" ) {
+    for (goob::SurfaceLayout layout : {goob::SurfaceLayout::tiled, goob::SurfaceLayout::morton}) {
+        goob::Framebuffer fb(128, 128, layout);
+        const std::size_t base = fb.block_offset(72, 16);
+        std::set<std::size_t> offsets;
+        for (int bit = 0; bit < 64; ++bit) {
+            offsets.insert(base + fb.block_pixel_offset(bit));
+        }
+        REQUIRE(*offsets.begin() == base);
+        REQUIRE(*offsets.rbegin() == base + 63);
+    }
+    REQUIRE(goob::Framebuffer::morton_interleave(0b101, 0b011) == 0b011011u);
+}
+
+TEST_CASE( "Resolve matches a linear render of the same scene", "[framebuffer]" ) {
+    goob::ThreadPool pool(3);
+    goob::Rasterizer rasterizer(pool);
+    const goob::ScreenTriangle triangles[] = {
+        {goob::ScreenVertex{3, 2, 0.5f, 1}, {141, 20, 0.2f, 1}, {40, 97, 0.8f, 1}},
+        {goob::ScreenVertex{150, 0, 0.3f, 1}, {150, 99, 0.3f, 1}, {10, 60, 0.6f, 1}},
+    };
+    const auto shade = [](std::uint32_t triangle, const linalg::vec<float,3> & bary) {
+        return goob::pack_color({bary.x, bary.y, float(triangle), 1.0f});
+    };
+
+    goob::Framebuffer reference(150, 99);
+    reference.clear(0xff000000u);
+    rasterizer.draw(triangles, reference, shade);
+    std::vector<std::uint32_t> expected(150 * 99);
+    reference.resolve_color(expected);
+
+    for (goob::SurfaceLayout layout : layouts) {
+        goob::Framebuffer fb(150, 99, layout);
+        fb.clear(0xff000000u);
+        rasterizer.draw(triangles, fb, shade);
+
+        std::vector<std::uint32_t> colors(150 * 99);
+        fb.resolve_color(colors, &pool);
+        REQUIRE(colors == expected);
+
+        std::vector<float> depth(150 * 99);
+        fb.resolve_depth(depth);
+        REQUIRE(depth[40 * 150 + 60] == fb.depth_at(60, 40));
+
+        std::vector<std::uint32_t> scratch;
+        const goob::ImageView view = fb.color_view(scratch, &pool);
+        REQUIRE(view.width() == 150);
+        REQUIRE(view.bgra(17, 31) == linalg::vec<std::uint8_t,4>(reinterpret_cast<const std::uint8_t *>(&expected[31 * 150 + 17])));
+        REQUIRE(scratch.empty() == (layout == goob::SurfaceLayout::linear));
+    }
+}
+
+TEST_CASE( "Depth bounds follow the depth buffer", "[framebuffer]" ) {
+    goob::Framebuffer fb(20, 12, goob::SurfaceLayout::tiled);
+    fb.clear(0, 0.75f);
+    REQUIRE(fb.depth_bounds(16, 8).min == 0.75f);
+    REQUIRE(fb.depth_bounds(16, 8).max == 0.75f);
+
+    // Only pixels inside the image count for the partial block at the corner
+    fb.depth()[fb.index(17, 9)] = 0.25f;
+    fb.update_depth_bounds();
+    REQUIRE(fb.depth_bounds(16, 8).min == 0.25f);
+    REQUIRE(fb.depth_bounds(16, 8).max == 0.75f);
+    REQUIRE(fb.depth_bounds(8, 8).min == 0.75f);
+}
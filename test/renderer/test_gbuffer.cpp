@@ -0,0 +1,74 @@
+#include "gbuffer.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <atomic>
+#include <cmath>
+
+TEST_CASE( "Octahedral normals round-trip within 16-bit precision", "[gbuffer]" ) {
+    for (int i = 0; i < 2000; ++i) {
+        // Fibonacci sphere, covering both hemispheres and the folded corners
+        const float z = 1.0f - 2.0f * (i + 0.5f) / 2000.0f;
+        const float r = std::sqrt(1.0f - z * z), phi = 2.399963f * i;
+        const linalg::vec<float,3> n(r * std::cos(phi), r * std::sin(phi), z);
+        const linalg::vec<float,3> decoded = goob::decode_normal(goob::encode_normal(n * 3.0f));
+        REQUIRE(linalg::length(decoded) == Catch::Approx(1.0f).margin(1e-5));
+        REQUIRE(linalg::dot(decoded, n) > 0.99999f);
+    }
+    for (const linalg::vec<float,3> axis : {linalg::vec<float,3>(1, 0, 0), linalg::vec<float,3>(0, -1, 0), linalg::vec<float,3>(0, 0, -1)}) {
+        REQUIRE(linalg::dot(goob::decode_normal(goob::encode_normal(axis)), axis) == Catch::Approx(1.0f));
+    }
+    REQUIRE(goob::decode_normal(goob::encode_normal({0, 0, 0})).z == Catch::Approx(1.0f));
+}
+
+TEST_CASE( "Surfaces pack into 8 bytes", "[gbuffer]" ) {
+    static_assert(sizeof(goob::GBufferTexel) == 8);
+    const goob::Surface surface{{0, 1, 0}, {1.0f, 0.5f, 0.0f}, 42};
+    const goob::Surface unpacked = goob::unpack_surface(goob::pack_surface(surface));
+    REQUIRE(unpacked.normal.y == Catch::Approx(1.0f));
+    REQUIRE(unpacked.albedo.x == Catch::Approx(1.0f));
+    REQUIRE(unpacked.albedo.y == Catch::Approx(0.5f).margin(1.0 / 255));
+    REQUIRE(unpacked.albedo.z == 0.0f);
+    REQUIRE(unpacked.material == 42);
+}
+
+TEST_CASE( "Lighting runs once per covered pixel in every layout", "[gbuffer]" ) {
+    goob::ThreadPool pool(3);
+    for (goob::SurfaceLayout layout : {goob::SurfaceLayout::linear, goob::SurfaceLayout::tiled, goob::SurfaceLayout::morton}) {
+        goob::GBuffer gbuffer(100, 70, layout);
+        gbuffer.clear(0xff000000u, 1.0f);
+
+        // Cover a rectangle by hand: depth, bounds and a material id encoding the column
+        for (int y = 10; y < 50; ++y) {
+            for (int x = 20; x < 90; ++x) {
+                const std::size_t pixel = gbuffer.target().index(x, y);
+                gbuffer.target().depth()[pixel] = 0.5f;
+                gbuffer.texels()[pixel] = goob::pack_surface({{0, 0, 1}, {1, 1, 1}, static_cast<std::uint8_t>(x)});
+            }
+        }
+        gbuffer.target().update_depth_bounds();
+
+        std::atomic<int> calls = 0;
+        gbuffer.light([&](const goob::GBufferSample & sample) -> std::uint32_t {
+            ++calls;
+            return sample.surface.material == sample.x && sample.depth == 0.5f ? 0xffffffffu : 0xff0000ffu;
+        }, &pool);
+
+        REQUIRE(calls == 40 * 70);
+        REQUIRE(gbuffer.covered(20, 10));
+        REQUIRE(!gbuffer.covered(19, 10));
+        REQUIRE(gbuffer.target().color_at(20, 10) == 0xffffffffu);
+        REQUIRE(gbuffer.target().color_at(89, 49) == 0xffffffffu);
+        REQUIRE(gbuffer.target().color_at(90, 49) == 0xff000000u);
+        REQUIRE(gbuffer.target().color_at(5, 5) == 0xff000000u);
+    }
+}
+
+TEST_CASE( "Clearing sets the depth that tells covered pixels apart", "[gbuffer]" ) {
+    goob::GBuffer gbuffer(16, 16);
+    gbuffer.clear(0, 0.75f);
+    REQUIRE(gbuffer.clear_depth() == 0.75f);
+    REQUIRE(!gbuffer.covered(3, 3));
+    gbuffer.target().depth()[gbuffer.target().index(3, 3)] = 0.5f;
+    REQUIRE(gbuffer.covered(3, 3));
+}
@@ -0,0 +1,166 @@
+#include "multisample.hpp"
+#include "pipeline.hpp"
+#include "rasterizer.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    goob::ScreenVertex v(float x, float y, float z = 0.5f) {
+        return {x, y, z, 1.0f};
+    }
+
+    struct ColorVertex {
+        linalg::vec<float,4> position;
+        linalg::vec<float,3> color;
+    };
+
+    struct ColorShader {
+        using Vertex = ColorVertex;
+        using Varyings = linalg::vec<float,3>;
+
+        linalg::vec<float,4> vertex(const Vertex & v, Varyings & out) const {
+            out = v.color;
+            return v.position;
+        }
+        linalg::vec<float,4> fragment(const Varyings & color) const {
+            return {color, 1.0f};
+        }
+    };
+}
+
+TEST_CASE( "Sample patterns are the standard 2x, 4x and 8x ones", "[multisample]" ) {
+    REQUIRE(goob::sample_positions(2).size() == 2);
+    REQUIRE(goob::sample_positions(4).size() == 4);
+    REQUIRE(goob::sample_positions(8).size() == 8);
+    REQUIRE(goob::sample_margin(2) == 4);
+    REQUIRE(goob::sample_margin(4) == 6);
+    REQUIRE(goob::sample_margin(8) == 7);
+    REQUIRE_THROWS_AS(goob::sample_positions(3), std::invalid_argument);
+    REQUIRE_THROWS_AS(goob::MultisampleFramebuffer(8, 8, 16), std::invalid_argument);
+}
+
+TEST_CASE( "Edges cover a fraction of the samples and interior pixels stay compressed", "[multisample]" ) {
+    goob::ThreadPool pool(3);
+    goob::Rasterizer rasterizer(pool);
+
+    // One triangle covering every pixel left of the vertical edge x = 10.5, which runs through the centers of column 10
+    const goob::ScreenTriangle triangles[] = {{v(10.5f, -100), v(10.5f, 200), v(-200, 50)}};
+
+    for (int samples : {2, 4, 8}) {
+        for (goob::SurfaceLayout layout : {goob::SurfaceLayout::linear, goob::SurfaceLayout::tiled}) {
+            goob::MultisampleFramebuffer fb(100, 70, samples, layout);
+            std::atomic<int> fragments = 0;
+            rasterizer.draw(triangles, fb, [&](std::uint32_t, const linalg::vec<float,3> &) {
+                ++fragments;
+                return 0xffffffffu;
+            });
+            REQUIRE(fragments == 11 * 70);
+            REQUIRE(fb.expanded_pixels() == 70);
+
+            for (int y = 0; y < 70; ++y) {
+                REQUIRE(fb.uniform(9, y));
+                REQUIRE(fb.sample_color(9, y, samples - 1) == 0xffffffffu);
+                REQUIRE(!fb.uniform(10, y));
+                REQUIRE(fb.uniform(11, y));
+                // Samples left of the center are inside
+                for (int s = 0; s < samples; ++s) {
+                    const bool inside = fb.positions()[s].x < 0;
+                    REQUIRE(fb.sample_color(10, y, s) == (inside ? 0xffffffffu : 0u));
+                    REQUIRE((fb.sample_depth(10, y, s) < 1.0f) == inside);
+                }
+            }
+
+            // Half of the samples of column 10 are inside for every pattern
+            std::vector<std::uint32_t> resolved(100 * 70);
+            fb.resolve_color(resolved, &pool);
+            for (int y = 0; y < 70; ++y) {
+                REQUIRE(resolved[y * 100 + 9] == 0xffffffffu);
+                REQUIRE(resolved[y * 100 + 10] == 0x80808080u);
+                REQUIRE(resolved[y * 100 + 11] == 0u);
+            }
+
+            // Clearing makes every pixel uniform again and reuses the expanded blocks
+            fb.clear(0xff000000u);
+            REQUIRE(fb.expanded_pixels() == 0);
+            REQUIRE(fb.sample_color(10, 5, 0) == 0xff000000u);
+            REQUIRE(fb.sample_depth(10, 5, 0) == 1.0f);
+        }
+    }
+}
+
+TEST_CASE( "Triangles between pixel centers are kept when they cover a sample", "[multisample]" ) {
+    goob::ThreadPool pool(2);
+    goob::Rasterizer rasterizer(pool);
+    goob::MultisampleFramebuffer fb(16, 16, 4);
+
+    // Covers sample 1 of pixel (5,5) at (5.875, 5.375) but no pixel center
+    const goob::ScreenTriangle triangles[] = {{v(5.7f, 5.2f), v(6.1f, 5.2f), v(5.7f, 5.6f)}};
+    std::atomic<int> fragments = 0;
+    rasterizer.draw(triangles, fb, [&](std::uint32_t, const linalg::vec<float,3> &) {
+        ++fragments;
+        return 0xffffffffu;
+    });
+
+    REQUIRE(fragments == 1);
+    REQUIRE(rasterizer.stats().triangles_culled == 0);
+    REQUIRE(!fb.uniform(5, 5));
+    for (int s = 0; s < 4; ++s) {
+        REQUIRE(fb.sample_color(5, 5, s) == (s == 1 ? 0xffffffffu : 0u));
+    }
+    REQUIRE(fb.expanded_pixels() == 1);
+}
+
+TEST_CASE( "Multisampled pipeline draws match with and without hierarchical Z", "[multisample]" ) {
+    goob::ThreadPool pool(4);
+    goob::Pipeline<ColorShader> pipeline(pool);
+
+    // Overlapping fans at different depths drawn back to front, then front to back
+    std::vector<ColorVertex> vertices;
+    for (int layer = 0; layer < 6; ++layer) {
+        const float z = 0.9f - 0.3f * layer, shift = 0.15f * layer;
+        vertices.push_back({{-1 + shift, -0.9f, z, 1}, {1, 0, 0.2f * layer}});
+        vertices.push_back({{0.9f, -1 + shift, z, 1}, {0, 1, 0}});
+        vertices.push_back({{-0.4f + shift, 0.95f, z, 1}, {0, 0, 1}});
+    }
+    for (int layer = 5; layer >= 0; --layer) {
+        for (int i = 0; i < 3; ++i) {
+            ColorVertex vertex = vertices[layer * 3 + i];
+            vertex.position.z += 0.05f;
+            vertices.push_back(vertex);
+        }
+    }
+
+    goob::MultisampleFramebuffer with_hiz(130, 90, 4, goob::SurfaceLayout::morton);
+    pipeline.draw(ColorShader{}, vertices, with_hiz);
+    const std::uint64_t blocks_culled = pipeline.rasterizer().stats().blocks_culled;
+    REQUIRE(blocks_culled > 0);
+
+    pipeline.rasterizer().set_hierarchical_z(false);
+    goob::MultisampleFramebuffer without_hiz(130, 90, 4, goob::SurfaceLayout::morton);
+    pipeline.draw(ColorShader{}, vertices, without_hiz);
+    REQUIRE(pipeline.rasterizer().stats().blocks_culled == blocks_culled);
+
+    for (int y = 0; y < 90; ++y) {
+        for (int x = 0; x < 130; ++x) {
+            REQUIRE(with_hiz.uniform(x, y) == without_hiz.uniform(x, y));
+            for (int s = 0; s < 4; ++s) {
+                REQUIRE(with_hiz.sample_color(x, y, s) == without_hiz.sample_color(x, y, s));
+                REQUIRE(with_hiz.sample_depth(x, y, s) == without_hiz.sample_depth(x, y, s));
+            }
+        }
+    }
+    // Only pixels along edges store their samples
+    REQUIRE(with_hiz.expanded_pixels() > 0);
+    REQUIRE(with_hiz.expanded_pixels() < 130 * 90 / 4);
+
+    std::vector<std::uint32_t> resolved(130 * 90);
+    with_hiz.resolve_color(resolved);
+    const goob::TGAImage image = with_hiz.resolve(&pool);
+    REQUIRE(image.width() == 130);
+    REQUIRE(image.height() == 90);
+    REQUIRE(std::memcmp(image.view().row(0), resolved.data(), resolved.size() * 4) == 0);
+}
@@ -0,0 +1,313 @@
+#include "pipeline.hpp"
+#include "counting_allocator.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    struct ColorVertex {
+        linalg::vec<float,3> position;
+        linalg::vec<float,3> color;
+    };
+
+    // Passes clip-space positions through and interpolates a color
+    struct ColorShader {
+        using Vertex = ColorVertex;
+        using Varyings = linalg::vec<float,3>;
+
+        std::atomic<int> * vertex_calls = nullptr;
+
+        linalg::vec<float,4> vertex(const Vertex & v, Varyings & out) const {
+            if (vertex_calls) {
+                ++*vertex_calls;
+            }
+            out = v.color;
+            return {v.position, 1.0f};
+        }
+        linalg::vec<float,4> fragment(const Varyings & color) const { return {color, 1.0f}; }
+    };
+
+    // Matrix varyings and a packed color result
+    struct MatrixShader {
+        using Vertex = linalg::vec<float,4>;
+        using Varyings = linalg::mat<float,2,2>;
+
+        linalg::vec<float,4> vertex(const Vertex & v, Varyings & out) const {
+            out = {{v.x, 0}, {0, 1}};
+            return v;
+        }
+        std::uint32_t fragment(const Varyings &) const { return 0xff00ff00u; }
+    };
+
+    struct NoFragment {
+        using Vertex = linalg::vec<float,4>;
+        using Varyings = linalg::vec<float,2>;
+        linalg::vec<float,4> vertex(const Vertex & v, Varyings &) const { return v; }
+    };
+
+    struct IntegerVaryings {
+        using Vertex = linalg::vec<float,4>;
+        using Varyings = linalg::vec<int,2>;
+        linalg::vec<float,4> vertex(const Vertex & v, Varyings &) const { return v; }
+        std::uint32_t fragment(const Varyings &) const { return 0; }
+    };
+}
+
+static_assert(goob::Shader<ColorShader>);
+static_assert(goob::Shader<MatrixShader>);
+static_assert(!goob::Shader<NoFragment>);
+static_assert(!goob::Shader<IntegerVaryings>);
+
+TEST_CASE( "Indexed quad interpolates vertex colors", "[pipeline]" ) {
+    goob::ThreadPool pool(3);
+    goob::Pipeline<ColorShader> pipeline(pool);
+    goob::Framebuffer fb(64, 64);
+
+    const ColorVertex vertices[] = {
+        {{-1, -1, 0}, {1, 0, 0}},
+        {{ 1, -1, 0}, {0, 1, 0}},
+        {{ 1,  1, 0}, {0, 0, 1}},
+        {{-1,  1, 0}, {0, 0, 0}},
+    };
+    const std::uint32_t indices[] = {0, 1, 2, 0, 2, 3};
+
+    std::atomic<int> calls = 0;
+    pipeline.draw(ColorShader{&calls}, vertices, indices, fb);
+    REQUIRE(calls == 4);
+
+    // NDC y points up, so the first vertex is the bottom-left pixel
+    const linalg::vec<float,4> bottom_left = goob::unpack_color(fb.color_at(0, 63));
+    const linalg::vec<float,4> top_right = goob::unpack_color(fb.color_at(63, 0));
+    REQUIRE(bottom_left.x > 0.95f);
+    REQUIRE(top_right.z > 0.95f);
+    REQUIRE(fb.depth_at(10, 10) == Catch::Approx(0.5f));
+
+    REQUIRE_THROWS_AS(pipeline.draw(ColorShader{}, vertices, std::span<const std::uint32_t>(std::array<std::uint32_t,3>{0, 1, 4}), fb),
+                      std::out_of_range);
+}
+
+TEST_CASE( "Indexed draws shade referenced vertices once per batch", "[pipeline]" ) {
+    goob::ThreadPool pool(4);
+    goob::Pipeline<ColorShader> pipeline(pool);
+    goob::Framebuffer fb(64, 64);
+
+    // A strip of 4000 triangles over 2002 vertices, plus vertices no triangle uses
+    std::vector<ColorVertex> vertices;
+    for (int i = 0; i < 1001; ++i) {
+        const float x = -1.0f + 2.0f * i / 1000.0f;
+        vertices.push_back({{x, -1, 0}, {1, 1, 1}});
+        vertices.push_back({{x, 1, 0}, {1, 1, 1}});
+    }
+    vertices.resize(vertices.size() + 500, {{0, 0, 0}, {1, 0, 0}});
+    std::vector<std::uint32_t> indices;
+    for (std::uint32_t i = 0; i + 3 < 2002; i += 2) {
+        indices.insert(indices.end(), {i, i + 2, i + 3, i, i + 3, i + 1});
+        indices.insert(indices.end(), {i, i + 2, i + 3, i, i + 3, i + 1});
+    }
+
+    std::atomic<int> calls = 0;
+    pipeline.draw(ColorShader{&calls}, vertices, indices, fb);
+    // Each batch re-shades at most the few vertices it shares with the previous batch
+    const std::size_t batches = (indices.size() / 3 + 511) / 512;
+    REQUIRE(calls >= 2002);
+    REQUIRE(calls <= 2002 + 4 * static_cast<int>(batches));
+    REQUIRE(fb.color_at(32, 32) == 0xffffffffu);
+}
+
+TEST_CASE( "Indexed draws size vertex slots by the mesh, not the index count", "[pipeline]" ) {
+    goob::ThreadPool pool(1);
+    goob::FrameArena arena(pool.size());
+    goob::Pipeline<ColorShader> pipeline(pool, arena);
+    goob::Framebuffer fb(64, 64);
+
+    // One off-screen quad repeated over many batches, so no triangle reaches the rasterizer
+    const std::vector<ColorVertex> vertices = {{{2, -1, 0}, {1, 1, 1}}, {{3, -1, 0}, {1, 1, 1}}, {{2, 1, 0}, {1, 1, 1}}, {{3, 1, 0}, {1, 1, 1}}};
+    std::vector<std::uint32_t> indices;
+    for (int i = 0; i < 5000; ++i) {
+        indices.insert(indices.end(), {0, 1, 3, 0, 3, 2});
+    }
+
+    std::atomic<int> calls = 0;
+    pipeline.draw(ColorShader{&calls}, vertices, indices, fb);
+    const std::size_t batches = (indices.size() / 3 + 511) / 512;
+    REQUIRE(calls == 4 * static_cast<int>(batches));
+    // Triangle lists are reserved per triangle, about 21 bytes per corner with the slot table; shaded vertex
+    // slots sized per corner would add over 40 more
+    REQUIRE(arena.frame().used() < indices.size() * 32);
+    // The vertex cache tables are worker scratch
+    REQUIRE(arena.worker(0).used() >= 2 * 2048 * sizeof(std::uint32_t));
+
+    goob::FrameArena too_few(0);
+    REQUIRE_THROWS_AS(goob::Pipeline<ColorShader>(pool, too_few), std::invalid_argument);
+}
+
+TEST_CASE( "Triangles behind the eye are dropped and depth range is configurable", "[pipeline]" ) {
+    goob::ThreadPool pool(2);
+    goob::Pipeline<MatrixShader> pipeline(pool);
+    goob::Framebuffer fb(16, 16);
+
+    const linalg::vec<float,4> behind[] = {{-1, -1, 0, -1}, {3, -1, 0, -1}, {-1, 3, 0, -1}};
+    pipeline.draw(MatrixShader{}, behind, fb);
+    REQUIRE(pipeline.rasterizer().binned_count(0) == 0);
+    REQUIRE(fb.color_at(8, 8) == 0u);
+
+    const linalg::vec<float,4> covering[] = {{-1, -1, 0.25f, 1}, {3, -1, 0.25f, 1}, {-1, 3, 0.25f, 1}};
+    pipeline.set_depth_range(linalg::zero_to_one);
+    pipeline.draw(MatrixShader{}, covering, fb);
+    REQUIRE(fb.color_at(8, 8) == 0xff00ff00u);
+    REQUIRE(fb.depth_at(8, 8) == Catch::Approx(0.25f));
+}
+
+TEST_CASE( "Triangles crossing the near plane are clipped", "[pipeline]" ) {
+    goob::ThreadPool pool(2);
+    goob::Pipeline<ColorShader> pipeline(pool);
+    goob::Framebuffer fb(16, 16);
+
+    // NDC z = x + y - 1, so the near plane z = -1 cuts along x + y = 0
+    const ColorVertex vertices[] = {{{-1, -1, -3}, {1, 0, 0}}, {{3, -1, 1}, {0, 1, 0}}, {{-1, 3, 1}, {0, 0, 1}}};
+    pipeline.draw(ColorShader{}, vertices, fb);
+    REQUIRE(fb.color_at(0, 15) == 0u);
+
+    // Pixel (15, 0) is at NDC (0.9375, 0.9375); colors interpolate as on the unclipped triangle
+    const linalg::vec<float,4> color = goob::unpack_color(fb.color_at(15, 0));
+    REQUIRE(color.x == Catch::Approx(0.03125f).margin(1.0 / 255));
+    REQUIRE(color.y == Catch::Approx(0.484375f).margin(1.0 / 255));
+    REQUIRE(color.z == Catch::Approx(0.484375f).margin(1.0 / 255));
+    REQUIRE(fb.depth_at(15, 0) == Catch::Approx(0.9375f));
+}
+
+TEST_CASE( "Guard band keeps screen-crossing triangles whole", "[pipeline]" ) {
+    goob::ThreadPool pool(2);
+    goob::Pipeline<ColorShader> pipeline(pool);
+    goob::Framebuffer fb(16, 16);
+
+    // Crosses every side of the viewport but stays inside the guard band: one unsplit triangle
+    const ColorVertex inside[] = {{{-5, -5, 0}, {1, 1, 1}}, {{20, -5, 0}, {1, 1, 1}}, {{-5, 20, 0}, {1, 1, 1}}};
+    pipeline.draw(ColorShader{}, inside, fb);
+    REQUIRE(pipeline.rasterizer().binned_count(0) == 1);
+    REQUIRE(fb.color_at(8, 8) == 0xffffffffu);
+
+    // Beyond the guard band the rasterizer could not represent the vertices; the cut polygon covers the screen
+    fb.clear();
+    const ColorVertex outside[] = {{{-1e5f, -1e5f, 0}, {0, 1, 0}}, {{1e5f, -1e5f, 0}, {0, 1, 0}}, {{0, 1e5f, 0}, {0, 1, 0}}};
+    pipeline.draw(ColorShader{}, outside, fb);
+    REQUIRE(pipeline.rasterizer().binned_count(0) > 1);
+    REQUIRE(fb.color_at(0, 0) == 0xff00ff00u);
+    REQUIRE(fb.color_at(15, 15) == 0xff00ff00u);
+}
+
+TEST_CASE( "Steady-state frames do not allocate", "[pipeline]" ) {
+    goob::ThreadPool pool(4);
+    goob::FrameArena arena(pool.size());
+    goob::Pipeline<ColorShader> pipeline(pool, arena);
+    goob::Framebuffer fb(300, 200, goob::SurfaceLayout::tiled);
+
+    // Enough triangles for several binning chunks
+    std::vector<ColorVertex> vertices;
+    for (int i = 0; i < 3000; ++i) {
+        const float x = -1.0f + 2.0f * (i % 50) / 50.0f, y = -1.0f + 2.0f * (i / 50) / 60.0f;
+        vertices.push_back({{x, y, 0.5f}, {1, 0, 0}});
+        vertices.push_back({{x + 0.1f, y, 0.5f}, {0, 1, 0}});
+        vertices.push_back({{x, y + 0.1f, 0.5f}, {0, 0, 1}});
+    }
+
+    const auto frame = [&] {
+        fb.clear();
+        pipeline.draw(ColorShader{}, vertices, fb);
+        pipeline.draw(ColorShader{}, vertices, fb);
+        arena.reset();
+    };
+    frame();
+    frame();
+
+    heap_allocations = 0;
+    counting_allocations = true;
+    for (int i = 0; i < 5; ++i) {
+        frame();
+    }
+    counting_allocations = false;
+    REQUIRE(heap_allocations == 0);
+    REQUIRE(pipeline.rasterizer().stats().pixels_shaded > 0);
+}
+
+namespace {
+    // Writes the interpolated color as albedo and a constant normal
+    struct SurfaceShader {
+        using Vertex = ColorVertex;
+        using Varyings = linalg::vec<float,3>;
+
+        std::atomic<int> * fragment_calls = nullptr;
+
+        linalg::vec<float,4> vertex(const Vertex & v, Varyings & out) const {
+            out = v.color;
+            return {v.position, 1.0f};
+        }
+        goob::Surface fragment(const Varyings & color) const {
+            ++*fragment_calls;
+            return {{0, 0, 1}, color, 7};
+        }
+    };
+}
+
+static_assert(goob::Shader<SurfaceShader>);
+
+TEST_CASE( "Deferred draws light each visible pixel once", "[pipeline]" ) {
+    goob::ThreadPool pool(3);
+    goob::Pipeline<SurfaceShader> pipeline(pool);
+    goob::GBuffer gbuffer(32, 32, goob::SurfaceLayout::tiled);
+    gbuffer.clear();
+
+    // Back to front: the near triangle overwrites the far one over the screen's lower left half
+    const ColorVertex far[] = {{{-1, -1, 0.5f}, {1, 0, 0}}, {{3, -1, 0.5f}, {1, 0, 0}}, {{-1, 3, 0.5f}, {1, 0, 0}}};
+    const ColorVertex near[] = {{{-1, -1, 0}, {0, 1, 0}}, {{1, -1, 0}, {0, 1, 0}}, {{-1, 1, 0}, {0, 1, 0}}};
+    std::atomic<int> fragments = 0;
+    pipeline.draw(SurfaceShader{&fragments}, far, gbuffer);
+    pipeline.draw(SurfaceShader{&fragments}, near, gbuffer);
+    REQUIRE(fragments > 32 * 32);
+
+    std::atomic<int> lit = 0;
+    gbuffer.light([&](const goob::GBufferSample & sample) {
+        ++lit;
+        const float diffuse = std::max(linalg::dot(sample.surface.normal, linalg::vec<float,3>(0, 0, 1)), 0.0f);
+        return linalg::vec<float,4>(sample.surface.albedo * diffuse, 1.0f);
+    }, &pool);
+    REQUIRE(lit == 32 * 32);
+    REQUIRE(gbuffer.surface_at(0, 31).material == 7);
+    REQUIRE(gbuffer.target().color_at(0, 31) == 0xff00ff00u);
+    REQUIRE(gbuffer.target().color_at(31, 0) == 0xffff0000u);
+}
+
+TEST_CASE( "Draws report stages and counters to a profiler", "[pipeline]" ) {
+    goob::ThreadPool pool(3);
+    goob::Pipeline<ColorShader> pipeline(pool);
+    goob::Framebuffer fb(64, 64);
+    goob::Profiler profiler(pool.size());
+    pipeline.set_profiler(&profiler);
+
+    // A full-screen quad drawn twice: the second pass fails the depth test everywhere
+    const ColorVertex vertices[] = {
+        {{-1, -1, 0}, {1, 0, 0}}, {{1, -1, 0}, {1, 0, 0}}, {{1, 1, 0}, {1, 0, 0}}, {{-1, 1, 0}, {1, 0, 0}},
+    };
+    const std::uint32_t indices[] = {0, 1, 2, 0, 2, 3};
+    profiler.begin_frame();
+    pipeline.draw(ColorShader{}, vertices, indices, fb);
+    pipeline.draw(ColorShader{}, vertices, indices, fb);
+    const goob::FrameStats & stats = profiler.end_frame();
+
+#if GOOB_ENABLE_STATS
+    REQUIRE(stats.count(goob::Counter::vertices_shaded) == 8);
+    REQUIRE(stats.count(goob::Counter::triangles_in) == 4);
+    REQUIRE(stats.count(goob::Counter::fragments_shaded) == 64 * 64);
+    REQUIRE(stats.count(goob::Counter::fragments_killed) == 64 * 64);
+    REQUIRE(stats.time(goob::Stage::raster) > 0);
+    REQUIRE(stats.time(goob::Stage::vertex) > 0);
+#else
+    REQUIRE(stats.count(goob::Counter::fragments_shaded) == 0);
+#endif
+
+    goob::Profiler too_small(1);
+    REQUIRE_THROWS_AS(pipeline.set_profiler(&too_small), std::invalid_argument);
+}
@@ -0,0 +1,138 @@
+#include "rasterizer.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <atomic>
+
+namespace {
+    goob::ScreenVertex v(float x, float y, float z = 0.5f) {
+        return {x, y, z, 1.0f};
+    }
+}
+
+TEST_CASE( "Triangles sharing an edge cover each pixel once", "[rasterizer]" ) {
+    goob::ThreadPool pool(4);
+    goob::Rasterizer rasterizer(pool);
+    goob::Framebuffer fb(200, 150);
+
+    // Second triangle is closer so a double-covered pixel would be shaded twice
+    const goob::ScreenTriangle triangles[] = {
+        {v(0, 0, 0.6f), v(200, 0, 0.6f), v(200, 150, 0.6f)},
+        {v(0, 0, 0.4f), v(200, 150, 0.4f), v(0, 150, 0.4f)},
+    };
+
+    std::atomic<int> fragments = 0;
+    rasterizer.draw(triangles, fb, [&](std::uint32_t, const linalg::vec<float,3> &) {
+        ++fragments;
+        return 0xffffffffu;
+    });
+
+    REQUIRE(fragments == 200 * 150);
+    for (int y = 0; y < fb.height(); ++y) {
+        for (int x = 0; x < fb.width(); ++x) {
+            REQUIRE(fb.color_at(x, y) == 0xffffffffu);
+        }
+    }
+}
+
+TEST_CASE( "Depth test keeps the nearest triangle regardless of order", "[rasterizer]" ) {
+    goob::ThreadPool pool(2);
+    goob::Rasterizer rasterizer(pool);
+    goob::Framebuffer fb(64, 64);
+
+    const goob::ScreenTriangle triangles[] = {
+        {v(0, 0, 0.2f), v(64, 0, 0.2f), v(0, 64, 0.2f)},
+        {v(0, 0, 0.8f), v(64, 0, 0.8f), v(0, 64, 0.8f)},
+    };
+    rasterizer.draw(triangles, fb, [](std::uint32_t triangle, const linalg::vec<float,3> &) {
+        return triangle == 0 ? 0xff0000ffu : 0xffff0000u;
+    });
+
+    REQUIRE(fb.color_at(10, 10) == 0xff0000ffu);
+    REQUIRE(fb.depth_at(10, 10) == Catch::Approx(0.2f));
+    REQUIRE(fb.color_at(60, 60) == 0);
+    REQUIRE(fb.depth_at(60, 60) == 1.0f);
+}
+
+TEST_CASE( "Binning distributes triangles to overlapped tiles", "[rasterizer]" ) {
+    goob::ThreadPool pool(4);
+    goob::Rasterizer rasterizer(pool);
+    goob::Framebuffer fb(256, 192);
+
+    const goob::ScreenTriangle triangles[] = {
+        {v(10, 10), v(20, 10), v(10, 20)},      // tile 0 only
+        {v(10, 10), v(250, 10), v(10, 120)},    // spans the top two tile rows
+    };
+    rasterizer.draw(triangles, fb, [](std::uint32_t, const linalg::vec<float,3> &) { return 1u; });
+
+    REQUIRE(rasterizer.tiles_x() == 4);
+    REQUIRE(rasterizer.tiles_y() == 3);
+    REQUIRE(rasterizer.binned_count(0) == 2);
+    REQUIRE(rasterizer.binned_count(3) == 1);
+    REQUIRE(rasterizer.binned_count(8) == 0);
+}
+
+TEST_CASE( "Parallel rasterization matches single-threaded output", "[rasterizer]" ) {
+    std::vector<goob::ScreenTriangle> triangles;
+    for (int i = 0; i < 2000; ++i) {
+        const float x = float((i * 37) % 300), y = float((i * 91) % 200), z = float(i % 97) / 97.0f;
+        triangles.push_back({v(x, y, z), v(x + 40, y + 5, z), v(x + 7, y + 33, z)});
+    }
+    auto shade = [](std::uint32_t triangle, const linalg::vec<float,3> & bary) {
+        return goob::pack_color({bary.x, bary.y, bary.z, float(triangle % 255) / 255.0f});
+    };
+
+    goob::ThreadPool serial_pool(1), parallel_pool(8);
+    goob::Rasterizer serial(serial_pool), parallel(parallel_pool);
+    goob::Framebuffer a(320, 240), b(320, 240);
+    serial.draw(triangles, a, shade);
+    parallel.draw(triangles, b, shade);
+
+    for (int y = 0; y < a.height(); ++y) {
+        for (int x = 0; x < a.width(); ++x) {
+            REQUIRE(a.color_at(x, y) == b.color_at(x, y));
+            REQUIRE(a.depth_at(x, y) == b.depth_at(x, y));
+        }
+    }
+}
+
+TEST_CASE( "Hierarchical Z culls occluded geometry without changing the image", "[rasterizer]" ) {
+    goob::ThreadPool pool(4);
+    goob::Rasterizer rasterizer(pool);
+
+    // A near occluder over the left half, then many layers of far geometry over the whole target
+    std::vector<goob::ScreenTriangle> triangles = {
+        {v(0, 0, 0.1f), v(96, 0, 0.1f), v(96, 130, 0.1f)},
+        {v(0, 0, 0.1f), v(96, 130, 0.1f), v(0, 130, 0.1f)},
+    };
+    for (int layer = 0; layer < 8; ++layer) {
+        const float z = 0.9f - 0.05f * layer;
+        triangles.push_back({v(0, 0, z), v(190, 0, z + 0.02f), v(190, 130, z)});
+        triangles.push_back({v(0, 0, z), v(190, 130, z), v(0, 130, z + 0.02f)});
+    }
+    const auto shade = [](std::uint32_t triangle, const linalg::vec<float,3> &) { return 0xff000000u | triangle; };
+
+    goob::Framebuffer reference(190, 130), culled(190, 130);
+    rasterizer.set_hierarchical_z(false);
+    rasterizer.draw(triangles, reference, shade);
+    const goob::RasterStats brute = rasterizer.stats();
+    REQUIRE(brute.tiles_culled == 0);
+    REQUIRE(brute.blocks_culled == 0);
+
+    rasterizer.reset_stats();
+    rasterizer.set_hierarchical_z(true);
+    rasterizer.draw(triangles, culled, shade);
+    const goob::RasterStats stats = rasterizer.stats();
+
+    for (int y = 0; y < 130; ++y) {
+        for (int x = 0; x < 190; ++x) {
+            REQUIRE(culled.color_at(x, y) == reference.color_at(x, y));
+            REQUIRE(culled.depth_at(x, y) == reference.depth_at(x, y));
+        }
+    }
+    // The first tile column lies entirely behind the occluder
+    REQUIRE(stats.tiles_culled > 0);
+    REQUIRE(stats.blocks_culled > 0);
+    REQUIRE(stats.pixels_shaded == brute.pixels_shaded);
+    REQUIRE(stats.pixels_depth_failed < brute.pixels_depth_failed);
+}
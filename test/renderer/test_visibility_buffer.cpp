@@ -0,0 +1,114 @@
+#include "pipeline.hpp"
+#include "visibility_buffer.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    struct ColorVertex {
+        linalg::vec<float,4> position;
+        linalg::vec<float,3> color;
+    };
+
+    struct CountingShader {
+        using Vertex = ColorVertex;
+        using Varyings = linalg::vec<float,3>;
+
+        std::atomic<int> * fragment_calls = nullptr;
+
+        linalg::vec<float,4> vertex(const Vertex & v, Varyings & out) const {
+            out = v.color;
+            return v.position;
+        }
+        linalg::vec<float,4> fragment(const Varyings & color) const {
+            if (fragment_calls) {
+                ++*fragment_calls;
+            }
+            return {color, 1.0f};
+        }
+    };
+
+    // Overlapping fans at different depths plus a triangle crossing the near plane
+    std::vector<ColorVertex> scene() {
+        std::vector<ColorVertex> vertices;
+        for (int layer = 0; layer < 4; ++layer) {
+            const float z = 0.8f - 0.3f * layer, shift = 0.2f * layer;
+            vertices.push_back({{-1 + shift, -1, z, 1}, {1, 0, 0.25f * layer}});
+            vertices.push_back({{1, -1 + shift, z, 1}, {0, 1, 0}});
+            vertices.push_back({{-0.5f, 1, z, 1}, {0, 0, 1}});
+        }
+        // Perspective: w differs per corner, and the first corner is behind the near plane
+        vertices.push_back({{-0.4f, -0.4f, -1.5f, 0.5f}, {1, 1, 0}});
+        vertices.push_back({{2.0f, 0.2f, 1.0f, 2.0f}, {0, 1, 1}});
+        vertices.push_back({{0.2f, 2.0f, 1.0f, 2.0f}, {1, 0, 1}});
+        return vertices;
+    }
+}
+
+TEST_CASE( "Resolving the visibility buffer matches forward shading", "[visibility]" ) {
+    goob::ThreadPool pool(3);
+    goob::Pipeline<CountingShader> pipeline(pool);
+    const std::vector<ColorVertex> vertices = scene();
+
+    for (goob::SurfaceLayout layout : {goob::SurfaceLayout::linear, goob::SurfaceLayout::morton}) {
+        goob::Framebuffer forward(96, 80, layout);
+        std::atomic<int> forward_calls = 0;
+        pipeline.draw(CountingShader{&forward_calls}, vertices, forward);
+
+        goob::VisibilityBuffer visibility(96, 80, layout);
+        std::atomic<int> resolve_calls = 0;
+        const CountingShader shader{&resolve_calls};
+        pipeline.draw(shader, vertices, visibility, 0);
+        REQUIRE(resolve_calls == 0);
+        const goob::DrawCall<CountingShader> draws[] = {{&shader, vertices, {}}};
+        pipeline.resolve(draws, visibility);
+
+        int covered = 0;
+        for (int y = 0; y < 80; ++y) {
+            for (int x = 0; x < 96; ++x) {
+                REQUIRE(visibility.target().depth_at(x, y) == forward.depth_at(x, y));
+                if (!visibility.covered(x, y)) {
+                    REQUIRE(visibility.target().color_at(x, y) == 0u);
+                    continue;
+                }
+                ++covered;
+                const linalg::vec<float,4> a = goob::unpack_color(visibility.target().color_at(x, y));
+                const linalg::vec<float,4> b = goob::unpack_color(forward.color_at(x, y));
+                REQUIRE(linalg::maxelem(linalg::abs(a - b)) <= 1.5f / 255);
+            }
+        }
+        // Overdraw costs the forward path fragments but not the resolve
+        REQUIRE(resolve_calls == covered);
+        REQUIRE(forward_calls > covered);
+        REQUIRE(visibility.texel_at(48, 40).instance == 0u);
+    }
+}
+
+TEST_CASE( "Visibility texels identify draw triangles and instances", "[visibility]" ) {
+    goob::ThreadPool pool(2);
+    goob::Pipeline<CountingShader> pipeline(pool);
+    goob::VisibilityBuffer visibility(32, 32, goob::SurfaceLayout::tiled);
+
+    const ColorVertex vertices[] = {
+        {{-1, -1, 0.5f, 1}, {1, 0, 0}}, {{1, -1, 0.5f, 1}, {1, 0, 0}}, {{1, 1, 0.5f, 1}, {1, 0, 0}}, {{-1, 1, 0.5f, 1}, {1, 0, 0}},
+    };
+    const std::uint32_t quad[] = {0, 1, 2, 0, 2, 3};
+    const CountingShader shader;
+    pipeline.draw(shader, vertices, quad, visibility, 5);
+
+    // Triangle 1 covers the upper left half
+    REQUIRE(visibility.texel_at(2, 2).triangle == 1u);
+    REQUIRE(visibility.texel_at(29, 29).triangle == 0u);
+    REQUIRE(visibility.texel_at(2, 2).instance == 5u);
+
+    const goob::DrawCall<CountingShader> too_few[] = {{&shader, vertices, quad}};
+    REQUIRE_THROWS_AS(pipeline.resolve(too_few, visibility), std::out_of_range);
+
+    std::vector<goob::DrawCall<CountingShader>> draws(6, {&shader, vertices, quad});
+    pipeline.resolve(draws, visibility);
+    REQUIRE(visibility.target().color_at(2, 2) == 0xffff0000u);
+    REQUIRE(visibility.target().color_at(29, 29) == 0xffff0000u);
+}
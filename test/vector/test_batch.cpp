@@ -0,0 +1,125 @@
+#include "batch.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    std::vector<linalg::vec<float,3>> random_vectors(std::size_t n, unsigned seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> d(-10.0f, 10.0f);
+        std::vector<linalg::vec<float,3>> v(n);
+        for (auto & x : v) {
+            x = {d(rng), d(rng), d(rng)};
+        }
+        return v;
+    }
+
+    template<int M>
+    void require_near(const linalg::vec<float,M> & a, const linalg::vec<float,M> & b) {
+        for (int c = 0; c < M; ++c) {
+            REQUIRE(a[c] == Catch::Approx(b[c]).margin(1e-4).epsilon(1e-5));
+        }
+    }
+
+    std::vector<const goob::BatchKernels *> available_kernels() {
+        std::vector<const goob::BatchKernels *> kernels;
+        for (goob::SimdLevel level : {goob::SimdLevel::scalar, goob::SimdLevel::sse2, goob::SimdLevel::avx2, goob::SimdLevel::avx512}) {
+            if (const goob::BatchKernels * k = goob::batch_kernels(level)) {
+                kernels.push_back(k);
+            }
+        }
+        return kernels;
+    }
+}
+
+TEST_CASE( "Batch kernels match per-vector linalg", "[batch]" ) {
+    const linalg::mat<float,4,4> m = linalg::mul(linalg::perspective_matrix(1.0f, 1.5f, 0.1f, 100.0f),
+                                                 linalg::pose_matrix(linalg::rotation_quat(linalg::normalize(linalg::vec<float,3>{1, 2, 3}), 0.7f), linalg::vec<float,3>{1, -2, 5}));
+    const linalg::mat<float,3,3> r = linalg::qmat(linalg::rotation_quat(linalg::vec<float,3>{0, 1, 0}, 0.3f));
+
+    // 37 exercises full packs of every width plus a scalar tail
+    const std::size_t n = 37;
+    const auto a = random_vectors(n, 1), b = random_vectors(n, 2);
+    const goob::SoaBuffer<3> sa{std::span<const linalg::vec<float,3>>(a)}, sb{std::span<const linalg::vec<float,3>>(b)};
+
+    for (const goob::BatchKernels * k : available_kernels()) {
+        INFO(goob::to_string(k->level));
+        const float * in_a[3] = {sa.component(0), sa.component(1), sa.component(2)};
+        const float * in_b[3] = {sb.component(0), sb.component(1), sb.component(2)};
+
+        goob::SoaBuffer<4> points(n), transformed(n);
+        float * p[4] = {points.component(0), points.component(1), points.component(2), points.component(3)};
+        k->transform_points(&m.x.x, in_a, p, n);
+        const float * pc[4] = {p[0], p[1], p[2], p[3]};
+        float * t[4] = {transformed.component(0), transformed.component(1), transformed.component(2), transformed.component(3)};
+        k->transform(&m.x.x, pc, t, n);
+
+        goob::SoaBuffer<3> vectors(n), crossed(n), normalized(n);
+        float * v[3] = {vectors.component(0), vectors.component(1), vectors.component(2)};
+        float * c[3] = {crossed.component(0), crossed.component(1), crossed.component(2)};
+        float * u[3] = {normalized.component(0), normalized.component(1), normalized.component(2)};
+        k->transform_vectors(&r.x.x, in_a, v, n);
+        k->cross(in_a, in_b, c, n);
+        k->normalize(in_a, u, n);
+        std::vector<float> dots(n);
+        k->dot(in_a, in_b, dots.data(), n);
+
+        for (std::size_t i = 0; i < n; ++i) {
+            const linalg::vec<float,4> expected = linalg::mul(m, linalg::vec<float,4>{a[i], 1});
+            require_near(points[i], expected);
+            require_near(transformed[i], linalg::mul(m, expected));
+            require_near(vectors[i], linalg::mul(r, a[i]));
+            require_near(crossed[i], linalg::cross(a[i], b[i]));
+            require_near(normalized[i], linalg::normalize(a[i]));
+            REQUIRE(dots[i] == Catch::Approx(linalg::dot(a[i], b[i])).margin(1e-4));
+        }
+    }
+}
+
+TEST_CASE( "Batch API works in place and on AoS arrays", "[batch]" ) {
+    const auto a = random_vectors(1000, 3);
+    goob::SoaBuffer<3> soa{std::span<const linalg::vec<float,3>>(a)};
+    goob::normalize(soa.span(), soa.span());
+    std::vector<float> lengths(soa.size());
+    goob::dot(soa.span(), soa.span(), lengths);
+    for (float l : lengths) {
+        REQUIRE(l == Catch::Approx(1.0f).epsilon(1e-5));
+    }
+
+    const linalg::mat<float,4,4> m = linalg::translation_matrix(linalg::vec<float,3>{1, 2, 3});
+    std::vector<linalg::vec<float,4>> out(a.size());
+    goob::transform_points(m, a, out);
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        require_near(out[i], linalg::vec<float,4>{a[i] + linalg::vec<float,3>{1, 2, 3}, 1});
+    }
+
+    std::vector<linalg::vec<float,3>> back(a.size());
+    goob::SoaBuffer<3>{std::span<const linalg::vec<float,3>>(a)}.copy_to(back);
+    REQUIRE(back == a);
+}
+
+TEST_CASE( "Batch functions reject spans shorter than their input", "[batch]" ) {
+    const auto a = random_vectors(40, 5);
+    const goob::SoaBuffer<3> in{std::span<const linalg::vec<float,3>>(a)};
+    goob::SoaBuffer<3> short3(39);
+    goob::SoaBuffer<4> short4(39);
+    std::vector<float> short_floats(39, -1.0f);
+    const linalg::mat<float,4,4> m = linalg::identity;
+
+    REQUIRE_THROWS_AS(goob::transform_points(m, in.span(), short4.span()), std::invalid_argument);
+    REQUIRE_THROWS_AS(goob::normalize(in.span(), short3.span()), std::invalid_argument);
+    REQUIRE_THROWS_AS(goob::cross(in.span(), short3.span(), goob::SoaBuffer<3>(40).span()), std::invalid_argument);
+    REQUIRE_THROWS_AS(goob::dot(in.span(), in.span(), short_floats), std::invalid_argument);
+    REQUIRE(short_floats[0] == -1.0f);
+
+    std::vector<linalg::vec<float,4>> short_aos(39);
+    REQUIRE_THROWS_AS(goob::transform_points(m, a, short_aos), std::invalid_argument);
+    const std::vector<float> floats(40, 1.0f);
+    std::vector<goob::Half> halves(39);
+    std::vector<goob::Fixed16_16> fixed(39);
+    REQUIRE_THROWS_AS(goob::convert(std::span<const float>(floats), std::span<goob::Half>(halves)), std::invalid_argument);
+    REQUIRE_THROWS_AS(goob::convert(std::span<const float>(floats), std::span<goob::Fixed16_16>(fixed)), std::invalid_argument);
+}
@@ -0,0 +1,178 @@
+#include "batch.hpp"
+#include "packed_scalar.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+    std::vector<const goob::BatchKernels *> available_kernels() {
+        std::vector<const goob::BatchKernels *> kernels;
+        for (goob::SimdLevel level : {goob::SimdLevel::scalar, goob::SimdLevel::sse2, goob::SimdLevel::avx2, goob::SimdLevel::avx512}) {
+            if (const goob::BatchKernels * k = goob::batch_kernels(level)) {
+                kernels.push_back(k);
+            }
+        }
+        return kernels;
+    }
+
+    // Random bit patterns cover every exponent, plus the edge cases of both formats
+    std::vector<float> conversion_inputs() {
+        std::vector<float> v = {0.0f, -0.0f, 1.0f, -1.0f, 0.5f, 1.5f, 2.5f, -2.5f, 65504.0f, 65519.0f, 65520.0f, 1e10f, -1e10f,
+                                0x1p-14f, 0x1p-24f, 0x1p-25f, 0x1.8p-25f, 0x1p-26f, 1e-30f,
+                                std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+                                std::numeric_limits<float>::quiet_NaN(), std::bit_cast<float>(0xffa01234u),
+                                8388607.5f, 2147483520.0f, 2147483648.0f, -2147483648.0f, -3e9f};
+        std::mt19937 rng(7);
+        for (int i = 0; i < 2000; ++i) {
+            v.push_back(std::bit_cast<float>(static_cast<std::uint32_t>(rng())));
+        }
+        std::uniform_real_distribution<float> d(-70000.0f, 70000.0f);
+        for (int i = 0; i < 2000; ++i) {
+            v.push_back(d(rng));
+        }
+        return v;
+    }
+
+    bool same_bits(float a, float b) {
+        return std::bit_cast<std::uint32_t>(a) == std::bit_cast<std::uint32_t>(b);
+    }
+}
+
+TEST_CASE( "Half conversions round to nearest even", "[packed_scalar]" ) {
+    static_assert(goob::float_to_half_bits(1.0f) == 0x3c00);
+    static_assert(goob::half_bits_to_float(0xc000) == -2.0f);
+    REQUIRE(goob::float_to_half_bits(65504.0f) == 0x7bff);
+    REQUIRE(goob::float_to_half_bits(65519.0f) == 0x7bff);
+    REQUIRE(goob::float_to_half_bits(65520.0f) == 0x7c00);
+    REQUIRE(goob::float_to_half_bits(-1e10f) == 0xfc00);
+    REQUIRE(goob::float_to_half_bits(0x1p-24f) == 0x0001);
+    REQUIRE(goob::float_to_half_bits(0x1p-25f) == 0x0000);
+    REQUIRE(goob::float_to_half_bits(0x1.8p-25f) == 0x0001);
+    REQUIRE(goob::float_to_half_bits(-0.0f) == 0x8000);
+    REQUIRE(goob::float_to_half_bits(std::numeric_limits<float>::quiet_NaN()) == 0x7e00);
+
+    for (std::uint32_t bits = 0; bits < 0x10000; ++bits) {
+        const float value = goob::half_bits_to_float(static_cast<std::uint16_t>(bits));
+        if (std::isnan(value)) {
+            REQUIRE((bits & 0x7c00) == 0x7c00);
+            REQUIRE((goob::float_to_half_bits(value) & 0x7fff) > 0x7c00);
+            continue;
+        }
+        REQUIRE(goob::float_to_half_bits(value) == bits);
+
+        // Halfway to the next larger magnitude goes to the even one of both
+        if ((bits & 0x7fff) < 0x7bff) {
+            const float next = goob::half_bits_to_float(static_cast<std::uint16_t>(bits + 1));
+            const std::uint16_t even = (bits & 1) ? static_cast<std::uint16_t>(bits + 1) : static_cast<std::uint16_t>(bits);
+            REQUIRE(goob::float_to_half_bits(value + (next - value) / 2) == even);
+        }
+    }
+}
+
+TEST_CASE( "Half and fixed point work in linalg vectors", "[packed_scalar]" ) {
+    using namespace linalg::aliases;
+
+    const half3 a = float3{1.0f, -2.5f, 0.1f};
+    REQUIRE(float(a.z) == goob::half_bits_to_float(goob::float_to_half_bits(0.1f)));
+    const half3 b = a * goob::Half(2.0f) + a;
+    const float3 back = b;
+    REQUIRE(back == float3{3.0f, -7.5f, float(goob::Half(3 * float(a.z)))});
+    REQUIRE(linalg::dot(float3(a), float3(a)) == float(a.x) * float(a.x) + float(a.y) * float(a.y) + float(a.z) * float(a.z));
+    goob::Half h(1.0f);
+    h += 0.5f;
+    REQUIRE(float(h) == 1.5f);
+    REQUIRE(float(-h) == -1.5f);
+
+    using goob::Fixed24_8;
+    static_assert(Fixed24_8(1.0f).raw() == 256);
+    REQUIRE(Fixed24_8(0x1p-9f).raw() == 0);
+    REQUIRE(Fixed24_8(0x3p-9f).raw() == 2);
+    REQUIRE(Fixed24_8(-0x3p-9f).raw() == -2);
+    REQUIRE(Fixed24_8(1e10f).raw() == std::numeric_limits<std::int32_t>::max() - 127);
+    REQUIRE(Fixed24_8(-1e10f).raw() == std::numeric_limits<std::int32_t>::min());
+    REQUIRE(Fixed24_8(std::numeric_limits<float>::quiet_NaN()).raw() == std::numeric_limits<std::int32_t>::min());
+    REQUIRE(goob::Fixed8_8(200.0f).raw() == std::numeric_limits<std::int16_t>::max());
+
+    const Fixed24_8 x(2.5f), y(-1.25f);
+    REQUIRE(float(x + y) == 1.25f);
+    REQUIRE(float(x - y) == 3.75f);
+    REQUIRE(float(x * y) == -3.125f);
+    REQUIRE(float(x / y) == -2.0f);
+    REQUIRE((Fixed24_8::from_raw(-1) * Fixed24_8(0.5f)).raw() == -1);
+    REQUIRE(x + 1 == 3.5f);
+
+    using fixed2 = linalg::vec<Fixed24_8,2>;
+    const fixed2 p = float2{10.25f, -3.0f}, q = float2{0.5f, 0.75f};
+    REQUIRE(float2(p + q * Fixed24_8(4.0f)) == float2{12.25f, 0.0f});
+    REQUIRE(float2(linalg::min(p, q)) == float2{0.5f, -3.0f});
+}
+
+TEST_CASE( "Bulk conversion kernels match the scalar conversions", "[packed_scalar]" ) {
+    const std::vector<float> in = conversion_inputs();
+
+    std::vector<std::uint16_t> all_halves(0x10000);
+    for (std::uint32_t bits = 0; bits < 0x10000; ++bits) {
+        all_halves[bits] = static_cast<std::uint16_t>(bits);
+    }
+
+    for (const goob::BatchKernels * k : available_kernels()) {
+        INFO(goob::to_string(k->level));
+
+        std::vector<std::uint16_t> halves(in.size());
+        k->to_half(in.data(), halves.data(), in.size());
+        for (std::size_t i = 0; i < in.size(); ++i) {
+            INFO(in[i]);
+            REQUIRE(halves[i] == goob::float_to_half_bits(in[i]));
+        }
+
+        std::vector<float> floats(all_halves.size());
+        k->from_half(all_halves.data(), floats.data(), all_halves.size());
+        for (std::size_t i = 0; i < all_halves.size(); ++i) {
+            REQUIRE(same_bits(floats[i], goob::half_bits_to_float(all_halves[i])));
+        }
+
+        std::vector<std::int32_t> fixed(in.size());
+        for (const float scale : {256.0f, 65536.0f}) {
+            k->to_fixed(in.data(), fixed.data(), scale, in.size());
+            for (std::size_t i = 0; i < in.size(); ++i) {
+                INFO(in[i]);
+                REQUIRE(fixed[i] == goob::detail::saturate_round<std::int32_t>(in[i] * scale));
+            }
+            k->from_fixed(fixed.data(), floats.data(), 1.0f / scale, in.size());
+            for (std::size_t i = 0; i < in.size(); ++i) {
+                REQUIRE(same_bits(floats[i], static_cast<float>(fixed[i]) / scale));
+            }
+        }
+    }
+
+    // Public wrappers, including vector spans and 16-bit fixed point
+    const std::vector<linalg::vec<float,3>> vectors = {{1.0f, 0.1f, -3.3f}, {1e5f, -1e-6f, 0.0f}, {0.75f, 2.0f, 1000.1f}};
+    std::vector<linalg::vec<goob::Half,3>> packed(vectors.size());
+    goob::convert(std::span<const linalg::vec<float,3>>(vectors), std::span<linalg::vec<goob::Half,3>>(packed));
+    std::vector<linalg::vec<goob::Fixed16_16,3>> fixed(vectors.size());
+    goob::convert(std::span<const linalg::vec<float,3>>(vectors), std::span<linalg::vec<goob::Fixed16_16,3>>(fixed));
+    std::vector<linalg::vec<goob::Fixed8_8,3>> fixed_short(vectors.size());
+    goob::convert(std::span<const linalg::vec<float,3>>(vectors), std::span<linalg::vec<goob::Fixed8_8,3>>(fixed_short));
+    for (std::size_t i = 0; i < vectors.size(); ++i) {
+        for (int c = 0; c < 3; ++c) {
+            REQUIRE(goob::half_bits(packed[i][c]) == goob::half_bits(goob::Half(vectors[i][c])));
+            REQUIRE(fixed[i][c].raw() == goob::Fixed16_16(vectors[i][c]).raw());
+            REQUIRE(fixed_short[i][c].raw() == goob::Fixed8_8(vectors[i][c]).raw());
+        }
+    }
+
+    std::vector<linalg::vec<float,3>> unpacked(vectors.size());
+    goob::convert(std::span<const linalg::vec<goob::Half,3>>(packed), std::span<linalg::vec<float,3>>(unpacked));
+    for (std::size_t i = 0; i < vectors.size(); ++i) {
+        REQUIRE(unpacked[i] == linalg::vec<float,3>(packed[i]));
+    }
+    goob::convert(std::span<const linalg::vec<goob::Fixed16_16,3>>(fixed), std::span<linalg::vec<float,3>>(unpacked));
+    for (std::size_t i = 0; i < vectors.size(); ++i) {
+        REQUIRE(unpacked[i] == linalg::vec<float,3>(fixed[i]));
+    }
+}